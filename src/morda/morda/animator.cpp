@@ -0,0 +1,199 @@
+#include "animator.hpp"
+
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+#include <utki/time.hpp>
+#include <utki/util.hpp>
+
+using namespace morda;
+
+namespace{
+real ease(animator::easing e, real p)noexcept{
+	switch(e){
+		case animator::easing::linear:
+			break;
+		case animator::easing::ease_in:
+			return p * p;
+		case animator::easing::ease_out:
+			return p * (2 - p);
+		case animator::easing::ease_in_out:
+			return p < real(0.5) ? 2 * p * p : -1 + (4 - 2 * p) * p;
+		case animator::easing::step:
+			return p < real(0.5) ? 0 : 1;
+	}
+	return p;
+}
+}
+
+void animation::stop()noexcept{
+	if(!this->owner){
+		return;
+	}
+	this->owner->remove(this->index);
+	ASSERT(!this->owner)
+}
+
+animator::~animator()noexcept{
+	for(auto h : this->handles){
+		h->owner = nullptr;
+	}
+}
+
+void animator::remove(size_t index)noexcept{
+	ASSERT(index < this->size())
+	ASSERT(this->handles[index]->owner == this)
+	ASSERT(this->handles[index]->index == index)
+
+	this->handles[index]->owner = nullptr;
+
+	// move the last animation to the place of the removed one
+	size_t last = this->size() - 1;
+	if(index != last){
+		this->targets[index] = this->targets[last];
+		this->from_values[index] = this->from_values[last];
+		this->deltas[index] = this->deltas[last];
+		this->start_times[index] = this->start_times[last];
+		this->durations[index] = this->durations[last];
+		this->easings[index] = this->easings[last];
+		this->loops[index] = this->loops[last];
+		this->handles[index] = this->handles[last];
+		this->end_handlers[index] = std::move(this->end_handlers[last]);
+
+		this->handles[index]->index = index;
+	}
+
+	this->targets.pop_back();
+	this->from_values.pop_back();
+	this->deltas.pop_back();
+	this->start_times.pop_back();
+	this->durations.pop_back();
+	this->easings.pop_back();
+	this->loops.pop_back();
+	this->handles.pop_back();
+	this->end_handlers.pop_back();
+}
+
+void animator::start(
+		animation& a,
+		real& target,
+		real from,
+		real to,
+		uint32_t duration_ms,
+		easing e,
+		bool loop,
+		std::function<void()>&& end_handler
+	)
+{
+	if(loop && duration_ms == 0){
+		throw std::invalid_argument("animator::start(): looped animation has zero duration");
+	}
+
+	a.stop();
+
+	// in case there were no running animations the frame time can be way behind
+	if(!this->is_active() && !this->is_ending){
+		this->frame_time = utki::get_ticks_ms();
+	}
+
+	this->targets.push_back(&target);
+	this->from_values.push_back(from);
+	this->deltas.push_back(to - from);
+	this->start_times.push_back(this->frame_time);
+	this->durations.push_back(duration_ms);
+	this->easings.push_back(e);
+	this->loops.push_back(loop);
+	this->handles.push_back(&a);
+	this->end_handlers.push_back(std::move(end_handler));
+
+	a.owner = this;
+	a.index = this->size() - 1;
+
+	target = from;
+}
+
+void animator::advance(uint32_t now){
+	this->frame_time = now;
+
+	bool has_ended = false;
+
+	for(size_t i = 0; i != this->size(); ++i){
+		// unsigned arithmetic handles the wrap around of the timestamp
+		uint32_t t = now - this->start_times[i];
+		uint32_t d = this->durations[i];
+
+		if(t >= d){
+			if(this->loops[i]){
+				t %= d;
+			}else{
+				*this->targets[i] = this->from_values[i] + this->deltas[i];
+				has_ended = true;
+				continue;
+			}
+		}
+
+		real p = ease(this->easings[i], real(t) / real(d));
+		*this->targets[i] = this->from_values[i] + this->deltas[i] * p;
+	}
+
+	if(!has_ended){
+		return;
+	}
+
+	// collect the ended animations first, since end handlers can start and stop animations
+	std::vector<std::function<void()>> handlers;
+	for(size_t i = 0; i != this->size();){
+		if(this->loops[i] || now - this->start_times[i] < this->durations[i]){
+			++i;
+			continue;
+		}
+		if(this->end_handlers[i]){
+			handlers.push_back(std::move(this->end_handlers[i]));
+		}
+		this->remove(i);
+	}
+
+	this->is_ending = true;
+	utki::scope_exit ending_scope_exit([this](){
+		this->is_ending = false;
+	});
+
+	for(auto& h : handlers){
+		h();
+	}
+}
+
+uint32_t animator::get_next_update_delay()const noexcept{
+	uint32_t ret = this->frame_period;
+
+	for(size_t i = 0; i != this->size(); ++i){
+		if(this->easings[i] != easing::step){
+			return this->frame_period;
+		}
+
+		uint32_t t = this->frame_time - this->start_times[i];
+		uint32_t d = this->durations[i];
+
+		if(this->loops[i]){
+			t %= d;
+		}
+
+		// for integer times t / d >= 0.5 is same as t >= ceil(d / 2)
+		uint32_t half = d - d / 2;
+
+		uint32_t delay;
+		if(t < half){
+			delay = half - t;
+		}else if(t < d){
+			delay = d - t;
+		}else{
+			delay = 0;
+		}
+
+		if(i == 0 || delay < ret){
+			ret = delay;
+		}
+	}
+
+	return ret;
+}
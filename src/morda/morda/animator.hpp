@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "config.hpp"
+
+namespace morda{
+
+class animator;
+
+/**
+ * @brief Handle of a running animation.
+ * The handle is owned by the object whose property is animated, normally it is a member
+ * of the widget. Destroying the handle stops the animation, so the animated property never outlives
+ * its animation.
+ */
+class animation{
+	friend class animator;
+
+	animator* owner = nullptr;
+
+	// index of the animation in the animator's arrays
+	size_t index;
+
+public:
+	animation() = default;
+
+	animation(const animation&) = delete;
+	animation& operator=(const animation&) = delete;
+
+	~animation()noexcept{
+		this->stop();
+	}
+
+	/**
+	 * @brief Check if the animation is running.
+	 * @return true if the animation is running.
+	 * @return false otherwise.
+	 */
+	bool is_active()const noexcept{
+		return this->owner != nullptr;
+	}
+
+	/**
+	 * @brief Stop the animation.
+	 * The animated property keeps its current value. The end handler is not called.
+	 * Does nothing if the animation is not running.
+	 */
+	void stop()noexcept;
+};
+
+/**
+ * @brief Tween engine.
+ * Animates real number properties from one value to another over time.
+ * All running animations are stored in flat arrays and are advanced in a single pass once per frame,
+ * using the same frame timestamp, so all animations are in sync and there is no per-animation
+ * timer bookkeeping.
+ *
+ * The animator is owned by updater, which advances it on each UI cycle and keeps the UI cycles coming
+ * at the frame rate while there are running animations. In case all running animations use step easing,
+ * the UI cycles are only requested at the moments when the animated values change, see get_next_update_delay().
+ * The animator is not thread safe, it must be used from UI thread.
+ */
+class animator{
+	friend class animation;
+
+public:
+	/**
+	 * @brief Easing function.
+	 */
+	enum class easing{
+		linear,
+		ease_in,
+		ease_out,
+		ease_in_out,
+
+		/**
+		 * @brief Hold the start value during the first half of the duration and the end value during the second half.
+		 * Useful for blinking, as the values change only twice per period.
+		 */
+		step
+	};
+
+private:
+	// struct of arrays, the i'th animation is described by the i'th elements of all the arrays
+	std::vector<real*> targets;
+	std::vector<real> from_values;
+	std::vector<real> deltas;
+	std::vector<uint32_t> start_times;
+	std::vector<uint32_t> durations;
+	std::vector<easing> easings;
+	std::vector<bool> loops;
+	std::vector<animation*> handles;
+	std::vector<std::function<void()>> end_handlers;
+
+	uint32_t frame_time = 0;
+
+	// end handlers are being called, so the frame time is up to date
+	bool is_ending = false;
+
+	uint16_t frame_period = 16;
+
+	void remove(size_t index)noexcept;
+
+public:
+	animator() = default;
+
+	animator(const animator&) = delete;
+	animator& operator=(const animator&) = delete;
+
+	~animator()noexcept;
+
+	/**
+	 * @brief Start animation.
+	 * If the animation handle is already running some animation, then that animation is replaced.
+	 * The value of the target is set to the 'from' value right away.
+	 * @param a - animation handle. It must remain alive while the animation is running.
+	 * @param target - property to animate. It must remain alive while the animation is running.
+	 * @param from - start value.
+	 * @param to - end value.
+	 * @param duration_ms - duration of the animation in milliseconds.
+	 * @param e - easing function.
+	 * @param loop - whether to restart the animation from the beginning each time it ends.
+	 * @param end_handler - function to call when the animation ends. Not called for looped animations
+	 *                      and for stopped animations.
+	 */
+	void start(
+			animation& a,
+			real& target,
+			real from,
+			real to,
+			uint32_t duration_ms,
+			easing e = easing::linear,
+			bool loop = false,
+			std::function<void()>&& end_handler = nullptr
+		);
+
+	/**
+	 * @brief Advance all running animations.
+	 * Sets the animated properties to their values at the given time, removes the ended animations
+	 * and calls their end handlers.
+	 * Normally, it is called by updater once per UI cycle.
+	 * @param now - timestamp of the frame in milliseconds.
+	 */
+	void advance(uint32_t now);
+
+	/**
+	 * @brief Get number of running animations.
+	 * @return number of running animations.
+	 */
+	size_t size()const noexcept{
+		return this->targets.size();
+	}
+
+	/**
+	 * @brief Check if there are running animations.
+	 * @return true if there is at least one running animation.
+	 * @return false otherwise.
+	 */
+	bool is_active()const noexcept{
+		return this->size() != 0;
+	}
+
+	/**
+	 * @brief Get timestamp of the current frame.
+	 * All animations are advanced to this time.
+	 * @return timestamp of the current frame in milliseconds.
+	 */
+	uint32_t get_frame_time()const noexcept{
+		return this->frame_time;
+	}
+
+	/**
+	 * @brief Get time until the animated values change next.
+	 * For animations with step easing, this is the time till the next step, for other animations it is the frame period.
+	 * The updater uses it to decide when the next UI cycle is needed.
+	 * @return time from the current frame until the next update is needed, in milliseconds.
+	 */
+	uint32_t get_next_update_delay()const noexcept;
+
+	/**
+	 * @brief Set frame period.
+	 * While there are running animations, the UI cycles are requested with this period.
+	 * @param period_ms - frame period in milliseconds, 16 by default.
+	 */
+	void set_frame_period(uint16_t period_ms)noexcept{
+		this->frame_period = period_ms;
+	}
+
+	/**
+	 * @brief Get frame period.
+	 * @return frame period in milliseconds.
+	 */
+	uint16_t get_frame_period()const noexcept{
+		return this->frame_period;
+	}
+};
+
+}
@@ -14,6 +14,13 @@ context::context(
 		renderer(std::move(r)),
 		updater(std::move(u)),
 		run_from_ui_thread(std::move(run_from_ui_thread_function)),
+		task_queue([this](){
+			this->run_from_ui_thread([c = utki::make_weak_from(*this)](){
+				if(auto ctx = c.lock()){
+					ctx->task_queue.run();
+				}
+			});
+		}),
 		cursor_manager(std::move(set_mouse_cursor_function)),
 		loader(*this),
 		inflater(*this),
@@ -10,6 +10,8 @@
 #include "updateable.hpp"
 #include "inflater.hpp"
 #include "resource_loader.hpp"
+#include "layout_scheduler.hpp"
+#include "task_queue.hpp"
 
 namespace morda{
 
@@ -28,6 +30,15 @@ public:
 
 	const std::function<void(std::function<void()>&&)> run_from_ui_thread;
 
+	/**
+	 * @brief Queue of tasks to execute on UI thread.
+	 * Prefer it to run_from_ui_thread when posting lots of tasks, e.g. updates from background threads.
+	 * The queue is run on UI thread using run_from_ui_thread, one platform message per batch of tasks.
+	 * Each run is limited by the queue's time budget, the rest of the tasks is run after
+	 * the platform had a chance to process other messages.
+	 */
+	morda::task_queue task_queue;
+
 	mouse_cursor_manager cursor_manager;
 
 	/**
@@ -40,6 +51,15 @@ public:
 	 */
 	morda::inflater inflater;
 
+	/**
+	 * @brief Scheduler for parallel layout.
+	 * By default it is not set, which means that all the layout is done on the UI thread.
+	 * Set the scheduler to lay out children of containers which have parallel layout enabled concurrently,
+	 * see container::lay_out_children() for details.
+	 * The scheduler must be set or changed only from the UI thread outside of the layout pass.
+	 */
+	std::shared_ptr<morda::layout_scheduler> layout_scheduler;
+
 	/**
 	 * @brief Constructor.
 	 * @param r - renderer implementation.
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <stdexcept>
 
 #include <utki/unicode.hpp>
 
@@ -15,6 +17,9 @@ namespace morda{
 
 /**
  * @brief Basic class representing a font.
+ * Text is rendered one glyph per character with pair kerning from the font, if the font does kerning.
+ * Complex script shaping is not supported, i.e. Arabic text is rendered with isolated forms of the letters
+ * and Indic text without reordering and conjuncts.
  */
 class font{
 public:
@@ -94,6 +99,16 @@ protected:
 	virtual morda::rectangle get_bounding_box_internal(const std::u32string& str, size_t tab_size)const = 0;
 public:
 	virtual ~font()noexcept{}
+
+	/**
+	 * @brief Prepare glyphs for range of characters in advance.
+	 * Font implementations which load glyphs lazily can prepare the glyphs in background,
+	 * so that the first rendering of the characters does not stall the UI thread.
+	 * The default implementation does nothing.
+	 * @param first - first character of the range.
+	 * @param last - last character of the range, inclusive.
+	 */
+	virtual void prewarm(char32_t first, char32_t last)const{}
 	
 	/**
 	 * @brief Render string of text.
@@ -231,6 +246,35 @@ public:
 	 */
 	virtual real get_advance(char32_t c, size_t tab_size = 4)const = 0;
 
+	/**
+	 * @brief Get positions of the characters in the string.
+	 * The positions are as when the string is rendered as a whole, i.e. with kerning applied,
+	 * so those can be used for placing the text cursor or hit-testing the rendered string.
+	 * Characters which have no glyph have zero advance.
+	 * The default implementation sums advances of the characters, fonts which do kerning override it.
+	 * @param str - string of text to get character positions for.
+	 * @param tab_size - tabulation size in widths of space character.
+	 * @return str.size() + 1 positions, element i is the pen position of the i-th character,
+	 *         the last element is the advance of the whole string.
+	 */
+	virtual std::vector<real> get_char_offsets(const std::u32string& str, size_t tab_size = 4)const{
+		std::vector<real> ret;
+		ret.reserve(str.size() + 1);
+
+		real a = 0;
+		ret.push_back(a);
+		for(auto c : str){
+			try{
+				a += this->get_advance(c, tab_size);
+			}catch(std::out_of_range&){
+				// no glyph, zero advance
+			}
+			ret.push_back(a);
+		}
+
+		return ret;
+	}
+
 	/**
 	 * @brief Get bounding box of the string.
 	 * @param str - string of text to get the bounding box for.
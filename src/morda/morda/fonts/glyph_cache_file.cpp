@@ -0,0 +1,213 @@
+#include "glyph_cache_file.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+namespace{
+const char cache_magic[] = "MORDAGC1";
+const size_t cache_magic_size = sizeof(cache_magic) - 1;
+
+const size_t header_size = cache_magic_size + 8 + 4 + 4;
+const size_t entry_size = 4 + 4 + 5 * 4 + 4 + 4 + 8;
+
+const std::uint32_t flag_missing = 1;
+
+std::uint32_t read_u32(const std::uint8_t* p)noexcept{
+	return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+std::uint64_t read_u64(const std::uint8_t* p)noexcept{
+	return std::uint64_t(read_u32(p)) | (std::uint64_t(read_u32(p + 4)) << 32);
+}
+
+float read_float(const std::uint8_t* p)noexcept{
+	std::uint32_t n = read_u32(p);
+	float ret;
+	static_assert(sizeof(ret) == sizeof(n), "float is not 32 bit");
+	std::memcpy(&ret, &n, sizeof(ret));
+	return ret;
+}
+
+void append_u32(std::vector<std::uint8_t>& v, std::uint32_t n){
+	for(unsigned i = 0; i != 4; ++i){
+		v.push_back(std::uint8_t(n >> (i * 8)));
+	}
+}
+
+void append_u64(std::vector<std::uint8_t>& v, std::uint64_t n){
+	append_u32(v, std::uint32_t(n));
+	append_u32(v, std::uint32_t(n >> 32));
+}
+
+void append_float(std::vector<std::uint8_t>& v, float f){
+	std::uint32_t n;
+	std::memcpy(&n, &f, sizeof(n));
+	append_u32(v, n);
+}
+}
+
+glyph_cache_file::glyph_cache_file(const std::string& path, std::uint64_t font_hash, unsigned pixel_size) :
+		mapping(std::make_unique<mapped_file>(path))
+{
+	this->parse(this->mapping->data(), font_hash, pixel_size);
+}
+
+glyph_cache_file::glyph_cache_file(std::vector<std::uint8_t>&& data, std::uint64_t font_hash, unsigned pixel_size) :
+		buffer(std::move(data))
+{
+	this->parse(utki::make_span(this->buffer), font_hash, pixel_size);
+}
+
+void glyph_cache_file::parse(utki::span<const std::uint8_t> data, std::uint64_t font_hash, unsigned pixel_size){
+	auto p = data.data();
+	size_t size = data.size();
+
+	if(size < header_size || std::memcmp(p, cache_magic, cache_magic_size) != 0){
+		throw std::runtime_error("glyph_cache_file::parse(): not a glyph cache file");
+	}
+
+	size_t pos = cache_magic_size;
+
+	if(read_u64(p + pos) != font_hash){
+		throw std::runtime_error("glyph_cache_file::parse(): glyph cache is made for different font");
+	}
+	pos += 8;
+
+	if(read_u32(p + pos) != pixel_size){
+		throw std::runtime_error("glyph_cache_file::parse(): glyph cache is made for different font size");
+	}
+	pos += 4;
+
+	std::uint32_t num_glyphs = read_u32(p + pos);
+	pos += 4;
+
+	if((size - pos) / entry_size < num_glyphs){
+		throw std::runtime_error("glyph_cache_file::parse(): glyph index is corrupted");
+	}
+
+	this->glyphs.reserve(num_glyphs);
+
+	for(std::uint32_t i = 0; i != num_glyphs; ++i, pos += entry_size){
+		const std::uint8_t* e = p + pos;
+
+		glyph g;
+		g.c = char32_t(read_u32(e));
+		g.is_missing = (read_u32(e + 4) & flag_missing) != 0;
+		g.top_left.x() = read_float(e + 8);
+		g.top_left.y() = read_float(e + 12);
+		g.bottom_right.x() = read_float(e + 16);
+		g.bottom_right.y() = read_float(e + 20);
+		g.advance = read_float(e + 24);
+		g.dims.x() = read_u32(e + 28);
+		g.dims.y() = read_u32(e + 32);
+
+		std::uint64_t offset = read_u64(e + 36);
+		std::uint64_t bitmap_size = std::uint64_t(g.dims.x()) * std::uint64_t(g.dims.y());
+
+		if(offset > size || bitmap_size > size - offset){
+			throw std::runtime_error("glyph_cache_file::parse(): glyph bitmap is out of file bounds");
+		}
+
+		g.alpha = utki::make_span(p + offset, size_t(bitmap_size));
+
+		if(!this->glyphs.empty() && this->glyphs.back().c >= g.c){
+			throw std::runtime_error("glyph_cache_file::parse(): glyph index is not sorted");
+		}
+
+		this->glyphs.push_back(g);
+	}
+}
+
+const glyph_cache_file::glyph* glyph_cache_file::find(char32_t c)const noexcept{
+	auto i = std::lower_bound(
+			this->glyphs.begin(),
+			this->glyphs.end(),
+			c,
+			[](const glyph& g, char32_t c){
+				return g.c < c;
+			}
+		);
+	if(i == this->glyphs.end() || i->c != c){
+		return nullptr;
+	}
+	return &*i;
+}
+
+void glyph_cache_file::write(const papki::file& dst, std::uint64_t font_hash, unsigned pixel_size, utki::span<const glyph> glyphs){
+	std::vector<const glyph*> sorted;
+	sorted.reserve(glyphs.size());
+	for(auto& g : glyphs){
+		sorted.push_back(&g);
+	}
+	// keep the order of glyphs for the same character, so that the first one of them is written
+	std::stable_sort(
+			sorted.begin(),
+			sorted.end(),
+			[](const glyph* a, const glyph* b){
+				return a->c < b->c;
+			}
+		);
+	sorted.erase(
+			std::unique(
+					sorted.begin(),
+					sorted.end(),
+					[](const glyph* a, const glyph* b){
+						return a->c == b->c;
+					}
+				),
+			sorted.end()
+		);
+
+	std::vector<std::uint8_t> header;
+	header.reserve(header_size + sorted.size() * entry_size);
+
+	header.insert(header.end(), cache_magic, cache_magic + cache_magic_size);
+	append_u64(header, font_hash);
+	append_u32(header, std::uint32_t(pixel_size));
+	append_u32(header, std::uint32_t(sorted.size()));
+
+	std::uint64_t offset = header_size + sorted.size() * entry_size;
+
+	for(auto g : sorted){
+		ASSERT(g->alpha.size() == size_t(g->dims.x()) * size_t(g->dims.y()))
+
+		append_u32(header, std::uint32_t(g->c));
+		append_u32(header, g->is_missing ? flag_missing : 0);
+		append_float(header, float(g->top_left.x()));
+		append_float(header, float(g->top_left.y()));
+		append_float(header, float(g->bottom_right.x()));
+		append_float(header, float(g->bottom_right.y()));
+		append_float(header, float(g->advance));
+		append_u32(header, g->dims.x());
+		append_u32(header, g->dims.y());
+		append_u64(header, offset);
+
+		offset += g->alpha.size();
+	}
+
+	ASSERT(header.size() == header_size + sorted.size() * entry_size)
+
+	papki::file::guard file_guard(dst, papki::file::mode::create);
+
+	dst.write(utki::make_span(header));
+
+	for(auto g : sorted){
+		if(!g->alpha.empty()){
+			dst.write(g->alpha);
+		}
+	}
+}
+
+std::uint64_t glyph_cache_file::hash(utki::span<const std::uint8_t> data)noexcept{
+	std::uint64_t h = 0xcbf29ce484222325;
+	for(auto b : data){
+		h ^= std::uint64_t(b);
+		h *= 0x100000001b3;
+	}
+	return h;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <utki/span.hpp>
+
+#include <r4/vector.hpp>
+
+#include <papki/file.hpp>
+
+#include "../config.hpp"
+
+#include "../util/mapped_file.hpp"
+
+namespace morda{
+
+/**
+ * @brief Persistent cache of rasterized glyphs.
+ * The cache file holds glyph bitmaps and metrics of a single font of a single pixel size.
+ * The file is memory mapped, so glyph bitmaps are used right from the mapped pages without copying.
+ *
+ * File format, all numbers are little-endian:
+ * - 8 bytes: magic "MORDAGC1".
+ * - 8 bytes: hash of the font file, see hash().
+ * - 4 bytes: font size in pixels.
+ * - 4 bytes: number of glyphs.
+ * - glyph index, sorted by character, each entry is:
+ *   - 4 bytes: character, UTF-32.
+ *   - 4 bytes: flags, bit 0 is set if the font has no glyph for the character.
+ *   - 5 x 4 bytes: top left x, top left y, bottom right x, bottom right y, advance, as 32 bit floats.
+ *   - 4 bytes: bitmap width.
+ *   - 4 bytes: bitmap height.
+ *   - 8 bytes: offset of the bitmap data from the beginning of the file.
+ * - bitmap data, 1 byte of alpha per pixel, rows are tightly packed.
+ */
+class glyph_cache_file{
+public:
+	/**
+	 * @brief Rasterized glyph.
+	 */
+	struct glyph{
+		char32_t c;
+
+		/**
+		 * @brief Indicates that the font has no glyph for the character.
+		 */
+		bool is_missing;
+
+		morda::vector2 top_left;
+		morda::vector2 bottom_right;
+		real advance;
+
+		/**
+		 * @brief Bitmap dimensions in pixels.
+		 */
+		r4::vector2<unsigned> dims;
+
+		/**
+		 * @brief Bitmap alpha values.
+		 * Holds dims.x() * dims.y() bytes.
+		 */
+		utki::span<const std::uint8_t> alpha;
+	};
+
+private:
+	std::unique_ptr<mapped_file> mapping;
+
+	// in case the cache is not memory mapped, it is held in memory
+	std::vector<std::uint8_t> buffer;
+
+	// sorted by character
+	std::vector<glyph> glyphs;
+
+	void parse(utki::span<const std::uint8_t> data, std::uint64_t font_hash, unsigned pixel_size);
+
+public:
+	/**
+	 * @brief Open memory mapped cache file.
+	 * @param path - path to the cache file in the file system.
+	 * @param font_hash - hash of the font file the cache is expected to be made for.
+	 * @param pixel_size - font size in pixels the cache is expected to be made for.
+	 * @throw std::runtime_error - in case the file could not be mapped, is corrupted or is made for a different font.
+	 */
+	glyph_cache_file(const std::string& path, std::uint64_t font_hash, unsigned pixel_size);
+
+	/**
+	 * @brief Create cache from memory buffer.
+	 * @param data - cache file data.
+	 * @param font_hash - hash of the font file the cache is expected to be made for.
+	 * @param pixel_size - font size in pixels the cache is expected to be made for.
+	 * @throw std::runtime_error - in case the data is corrupted or is made for a different font.
+	 */
+	glyph_cache_file(std::vector<std::uint8_t>&& data, std::uint64_t font_hash, unsigned pixel_size);
+
+	glyph_cache_file(const glyph_cache_file&) = delete;
+	glyph_cache_file& operator=(const glyph_cache_file&) = delete;
+
+	/**
+	 * @brief Find glyph.
+	 * @param c - character to find the glyph for.
+	 * @return pointer to the glyph.
+	 * @return nullptr in case there is no glyph for the character in the cache.
+	 */
+	const glyph* find(char32_t c)const noexcept;
+
+	/**
+	 * @brief Get all glyphs of the cache.
+	 * @return glyphs sorted by character.
+	 */
+	utki::span<const glyph> get_glyphs()const noexcept{
+		return utki::make_span(this->glyphs);
+	}
+
+	/**
+	 * @brief Write cache file.
+	 * @param dst - file to write the cache to.
+	 * @param font_hash - hash of the font file.
+	 * @param pixel_size - font size in pixels.
+	 * @param glyphs - glyphs to write, in any order. In case there are several glyphs for the same character,
+	 *                 the first one of them is written.
+	 */
+	static void write(const papki::file& dst, std::uint64_t font_hash, unsigned pixel_size, utki::span<const glyph> glyphs);
+
+	/**
+	 * @brief Calculate hash of font file data.
+	 * 64 bit FNV-1a hash.
+	 * @param data - font file data.
+	 * @return hash of the data.
+	 */
+	static std::uint64_t hash(utki::span<const std::uint8_t> data)noexcept;
+};
+
+}
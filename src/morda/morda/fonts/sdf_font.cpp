@@ -0,0 +1,543 @@
+#include <unordered_map>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <utki/debug.hpp>
+
+#include "../render/texture_2d.hpp"
+#include "../render/vertex_array.hpp"
+
+#include "../util/res_pack.hpp"
+#include "../util/util.hpp"
+
+#include "sdf_font.hxx"
+#include "text_shaper.hxx"
+#include "../context.hpp"
+
+using namespace morda;
+
+namespace{
+constexpr const char32_t unknownChar_c = 0xfffd;
+
+constexpr const double infinity_c = 1e20;
+
+// Squared euclidean distance transform of one row or column, see
+// "Distance Transforms of Sampled Functions" by P. Felzenszwalb and D. Huttenlocher.
+// The grid values are squared distances, the transform is done in place with the given stride.
+void distance_transform_1d(double* grid, size_t stride, size_t n, std::vector<double>& f, std::vector<size_t>& v, std::vector<double>& z){
+	for(size_t i = 0; i != n; ++i){
+		f[i] = grid[i * stride];
+	}
+
+	size_t k = 0;
+	v[0] = 0;
+	z[0] = -infinity_c;
+	z[1] = infinity_c;
+
+	for(size_t q = 1; q != n; ++q){
+		double s;
+		for(;;){
+			auto p = v[k];
+			s = ((f[q] + double(q * q)) - (f[p] + double(p * p))) / double(2 * q - 2 * p);
+			if(s > z[k]){
+				break;
+			}
+			ASSERT(k != 0)
+			--k;
+		}
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = infinity_c;
+	}
+
+	k = 0;
+	for(size_t q = 0; q != n; ++q){
+		while(z[k + 1] < double(q)){
+			++k;
+		}
+		auto d = double(q) - double(v[k]);
+		grid[q * stride] = d * d + f[v[k]];
+	}
+}
+
+void distance_transform_2d(std::vector<double>& grid, r4::vector2<unsigned> dims){
+	auto n = std::max(dims.x(), dims.y());
+	std::vector<double> f(n);
+	std::vector<size_t> v(n);
+	std::vector<double> z(n + 1);
+
+	for(unsigned x = 0; x != dims.x(); ++x){
+		distance_transform_1d(&grid[x], dims.x(), dims.y(), f, v, z);
+	}
+	for(unsigned y = 0; y != dims.y(); ++y){
+		distance_transform_1d(&grid[size_t(y) * size_t(dims.x())], 1, dims.x(), f, v, z);
+	}
+}
+
+// Makes signed distance field from the glyph bitmap. The field is bigger than the bitmap by the spread on each side.
+// The field values are 128 at the glyph edge, bigger inside the glyph and smaller outside.
+std::vector<std::uint8_t> make_distance_field(const FT_Bitmap& bitmap, unsigned spread, r4::vector2<unsigned>& dims){
+	dims = r4::vector2<unsigned>(bitmap.width + 2 * spread, bitmap.rows + 2 * spread);
+
+	size_t size = size_t(dims.x()) * size_t(dims.y());
+
+	// squared distances to the nearest pixel outside and inside of the glyph
+	std::vector<double> to_outside(size, 0);
+	std::vector<double> to_inside(size, infinity_c);
+
+	for(unsigned y = 0; y != bitmap.rows; ++y){
+		auto src = bitmap.buffer + std::ptrdiff_t(y) * bitmap.pitch;
+		auto i = size_t(y + spread) * size_t(dims.x()) + spread;
+		for(unsigned x = 0; x != bitmap.width; ++x, ++i){
+			if(src[x] >= 0x80){
+				to_outside[i] = infinity_c;
+				to_inside[i] = 0;
+			}
+		}
+	}
+
+	distance_transform_2d(to_outside, dims);
+	distance_transform_2d(to_inside, dims);
+
+	std::vector<std::uint8_t> ret(size);
+	for(size_t i = 0; i != size; ++i){
+		using std::sqrt;
+		// pixel centers are half a pixel away from the edge
+		double d = to_inside[i] == 0 ? sqrt(to_outside[i]) - 0.5 : 0.5 - sqrt(to_inside[i]);
+		double v = 128 + d * 127 / spread;
+		ret[i] = std::uint8_t(std::min(std::max(v, 0.0), 255.0));
+	}
+	return ret;
+}
+}
+
+struct sdf_font::glyph_set{
+	struct glyph_metrics{
+		morda::vector2 top_left;
+		morda::vector2 bottom_right;
+		real advance;
+	};
+
+	struct glyph{
+		real advance;
+		std::shared_ptr<vertex_array> vao;
+		std::shared_ptr<texture_2d> tex;
+	};
+
+	FT_Library lib;
+	FT_Face face;
+
+	// the font data should be alive as long as the face is alive
+	std::vector<std::uint8_t> font_file;
+	// in case the font is loaded from resource pack archive, the font data is used right from the archive
+	std::shared_ptr<const res_pack> pack;
+
+	// guards the metrics cache, the freetype face and the shaper, so that text can be measured from any thread
+	std::mutex mutex;
+
+	// kerning is in pixels of base size
+	std::unique_ptr<text_shaper> shaper;
+
+	std::unordered_map<char32_t, glyph_metrics> metrics;
+
+	// Glyph textures are only accessed from UI thread. All the glyphs are kept, since one
+	// glyph set serves all font sizes, the number of glyphs is bounded by the used characters.
+	std::unordered_map<char32_t, glyph> glyphs;
+
+	// in pixels of base size
+	real height;
+	real descender;
+	real ascender;
+
+	glyph_set(const papki::file& fi){
+		utki::span<const std::uint8_t> data;
+		if(auto rf = dynamic_cast<const res_pack::file*>(&fi)){
+			data = rf->data();
+			this->pack = rf->get_pack();
+		}else{
+			this->font_file = fi.load();
+			data = utki::make_span(this->font_file);
+		}
+
+		if(FT_Init_FreeType(&this->lib)){
+			throw std::runtime_error("sdf_font::glyph_set::glyph_set(): unable to init freetype library");
+		}
+
+		if(FT_New_Memory_Face(this->lib, data.data(), FT_Long(data.size()), 0, &this->face) != 0){
+			FT_Done_FreeType(this->lib);
+			throw std::runtime_error("sdf_font::glyph_set::glyph_set(): unable to create font face object");
+		}
+
+		if(FT_Set_Pixel_Sizes(this->face, 0, base_size) != 0){
+			FT_Done_Face(this->face);
+			FT_Done_FreeType(this->lib);
+			throw std::runtime_error("sdf_font::glyph_set::glyph_set(): unable to set char size");
+		}
+
+		this->height = real(this->face->size->metrics.height) / 64.0f;
+		this->descender = -real(this->face->size->metrics.descender) / 64.0f;
+		this->ascender = real(this->face->size->metrics.ascender) / 64.0f;
+
+		this->shaper = std::make_unique<text_shaper>(this->face);
+	}
+
+	~glyph_set()noexcept{
+		FT_Done_Face(this->face);
+		FT_Done_FreeType(this->lib);
+	}
+
+	// the mutex must be locked when calling this function
+	const glyph_metrics& get_metrics(char32_t c){
+		auto i = this->metrics.find(c);
+		if(i != this->metrics.end()){
+			return i->second;
+		}
+
+		glyph_metrics gm;
+
+		if(FT_Load_Char(this->face, FT_ULong(c), FT_LOAD_DEFAULT) != 0){
+			if(c == unknownChar_c){
+				throw std::runtime_error("sdf_font::glyph_set::get_metrics(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
+			}
+			gm = this->get_metrics(unknownChar_c);
+		}else{
+			FT_Glyph_Metrics *m = &this->face->glyph->metrics;
+			gm.advance = real(m->horiAdvance) / (64.0f);
+			if(m->width == 0 || m->height == 0){
+				// empty glyph (space)
+				gm.top_left.set(0);
+				gm.bottom_right.set(0);
+			}else{
+				gm.top_left = morda::vector2(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f);
+				gm.bottom_right = morda::vector2(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f);
+			}
+		}
+
+		return this->metrics.insert(std::make_pair(c, gm)).first->second;
+	}
+
+	const glyph& get_glyph(char32_t c, morda::renderer& r){
+		auto i = this->glyphs.find(c);
+		if(i != this->glyphs.end()){
+			return i->second;
+		}
+
+		glyph g;
+		r4::vector2<unsigned> dims;
+		std::vector<std::uint8_t> field;
+		morda::vector2 top_left;
+
+		{
+			std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+			if(FT_Load_Char(this->face, FT_ULong(c), FT_LOAD_RENDER) != 0){
+				if(c == unknownChar_c){
+					throw std::runtime_error("sdf_font::glyph_set::get_glyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
+				}
+				TRACE(<< "sdf_font::glyph_set::get_glyph(" << std::hex << uint32_t(c) << "): failed to load glyph" << std::endl)
+				g.advance = -1;
+			}else{
+				FT_GlyphSlot slot = this->face->glyph;
+				g.advance = real(slot->metrics.horiAdvance) / (64.0f);
+				if(slot->bitmap.buffer){
+					field = make_distance_field(slot->bitmap, spread, dims);
+					top_left = morda::vector2(real(slot->bitmap_left) - real(spread), -real(slot->bitmap_top) - real(spread));
+				}
+			}
+		}
+
+		if(g.advance < 0){
+			// missing glyph, use the 'unknown character' glyph
+			auto u = this->get_glyph(unknownChar_c, r);
+			return this->glyphs.insert(std::make_pair(c, std::move(u))).first->second;
+		}
+
+		if(!field.empty()){
+			auto bottom_right = top_left + dims.to<real>();
+
+			std::array<r4::vector2<float>, 4> verts;
+			verts[0] = top_left;
+			verts[1] = morda::vector2(top_left.x(), bottom_right.y());
+			verts[2] = bottom_right;
+			verts[3] = morda::vector2(bottom_right.x(), top_left.y());
+
+			g.vao = r.factory->create_vertex_array(
+					{
+						r.factory->create_vertex_buffer(utki::make_span(verts)),
+						r.quad_01_vbo
+					},
+					r.quad_indices,
+					vertex_array::mode::triangle_fan
+				);
+
+			texture_2d::sampling params;
+			params.min_filter = texture_2d::filter::linear;
+			params.mag_filter = texture_2d::filter::linear;
+			params.wrap_s = texture_2d::wrap::clamp;
+			params.wrap_t = texture_2d::wrap::clamp;
+
+			std::array<utki::span<const std::uint8_t>, 1> mips = {{utki::make_span(field)}};
+
+			g.tex = r.factory->create_texture_2d(texture_2d::type::grey, dims, utki::make_span(mips), params);
+		}
+
+		return this->glyphs.insert(std::make_pair(c, std::move(g))).first->second;
+	}
+};
+
+sdf_font::sdf_font(std::shared_ptr<morda::context> c, std::shared_ptr<glyph_set> glyphs, real size) :
+		font(std::move(c)),
+		glyphs(std::move(glyphs)),
+		scale(size / real(base_size))
+{
+	ASSERT(this->glyphs)
+
+	using std::ceil;
+
+	this->height = ceil(this->glyphs->height * this->scale);
+	this->descender = ceil(this->glyphs->descender * this->scale);
+	this->ascender = ceil(this->glyphs->ascender * this->scale);
+}
+
+sdf_font::sdf_font(std::shared_ptr<morda::context> c, const papki::file& fi, real size) :
+		sdf_font(std::move(c), std::make_shared<glyph_set>(fi), size)
+{
+	// make sure the 'unknown character' glyph can be loaded
+	std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+	this->glyphs->get_metrics(unknownChar_c);
+}
+
+sdf_font::~sdf_font()noexcept{}
+
+std::unique_ptr<sdf_font> sdf_font::resize(real size)const{
+	return std::unique_ptr<sdf_font>(new sdf_font(this->context, this->glyphs, size));
+}
+
+real sdf_font::get_advance(char32_t c, size_t tab_size)const{
+	std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+	if(c == U'\t'){
+		return this->glyphs->get_metrics(U' ').advance * tab_size * this->scale;
+	}else{
+		return this->glyphs->get_metrics(c).advance * this->scale;
+	}
+}
+
+real sdf_font::get_advance_internal(const std::u32string& str, size_t tab_size)const{
+	real ret = 0;
+
+	std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+
+	real space_advance = this->glyphs->get_metrics(U' ').advance;
+
+	for(auto c : str){
+		if(c == U'\t'){
+			ret += space_advance * tab_size;
+		}else{
+			ret += this->glyphs->get_metrics(c).advance;
+		}
+	}
+
+	if(auto kerning = this->glyphs->shaper->shape(str)){
+		for(auto k : *kerning){
+			ret += k;
+		}
+	}
+
+	return ret * this->scale;
+}
+
+std::vector<real> sdf_font::get_char_offsets(const std::u32string& str, size_t tab_size)const{
+	std::vector<real> ret;
+	ret.reserve(str.size() + 1);
+
+	std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+
+	real space_advance = this->glyphs->get_metrics(U' ').advance;
+
+	auto kerning = this->glyphs->shaper->shape(str);
+
+	real a = 0;
+	for(size_t i = 0; i != str.size(); ++i){
+		// kerning moves the pen before the character
+		if(kerning){
+			a += (*kerning)[i];
+		}
+		ret.push_back(a * this->scale);
+
+		if(str[i] == U'\t'){
+			a += space_advance * tab_size;
+		}else{
+			a += this->glyphs->get_metrics(str[i]).advance;
+		}
+	}
+	ret.push_back(a * this->scale);
+
+	return ret;
+}
+
+morda::rectangle sdf_font::get_bounding_box_internal(const std::u32string& str, size_t tab_size)const{
+	morda::rectangle ret;
+
+	if(str.empty()){
+		ret.p.set(0);
+		ret.d.set(0);
+		return ret;
+	}
+
+	auto s = str.begin();
+
+	real curAdvance;
+
+	std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+
+	real left, right, top, bottom;
+	// init with bounding box of the first glyph
+	{
+		const auto& g = this->glyphs->get_metrics(*s);
+		left = g.top_left.x();
+		right = g.bottom_right.x();
+		top = g.top_left.y();
+		bottom = g.bottom_right.y();
+		curAdvance = g.advance;
+		++s;
+	}
+
+	real space_advance = this->glyphs->get_metrics(U' ').advance;
+
+	auto kerning = this->glyphs->shaper->shape(str);
+
+	for(; s != str.end(); ++s){
+		if(kerning){
+			curAdvance += (*kerning)[s - str.begin()];
+		}
+
+		if(*s == U'\t'){
+			curAdvance += space_advance * tab_size;
+		}else{
+			const auto& g = this->glyphs->get_metrics(*s);
+
+			using std::min;
+			using std::max;
+
+			top = min(g.top_left.y(), top);
+			bottom = max(g.bottom_right.y(), bottom);
+			left = min(curAdvance + g.top_left.x(), left);
+			right = max(curAdvance + g.bottom_right.x(), right);
+
+			curAdvance += g.advance;
+		}
+	}
+
+	ret.p.x() = left * this->scale;
+	ret.p.y() = top * this->scale;
+	ret.d.x() = (right - left) * this->scale;
+	ret.d.y() = (bottom - top) * this->scale;
+
+	ASSERT(ret.d.x() >= 0)
+	ASSERT(ret.d.y() >= 0)
+	return ret;
+}
+
+font::render_result sdf_font::render_internal(
+		const morda::matrix4& matrix,
+		r4::vector4<float> color,
+		const std::u32string_view str,
+		size_t tab_size,
+		size_t offset
+	)const
+{
+	render_result ret = {0, 0};
+
+	if(str.size() == 0){
+		return ret;
+	}
+
+	auto& r = *this->context->renderer;
+
+	set_simple_alpha_blending(r);
+
+	// in case the renderer has no SDF shader the distance field is rendered as is, which looks blurry
+	auto& s = r.shader->color_pos_sdf ? *r.shader->color_pos_sdf : *r.shader->color_pos_tex;
+
+	// glyphs are in pixels of base size
+	morda::matrix4 matr(matrix);
+	matr.scale(this->scale, this->scale);
+
+	real space_advance = this->glyphs->get_glyph(U' ', r).advance;
+
+	auto kerning = [this, &str](){
+		std::lock_guard<decltype(this->glyphs->mutex)> lock_guard(this->glyphs->mutex);
+		return this->glyphs->shaper->shape(str);
+	}();
+
+	size_t cur_offset = offset;
+
+	for(size_t i = 0; i != str.size(); ++i){
+		auto c = str[i];
+
+		if(kerning){
+			auto k = (*kerning)[i];
+			ret.advance += k;
+			matr.translate(k, 0);
+		}
+
+		real advance;
+
+		if(c == U'\t'){
+			size_t actual_tab_size;
+			if(offset == std::numeric_limits<size_t>::max()){
+				actual_tab_size = tab_size;
+			}else{
+				actual_tab_size = tab_size - cur_offset % tab_size;
+			}
+			advance = space_advance * actual_tab_size;
+			ret.length += actual_tab_size;
+			cur_offset += actual_tab_size;
+		}else{
+			const auto& g = this->glyphs->get_glyph(c, r);
+
+			// texture is null for glyphs of empty characters, like space
+			if(g.tex){
+				ASSERT(g.vao)
+				s.render(matr, *g.vao, color, *g.tex);
+			}
+			advance = g.advance;
+			++ret.length;
+			++cur_offset;
+		}
+
+		ret.advance += advance;
+		matr.translate(advance, 0);
+	}
+
+	ret.advance *= this->scale;
+
+	return ret;
+}
+
+void sdf_font::get_memory_usage(size_t& cpu, size_t& gpu)const{
+	std::shared_ptr<texture_2d> unknown_tex;
+	{
+		auto i = this->glyphs->glyphs.find(unknownChar_c);
+		if(i != this->glyphs->glyphs.end()){
+			unknown_tex = i->second.tex;
+		}
+	}
+
+	// glyph textures are only accessed from UI thread, no need to lock
+	for(auto& g : this->glyphs->glyphs){
+		// missing glyphs share the unknown glyph texture
+		if(!g.second.tex || (g.first != unknownChar_c && g.second.tex == unknown_tex)){
+			continue;
+		}
+		gpu += estimate_gpu_memory_usage(*g.second.tex);
+	}
+
+	cpu += this->glyphs->font_file.size();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+
+#include <papki/file.hpp>
+
+#include "../config.hpp"
+
+#include "font.hpp"
+
+
+namespace morda{
+/**
+ * @brief Signed distance field font.
+ * This font implementation reads a Truetype font from 'ttf' file and rasterizes the glyphs
+ * once, at fixed base size, into signed distance field textures. The glyphs are rendered
+ * with the signed distance field shader of the renderer (render_factory::shaders::color_pos_sdf),
+ * which keeps the glyph edges sharp at any scale. So, fonts of all sizes created from the same
+ * SDF font share the same set of glyphs, and text can be smoothly scaled without re-rasterizing.
+ */
+class sdf_font : public font{
+public:
+	/**
+	 * @brief Size of the font in pixels at which the glyphs are rasterized.
+	 */
+	constexpr static const unsigned base_size = 48;
+
+	/**
+	 * @brief Distance field spread, in pixels of the base size.
+	 * The distance field covers this distance to both sides of the glyph edge.
+	 */
+	constexpr static const unsigned spread = 6;
+
+private:
+	struct glyph_set;
+
+	// glyphs shared by the fonts of different sizes
+	const std::shared_ptr<glyph_set> glyphs;
+
+	// font size to base size ratio
+	const real scale;
+
+	sdf_font(std::shared_ptr<morda::context> c, std::shared_ptr<glyph_set> glyphs, real size);
+public:
+	/**
+	 * @brief Constructor.
+	 * @param c - context to which this font belongs.
+	 * @param fi - file interface to read Truetype font from, i.e. 'ttf' file.
+	 * @param size - size of the font in pixels.
+	 */
+	sdf_font(std::shared_ptr<morda::context> c, const papki::file& fi, real size);
+
+	/**
+	 * @brief Create font of another size.
+	 * The created font shares the glyphs with this one, so nothing is rasterized.
+	 * @param size - size of the font in pixels.
+	 * @return font of the requested size.
+	 */
+	std::unique_ptr<sdf_font> resize(real size)const;
+
+	~sdf_font()noexcept;
+
+	/**
+	 * @brief Get font size.
+	 * @return size of the font in pixels.
+	 */
+	real get_size()const noexcept{
+		return this->scale * real(base_size);
+	}
+
+	real get_advance(char32_t c, size_t tab_size)const override;
+
+	std::vector<real> get_char_offsets(const std::u32string& str, size_t tab_size)const override;
+
+	/**
+	 * @brief Get memory used by the glyphs.
+	 * The glyphs are shared with the fonts of other sizes created from this one.
+	 * @param cpu - main memory used by the font file is added to this, in bytes.
+	 * @param gpu - estimated memory used by the glyph textures is added to this, in bytes.
+	 */
+	void get_memory_usage(size_t& cpu, size_t& gpu)const;
+
+protected:
+	render_result render_internal(
+			const morda::matrix4& matrix,
+			r4::vector4<float> color,
+			const std::u32string_view str,
+			size_t tab_size,
+			size_t offset
+		)const override;
+
+	real get_advance_internal(const std::u32string& str, size_t tab_size)const override;
+
+	morda::rectangle get_bounding_box_internal(const std::u32string& str, size_t tab_size)const override;
+};
+}
@@ -0,0 +1,92 @@
+#include "text_shaper.hxx"
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+text_shaper::text_shaper(FT_Face face, size_t max_cached_runs) :
+		face(face),
+		has_kerning(FT_HAS_KERNING(face)),
+		max_cached_runs(max_cached_runs)
+{}
+
+FT_UInt text_shaper::get_glyph_index(char32_t c){
+	auto i = this->glyph_indices.find(c);
+	if(i != this->glyph_indices.end()){
+		return i->second;
+	}
+	return this->glyph_indices.insert(std::make_pair(c, FT_Get_Char_Index(this->face, FT_ULong(c)))).first->second;
+}
+
+std::vector<real> text_shaper::shape_uncached(std::u32string_view str){
+	std::vector<real> ret(str.size(), 0);
+
+	bool is_kerned = false;
+
+	FT_UInt prev = 0;
+	for(size_t i = 0; i != str.size(); ++i){
+		if(str[i] == U'\t'){
+			prev = 0;
+			continue;
+		}
+
+		auto cur = this->get_glyph_index(str[i]);
+
+		if(prev != 0 && cur != 0){
+			FT_Vector delta;
+			if(FT_Get_Kerning(this->face, prev, cur, FT_KERNING_DEFAULT, &delta) == 0 && delta.x != 0){
+				ret[i] = real(delta.x) / 64.0f;
+				is_kerned = true;
+			}
+		}
+
+		prev = cur;
+	}
+
+	if(!is_kerned){
+		ret.clear();
+	}
+
+	return ret;
+}
+
+std::shared_ptr<const std::vector<real>> text_shaper::shape(std::u32string_view str){
+	if(!this->has_kerning || str.size() < 2){
+		return nullptr;
+	}
+
+	auto i = this->run_index.find(str);
+	if(i != this->run_index.end()){
+		++this->counters.num_hits;
+		this->runs.splice(this->runs.begin(), this->runs, i->second);
+		return i->second->kerning;
+	}
+
+	++this->counters.num_misses;
+
+	std::shared_ptr<const std::vector<real>> kerning;
+	{
+		auto k = this->shape_uncached(str);
+		if(!k.empty()){
+			kerning = std::make_shared<const std::vector<real>>(std::move(k));
+		}
+	}
+
+	if(this->max_cached_runs == 0){
+		return kerning;
+	}
+
+	if(this->runs.size() == this->max_cached_runs){
+		ASSERT(!this->runs.empty())
+		this->run_index.erase(this->runs.back().str);
+		this->runs.pop_back();
+	}
+
+	this->runs.push_front(run_entry{std::u32string(str), std::move(kerning)});
+
+	// list elements are not moved, so the view of the string stays valid while the element is in the list
+	auto r = this->run_index.insert(std::make_pair(std::u32string_view(this->runs.front().str), this->runs.begin()));
+	ASSERT(r.second)
+
+	return this->runs.front().kerning;
+}
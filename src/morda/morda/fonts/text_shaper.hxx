@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "../config.hpp"
+
+namespace morda{
+
+/**
+ * @brief Text shaper with shaped run cache.
+ * Shapes strings of text with the font's kerning. Shaped runs are kept in a bounded LRU cache,
+ * so that strings rendered every frame are shaped only once.
+ * Character to glyph index mapping is cached as well.
+ *
+ * The shaping is limited to pair kerning from the font's kern table, one glyph per character.
+ * Complex script shaping, i.e. contextual forms of Arabic, Indic reordering and conjuncts, ligatures and
+ * mark positioning from GSUB/GPOS tables, is not done, as it needs a shaping engine like HarfBuzz,
+ * which is not a dependency of morda. Text in such scripts is rendered with isolated forms of the characters.
+ *
+ * The shaper uses the FreeType face of the font, it is not thread safe. The font should guard
+ * the shaper along with the face.
+ */
+class text_shaper{
+	FT_Face face;
+
+	const bool has_kerning;
+
+	const size_t max_cached_runs;
+
+	std::unordered_map<char32_t, FT_UInt> glyph_indices;
+
+	struct run_entry{
+		std::u32string str;
+		std::shared_ptr<const std::vector<real>> kerning;
+	};
+
+	// most recently used first
+	std::list<run_entry> runs;
+
+	// keys are views of the strings owned by the run entries, so that the strings are looked up without copying
+	std::unordered_map<std::u32string_view, decltype(runs)::iterator> run_index;
+
+	FT_UInt get_glyph_index(char32_t c);
+
+	std::vector<real> shape_uncached(std::u32string_view str);
+
+public:
+	/**
+	 * @brief Shaped run cache statistics.
+	 */
+	struct cache_counters{
+		size_t num_hits = 0;
+		size_t num_misses = 0;
+	};
+
+private:
+	cache_counters counters;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param face - FreeType face of the font, with the font size set.
+	 * @param max_cached_runs - maximum number of shaped runs to cache.
+	 */
+	text_shaper(FT_Face face, size_t max_cached_runs = 256);
+
+	text_shaper(const text_shaper&) = delete;
+	text_shaper& operator=(const text_shaper&) = delete;
+
+	/**
+	 * @brief Shape string of text.
+	 * @param str - string of text to shape.
+	 * @return kerning of each character, i.e. the pen position adjustment before the character, in pixels of the face size.
+	 *         Tab characters are not kerned.
+	 * @return nullptr in case the string needs no kerning, e.g. when the font has no kerning information.
+	 */
+	std::shared_ptr<const std::vector<real>> shape(std::u32string_view str);
+
+	/**
+	 * @brief Get shaped run cache statistics.
+	 * @return cache statistics.
+	 */
+	const cache_counters& get_cache_counters()const noexcept{
+		return this->counters;
+	}
+
+	/**
+	 * @brief Get number of cached shaped runs.
+	 * @return number of cached shaped runs.
+	 */
+	size_t get_num_cached_runs()const noexcept{
+		return this->runs.size();
+	}
+};
+
+}
@@ -1,8 +1,10 @@
 #include <algorithm>
+#include <iomanip>
 
 #include <utki/debug.hpp>
 
 #include "../util/raster_image.hpp"
+#include "../util/pixel_kernels.hpp"
 #include "../util/util.hpp"
 
 #include "texture_font.hxx"
@@ -25,8 +27,16 @@ texture_font::FreeTypeLibWrapper::~FreeTypeLibWrapper()noexcept{
 }
 
 texture_font::FreeTypeFaceWrapper::FreeTypeFaceWrapper(FT_Library& lib, const papki::file& fi) {
-	this->fontFile = fi.load();
-	if (FT_New_Memory_Face(lib, & * this->fontFile.begin(), int(this->fontFile.size()), 0/* face_index */, &this->f) != 0) {
+	utki::span<const std::uint8_t> data;
+	if(auto rf = dynamic_cast<const res_pack::file*>(&fi)){
+		data = rf->data();
+		this->pack = rf->get_pack();
+	}else{
+		this->fontFile = fi.load();
+		data = utki::make_span(this->fontFile);
+	}
+	this->data = data;
+	if (FT_New_Memory_Face(lib, data.data(), FT_Long(data.size()), 0/* face_index */, &this->f) != 0) {
 		throw std::runtime_error("FreeTypeFaceWrapper::FreeTypeFaceWrapper(): unable to crate font face object");
 	}
 }
@@ -35,40 +45,131 @@ texture_font::FreeTypeFaceWrapper::~FreeTypeFaceWrapper()noexcept{
 	FT_Done_Face(this->f);
 }
 
-texture_font::Glyph texture_font::loadGlyph(char32_t c)const{
+texture_font::glyph_bitmap texture_font::rasterize(char32_t c)const{
+	glyph_bitmap ret;
+
 	if(FT_Load_Char(this->face.f, FT_ULong(c), FT_LOAD_RENDER) != 0){
 		if(c == unknownChar_c){
-			throw std::runtime_error("texture_font::loadGlyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
+			throw std::runtime_error("texture_font::rasterize(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
 		}
-		TRACE(<< "texture_font::loadGlyph(" << std::hex << uint32_t(c) << "): failed to load glyph" << std::endl)
-		return this->unknownGlyph;
+		TRACE(<< "texture_font::rasterize(" << std::hex << uint32_t(c) << "): failed to load glyph" << std::endl)
+		ret.is_missing = true;
+		ret.metrics = this->get_bitmap(unknownChar_c)->metrics;
+		ret.dims.set(0);
+		return ret;
 	}
 	
 	FT_GlyphSlot slot = this->face.f->glyph;
 	
 	FT_Glyph_Metrics *m = &slot->metrics;
 	
-	Glyph g;
-	g.advance = real(m->horiAdvance) / (64.0f);
+	ret.metrics.advance = real(m->horiAdvance) / (64.0f);
 	
 	if(!slot->bitmap.buffer){
+		// empty glyph (space)
+		ret.metrics.top_left.set(0);
+		ret.metrics.bottom_right.set(0);
+		ret.dims.set(0);
+		return ret;
+	}
+
+	ret.metrics.top_left = morda::vector2(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f);
+	ret.metrics.bottom_right = morda::vector2(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f);
+
+	ret.dims = r4::vector2<unsigned>(slot->bitmap.width, slot->bitmap.rows);
+	ret.own_alpha.resize(size_t(ret.dims.x()) * size_t(ret.dims.y()));
+	for(unsigned y = 0; y != ret.dims.y(); ++y){
+		std::copy_n(
+				slot->bitmap.buffer + std::ptrdiff_t(y) * slot->bitmap.pitch,
+				ret.dims.x(),
+				ret.own_alpha.begin() + std::ptrdiff_t(y) * std::ptrdiff_t(ret.dims.x())
+			);
+	}
+	ret.alpha = utki::make_span(ret.own_alpha);
+
+	return ret;
+}
+
+std::shared_ptr<const texture_font::glyph_bitmap> texture_font::get_bitmap(char32_t c)const{
+	auto i = this->bitmaps.find(c);
+	if(i != this->bitmaps.end()){
+		this->bitmaps_last_used_order.splice(
+				this->bitmaps_last_used_order.begin(),
+				this->bitmaps_last_used_order,
+				i->second.last_used_iter
+			);
+		return i->second.bitmap;
+	}
+
+	std::shared_ptr<glyph_bitmap> b;
+
+	for(auto dc = this->disk_caches.rbegin(); dc != this->disk_caches.rend(); ++dc){
+		if(auto g = (*dc)->find(c)){
+			b = std::make_shared<glyph_bitmap>();
+			b->metrics.top_left = g->top_left;
+			b->metrics.bottom_right = g->bottom_right;
+			b->metrics.advance = g->advance;
+			b->is_missing = g->is_missing;
+			b->dims = g->dims;
+			b->alpha = g->alpha;
+			break;
+		}
+	}
+
+	if(!b){
+		// the vector buffer is moved along with the bitmap, so the alpha span stays valid
+		b = std::make_shared<glyph_bitmap>(this->rasterize(c));
+	}
+
+	this->bitmaps_last_used_order.push_front(c);
+
+	cached_bitmap cb;
+	cb.bitmap = b;
+	cb.last_used_iter = this->bitmaps_last_used_order.begin();
+	this->bitmaps.insert(std::make_pair(c, std::move(cb)));
+
+	while(this->bitmaps_last_used_order.size() > std::max(this->maxCached, 1u)){
+		this->bitmaps.erase(this->bitmaps_last_used_order.back());
+		this->bitmaps_last_used_order.pop_back();
+	}
+
+	return b;
+}
+
+texture_font::Glyph texture_font::upload_glyph(const glyph_bitmap& b)const{
+	if(b.is_missing){
+		return this->unknownGlyph;
+	}
+
+	Glyph g;
+	g.advance = b.metrics.advance;
+
+	if(b.alpha.empty()){
 		g.topLeft.set(0);
 		g.bottomRight.set(0);
 		// empty glyph (space)
 		return g;
 	}
 	
-	raster_image glyphim(r4::vector2<unsigned>(slot->bitmap.width, slot->bitmap.rows), raster_image::color_depth::grey, slot->bitmap.buffer);
-
-	raster_image im(glyphim.dims(), raster_image::color_depth::grey_alpha);
-	im.blit({0, 0}, glyphim, 1, 0);
-	im.clear(0, std::uint8_t(0xff));
+	// glyph bitmap is used as alpha channel of white image
+	raster_image im(b.dims, raster_image::color_depth::grey_alpha);
+	for(unsigned y = 0; y != im.dims().y(); ++y){
+		pixel_kernels::alpha_to_grey_alpha(
+				&im.pix_chan(0, y, 0),
+				b.alpha.data() + std::ptrdiff_t(y) * std::ptrdiff_t(b.dims.x()),
+				im.dims().x(),
+				0xff
+			);
+	}
 	
+	const auto& tl = b.metrics.top_left;
+	const auto& br = b.metrics.bottom_right;
+
 	std::array<r4::vector2<float>, 4> verts;
-	verts[0] = (morda::vector2(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f));
-	verts[1] = (morda::vector2(real(m->horiBearingX), real(m->height - m->horiBearingY)) / (64.0f));
-	verts[2] = (morda::vector2(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f));
-	verts[3] = (morda::vector2(real(m->horiBearingX + m->width), -real(m->horiBearingY)) / (64.0f));
+	verts[0] = tl;
+	verts[1] = morda::vector2(tl.x(), br.y());
+	verts[2] = br;
+	verts[3] = morda::vector2(br.x(), tl.y());
 
 	g.topLeft = verts[0];
 	g.bottomRight = verts[2];
@@ -94,7 +195,9 @@ texture_font::Glyph texture_font::loadGlyph(char32_t c)const{
 texture_font::texture_font(std::shared_ptr<morda::context> c, const papki::file& fi, unsigned fontSize, unsigned maxCached) :
 		font(std::move(c)),
 		maxCached(maxCached),
-		face(freetype.lib, fi)
+		pixel_size(fontSize),
+		face(freetype.lib, fi),
+		shaper(face.f)
 {
 //	TRACE(<< "texture_font::Load(): enter" << std::endl)
 
@@ -111,7 +214,7 @@ texture_font::texture_font(std::shared_ptr<morda::context> c, const papki::file&
 		}
 	}
 	
-	this->unknownGlyph = this->loadGlyph(unknownChar_c);
+	this->unknownGlyph = this->upload_glyph(*this->get_bitmap(unknownChar_c));
 
 //	TRACE(<< "texture_font::Load(): entering for loop" << std::endl)
 	
@@ -124,10 +227,52 @@ texture_font::texture_font(std::shared_ptr<morda::context> c, const papki::file&
 //	TRACE(<< "texture_font::texture_font(): height_v = " << this->height_v << std::endl)
 }
 
+const texture_font::glyph_metrics& texture_font::get_metrics(char32_t c)const{
+	auto i = this->metrics.find(c);
+	if(i != this->metrics.end()){
+		return i->second;
+	}
+
+	glyph_metrics gm;
+
+	bool is_cached = this->bitmaps.find(c) != this->bitmaps.end();
+	for(auto dc = this->disk_caches.rbegin(); !is_cached && dc != this->disk_caches.rend(); ++dc){
+		is_cached = (*dc)->find(c) != nullptr;
+	}
+
+	if(is_cached){
+		// the bitmap is already rasterized or is in disk cache, no need to load the glyph
+		gm = this->get_bitmap(c)->metrics;
+	}else if(FT_Load_Char(this->face.f, FT_ULong(c), FT_LOAD_DEFAULT) != 0){
+		gm.top_left = this->unknownGlyph.topLeft;
+		gm.bottom_right = this->unknownGlyph.bottomRight;
+		gm.advance = this->unknownGlyph.advance;
+	}else{
+		FT_Glyph_Metrics *m = &this->face.f->glyph->metrics;
+		gm.advance = real(m->horiAdvance) / (64.0f);
+		if(m->width == 0 || m->height == 0){
+			// empty glyph (space)
+			gm.top_left.set(0);
+			gm.bottom_right.set(0);
+		}else{
+			gm.top_left = morda::vector2(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f);
+			gm.bottom_right = morda::vector2(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f);
+		}
+	}
+
+	return this->metrics.insert(std::make_pair(c, gm)).first->second;
+}
+
 const texture_font::Glyph& texture_font::getGlyph(char32_t c)const{
 	auto i = this->glyphs.find(c);
 	if(i == this->glyphs.end()){
-		auto r = this->glyphs.insert(std::make_pair(c, this->loadGlyph(c)));
+		auto b = [this, c](){
+			std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+			return this->get_bitmap(c);
+		}();
+
+		// bitmaps are never modified after they are created, so it is safe to use it without locking
+		auto r = this->glyphs.insert(std::make_pair(c, this->upload_glyph(*b)));
 		ASSERT(r.second)
 		i = r.first;
 		this->lastUsedOrder.push_front(c);
@@ -162,22 +307,62 @@ real texture_font::renderGlyphInternal(const morda::matrix4& matrix, r4::vector4
 
 real texture_font::get_advance_internal(const std::u32string& str, size_t tab_size)const{
 	real ret = 0;
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
 	
-	real space_advance = this->getGlyph(U' ').advance;
+	real space_advance = this->get_metrics(U' ').advance;
 
 	for(auto s = str.begin(); s != str.end(); ++s){
 		try{
 			if(*s == U'\t'){
 				ret += space_advance * tab_size;
 			}else{
-				const Glyph& g = this->getGlyph(*s);
-				ret += g.advance;
+				ret += this->get_metrics(*s).advance;
 			}
 		}catch(std::out_of_range&){
 			// ignore
 		}
 	}
 
+	if(auto kerning = this->shaper.shape(str)){
+		for(auto k : *kerning){
+			ret += k;
+		}
+	}
+
+	return ret;
+}
+
+std::vector<real> texture_font::get_char_offsets(const std::u32string& str, size_t tab_size)const{
+	std::vector<real> ret;
+	ret.reserve(str.size() + 1);
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	real space_advance = this->get_metrics(U' ').advance;
+
+	auto kerning = this->shaper.shape(str);
+
+	real a = 0;
+	for(size_t i = 0; i != str.size(); ++i){
+		// kerning moves the pen before the character
+		if(kerning){
+			a += (*kerning)[i];
+		}
+		ret.push_back(a);
+
+		try{
+			if(str[i] == U'\t'){
+				a += space_advance * tab_size;
+			}else{
+				a += this->get_metrics(str[i]).advance;
+			}
+		}catch(std::out_of_range&){
+			// no glyph, zero advance
+		}
+	}
+	ret.push_back(a);
+
 	return ret;
 }
 
@@ -195,33 +380,41 @@ morda::rectangle texture_font::get_bounding_box_internal(const std::u32string& s
 
 	real curAdvance;
 
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
 	real left, right, top, bottom;
 	// init with bounding box of the first glyph
 	{
-		const Glyph& g = this->getGlyph(*s);
-		left = g.topLeft.x();
-		right = g.bottomRight.x();
-		top = g.topLeft.y();
-		bottom = g.bottomRight.y();
+		const auto& g = this->get_metrics(*s);
+		left = g.top_left.x();
+		right = g.bottom_right.x();
+		top = g.top_left.y();
+		bottom = g.bottom_right.y();
 		curAdvance = g.advance;
 		++s;
 	}
 
-	real space_advance = this->getGlyph(U' ').advance;
+	real space_advance = this->get_metrics(U' ').advance;
+
+	auto kerning = this->shaper.shape(str);
 
 	for(; s != str.end(); ++s){
+		if(kerning){
+			curAdvance += (*kerning)[s - str.begin()];
+		}
+
 		if(*s == U'\t'){
 			curAdvance += space_advance * tab_size;
 		}else{
-			const Glyph& g = this->getGlyph(*s);
+			const auto& g = this->get_metrics(*s);
 
 			using std::min;
 			using std::max;
 			
-			top = min(g.topLeft.y(), top);
-			bottom = max(g.bottomRight.y(), bottom);
-			left = min(curAdvance + g.topLeft.x(), left);
-			right = max(curAdvance + g.bottomRight.x(), right);
+			top = min(g.top_left.y(), top);
+			bottom = max(g.bottom_right.y(), bottom);
+			left = min(curAdvance + g.top_left.x(), left);
+			right = max(curAdvance + g.bottom_right.x(), right);
 
 			curAdvance += g.advance;
 		}
@@ -258,9 +451,20 @@ font::render_result texture_font::render_internal(
 
 	real space_advance = this->getGlyph(U' ').advance;
 
+	auto kerning = [this, &str](){
+		std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+		return this->shaper.shape(str);
+	}();
+
 	size_t cur_offset = offset;
 
 	for(auto s = str.begin(); s != str.end(); ++s){
+		if(kerning){
+			auto k = (*kerning)[s - str.begin()];
+			ret.advance += k;
+			matr.translate(k, 0);
+		}
+
 		try{
 			real advance;
 			
@@ -291,10 +495,172 @@ font::render_result texture_font::render_internal(
 }
 
 real texture_font::get_advance(char32_t c, size_t tab_size)const{
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
 	if(c == U'\t'){
-		return this->getGlyph(U' ').advance * tab_size;
+		return this->get_metrics(U' ').advance * tab_size;
 	}else{
-		auto& g = this->getGlyph(c);
-		return g.advance;
+		return this->get_metrics(c).advance;
+	}
+}
+
+texture_font::~texture_font()noexcept{
+	this->quit_prewarm_thread.store(true);
+	if(this->prewarm_thread.joinable()){
+		this->prewarm_thread.join();
+	}
+}
+
+void texture_font::prewarm(char32_t first, char32_t last)const{
+	if(first > last){
+		return;
+	}
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	this->prewarm_queue.push_back(std::make_pair(first, last));
+
+	if(this->is_prewarm_thread_running){
+		return;
+	}
+
+	// the thread has finished its work, it does not lock the mutex after it has reset the running flag
+	if(this->prewarm_thread.joinable()){
+		this->prewarm_thread.join();
+	}
+
+	this->prewarm_thread = std::thread([this](){
+		this->prewarm_thread_func();
+	});
+	this->is_prewarm_thread_running = true;
+}
+
+void texture_font::prewarm_thread_func()const{
+	for(;;){
+		std::pair<char32_t, char32_t> range;
+		{
+			std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+			if(this->prewarm_queue.empty() || this->quit_prewarm_thread.load()){
+				this->is_prewarm_thread_running = false;
+				return;
+			}
+			range = this->prewarm_queue.front();
+			this->prewarm_queue.pop_front();
+		}
+
+		for(char32_t c = range.first;; ++c){
+			if(this->quit_prewarm_thread.load()){
+				break;
+			}
+
+			// lock the mutex for each glyph separately to let the UI thread load glyphs meanwhile
+			try{
+				std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+				this->get_bitmap(c);
+			}catch(std::exception& e){
+				TRACE(<< "texture_font::prewarm_thread_func(): could not rasterize glyph " << uint32_t(c) << ": " << e.what() << std::endl)
+			}
+
+			if(c == range.second){
+				break;
+			}
+		}
+	}
+}
+
+std::string texture_font::get_glyph_cache_name()const{
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	if(!this->is_font_hash_valid){
+		this->font_hash = glyph_cache_file::hash(this->face.data);
+		this->is_font_hash_valid = true;
+	}
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << this->font_hash << std::dec << "_" << this->pixel_size << ".glyphs";
+	return ss.str();
+}
+
+bool texture_font::load_glyph_cache(const std::string& path)const{
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	if(!this->is_font_hash_valid){
+		this->font_hash = glyph_cache_file::hash(this->face.data);
+		this->is_font_hash_valid = true;
+	}
+
+	try{
+		this->disk_caches.push_back(std::make_unique<glyph_cache_file>(path, this->font_hash, this->pixel_size));
+	}catch(std::runtime_error& e){
+		TRACE(<< "texture_font::load_glyph_cache(): glyph cache not loaded: " << e.what() << std::endl)
+		return false;
+	}
+	return true;
+}
+
+void texture_font::save_glyph_cache(const papki::file& dst)const{
+	std::vector<glyph_cache_file::glyph> glyphs;
+	std::uint64_t hash;
+
+	// the bitmaps can be removed from the cache after unlocking the mutex, so those are held while writing
+	std::vector<std::shared_ptr<const glyph_bitmap>> bitmaps;
+
+	{
+		std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+		if(!this->is_font_hash_valid){
+			this->font_hash = glyph_cache_file::hash(this->face.data);
+			this->is_font_hash_valid = true;
+		}
+		hash = this->font_hash;
+
+		// the bitmaps are held and disk caches are never unloaded, so the alpha spans
+		// stay valid after unlocking the mutex
+		bitmaps.reserve(this->bitmaps.size());
+		for(auto& cb : this->bitmaps){
+			auto& b = *cb.second.bitmap;
+			glyph_cache_file::glyph g;
+			g.c = cb.first;
+			g.is_missing = b.is_missing;
+			g.top_left = b.metrics.top_left;
+			g.bottom_right = b.metrics.bottom_right;
+			g.advance = b.metrics.advance;
+			g.dims = b.dims;
+			g.alpha = b.alpha;
+			glyphs.push_back(g);
+			bitmaps.push_back(cb.second.bitmap);
+		}
+
+		// the latest loaded disk cache goes first, as it takes precedence
+		for(auto dc = this->disk_caches.rbegin(); dc != this->disk_caches.rend(); ++dc){
+			for(auto& g : (*dc)->get_glyphs()){
+				if(this->bitmaps.find(g.c) == this->bitmaps.end()){
+					glyphs.push_back(g);
+				}
+			}
+		}
+	}
+
+	// glyph_cache_file::write() keeps the first one of duplicate glyphs, i.e. the ones found in several disk caches
+	glyph_cache_file::write(dst, hash, this->pixel_size, utki::make_span(glyphs));
+}
+
+void texture_font::get_memory_usage(size_t& cpu, size_t& gpu)const{
+	// glyph textures are only accessed from UI thread, no need to lock
+	for(auto& g : this->glyphs){
+		// missing glyphs share the unknown glyph texture
+		if(!g.second.tex || g.second.tex == this->unknownGlyph.tex){
+			continue;
+		}
+		gpu += estimate_gpu_memory_usage(*g.second.tex);
+	}
+	if(this->unknownGlyph.tex){
+		gpu += estimate_gpu_memory_usage(*this->unknownGlyph.tex);
+	}
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	cpu += this->face.fontFile.size();
+	for(auto& b : this->bitmaps){
+		cpu += b.second.bitmap->own_alpha.size();
 	}
 }
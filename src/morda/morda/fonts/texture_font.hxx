@@ -4,6 +4,10 @@
 #include <sstream>
 #include <stdexcept>
 #include <list>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -18,7 +22,11 @@
 #include "../render/texture_2d.hpp"
 #include "../render/vertex_array.hpp"
 
+#include "../util/res_pack.hpp"
+
 #include "font.hpp"
+#include "glyph_cache_file.hpp"
+#include "text_shaper.hxx"
 
 
 namespace morda{
@@ -45,10 +53,58 @@ class texture_font : public font{
 	};
 	
 	mutable std::unordered_map<char32_t, Glyph> glyphs;
+
+	struct glyph_metrics{
+		morda::vector2 top_left;
+		morda::vector2 bottom_right;
+		real advance;
+	};
+
+	// Glyph metrics are cached separately from the glyph textures, so that text can be measured
+	// from any thread, for example during parallel layout. The metrics are never evicted from the cache.
+	mutable std::unordered_map<char32_t, glyph_metrics> metrics;
+
+	struct glyph_bitmap{
+		glyph_metrics metrics;
+
+		// the font has no glyph for the character
+		bool is_missing = false;
+
+		r4::vector2<unsigned> dims;
+
+		// in case the bitmap is loaded from disk cache, the alpha values are used right from the cache file
+		std::vector<std::uint8_t> own_alpha;
+		utki::span<const std::uint8_t> alpha;
+	};
+
+	// Rasterized glyph bitmaps. The bitmaps are kept after uploading to textures, so that glyphs evicted from
+	// the texture cache are uploaded again without rasterizing, and so that the bitmaps can be saved to disk cache.
+	// The number of cached bitmaps is limited by the same number as the glyph textures, the least recently
+	// used ones are removed. The bitmaps are held by shared pointers, so those can be used after unlocking the mutex.
+	struct cached_bitmap{
+		std::shared_ptr<const glyph_bitmap> bitmap;
+		std::list<char32_t>::iterator last_used_iter;
+	};
+	mutable std::list<char32_t> bitmaps_last_used_order;
+	mutable std::unordered_map<char32_t, cached_bitmap> bitmaps;
+
+	mutable std::vector<std::unique_ptr<glyph_cache_file>> disk_caches;
+
+	// guards the metrics cache, the bitmaps cache, the disk caches, the pre-warm queue, the freetype face and the shaper
+	mutable std::mutex mutex;
 	
 	
 	unsigned maxCached;
 
+	unsigned pixel_size;
+
+	mutable std::deque<std::pair<char32_t, char32_t>> prewarm_queue;
+	mutable bool is_prewarm_thread_running = false;
+	mutable std::thread prewarm_thread;
+	std::atomic<bool> quit_prewarm_thread{false};
+
+	void prewarm_thread_func()const;
+
 	struct FreeTypeLibWrapper{
 		FT_Library lib;
 
@@ -60,26 +116,94 @@ class texture_font : public font{
 
 	struct FreeTypeFaceWrapper{
 		FT_Face f;
-		std::vector<std::uint8_t> fontFile;//the buffer should be alive as long as the Face is alive!!!
+
+		// the font data should be alive as long as the Face is alive!!!
+		std::vector<std::uint8_t> fontFile;
+		// in case the font is loaded from resource pack archive, the font data is used right from the archive
+		std::shared_ptr<const res_pack> pack;
+
+		utki::span<const std::uint8_t> data;
 
 		FreeTypeFaceWrapper(FT_Library& lib, const papki::file& fi);
 		~FreeTypeFaceWrapper()noexcept;
 	} face;
+
+	// guarded by the mutex, as it uses the freetype face
+	mutable text_shaper shaper;
 	
+	mutable std::uint64_t font_hash = 0;
+	mutable bool is_font_hash_valid = false;
+
 	Glyph unknownGlyph;
 	
-	Glyph loadGlyph(char32_t c)const;
+	Glyph upload_glyph(const glyph_bitmap& b)const;
+
+	// the mutex must be locked when calling this function
+	std::shared_ptr<const glyph_bitmap> get_bitmap(char32_t c)const;
+
+	// the mutex must be locked when calling this function
+	glyph_bitmap rasterize(char32_t c)const;
+
+	// the mutex must be locked when calling this function
+	const glyph_metrics& get_metrics(char32_t c)const;
 public:
 	/**
 	 * @brief Constructor.
 	 * @param c - context to which this font belongs.
 	 * @param fi - file interface to read Truetype font from, i.e. 'ttf' file.
 	 * @param fontSize - size of the font in pixels.
-	 * @param maxCached - maximum number of glyphs to cache.
+	 * @param maxCached - maximum number of glyphs to cache. The same limit applies to the glyph textures
+	 *                    and to the rasterized glyph bitmaps.
 	 */
 	texture_font(std::shared_ptr<morda::context> c, const papki::file& fi, unsigned fontSize, unsigned maxCached);
 
+	~texture_font()noexcept;
+
 	real get_advance(char32_t c, size_t tab_size)const override;
+
+	std::vector<real> get_char_offsets(const std::u32string& str, size_t tab_size)const override;
+
+	/**
+	 * @brief Rasterize glyphs in background.
+	 * The glyphs are rasterized by a background thread, so that later the glyphs
+	 * are only uploaded to textures when they are first rendered.
+	 * Since the number of cached glyph bitmaps is limited, only the last rasterized glyphs are kept in case
+	 * the range is bigger than the limit.
+	 * @param first - first character of the range.
+	 * @param last - last character of the range, inclusive.
+	 */
+	void prewarm(char32_t first, char32_t last)const override;
+
+	/**
+	 * @brief Get glyph cache file name.
+	 * The name is made of the font file hash and the font size, so that
+	 * the cache files for different fonts can be kept in the same directory.
+	 * @return file name of the glyph cache for this font.
+	 */
+	std::string get_glyph_cache_name()const;
+
+	/**
+	 * @brief Load glyph cache file.
+	 * The cache file is memory mapped. Glyphs found in the cache are not rasterized.
+	 * @param path - path to the cache file in the file system.
+	 * @return true in case the cache file was loaded.
+	 * @return false in case the cache file could not be opened or is made for a different font.
+	 */
+	bool load_glyph_cache(const std::string& path)const;
+
+	/**
+	 * @brief Save glyph cache file.
+	 * Saves the glyph bitmaps which are currently cached, along with all the glyphs of the loaded glyph cache files.
+	 * @param dst - file to save the cache to.
+	 */
+	void save_glyph_cache(const papki::file& dst)const;
+
+	/**
+	 * @brief Get memory used by the font.
+	 * @param cpu - main memory used by the font file and glyph bitmaps is added to this, in bytes.
+	 * @param gpu - estimated memory used by the cached glyph textures is added to this, in bytes.
+	 */
+	void get_memory_usage(size_t& cpu, size_t& gpu)const;
 	
 protected:
 	render_result render_internal(
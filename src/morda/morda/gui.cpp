@@ -17,9 +17,11 @@
 #include "widgets/label/busy.hpp"
 #include "widgets/label/color.hpp"
 #include "widgets/label/text.hpp"
+#include "widgets/label/multiline_text.hpp"
 #include "widgets/label/gradient.hpp"
 #include "widgets/label/image_mouse_cursor.hpp"
 #include "widgets/label/spinner.hpp"
+#include "widgets/label/tiled_image.hpp"
 
 #include "widgets/input/text_input_line.hpp"
 
@@ -209,6 +211,7 @@ void gui::initStandardWidgets(papki::file& fi) {
 		paths.push_back(fi.path());
 	}
 
+	paths.push_back("morda_res.respack");
 	paths.push_back("morda_res/");
 
 #if (M_OS == M_OS_LINUX && M_OS_NAME != M_OS_NAME_ANDROID) || \
@@ -253,9 +256,11 @@ void gui::initStandardWidgets(papki::file& fi) {
 	// add standard widgets to inflater
 
 	this->context->inflater.register_widget<text>("text");
+	this->context->inflater.register_widget<multiline_text>("multiline_text");
 	this->context->inflater.register_widget<color>("color");
 	this->context->inflater.register_widget<gradient>("gradient");
 	this->context->inflater.register_widget<image>("image");
+	this->context->inflater.register_widget<tiled_image>("tiled_image");
 	this->context->inflater.register_widget<vertical_scroll_bar>("vertical_scroll_bar");
 	this->context->inflater.register_widget<horizontal_scroll_bar>("horizontal_scroll_bar");
 	this->context->inflater.register_widget<window>("window");
@@ -329,18 +334,117 @@ void gui::render(const matrix4& matrix)const{
 	this->root_widget->renderInternal(m);
 }
 
+void gui::set_input_queueing(bool enable){
+	this->input_queueing = enable;
+
+	if(!enable){
+		this->process_input();
+	}
+}
+
+void gui::process_input(){
+	if(this->input_queue.empty()){
+		return;
+	}
+
+	// events sent by event handlers go to the next frame
+	decltype(this->input_queue) events;
+	std::swap(events, this->input_queue);
+
+	std::vector<vector2> history;
+
+	for(auto& e : events){
+		switch(e.kind){
+			case input_event::type::mouse_move:
+				history.clear();
+				for(auto& p : e.history){
+					history.push_back(p - e.pos);
+				}
+				this->dispatch_mouse_move(e.pos, e.id, utki::make_span(history));
+				break;
+			case input_event::type::mouse_button:
+				this->dispatch_mouse_button(e.is_down, e.pos, e.button, e.id);
+				break;
+			case input_event::type::mouse_hover:
+				this->dispatch_mouse_hover(e.is_down, e.id);
+				break;
+			case input_event::type::key:
+				this->dispatch_key(e.is_down, e.key_code);
+				break;
+			case input_event::type::character_input:
+				this->dispatch_character_input(e.text, e.key_code);
+				break;
+		}
+	}
+
+	// reuse the allocated memory
+	if(this->input_queue.empty()){
+		events.clear();
+		std::swap(events, this->input_queue);
+	}
+}
+
 void gui::send_mouse_move(const vector2& pos, unsigned id){
+	if(!this->input_queueing){
+		this->dispatch_mouse_move(pos, id, utki::span<const vector2>());
+		return;
+	}
+
+	// Look for a queued move of the same pointer which is not separated from the end of the queue
+	// by anything else than moves of other pointers. Moves of different pointers are independent,
+	// so the found move can be replaced by this one without changing the order of significant events.
+	for(auto i = this->input_queue.rbegin(); i != this->input_queue.rend(); ++i){
+		if(i->kind != input_event::type::mouse_move){
+			break;
+		}
+		if(i->id != id){
+			continue;
+		}
+
+		if(this->max_mouse_move_history != 0){
+			if(i->history.size() >= this->max_mouse_move_history){
+				i->history.erase(i->history.begin(), i->history.begin() + (i->history.size() - this->max_mouse_move_history + 1));
+			}
+			i->history.push_back(i->pos);
+		}
+		i->pos = pos;
+		return;
+	}
+
+	input_event e;
+	e.kind = input_event::type::mouse_move;
+	e.pos = pos;
+	e.id = id;
+	this->input_queue.push_back(std::move(e));
+}
+
+void gui::dispatch_mouse_move(const vector2& pos, unsigned id, utki::span<const vector2> history){
 	if(!this->root_widget){
 		return;
 	}
 
 	if(this->root_widget->is_interactive()){
 		this->root_widget->set_hovered(this->root_widget->rect().overlaps(pos), id);
-		this->root_widget->on_mouse_move(mouse_move_event{pos, id, false});
+		this->root_widget->on_mouse_move(mouse_move_event{pos, id, false, history});
 	}
 }
 
 void gui::send_mouse_button(bool is_down, const vector2& pos, mouse_button button, unsigned id){
+	if(!this->input_queueing){
+		this->dispatch_mouse_button(is_down, pos, button, id);
+		return;
+	}
+
+	input_event e;
+	e.kind = input_event::type::mouse_button;
+	e.is_down = is_down;
+	e.pos = pos;
+	e.button = button;
+	e.id = id;
+	this->input_queue.push_back(std::move(e));
+}
+
+void gui::dispatch_mouse_button(bool is_down, const vector2& pos, mouse_button button, unsigned id){
 	if(!this->root_widget){
 		return;
 	}
@@ -351,7 +455,20 @@ void gui::send_mouse_button(bool is_down, const vector2& pos, mouse_button butto
 	}
 }
 
-void gui::send_mouse_hover(bool isHovered, unsigned pointerID){
+void gui::send_mouse_hover(bool is_hovered, unsigned id){
+	if(!this->input_queueing){
+		this->dispatch_mouse_hover(is_hovered, id);
+		return;
+	}
+
+	input_event e;
+	e.kind = input_event::type::mouse_hover;
+	e.is_down = is_hovered;
+	e.id = id;
+	this->input_queue.push_back(std::move(e));
+}
+
+void gui::dispatch_mouse_hover(bool isHovered, unsigned pointerID){
 	if(!this->root_widget){
 		return;
 	}
@@ -360,6 +477,19 @@ void gui::send_mouse_hover(bool isHovered, unsigned pointerID){
 }
 
 void gui::send_key(bool is_down, key key_code){
+	if(!this->input_queueing){
+		this->dispatch_key(is_down, key_code);
+		return;
+	}
+
+	input_event e;
+	e.kind = input_event::type::key;
+	e.is_down = is_down;
+	e.key_code = key_code;
+	this->input_queue.push_back(std::move(e));
+}
+
+void gui::dispatch_key(bool is_down, key key_code){
 //		TRACE(<< "HandleKeyEvent(): is_down = " << is_down << " is_char_input_only = " << is_char_input_only << " keyCode = " << unsigned(keyCode) << std::endl)
 
 	if(auto w = this->context->focused_widget.lock()){
@@ -374,10 +504,27 @@ void gui::send_key(bool is_down, key key_code){
 }
 
 void gui::send_character_input(const unicode_provider& unicode, key key_code){
+	if(!this->input_queueing){
+		if(auto w = this->context->focused_widget.lock()){
+			//			TRACE(<< "HandleCharacterInput(): there is a focused widget" << std::endl)
+			if(auto c = dynamic_cast<character_input_widget*>(w.get())){
+				c->on_character_input(unicode.get(), key_code);
+			}
+		}
+		return;
+	}
+
+	input_event e;
+	e.kind = input_event::type::character_input;
+	e.text = unicode.get();
+	e.key_code = key_code;
+	this->input_queue.push_back(std::move(e));
+}
+
+void gui::dispatch_character_input(const std::u32string& text, key key_code){
 	if(auto w = this->context->focused_widget.lock()){
-		//			TRACE(<< "HandleCharacterInput(): there is a focused widget" << std::endl)
 		if(auto c = dynamic_cast<character_input_widget*>(w.get())){
-			c->on_character_input(unicode.get(), key_code);
+			c->on_character_input(text, key_code);
 		}
 	}
 }
@@ -3,6 +3,9 @@
 #include "context.hpp"
 #include "updateable.hpp"
 
+#include <vector>
+#include <string>
+
 namespace morda{
 
 class gui{
@@ -21,7 +24,10 @@ public:
 	gui(const gui&) = delete;
 	gui& operator=(const gui&) = delete;
 
-	virtual ~gui()noexcept{}
+	virtual ~gui()noexcept{
+		// retained resources hold the context
+		this->context->loader.clear_cache();
+	}
 
 private:
 	std::shared_ptr<morda::widget> root_widget;
@@ -71,12 +77,94 @@ public:
 	/**
 	 * @brief Update GUI.
 	 * Call this function from main loop of the program.
+	 * Queued input events are processed before updating the updateables.
 	 * @return number of milliseconds to sleep before next call.
 	 */
 	uint32_t update(){
+		this->process_input();
 		return this->context->updater->update();
 	}
 
+private:
+	struct input_event{
+		enum class type{
+			mouse_move,
+			mouse_button,
+			mouse_hover,
+			key,
+			character_input
+		} kind;
+
+		vector2 pos = vector2(0);
+		unsigned id = 0;
+		bool is_down = false; // also is_hovered for mouse hover events
+		mouse_button button = mouse_button::left;
+		morda::key key_code = morda::key::unknown;
+		std::u32string text;
+
+		// absolute positions of the coalesced mouse moves, oldest first
+		std::vector<vector2> history;
+	};
+
+	bool input_queueing = false;
+
+	size_t max_mouse_move_history = 64;
+
+	std::vector<input_event> input_queue;
+
+	void dispatch_mouse_move(const vector2& pos, unsigned id, utki::span<const vector2> history);
+	void dispatch_mouse_button(bool is_down, const vector2& pos, mouse_button button, unsigned id);
+	void dispatch_mouse_hover(bool is_hovered, unsigned id);
+	void dispatch_key(bool is_down, key key_code);
+	void dispatch_character_input(const std::u32string& text, key key_code);
+public:
+	/**
+	 * @brief Enable or disable input events queueing.
+	 * When queueing is enabled, the send_*() methods do not deliver the events to widgets right away,
+	 * but put them to a queue which is processed once per frame by process_input(), which is called from update().
+	 * Consecutive mouse move events of the same pointer are coalesced into one event, so that
+	 * high rate pointing devices do not cause a widget hierarchy traversal for every motion event.
+	 * The positions of the coalesced moves are delivered in mouse_move_event::history.
+	 * Button, hover, key and character input events are delivered in the order they were sent.
+	 * When queueing is disabled, the events which are still in the queue are processed right away.
+	 * By default, the queueing is disabled.
+	 * @param enable - whether to enable input queueing.
+	 */
+	void set_input_queueing(bool enable);
+
+	/**
+	 * @brief Check if input events queueing is enabled.
+	 * @return true if input queueing is enabled.
+	 * @return false otherwise.
+	 */
+	bool is_input_queueing()const noexcept{
+		return this->input_queueing;
+	}
+
+	/**
+	 * @brief Set maximum number of coalesced mouse move positions kept in the history.
+	 * In case more mouse moves are coalesced into one event, the oldest positions are dropped.
+	 * Default value is 64.
+	 * @param size - maximum history size, 0 means not to keep the history at all.
+	 */
+	void set_max_mouse_move_history(size_t size)noexcept{
+		this->max_mouse_move_history = size;
+	}
+
+	/**
+	 * @brief Get number of queued input events.
+	 * @return number of input events waiting to be processed.
+	 */
+	size_t get_num_queued_input_events()const noexcept{
+		return this->input_queue.size();
+	}
+
+	/**
+	 * @brief Deliver queued input events to widgets.
+	 * Events sent during processing are queued and delivered on the next call.
+	 */
+	void process_input();
+
 	/**
 	 * @brief Feed in the mouse move event to GUI.
 	 * @param pos - new position of the mouse pointer.
@@ -128,6 +216,7 @@ public:
 	 * @brief Feed in the character input event to the GUI.
 	 * The idea with unicode_provider parameter is that we don't want to calculate the unicode string
 	 * unless it is really needed, thus provide the string only when get() method is called.
+	 * In case input queueing is enabled, the string is obtained right away to be stored in the queue.
 	 * This method is supposed to receive also a repeated key events when user holds down the key, as well as initial key press.
 	 * unicode_provider may provide empty string.
 	 * @param unicode - unicode string provider.
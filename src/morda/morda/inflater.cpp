@@ -24,9 +24,25 @@ bool inflater::unregister_widget(const std::string& widgetName)noexcept{
 	if(this->factories.erase(widgetName) == 0){
 		return false;
 	}
+
+	for(auto i = this->type_infos.begin(); i != this->type_infos.end(); ++i){
+		if(i->second.name == widgetName){
+			this->type_infos.erase(i);
+			break;
+		}
+	}
+
 	return true;
 }
 
+const inflater::widget_type_info* inflater::find_type_info(const std::type_info& type)const noexcept{
+	auto i = this->type_infos.find(std::type_index(type));
+	if(i == this->type_infos.end()){
+		return nullptr;
+	}
+	return &i->second;
+}
+
 std::shared_ptr<morda::widget> inflater::inflate(const papki::file& fi) {
 	return this->inflate(treeml::read(fi));
 }
@@ -156,6 +172,14 @@ std::shared_ptr<widget> inflater::inflate(const std::string& str){
 }
 
 std::shared_ptr<widget> inflater::inflate(treeml::forest::const_iterator begin, treeml::forest::const_iterator end){
+	// widget descriptions from the blueprint being inflated are already resolved
+	if(this->current_blueprint && begin != end){
+		auto f = this->current_blueprint->widget_factories.find(&*begin);
+		if(f != this->current_blueprint->widget_factories.end()){
+			return f->second(utki::make_shared_from(this->context), begin->children);
+		}
+	}
+
 	auto i = begin;
 
 	for(; i != end && is_leaf_property(i->value); ++i){
@@ -226,6 +250,140 @@ std::shared_ptr<widget> inflater::inflate(treeml::forest::const_iterator begin,
 	}
 }
 
+std::shared_ptr<const inflater::blueprint> inflater::compile(treeml::forest::const_iterator begin, treeml::forest::const_iterator end){
+	unsigned num_pop_defs = 0;
+	utki::scope_exit pop_defs_scope_exit([this, &num_pop_defs](){
+		for(unsigned i = 0; i != num_pop_defs; ++i){
+			this->pop_defs();
+		}
+	});
+
+	auto i = begin;
+
+	for(; i != end && is_leaf_property(i->value); ++i){
+		if(i->value == wording_defs){
+			this->push_defs(i->children);
+			++num_pop_defs;
+		}else{
+			throw std::invalid_argument("inflater::compile(): unknown declaration encountered before first widget");
+		}
+	}
+
+	if(i == end){
+		throw std::invalid_argument("inflater::compile(): no widget found in GUI script");
+	}
+
+	auto ret = std::make_shared<blueprint>();
+
+	ret->desc.push_back(*i);
+
+	// the tree is resolved in place, so that addresses of the resolved widget trees remain valid
+	this->resolve(ret->desc.front(), *ret);
+
+	return ret;
+}
+
+void inflater::resolve(treeml::tree& widget_tree, blueprint& bp){
+	ASSERT(!widget_tree.value.empty())
+	ASSERT(widget_tree.value.to_string()[0] == '@')
+
+	std::string widget_name;
+	treeml::forest widget_desc;
+
+	if(auto tmpl = this->find_template(widget_tree.value.to_string().substr(1))){
+		widget_tree.value = tmpl->templ.value;
+		widget_name = tmpl->templ.value.to_string().substr(1);
+		widget_desc = apply_gui_template(tmpl->templ.children, tmpl->vars, std::move(widget_tree.children));
+	}else{
+		widget_name = widget_tree.value.to_string().substr(1);
+		widget_desc = std::move(widget_tree.children);
+	}
+
+	const auto& fac = this->find_factory(widget_name);
+
+	unsigned num_pop_defs = 0;
+	utki::scope_exit pop_defs_scope_exit([this, &num_pop_defs](){
+		for(unsigned i = 0; i != num_pop_defs; ++i){
+			this->pop_defs();
+		}
+	});
+
+	for(auto& d : widget_desc){
+		if(d.value != wording_defs){
+			continue;
+		}
+		this->push_defs(d.children);
+		++num_pop_defs;
+		d.children.clear();
+	}
+
+	substitute_vars(
+			widget_desc,
+			[this](const std::string& name) -> const treeml::forest*{
+				return this->find_variable(name);
+			},
+			true,
+			false
+		);
+
+	// child widgets are resolved while the local defs of this widget are pushed
+	this->resolve_children(widget_desc, bp);
+
+	// moving the forest does not move the trees it holds, so the addresses of the resolved child widget trees stay valid
+	widget_tree.children = std::move(widget_desc);
+
+	bp.widget_factories.insert(std::make_pair(&widget_tree, fac));
+}
+
+void inflater::resolve_children(treeml::forest& desc, blueprint& bp){
+	for(auto& t : desc){
+		if(is_leaf_child(t.value)){
+			this->resolve(t, bp);
+		}else{
+			this->resolve_children(t.children, bp);
+		}
+	}
+}
+
+std::shared_ptr<widget> inflater::inflate(const blueprint& bp){
+	ASSERT(bp.desc.size() == 1)
+
+	auto prev = this->current_blueprint;
+	this->current_blueprint = &bp;
+	utki::scope_exit current_blueprint_scope_exit([this, prev](){
+		this->current_blueprint = prev;
+	});
+
+	return this->inflate(bp.desc.begin(), bp.desc.end());
+}
+
+namespace{
+template <class F> std::shared_ptr<widget> inflate_in_arena(std::shared_ptr<arena>& current_arena, std::shared_ptr<arena>&& a, F inflate){
+	// out of line data of the widgets created during inflating is allocated from the arena as well
+	arena::scope arena_scope(a.get());
+
+	auto prev = std::move(current_arena);
+	current_arena = std::move(a);
+	utki::scope_exit current_arena_scope_exit([&current_arena, &prev](){
+		current_arena = std::move(prev);
+	});
+
+	return inflate();
+}
+}
+
+std::shared_ptr<widget> inflater::inflate(const treeml::forest& gui_script, std::shared_ptr<morda::arena> arena){
+	return inflate_in_arena(this->current_arena, std::move(arena), [this, &gui_script](){
+		return this->inflate(gui_script);
+	});
+}
+
+std::shared_ptr<widget> inflater::inflate(const blueprint& bp, std::shared_ptr<morda::arena> arena){
+	return inflate_in_arena(this->current_arena, std::move(arena), [this, &bp](){
+		return this->inflate(bp);
+	});
+}
+
 namespace{
 // name starts with @
 void check_template_recursion(const std::string& name, const treeml::forest& desc){
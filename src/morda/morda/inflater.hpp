@@ -1,11 +1,15 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <memory>
+#include <typeindex>
+#include <unordered_map>
 
 #include "widgets/widget.hpp"
 
 #include "util/util.hpp"
+#include "util/arena.hpp"
 
 namespace morda{
 
@@ -39,6 +43,38 @@ private:
 
 	void add_factory(std::string&& widget_name, decltype(factories)::value_type::second_type&& factory);
 
+public:
+	/**
+	 * @brief Information about registered widget type.
+	 */
+	struct widget_type_info{
+		/**
+		 * @brief Name of the widget type as it appears in GUI script.
+		 */
+		std::string name;
+
+		/**
+		 * @brief Size of the widget object in bytes.
+		 */
+		size_t size;
+	};
+
+private:
+	std::map<std::type_index, widget_type_info> type_infos;
+
+public:
+	/**
+	 * @brief Find information about registered widget type.
+	 * @param type - type of the widget.
+	 * @return pointer to the widget type information.
+	 * @return nullptr if given widget type was not registered.
+	 */
+	const widget_type_info* find_type_info(const std::type_info& type)const noexcept;
+
+private:
+	// arena to allocate the widgets from during the inflate call
+	std::shared_ptr<morda::arena> current_arena;
+
 public:
 	/**
 	 * @brief Registers a new widget type.
@@ -49,10 +85,16 @@ public:
 	template <class T> void register_widget(const std::string& widget_name){
 		this->add_factory(
 				std::string(widget_name),
-				[](std::shared_ptr<morda::context> c, const treeml::forest& desc) -> std::shared_ptr<morda::widget> {
+				[this](std::shared_ptr<morda::context> c, const treeml::forest& desc) -> std::shared_ptr<morda::widget> {
+					if(this->current_arena){
+						auto w = std::allocate_shared<T>(arena_allocator<T>(this->current_arena), std::move(c), desc);
+						w->owner_arena = this->current_arena.get();
+						return w;
+					}
 					return std::make_shared<T>(std::move(c), desc);
 				}
 			);
+		this->type_infos[std::type_index(typeid(T))] = widget_type_info{widget_name, sizeof(T)};
 	}
 
 	/**
@@ -80,6 +122,21 @@ public:
 		return this->inflate(gui_script.begin(), gui_script.end());
 	}
 
+	/**
+	 * @brief Create widgets hierarchy from GUI script in arena.
+	 * All the widgets inflated during this call, including the ones inflated by the widgets themselves,
+	 * are allocated contiguously from the given arena. The widgets' layout parameters and out of line data
+	 * are allocated from the arena as well, also when those are created later, e.g. on first laying out.
+	 * The layout description copies held by the out of line data are treeml forests, those allocate their nodes
+	 * on the heap.
+	 * The arena memory is freed when all the widgets allocated from it are destroyed and there are no
+	 * weak pointers to any of them left, i.e. a single std::weak_ptr to one widget keeps the whole arena allocated.
+	 * @param gui_script - GUI script to use.
+	 * @param arena - arena to allocate the widgets from.
+	 * @return the inflated widget.
+	 */
+	std::shared_ptr<widget> inflate(const treeml::forest& gui_script, std::shared_ptr<morda::arena> arena);
+
 	/**
 	 * @brief Inflate widget and cast to specified type.
 	 * Only the first widget from the STOB chain is returned.
@@ -131,6 +188,73 @@ public:
 		return std::dynamic_pointer_cast<T>(this->inflate(fi));
 	}
 
+	/**
+	 * @brief Compiled GUI script.
+	 * Blueprint holds the description of a widget hierarchy with all the templates applied
+	 * and all the variables substituted, along with the widget factories for each widget of the hierarchy.
+	 * Inflating widgets from a blueprint does not involve any template lookups, tree copying or variables substitution.
+	 * The defs which were active at the moment of compilation are captured by the blueprint,
+	 * later changes to the defs do not affect it.
+	 * Blueprint is immutable, so it can be compiled once and then used to inflate the same widget hierarchy many times.
+	 */
+	class blueprint{
+		friend class inflater;
+
+		treeml::forest desc;
+
+		std::unordered_map<const treeml::tree*, decltype(factories)::value_type::second_type> widget_factories;
+	public:
+		blueprint() = default;
+
+		blueprint(const blueprint&) = delete;
+		blueprint& operator=(const blueprint&) = delete;
+	};
+
+	/**
+	 * @brief Compile GUI script to a blueprint.
+	 * Only the first widget from the GUI script is compiled. The defs which precede the first widget
+	 * are taken into account, but unlike inflate(), they are not left pushed after the compilation.
+	 * @param begin - begin iterator into the GUI script.
+	 * @param end - end iterator into the GUI script.
+	 * @return the compiled blueprint.
+	 */
+	std::shared_ptr<const blueprint> compile(treeml::forest::const_iterator begin, treeml::forest::const_iterator end);
+
+	/**
+	 * @brief Compile GUI script to a blueprint.
+	 * @param gui_script - GUI script to compile.
+	 * @return the compiled blueprint.
+	 */
+	std::shared_ptr<const blueprint> compile(const treeml::forest& gui_script){
+		return this->compile(gui_script.begin(), gui_script.end());
+	}
+
+	/**
+	 * @brief Create widgets hierarchy from blueprint.
+	 * @param bp - blueprint to inflate the widgets from.
+	 * @return the inflated widget.
+	 */
+	std::shared_ptr<widget> inflate(const blueprint& bp);
+
+	/**
+	 * @brief Create widgets hierarchy from blueprint in arena.
+	 * All the widgets inflated during this call are allocated contiguously from the given arena.
+	 * See inflate(const treeml::forest&, std::shared_ptr<morda::arena>) for details.
+	 * @param bp - blueprint to inflate the widgets from.
+	 * @param arena - arena to allocate the widgets from.
+	 * @return the inflated widget.
+	 */
+	std::shared_ptr<widget> inflate(const blueprint& bp, std::shared_ptr<morda::arena> arena);
+
+	/**
+	 * @brief Inflate widget from blueprint and cast to specified type.
+	 * @param bp - blueprint to inflate the widget from.
+	 * @return the inflated widget.
+	 */
+	template <typename T> std::shared_ptr<T> inflate_as(const blueprint& bp){
+		return std::dynamic_pointer_cast<T>(this->inflate(bp));
+	}
+
 private:
 	struct widget_template{
 		treeml::tree templ;
@@ -158,6 +282,12 @@ private:
 
 	void push_defs(const treeml::forest& chain);
 	void pop_defs();
+
+	// blueprint which is being inflated at the moment
+	const blueprint* current_blueprint = nullptr;
+
+	void resolve(treeml::tree& widget_tree, blueprint& bp);
+	void resolve_children(treeml::forest& desc, blueprint& bp);
 };
 
 }
@@ -0,0 +1,168 @@
+#include "layout_scheduler.hpp"
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+namespace{
+thread_local const layout_scheduler* current_scheduler = nullptr;
+thread_local size_t current_queue_index = 0;
+}
+
+layout_scheduler::layout_scheduler(unsigned num_threads){
+	if(num_threads == 0){
+		unsigned hc = std::thread::hardware_concurrency();
+		num_threads = hc > 1 ? hc - 1 : 0;
+	}
+
+	for(unsigned i = 0; i != num_threads + 1; ++i){
+		this->queues.push_back(std::make_unique<task_queue>());
+	}
+
+	try{
+		for(unsigned i = 0; i != num_threads; ++i){
+			this->threads.emplace_back([this, i](){this->thread_func(i);});
+		}
+	}catch(...){
+		this->stop_threads();
+		throw;
+	}
+}
+
+layout_scheduler::~layout_scheduler()noexcept{
+	this->stop_threads();
+}
+
+void layout_scheduler::stop_threads()noexcept{
+	{
+		std::lock_guard<decltype(this->wake_mutex)> lock_guard(this->wake_mutex);
+		this->quit = true;
+	}
+	this->wake_cv.notify_all();
+
+	for(auto& t : this->threads){
+		t.join();
+	}
+	this->threads.clear();
+}
+
+bool layout_scheduler::is_worker_thread()noexcept{
+	return current_scheduler != nullptr;
+}
+
+size_t layout_scheduler::get_queue_index()const noexcept{
+	if(current_scheduler == this){
+		return current_queue_index;
+	}
+	// the thread which owns the scheduler
+	ASSERT(!this->queues.empty())
+	return this->queues.size() - 1;
+}
+
+bool layout_scheduler::pop_own(size_t queue_index, task& t){
+	auto& q = *this->queues[queue_index];
+	std::lock_guard<decltype(q.mutex)> lock_guard(q.mutex);
+	if(q.tasks.empty()){
+		return false;
+	}
+	t = q.tasks.back();
+	q.tasks.pop_back();
+	--this->num_pending_tasks;
+	return true;
+}
+
+bool layout_scheduler::steal(size_t queue_index, task& t){
+	for(size_t i = 1; i != this->queues.size(); ++i){
+		auto& q = *this->queues[(queue_index + i) % this->queues.size()];
+		std::lock_guard<decltype(q.mutex)> lock_guard(q.mutex);
+		if(q.tasks.empty()){
+			continue;
+		}
+		t = q.tasks.front();
+		q.tasks.pop_front();
+		--this->num_pending_tasks;
+		return true;
+	}
+	return false;
+}
+
+void layout_scheduler::run_task(const task& t)noexcept{
+	auto& g = *t.group;
+	try{
+		g.func(t.index);
+	}catch(...){
+		std::lock_guard<decltype(g.exception_mutex)> lock_guard(g.exception_mutex);
+		if(!g.exception){
+			g.exception = std::current_exception();
+		}
+	}
+	// this must be the last access to the group, as it can be destroyed right after the counter reaches zero
+	--g.num_left;
+}
+
+bool layout_scheduler::run_one(size_t queue_index){
+	task t;
+	if(this->pop_own(queue_index, t) || this->steal(queue_index, t)){
+		run_task(t);
+		return true;
+	}
+	return false;
+}
+
+void layout_scheduler::thread_func(size_t queue_index){
+	current_scheduler = this;
+	current_queue_index = queue_index;
+
+	for(;;){
+		if(this->run_one(queue_index)){
+			continue;
+		}
+
+		std::unique_lock<decltype(this->wake_mutex)> lock(this->wake_mutex);
+		this->wake_cv.wait(lock, [this](){return this->quit || this->num_pending_tasks != 0;});
+		if(this->quit){
+			break;
+		}
+	}
+}
+
+void layout_scheduler::for_each(size_t num_tasks, const std::function<void(size_t)>& func){
+	if(num_tasks == 0){
+		return;
+	}
+
+	task_group g(func, num_tasks);
+
+	size_t queue_index = this->get_queue_index();
+
+	// increment the counter before pushing the tasks, so that it does not underflow when the tasks are popped
+	this->num_pending_tasks += num_tasks;
+
+	{
+		auto& q = *this->queues[queue_index];
+		std::lock_guard<decltype(q.mutex)> lock_guard(q.mutex);
+		// own tasks are taken from the back, so push in reverse order to execute them in natural order
+		for(size_t i = num_tasks; i != 0; --i){
+			q.tasks.push_back(task{&g, i - 1});
+		}
+	}
+
+	if(!this->threads.empty()){
+		{
+			// lock the mutex to make sure that waiting threads do not miss the notification
+			std::lock_guard<decltype(this->wake_mutex)> lock_guard(this->wake_mutex);
+		}
+		this->wake_cv.notify_all();
+	}
+
+	// help executing tasks while waiting
+	while(g.num_left != 0){
+		if(!this->run_one(queue_index)){
+			std::this_thread::yield();
+		}
+	}
+
+	if(g.exception){
+		std::rethrow_exception(g.exception);
+	}
+}
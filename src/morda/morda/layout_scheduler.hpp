@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+namespace morda{
+
+/**
+ * @brief Work stealing scheduler for parallel layout.
+ * The scheduler owns a pool of worker threads, each having its own task queue.
+ * A thread takes tasks from the back of its own queue and, when the queue is empty,
+ * steals tasks from the front of other threads' queues.
+ * A thread which waits for completion of the tasks it has scheduled keeps executing
+ * pending tasks meanwhile, so nested parallel loops do not block the worker threads.
+ *
+ * Set the scheduler to the context to enable parallel layout,
+ * see context::layout_scheduler and container::lay_out_children().
+ */
+class layout_scheduler{
+	struct task_group{
+		const std::function<void(size_t)>& func;
+		std::atomic<size_t> num_left;
+
+		std::mutex exception_mutex;
+		std::exception_ptr exception;
+
+		task_group(const std::function<void(size_t)>& func, size_t num_tasks) :
+				func(func),
+				num_left(num_tasks)
+		{}
+	};
+
+	struct task{
+		task_group* group;
+		size_t index;
+	};
+
+	struct task_queue{
+		std::mutex mutex;
+		std::deque<task> tasks;
+	};
+
+	// one queue per worker thread plus the last one for the thread which owns the scheduler (UI thread)
+	std::vector<std::unique_ptr<task_queue>> queues;
+
+	std::vector<std::thread> threads;
+
+	std::atomic<size_t> num_pending_tasks{0};
+
+	std::mutex wake_mutex;
+	std::condition_variable wake_cv;
+	bool quit = false;
+
+	size_t get_queue_index()const noexcept;
+
+	bool pop_own(size_t queue_index, task& t);
+	bool steal(size_t queue_index, task& t);
+
+	bool run_one(size_t queue_index);
+
+	static void run_task(const task& t)noexcept;
+
+	void thread_func(size_t queue_index);
+
+	void stop_threads()noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param num_threads - number of worker threads to start. Zero means one less than number of hardware threads,
+	 *                      as the thread calling for_each() also executes the tasks.
+	 */
+	layout_scheduler(unsigned num_threads = 0);
+
+	layout_scheduler(const layout_scheduler&) = delete;
+	layout_scheduler& operator=(const layout_scheduler&) = delete;
+
+	~layout_scheduler()noexcept;
+
+	/**
+	 * @brief Get number of worker threads.
+	 * @return number of worker threads.
+	 */
+	size_t num_threads()const noexcept{
+		return this->threads.size();
+	}
+
+	/**
+	 * @brief Check if the calling thread is one of the scheduler's worker threads.
+	 * @return true if called from a worker thread of any layout_scheduler.
+	 * @return false otherwise.
+	 */
+	static bool is_worker_thread()noexcept;
+
+	/**
+	 * @brief Execute function in parallel for each index.
+	 * Calls the given function for each index from [0, num_tasks) range, the calls are distributed among
+	 * the worker threads and the calling thread. The method returns when all the calls have finished.
+	 * The method can be called from the UI thread or from within a task being executed by the scheduler.
+	 * In case some calls have thrown an exception, the first caught exception is rethrown
+	 * after all the calls have finished.
+	 * @param num_tasks - number of times to call the function.
+	 * @param func - function to call.
+	 */
+	void for_each(size_t num_tasks, const std::function<void(size_t)>& func);
+};
+
+}
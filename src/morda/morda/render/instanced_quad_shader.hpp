@@ -0,0 +1,65 @@
+#pragma once
+
+#include <r4/matrix.hpp>
+#include <r4/vector.hpp>
+
+#include <utki/span.hpp>
+
+#include "texture_2d.hpp"
+
+namespace morda{
+
+/**
+ * @brief Per-instance data of a quad.
+ */
+struct quad_instance{
+	/**
+	 * @brief Transformation matrix of the quad.
+	 * Maps the unit quad (0, 0) - (1, 1) to the output.
+	 */
+	r4::matrix4<float> matrix;
+
+	/**
+	 * @brief Color of the quad.
+	 * For textured quads the texture color is multiplied by this color.
+	 */
+	r4::vector4<float> color;
+
+	/**
+	 * @brief Texture coordinates rectangle.
+	 * x and y are the texture coordinates of the (0, 0) corner of the unit quad,
+	 * z and w are the texture coordinates of the (1, 1) corner.
+	 * Ignored for quads without texture.
+	 */
+	r4::vector4<float> tex_rect = r4::vector4<float>(0, 0, 1, 1);
+};
+
+/**
+ * @brief Shader rendering many quads in one draw call.
+ * The unit quad geometry is shared by all the instances, the per-instance transformation, color
+ * and texture coordinates rectangle are passed as instance attributes.
+ */
+class instanced_quad_shader{
+public:
+	instanced_quad_shader(){}
+
+	instanced_quad_shader(const instanced_quad_shader&) = delete;
+	instanced_quad_shader& operator=(const instanced_quad_shader&) = delete;
+
+	virtual ~instanced_quad_shader()noexcept{}
+
+	/**
+	 * @brief Render solid color quads.
+	 * @param instances - quads to render, in the order of rendering.
+	 */
+	virtual void render(utki::span<const quad_instance> instances)const = 0;
+
+	/**
+	 * @brief Render textured quads.
+	 * @param instances - quads to render, in the order of rendering.
+	 * @param tex - texture to sample.
+	 */
+	virtual void render(utki::span<const quad_instance> instances, const texture_2d& tex)const = 0;
+};
+
+}
@@ -0,0 +1,581 @@
+#include "recording_renderer.hpp"
+
+#include <functional>
+
+#include <utki/debug.hpp>
+
+#include "render_trace.hxx"
+
+using namespace morda;
+
+namespace{
+struct recorder{
+	render_trace::writer trace;
+
+	std::uint32_t next_id = 1;
+
+	std::uint32_t new_id()noexcept{
+		return this->next_id++;
+	}
+
+	void destroy(std::uint32_t id){
+		this->trace.op(render_trace::opcode::destroy);
+		this->trace.u32(id);
+	}
+};
+
+// base of the recorded objects, records destruction of the object
+class recorded{
+public:
+	const std::shared_ptr<recorder> rec;
+	const std::uint32_t id;
+
+	recorded(std::shared_ptr<recorder> rec) :
+			rec(std::move(rec)),
+			id(this->rec->new_id())
+	{}
+
+	~recorded()noexcept{
+		try{
+			this->rec->destroy(this->id);
+		}catch(...){
+			// nothing to do if out of memory
+		}
+	}
+};
+
+class recorded_texture : public texture_2d, public recorded{
+public:
+	const std::shared_ptr<texture_2d> real;
+
+	recorded_texture(std::shared_ptr<recorder> rec, std::shared_ptr<texture_2d> real) :
+			texture_2d(real->dims(), real->memory_size()),
+			recorded(std::move(rec)),
+			real(std::move(real))
+	{}
+};
+
+// vertex buffer updates are not supported, so that streamed geometry is recorded as new buffers
+// and the trace stays a sequence of immutable objects
+class recorded_vertex_buffer : public vertex_buffer, public recorded{
+public:
+	const std::shared_ptr<vertex_buffer> real;
+
+	recorded_vertex_buffer(std::shared_ptr<recorder> rec, std::shared_ptr<vertex_buffer> real, size_t size) :
+			vertex_buffer(size),
+			recorded(std::move(rec)),
+			real(std::move(real))
+	{}
+};
+
+class recorded_index_buffer : public index_buffer, public recorded{
+public:
+	const std::shared_ptr<index_buffer> real;
+
+	recorded_index_buffer(std::shared_ptr<recorder> rec, std::shared_ptr<index_buffer> real) :
+			recorded(std::move(rec)),
+			real(std::move(real))
+	{}
+};
+
+class recorded_vertex_array : public vertex_array, public recorded{
+public:
+	const std::shared_ptr<vertex_array> real;
+
+	recorded_vertex_array(
+			std::shared_ptr<recorder> rec,
+			std::shared_ptr<vertex_array> real,
+			std::vector<std::shared_ptr<vertex_buffer>>&& buffers,
+			std::shared_ptr<index_buffer> indices,
+			mode rendering_mode
+		) :
+			vertex_array(std::move(buffers), std::move(indices), rendering_mode),
+			recorded(std::move(rec)),
+			real(std::move(real))
+	{}
+};
+
+class recorded_frame_buffer : public frame_buffer, public recorded{
+public:
+	const std::shared_ptr<frame_buffer> real;
+
+	recorded_frame_buffer(std::shared_ptr<recorder> rec, std::shared_ptr<frame_buffer> real, std::shared_ptr<texture_2d> color) :
+			frame_buffer(std::move(color)),
+			recorded(std::move(rec)),
+			real(std::move(real))
+	{}
+};
+
+// all the objects passed to the recorded shaders are created by the recording factory
+template <class T> const T& unwrap_texture(const texture_2d& t){
+	ASSERT(dynamic_cast<const T*>(&t))
+	return static_cast<const T&>(t);
+}
+
+const recorded_vertex_array& unwrap(const vertex_array& va){
+	// vertex_array is not polymorphic, so there is no way to check the type
+	return static_cast<const recorded_vertex_array&>(va);
+}
+
+std::uint32_t get_id(const texture_2d& t){
+	return unwrap_texture<recorded_texture>(t).id;
+}
+
+const texture_2d& get_real(const texture_2d& t){
+	return *unwrap_texture<recorded_texture>(t).real;
+}
+
+void record_draw(recorder& rec, render_trace::shader s, const r4::matrix4<float>& m, const vertex_array& va){
+	rec.trace.op(render_trace::opcode::draw);
+	rec.trace.u8(std::uint8_t(s));
+	rec.trace.u32(unwrap(va).id);
+	rec.trace.mat(m);
+}
+
+class recorded_texturing_shader : public texturing_shader{
+	const std::shared_ptr<recorder> rec;
+	const texturing_shader& real;
+public:
+	recorded_texturing_shader(std::shared_ptr<recorder> rec, const texturing_shader& real) :
+			rec(std::move(rec)),
+			real(real)
+	{}
+
+	void render(const r4::matrix4<float>& m, const vertex_array& va, const texture_2d& tex)const override{
+		record_draw(*this->rec, render_trace::shader::pos_tex, m, va);
+		this->rec->trace.u32(get_id(tex));
+		this->real.render(m, *unwrap(va).real, get_real(tex));
+	}
+};
+
+class recorded_coloring_shader : public coloring_shader{
+	const std::shared_ptr<recorder> rec;
+	const coloring_shader& real;
+	const render_trace::shader kind;
+public:
+	recorded_coloring_shader(std::shared_ptr<recorder> rec, const coloring_shader& real, render_trace::shader kind) :
+			rec(std::move(rec)),
+			real(real),
+			kind(kind)
+	{}
+
+	void render(const r4::matrix4<float>& m, const vertex_array& va, r4::vector4<float> color)const override{
+		record_draw(*this->rec, this->kind, m, va);
+		this->rec->trace.vec(color);
+		this->real.render(m, *unwrap(va).real, color);
+	}
+};
+
+class recorded_shader : public shader{
+	const std::shared_ptr<recorder> rec;
+	const shader& real;
+public:
+	recorded_shader(std::shared_ptr<recorder> rec, const shader& real) :
+			rec(std::move(rec)),
+			real(real)
+	{}
+
+	void render(const r4::matrix4<float>& m, const vertex_array& va)const override{
+		record_draw(*this->rec, render_trace::shader::pos_clr, m, va);
+		this->real.render(m, *unwrap(va).real);
+	}
+};
+
+class recorded_coloring_texturing_shader : public coloring_texturing_shader{
+	const std::shared_ptr<recorder> rec;
+	const coloring_texturing_shader& real;
+	const render_trace::shader kind;
+public:
+	recorded_coloring_texturing_shader(std::shared_ptr<recorder> rec, const coloring_texturing_shader& real, render_trace::shader kind) :
+			rec(std::move(rec)),
+			real(real),
+			kind(kind)
+	{}
+
+	void render(const r4::matrix4<float>& m, const vertex_array& va, r4::vector4<float> color, const texture_2d& tex)const override{
+		record_draw(*this->rec, this->kind, m, va);
+		this->rec->trace.vec(color);
+		this->rec->trace.u32(get_id(tex));
+		this->real.render(m, *unwrap(va).real, color, get_real(tex));
+	}
+};
+
+class recorded_instanced_quad_shader : public instanced_quad_shader{
+	const std::shared_ptr<recorder> rec;
+	const instanced_quad_shader& real;
+
+	void record(utki::span<const quad_instance> instances, std::uint32_t texture_id)const{
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::draw_quads);
+		t.u32(texture_id);
+		t.u32(std::uint32_t(instances.size()));
+		for(auto& q : instances){
+			t.mat(q.matrix);
+			t.vec(q.color);
+			t.vec(q.tex_rect);
+		}
+	}
+public:
+	recorded_instanced_quad_shader(std::shared_ptr<recorder> rec, const instanced_quad_shader& real) :
+			rec(std::move(rec)),
+			real(real)
+	{}
+
+	void render(utki::span<const quad_instance> instances)const override{
+		this->record(instances, 0);
+		this->real.render(instances);
+	}
+
+	void render(utki::span<const quad_instance> instances, const texture_2d& tex)const override{
+		this->record(instances, get_id(tex));
+		this->real.render(instances, get_real(tex));
+	}
+};
+
+void write_sampling(render_trace::writer& t, const texture_2d::sampling& params){
+	t.u8(std::uint8_t(params.min_filter));
+	t.u8(std::uint8_t(params.mag_filter));
+	t.u8(std::uint8_t(params.mipmaps));
+	t.u8(std::uint8_t(params.wrap_s));
+	t.u8(std::uint8_t(params.wrap_t));
+}
+
+void write_mips(render_trace::writer& t, utki::span<const utki::span<const uint8_t>> mips){
+	t.u32(std::uint32_t(mips.size()));
+	for(auto& m : mips){
+		t.bytes(m);
+	}
+}
+
+class recording_factory : public render_factory{
+public:
+	const std::shared_ptr<renderer> target;
+	const std::shared_ptr<recorder> rec = std::make_shared<recorder>();
+
+	recording_factory(std::shared_ptr<renderer> target) :
+			target(std::move(target))
+	{}
+
+	render_factory& real()noexcept{
+		return *this->target->factory;
+	}
+
+	using render_factory::create_texture_2d;
+
+	std::shared_ptr<texture_2d> create_texture_2d(texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data)override{
+		auto ret = std::make_shared<recorded_texture>(this->rec, this->real().create_texture_2d(type, dims, data));
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_texture);
+		t.u32(ret->id);
+		t.u8(std::uint8_t(type));
+		t.u32(dims.x());
+		t.u32(dims.y());
+		t.bytes(data);
+		return ret;
+	}
+
+	std::shared_ptr<texture_2d> create_texture_2d(
+			texture_2d::type type,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const texture_2d::sampling& params
+		)override
+	{
+		auto ret = std::make_shared<recorded_texture>(this->rec, this->real().create_texture_2d(type, dims, mips, params));
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_mipmapped_texture);
+		t.u32(ret->id);
+		t.u8(std::uint8_t(type));
+		t.u32(dims.x());
+		t.u32(dims.y());
+		write_sampling(t, params);
+		write_mips(t, mips);
+		return ret;
+	}
+
+	bool is_supported(texture_2d::compression c)const override{
+		return this->target->factory->is_supported(c);
+	}
+
+	std::shared_ptr<texture_2d> create_texture_2d(
+			texture_2d::compression c,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const texture_2d::sampling& params
+		)override
+	{
+		auto ret = std::make_shared<recorded_texture>(this->rec, this->real().create_texture_2d(c, dims, mips, params));
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_compressed_texture);
+		t.u32(ret->id);
+		t.u8(std::uint8_t(c));
+		t.u32(dims.x());
+		t.u32(dims.y());
+		write_sampling(t, params);
+		write_mips(t, mips);
+		return ret;
+	}
+
+	template <class T, unsigned N> std::shared_ptr<vertex_buffer> record_vertex_buffer(
+			utki::span<const T> vertices,
+			const std::function<void(render_trace::writer&, const T&)>& write
+		)
+	{
+		auto ret = std::make_shared<recorded_vertex_buffer>(this->rec, this->real().create_vertex_buffer(vertices), vertices.size());
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_vertex_buffer);
+		t.u32(ret->id);
+		t.u8(std::uint8_t(N));
+		t.u32(std::uint32_t(vertices.size()));
+		for(auto& v : vertices){
+			write(t, v);
+		}
+		return ret;
+	}
+
+	std::shared_ptr<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices)override{
+		return this->record_vertex_buffer<r4::vector4<float>, 4>(vertices, [](render_trace::writer& t, const r4::vector4<float>& v){
+			t.vec(v);
+		});
+	}
+
+	std::shared_ptr<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector3<float>> vertices)override{
+		return this->record_vertex_buffer<r4::vector3<float>, 3>(vertices, [](render_trace::writer& t, const r4::vector3<float>& v){
+			t.f32(v.x());
+			t.f32(v.y());
+			t.f32(v.z());
+		});
+	}
+
+	std::shared_ptr<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector2<float>> vertices)override{
+		return this->record_vertex_buffer<r4::vector2<float>, 2>(vertices, [](render_trace::writer& t, const r4::vector2<float>& v){
+			t.vec(v);
+		});
+	}
+
+	std::shared_ptr<vertex_buffer> create_vertex_buffer(utki::span<const float> vertices)override{
+		return this->record_vertex_buffer<float, 1>(vertices, [](render_trace::writer& t, const float& v){
+			t.f32(v);
+		});
+	}
+
+	std::shared_ptr<index_buffer> create_index_buffer(utki::span<const uint16_t> indices)override{
+		auto ret = std::make_shared<recorded_index_buffer>(this->rec, this->real().create_index_buffer(indices));
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_index_buffer);
+		t.u32(ret->id);
+		t.u32(std::uint32_t(indices.size()));
+		for(auto i : indices){
+			t.u16(i);
+		}
+		return ret;
+	}
+
+	std::shared_ptr<vertex_array> create_vertex_array(
+			std::vector<std::shared_ptr<morda::vertex_buffer>>&& buffers,
+			std::shared_ptr<morda::index_buffer> indices,
+			vertex_array::mode rendering_mode
+		)override
+	{
+		std::vector<std::shared_ptr<morda::vertex_buffer>> real_buffers;
+		real_buffers.reserve(buffers.size());
+		for(auto& b : buffers){
+			ASSERT(std::dynamic_pointer_cast<recorded_vertex_buffer>(b))
+			real_buffers.push_back(std::static_pointer_cast<recorded_vertex_buffer>(b)->real);
+		}
+
+		auto recorded_indices = std::dynamic_pointer_cast<recorded_index_buffer>(indices);
+		ASSERT(recorded_indices || !indices)
+
+		auto ret = std::make_shared<recorded_vertex_array>(
+				this->rec,
+				this->real().create_vertex_array(
+						std::move(real_buffers),
+						recorded_indices ? recorded_indices->real : nullptr,
+						rendering_mode
+					),
+				std::move(buffers),
+				std::move(indices),
+				rendering_mode
+			);
+
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_vertex_array);
+		t.u32(ret->id);
+		t.u32(std::uint32_t(ret->buffers.size()));
+		for(auto& b : ret->buffers){
+			t.u32(std::static_pointer_cast<recorded_vertex_buffer>(b)->id);
+		}
+		t.u32(recorded_indices ? recorded_indices->id : 0);
+		t.u8(std::uint8_t(rendering_mode));
+		return ret;
+	}
+
+	std::unique_ptr<shaders> create_shaders()override{
+		auto ret = std::make_unique<shaders>();
+
+		auto& s = this->target->shader;
+		if(!s){
+			return ret;
+		}
+
+		if(s->pos_tex){
+			ret->pos_tex = std::make_unique<recorded_texturing_shader>(this->rec, *s->pos_tex);
+		}
+		if(s->color_pos){
+			ret->color_pos = std::make_unique<recorded_coloring_shader>(this->rec, *s->color_pos, render_trace::shader::color_pos);
+		}
+		if(s->color_pos_lum){
+			ret->color_pos_lum = std::make_unique<recorded_coloring_shader>(this->rec, *s->color_pos_lum, render_trace::shader::color_pos_lum);
+		}
+		if(s->pos_clr){
+			ret->pos_clr = std::make_unique<recorded_shader>(this->rec, *s->pos_clr);
+		}
+		if(s->color_pos_tex){
+			ret->color_pos_tex = std::make_unique<recorded_coloring_texturing_shader>(this->rec, *s->color_pos_tex, render_trace::shader::color_pos_tex);
+		}
+		if(s->color_pos_sdf){
+			ret->color_pos_sdf = std::make_unique<recorded_coloring_texturing_shader>(this->rec, *s->color_pos_sdf, render_trace::shader::color_pos_sdf);
+		}
+		if(s->instanced_quad){
+			ret->instanced_quad = std::make_unique<recorded_instanced_quad_shader>(this->rec, *s->instanced_quad);
+		}
+		return ret;
+	}
+
+	std::shared_ptr<frame_buffer> create_framebuffer(std::shared_ptr<texture_2d> color)override{
+		auto recorded_color = std::dynamic_pointer_cast<recorded_texture>(color);
+		ASSERT(recorded_color || !color)
+
+		auto ret = std::make_shared<recorded_frame_buffer>(
+				this->rec,
+				this->real().create_framebuffer(recorded_color ? recorded_color->real : nullptr),
+				std::move(color)
+			);
+
+		auto& t = this->rec->trace;
+		t.op(render_trace::opcode::create_framebuffer);
+		t.u32(ret->id);
+		t.u32(recorded_color ? recorded_color->id : 0);
+		return ret;
+	}
+};
+
+recorder& get_recorder(const render_factory& f)noexcept{
+	ASSERT(dynamic_cast<const recording_factory*>(&f))
+	return *static_cast<const recording_factory&>(f).rec;
+}
+
+void write_rectangle(render_trace::writer& t, const r4::rectangle<int>& r){
+	t.i32(r.p.x());
+	t.i32(r.p.y());
+	t.i32(r.d.x());
+	t.i32(r.d.y());
+}
+}
+
+std::unique_ptr<render_factory> recording_renderer::create_factory(std::shared_ptr<renderer> target){
+	if(!target){
+		throw std::invalid_argument("recording_renderer::recording_renderer(): target renderer is null");
+	}
+	return std::make_unique<recording_factory>(std::move(target));
+}
+
+recording_renderer::recording_renderer(std::shared_ptr<renderer> target) :
+		renderer(
+				create_factory(target),
+				[&target](){
+					params p;
+					p.max_texture_size = target->max_texture_size;
+					p.initial_matrix = target->initial_matrix;
+					return p;
+				}()
+			),
+		target(std::move(target))
+{}
+
+recording_renderer::~recording_renderer()noexcept{}
+
+void recording_renderer::end_frame(){
+	get_recorder(*this->factory).trace.op(render_trace::opcode::end_frame);
+}
+
+utki::span<const std::uint8_t> recording_renderer::get_trace()const noexcept{
+	return utki::make_span(get_recorder(*this->factory).trace.data);
+}
+
+void recording_renderer::save_trace(const papki::file& dst)const{
+	papki::file::guard file_guard(dst, papki::file::mode::create);
+	dst.write(this->get_trace());
+}
+
+void recording_renderer::clear_framebuffer(){
+	get_recorder(*this->factory).trace.op(render_trace::opcode::clear_framebuffer);
+	this->target->clear_framebuffer();
+}
+
+void recording_renderer::set_framebuffer_internal(frame_buffer* fb){
+	auto recorded_fb = dynamic_cast<recorded_frame_buffer*>(fb);
+	ASSERT(recorded_fb || !fb)
+
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_framebuffer);
+	t.u32(recorded_fb ? recorded_fb->id : 0);
+
+	this->target->set_framebuffer(recorded_fb ? recorded_fb->real : nullptr);
+}
+
+bool recording_renderer::is_scissor_enabled_internal()const{
+	return this->target->is_scissor_enabled();
+}
+
+void recording_renderer::set_scissor_enabled_internal(bool enabled){
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_scissor_enabled);
+	t.u8(enabled ? 1 : 0);
+
+	this->target->set_scissor_enabled(enabled);
+}
+
+r4::rectangle<int> recording_renderer::get_scissor_internal()const{
+	return this->target->get_scissor();
+}
+
+void recording_renderer::set_scissor_internal(r4::rectangle<int> r){
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_scissor);
+	write_rectangle(t, r);
+
+	this->target->set_scissor(r);
+}
+
+r4::rectangle<int> recording_renderer::get_viewport_internal()const{
+	return this->target->get_viewport();
+}
+
+void recording_renderer::set_viewport_internal(r4::rectangle<int> r){
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_viewport);
+	write_rectangle(t, r);
+
+	this->target->set_viewport(r);
+}
+
+void recording_renderer::set_blend_enabled_internal(bool enable){
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_blend_enabled);
+	t.u8(enable ? 1 : 0);
+
+	this->target->set_blend_enabled(enable);
+}
+
+void recording_renderer::set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha){
+	auto& t = get_recorder(*this->factory).trace;
+	t.op(render_trace::opcode::set_blend_func);
+	t.u8(std::uint8_t(src_color));
+	t.u8(std::uint8_t(dst_color));
+	t.u8(std::uint8_t(src_alpha));
+	t.u8(std::uint8_t(dst_alpha));
+
+	this->target->set_blend_func(src_color, dst_color, src_alpha, dst_alpha);
+}
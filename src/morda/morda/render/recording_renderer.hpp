@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <utki/span.hpp>
+
+#include <papki/file.hpp>
+
+#include "renderer.hpp"
+
+namespace morda{
+
+/**
+ * @brief Renderer decorator which records render trace.
+ * The recording renderer passes everything to the target renderer and, at the same time, serializes
+ * every texture, buffer and framebuffer creation and destruction, render state change and shader draw
+ * call into a compact binary trace. The trace can be replayed later with trace_player against any renderer.
+ *
+ * Use the recording renderer instead of the target one when creating the GUI context. Resources
+ * created before the recording renderer is set up are not known to the trace.
+ */
+class recording_renderer : public renderer{
+	const std::shared_ptr<renderer> target;
+
+	static std::unique_ptr<render_factory> create_factory(std::shared_ptr<renderer> target);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param target - renderer to pass everything to.
+	 */
+	recording_renderer(std::shared_ptr<renderer> target);
+
+	~recording_renderer()noexcept;
+
+	/**
+	 * @brief Mark end of frame.
+	 * Call this after each rendered frame, the trace player reports timings per frame.
+	 */
+	void end_frame();
+
+	/**
+	 * @brief Get the trace recorded so far.
+	 * @return render trace.
+	 */
+	utki::span<const std::uint8_t> get_trace()const noexcept;
+
+	/**
+	 * @brief Save the trace recorded so far.
+	 * @param dst - file to write the trace to.
+	 */
+	void save_trace(const papki::file& dst)const;
+
+	void clear_framebuffer()override;
+
+protected:
+	void set_framebuffer_internal(frame_buffer* fb)override;
+
+	bool is_scissor_enabled_internal()const override;
+
+	void set_scissor_enabled_internal(bool enabled)override;
+
+	r4::rectangle<int> get_scissor_internal()const override;
+
+	void set_scissor_internal(r4::rectangle<int> r)override;
+
+	r4::rectangle<int> get_viewport_internal()const override;
+
+	void set_viewport_internal(r4::rectangle<int> r)override;
+
+	void set_blend_enabled_internal(bool enable)override;
+
+	void set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override;
+};
+
+}
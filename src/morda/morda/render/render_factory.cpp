@@ -1,5 +1,7 @@
 #include "render_factory.hpp"
 
+#include <stdexcept>
+
 using namespace morda;
 
 std::shared_ptr<texture_2d> render_factory::create_texture_2d(r4::vector2<unsigned> dims, utki::span<const uint32_t> data){
@@ -12,3 +14,26 @@ std::shared_ptr<texture_2d> render_factory::create_texture_2d(r4::vector2<unsign
 				)
 		);
 }
+
+std::shared_ptr<texture_2d> render_factory::create_texture_2d(
+		texture_2d::type type,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const texture_2d::sampling& params
+	)
+{
+	if(mips.empty()){
+		return this->create_texture_2d(type, dims, utki::span<const uint8_t>());
+	}
+	return this->create_texture_2d(type, dims, mips[0]);
+}
+
+std::shared_ptr<texture_2d> render_factory::create_texture_2d(
+		texture_2d::compression c,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const texture_2d::sampling& params
+	)
+{
+	throw std::runtime_error("render_factory::create_texture_2d(): compressed textures are not supported");
+}
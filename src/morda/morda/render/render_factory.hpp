@@ -16,6 +16,7 @@
 #include "coloring_shader.hpp"
 #include "shader.hpp"
 #include "coloring_texturing_shader.hpp"
+#include "instanced_quad_shader.hpp"
 #include "frame_buffer.hpp"
 
 namespace morda{
@@ -30,6 +31,54 @@ public:
 	virtual std::shared_ptr<texture_2d> create_texture_2d(texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data) = 0;
 	
 	std::shared_ptr<texture_2d> create_texture_2d(r4::vector2<unsigned> dims, utki::span<const uint32_t> data);
+
+	/**
+	 * @brief Create texture with mipmaps.
+	 * In case only the base level is given and sampling parameters require mipmaps, then
+	 * mipmaps are generated by the rendering backend, if it supports that.
+	 * Default implementation creates texture from the base level only and ignores sampling parameters.
+	 * @param type - texture type.
+	 * @param dims - dimensions of the base level.
+	 * @param mips - pixel data of the mipmap levels, base level first. Each next level has half of the previous level dimensions, but not less than 1.
+	 * @param params - sampling parameters.
+	 * @return created texture.
+	 */
+	virtual std::shared_ptr<texture_2d> create_texture_2d(
+			texture_2d::type type,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const texture_2d::sampling& params
+		);
+
+	/**
+	 * @brief Check if compressed texture format is supported.
+	 * Default implementation returns false.
+	 * @param c - compressed texture format.
+	 * @return true in case the format is supported by the rendering backend.
+	 * @return false otherwise.
+	 */
+	virtual bool is_supported(texture_2d::compression c)const{
+		return false;
+	}
+
+	/**
+	 * @brief Create texture from GPU compressed data.
+	 * Compressed textures cannot have mipmaps generated, so sampling parameters requiring mipmaps are
+	 * ignored in case only the base level is given.
+	 * Default implementation throws std::runtime_error.
+	 * @param c - compressed texture format.
+	 * @param dims - dimensions of the base level.
+	 * @param mips - compressed data of the mipmap levels, base level first.
+	 * @param params - sampling parameters.
+	 * @return created texture.
+	 * @throw std::runtime_error - in case the format is not supported.
+	 */
+	virtual std::shared_ptr<texture_2d> create_texture_2d(
+			texture_2d::compression c,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const texture_2d::sampling& params
+		);
 	
 	virtual std::shared_ptr<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices) = 0;
 	
@@ -53,6 +102,21 @@ public:
 		std::unique_ptr<coloring_shader> color_pos_lum;
 		std::unique_ptr<shader> pos_clr;
 		std::unique_ptr<coloring_texturing_shader> color_pos_tex;
+
+		/**
+		 * @brief Signed distance field shader.
+		 * Renders the texture holding signed distance field in its first channel, where 0.5 is the shape edge,
+		 * as a shape filled with the given color, with antialiased edges at any scale.
+		 * Backends which cannot do that leave it empty.
+		 */
+		std::unique_ptr<coloring_texturing_shader> color_pos_sdf;
+
+		/**
+		 * @brief Instanced quad shader.
+		 * Backends which do not support instancing leave it empty, in that case
+		 * renderer::render_quads() expands the instances to vertices on CPU.
+		 */
+		std::unique_ptr<instanced_quad_shader> instanced_quad;
 	};
 	
 	virtual std::unique_ptr<shaders> create_shaders() = 0;
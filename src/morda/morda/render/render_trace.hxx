@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <utki/span.hpp>
+#include <utki/debug.hpp>
+
+#include <r4/matrix.hpp>
+#include <r4/vector.hpp>
+
+// render trace format, all numbers are little-endian:
+// - 8 bytes: magic "MORDART1".
+// - sequence of records, each record is 1 byte of opcode followed by opcode specific data.
+// Objects created during recording are referred to by 32 bit ids, id 0 means no object.
+
+namespace morda{ namespace render_trace{
+
+const char magic[] = "MORDART1";
+const size_t magic_size = sizeof(magic) - 1;
+
+enum class opcode : std::uint8_t{
+	// id, type, width, height, data
+	create_texture,
+	// id, type, width, height, sampling, number of mips, mips data
+	create_mipmapped_texture,
+	// id, compression, width, height, sampling, number of mips, mips data
+	create_compressed_texture,
+	// id, number of components, number of vertices, floats
+	create_vertex_buffer,
+	// id, number of indices, indices
+	create_index_buffer,
+	// id, number of buffers, buffer ids, index buffer id, mode
+	create_vertex_array,
+	// id, color texture id
+	create_framebuffer,
+	// id
+	destroy,
+	// framebuffer id
+	set_framebuffer,
+	clear_framebuffer,
+	// enabled
+	set_scissor_enabled,
+	// x, y, width, height
+	set_scissor,
+	// x, y, width, height
+	set_viewport,
+	// enabled
+	set_blend_enabled,
+	// 4 blend factors
+	set_blend_func,
+	// shader, vertex array id, matrix, shader specific data: color and/or texture id
+	draw,
+	// texture id, number of quads, quads
+	draw_quads,
+	end_frame
+};
+
+enum class shader : std::uint8_t{
+	pos_tex,
+	color_pos,
+	color_pos_lum,
+	pos_clr,
+	color_pos_tex,
+	color_pos_sdf
+};
+
+class writer{
+public:
+	std::vector<std::uint8_t> data;
+
+	writer(){
+		this->data.insert(this->data.end(), magic, magic + magic_size);
+	}
+
+	void u8(std::uint8_t n){
+		this->data.push_back(n);
+	}
+
+	void op(opcode o){
+		this->u8(std::uint8_t(o));
+	}
+
+	void u16(std::uint16_t n){
+		this->data.push_back(std::uint8_t(n));
+		this->data.push_back(std::uint8_t(n >> 8));
+	}
+
+	void u32(std::uint32_t n){
+		for(unsigned i = 0; i != 4; ++i){
+			this->data.push_back(std::uint8_t(n >> (i * 8)));
+		}
+	}
+
+	void i32(std::int32_t n){
+		this->u32(std::uint32_t(n));
+	}
+
+	void f32(float f){
+		std::uint32_t n;
+		static_assert(sizeof(n) == sizeof(f), "float is not 32 bit");
+		std::memcpy(&n, &f, sizeof(n));
+		this->u32(n);
+	}
+
+	void vec(const r4::vector2<float>& v){
+		this->f32(v.x());
+		this->f32(v.y());
+	}
+
+	void vec(const r4::vector4<float>& v){
+		this->f32(v.x());
+		this->f32(v.y());
+		this->f32(v.z());
+		this->f32(v.w());
+	}
+
+	void mat(const r4::matrix4<float>& m){
+		for(unsigned i = 0; i != 4; ++i){
+			this->vec(m[i]);
+		}
+	}
+
+	void bytes(utki::span<const std::uint8_t> b){
+		this->u32(std::uint32_t(b.size()));
+		this->data.insert(this->data.end(), b.begin(), b.end());
+	}
+};
+
+class reader{
+	utki::span<const std::uint8_t> data;
+	size_t pos = magic_size;
+
+	const std::uint8_t* take(size_t size){
+		if(this->data.size() - this->pos < size){
+			throw std::invalid_argument("render_trace::reader: unexpected end of trace");
+		}
+		auto ret = this->data.data() + this->pos;
+		this->pos += size;
+		return ret;
+	}
+
+public:
+	reader(utki::span<const std::uint8_t> data) :
+			data(data)
+	{
+		if(data.size() < magic_size || std::memcmp(data.data(), magic, magic_size) != 0){
+			throw std::invalid_argument("render_trace::reader: not a render trace");
+		}
+	}
+
+	bool empty()const noexcept{
+		return this->pos == this->data.size();
+	}
+
+	std::uint8_t u8(){
+		return *this->take(1);
+	}
+
+	opcode op(){
+		return opcode(this->u8());
+	}
+
+	std::uint16_t u16(){
+		auto p = this->take(2);
+		return std::uint16_t(p[0] | (p[1] << 8));
+	}
+
+	std::uint32_t u32(){
+		auto p = this->take(4);
+		return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+	}
+
+	std::int32_t i32(){
+		return std::int32_t(this->u32());
+	}
+
+	float f32(){
+		std::uint32_t n = this->u32();
+		float ret;
+		std::memcpy(&ret, &n, sizeof(ret));
+		return ret;
+	}
+
+	r4::vector2<float> vec2(){
+		auto x = this->f32();
+		auto y = this->f32();
+		return r4::vector2<float>(x, y);
+	}
+
+	r4::vector4<float> vec4(){
+		auto x = this->f32();
+		auto y = this->f32();
+		auto z = this->f32();
+		auto w = this->f32();
+		return r4::vector4<float>(x, y, z, w);
+	}
+
+	r4::matrix4<float> mat(){
+		r4::matrix4<float> ret;
+		for(unsigned i = 0; i != 4; ++i){
+			ret[i] = this->vec4();
+		}
+		return ret;
+	}
+
+	/**
+	 * @brief Read number of the following elements.
+	 * The number is checked against the rest of the trace, so that corrupted count cannot
+	 * make the caller allocate more memory than the trace can fill.
+	 * @param element_size - minimal number of bytes each element takes in the trace.
+	 * @return number of elements.
+	 */
+	size_t count(size_t element_size){
+		ASSERT(element_size != 0)
+		size_t ret = this->u32();
+		if(ret > (this->data.size() - this->pos) / element_size){
+			throw std::invalid_argument("render_trace::reader: number of elements exceeds the trace size");
+		}
+		return ret;
+	}
+
+	utki::span<const std::uint8_t> bytes(){
+		size_t size = this->u32();
+		return utki::make_span(this->take(size), size);
+	}
+};
+
+}}
@@ -1,7 +1,38 @@
 #include "renderer.hpp"
 
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
 using namespace morda;
 
+namespace{
+const std::array<r4::vector2<float>, 4> quad_corners = {{
+	r4::vector2<float>(0, 0), r4::vector2<float>(0, 1), r4::vector2<float>(1, 1), r4::vector2<float>(1, 0)
+}};
+
+void expand_positions(utki::span<const quad_instance> instances, std::vector<r4::vector4<float>>& out){
+	for(auto& q : instances){
+		for(auto& c : quad_corners){
+			out.push_back(q.matrix * r4::vector4<float>(c.x(), c.y(), 0, 1));
+		}
+	}
+}
+
+std::shared_ptr<index_buffer> create_quad_indices(render_factory& f, size_t num_quads){
+	ASSERT(num_quads <= renderer::max_quads_per_draw)
+	std::vector<std::uint16_t> indices;
+	indices.reserve(num_quads * 6);
+	for(size_t i = 0; i != num_quads; ++i){
+		auto v = std::uint16_t(i * 4);
+		for(auto j : {0, 1, 2, 0, 2, 3}){
+			indices.push_back(std::uint16_t(v + j));
+		}
+	}
+	return f.create_index_buffer(utki::make_span(indices));
+}
+}
+
 renderer::renderer(std::unique_ptr<render_factory> factory, const renderer::params& params) :
 		factory(std::move(factory)),
 		shader(this->factory->create_shaders()),
@@ -17,6 +48,188 @@ renderer::renderer(std::unique_ptr<render_factory> factory, const renderer::para
 }
 
 void renderer::set_framebuffer(std::shared_ptr<frame_buffer> fb){
+	if(this->state.framebuffer_known && this->curFB == fb){
+		++this->counters.num_skipped_changes;
+		return;
+	}
+	++this->counters.num_changes;
 	this->set_framebuffer_internal(fb.get());
 	this->curFB = std::move(fb);
+	this->state.framebuffer_known = true;
+}
+
+void renderer::set_scissor_enabled(bool enabled){
+	if(this->is_redundant_change(this->state.scissor_enabled, enabled)){
+		return;
+	}
+	this->set_scissor_enabled_internal(enabled);
+	this->state.scissor_enabled = enabled;
+}
+
+void renderer::set_scissor(r4::rectangle<int> r){
+	if(this->is_redundant_change(this->state.scissor, r)){
+		return;
+	}
+	this->set_scissor_internal(r);
+	this->state.scissor = r;
+}
+
+void renderer::set_viewport(r4::rectangle<int> r){
+	if(this->is_redundant_change(this->state.viewport, r)){
+		return;
+	}
+	this->set_viewport_internal(r);
+	this->state.viewport = r;
+}
+
+void renderer::set_blend_enabled(bool enable){
+	if(this->is_redundant_change(this->state.blend_enabled, enable)){
+		return;
+	}
+	this->set_blend_enabled_internal(enable);
+	this->state.blend_enabled = enable;
+}
+
+void renderer::set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha){
+	std::array<blend_factor, 4> func = {{src_color, dst_color, src_alpha, dst_alpha}};
+	if(this->is_redundant_change(this->state.blend_func, func)){
+		return;
+	}
+	this->set_blend_func_internal(src_color, dst_color, src_alpha, dst_alpha);
+	this->state.blend_func = func;
+}
+
+namespace{
+size_t get_quad_stream_index(size_t num_quads){
+	ASSERT(num_quads != 0 && num_quads <= renderer::max_quads_per_draw)
+	size_t ret = 0;
+	for(size_t n = 1; n < num_quads; n <<= 1){
+		++ret;
+	}
+	return ret;
+}
+}
+
+template <class T> const vertex_array& renderer::stream_quads(quad_streams_type& streams, size_t num_quads, std::vector<T>& attributes)const{
+	auto i = get_quad_stream_index(num_quads);
+	size_t stream_size = size_t(1) << i;
+	size_t num_vertices = stream_size * quad_corners.size();
+
+	// fill the unused tail with degenerate quads, those produce no fragments
+	this->quad_positions.resize(num_vertices, r4::vector4<float>(0));
+	attributes.resize(num_vertices, T(0));
+
+	auto& s = streams[i];
+	if(s.vao && s.positions->update(utki::make_span(this->quad_positions)) && s.attributes->update(utki::make_span(attributes))){
+		return *s.vao;
+	}
+
+	// first use of the stream or the backend does not support updating vertex buffers
+
+	auto& indices = this->quad_stream_indices[i];
+	if(!indices){
+		indices = create_quad_indices(*this->factory, stream_size);
+	}
+
+	s.positions = this->factory->create_vertex_buffer(utki::make_span(this->quad_positions));
+	s.attributes = this->factory->create_vertex_buffer(utki::make_span(attributes));
+	s.vao = this->factory->create_vertex_array({s.positions, s.attributes}, indices, vertex_array::mode::triangles);
+
+	return *s.vao;
+}
+
+void renderer::render_quads(utki::span<const quad_instance> instances)const{
+	if(instances.empty()){
+		return;
+	}
+
+	// single quad is cheaper to draw with uniforms than to upload a one instance buffer
+	if(instances.size() == 1){
+		auto& q = instances.front();
+		this->shader->color_pos->render(q.matrix, *this->pos_quad_01_vao, q.color);
+		return;
+	}
+
+	if(this->shader->instanced_quad){
+		this->shader->instanced_quad->render(instances);
+		return;
+	}
+
+	for(size_t i = 0; i != instances.size();){
+		auto chunk = utki::make_span(instances.data() + i, std::min(instances.size() - i, max_quads_per_draw));
+		i += chunk.size();
+
+		if(chunk.size() == 1){
+			auto& q = chunk.front();
+			this->shader->color_pos->render(q.matrix, *this->pos_quad_01_vao, q.color);
+			continue;
+		}
+
+		this->quad_positions.clear();
+		expand_positions(chunk, this->quad_positions);
+
+		this->quad_colors.clear();
+		for(auto& q : chunk){
+			this->quad_colors.insert(this->quad_colors.end(), quad_corners.size(), q.color);
+		}
+
+		auto& vao = this->stream_quads(this->solid_quad_streams, chunk.size(), this->quad_colors);
+
+		// the positions are already transformed
+		this->shader->pos_clr->render(r4::matrix4<float>().set_identity(), vao);
+	}
+}
+
+void renderer::render_quads(utki::span<const quad_instance> instances, const texture_2d& tex)const{
+	if(instances.empty()){
+		return;
+	}
+
+	if(instances.size() == 1 && instances.front().tex_rect == r4::vector4<float>(0, 0, 1, 1)){
+		auto& q = instances.front();
+		this->shader->color_pos_tex->render(q.matrix, *this->pos_tex_quad_01_vao, q.color, tex);
+		return;
+	}
+
+	if(this->shader->instanced_quad){
+		this->shader->instanced_quad->render(instances, tex);
+		return;
+	}
+
+	// the coloring texturing shader has color uniform, so render subsequent quads of the same color at once
+	for(auto begin = instances.begin(); begin != instances.end();){
+		auto end = std::find_if(
+				begin + 1,
+				begin + std::min(size_t(instances.end() - begin), max_quads_per_draw),
+				[&color = begin->color](const quad_instance& q){
+					return !(q.color == color);
+				}
+			);
+		auto run = utki::make_span(&*begin, size_t(end - begin));
+		begin = end;
+
+		if(run.size() == 1 && run.front().tex_rect == r4::vector4<float>(0, 0, 1, 1)){
+			auto& q = run.front();
+			this->shader->color_pos_tex->render(q.matrix, *this->pos_tex_quad_01_vao, q.color, tex);
+			continue;
+		}
+
+		this->quad_positions.clear();
+		expand_positions(run, this->quad_positions);
+
+		this->quad_tex_coords.clear();
+		for(auto& q : run){
+			for(auto& c : quad_corners){
+				this->quad_tex_coords.push_back(r4::vector2<float>(
+						q.tex_rect.x() + (q.tex_rect.z() - q.tex_rect.x()) * c.x(),
+						q.tex_rect.y() + (q.tex_rect.w() - q.tex_rect.y()) * c.y()
+					));
+			}
+		}
+
+		auto& vao = this->stream_quads(this->textured_quad_streams, run.size(), this->quad_tex_coords);
+
+		// the positions are already transformed
+		this->shader->color_pos_tex->render(r4::matrix4<float>().set_identity(), vao, run.front().color, tex);
+	}
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <vector>
+#include <optional>
+
 #include "render_factory.hpp"
 
 namespace morda{
@@ -31,8 +35,119 @@ protected:
 	
 	virtual ~renderer()noexcept{}
 	
+public:
+	/**
+	 * @brief Blending factor type.
+	 * Enumeration defines possible blending factor types.
+	 */
+	enum class blend_factor{
+		// WARNING: do not change order
+		
+		zero,
+		one,
+		src_color,
+		one_minus_src_color,
+		dst_color,
+		one_minus_dst_color,
+		src_alpha,
+		one_minus_src_alpha,
+		dst_alpha,
+		one_minus_dst_alpha,
+		constant_color,
+		one_minus_constant_color,
+		constant_alpha,
+		one_minus_constant_alpha,
+		src_alpha_saturate
+	};
+	
+	/**
+	 * @brief Render state change counters.
+	 * Renderer keeps a shadow copy of the render state, so redundant state changes
+	 * are not passed to the rendering backend and state queries do not need to query the backend.
+	 */
+	struct state_counters{
+		/**
+		 * @brief Number of state changes passed to the rendering backend.
+		 */
+		size_t num_changes = 0;
+
+		/**
+		 * @brief Number of state changes skipped because the state was already set.
+		 */
+		size_t num_skipped_changes = 0;
+
+		/**
+		 * @brief Number of state queries answered from the shadow copy of the render state.
+		 */
+		size_t num_cached_queries = 0;
+	};
+
 private:
 	std::shared_ptr<frame_buffer> curFB;
+
+	// shadow copy of the render state, empty values mean the state is unknown
+	struct shadow_state{
+		bool framebuffer_known = false;
+		std::optional<bool> scissor_enabled;
+		std::optional<r4::rectangle<int>> scissor;
+		std::optional<r4::rectangle<int>> viewport;
+		std::optional<bool> blend_enabled;
+		std::optional<std::array<blend_factor, 4>> blend_func;
+	};
+
+	mutable shadow_state state;
+
+	mutable state_counters counters;
+
+	template <class T> static bool is_equal(const T& a, const T& b)noexcept{
+		return a == b;
+	}
+
+	static bool is_equal(const r4::rectangle<int>& a, const r4::rectangle<int>& b)noexcept{
+		return a.p == b.p && a.d == b.d;
+	}
+
+	template <class T> bool is_redundant_change(const std::optional<T>& shadow, const T& value)noexcept{
+		if(shadow.has_value() && is_equal(*shadow, value)){
+			++this->counters.num_skipped_changes;
+			return true;
+		}
+		++this->counters.num_changes;
+		return false;
+	}
+
+	template <class T, class F> const T& query(std::optional<T>& shadow, const F& query_internal)const{
+		if(shadow.has_value()){
+			++this->counters.num_cached_queries;
+		}else{
+			shadow = query_internal();
+		}
+		return *shadow;
+	}
+
+	// quads expanded on CPU are streamed through reused buffers, there is a set of buffers for each
+	// power of two number of quads, the unused tail of the buffers is filled with degenerate quads
+	struct quad_stream{
+		std::shared_ptr<vertex_buffer> positions;
+		std::shared_ptr<vertex_buffer> attributes; // colors or texture coordinates
+		std::shared_ptr<vertex_array> vao;
+	};
+
+	constexpr static const size_t num_quad_stream_sizes = 15;
+
+	typedef std::array<quad_stream, num_quad_stream_sizes> quad_streams_type;
+
+	mutable quad_streams_type solid_quad_streams;
+	mutable quad_streams_type textured_quad_streams;
+
+	mutable std::array<std::shared_ptr<index_buffer>, num_quad_stream_sizes> quad_stream_indices;
+
+	// expanded vertex data, kept between the calls to avoid allocations
+	mutable std::vector<r4::vector4<float>> quad_positions;
+	mutable std::vector<r4::vector4<float>> quad_colors;
+	mutable std::vector<r4::vector2<float>> quad_tex_coords;
+
+	template <class T> const vertex_array& stream_quads(quad_streams_type& streams, size_t num_quads, std::vector<T>& attributes)const;
 public:
 	const unsigned max_texture_size;
 	
@@ -50,48 +165,103 @@ public:
 	
 	virtual void clear_framebuffer() = 0;
 	
-	virtual bool is_scissor_enabled()const = 0;
+	bool is_scissor_enabled()const{
+		return this->query(this->state.scissor_enabled, [this](){return this->is_scissor_enabled_internal();});
+	}
 	
-	virtual void set_scissor_enabled(bool enabled) = 0;
+	void set_scissor_enabled(bool enabled);
 	
-	virtual r4::rectangle<int> get_scissor()const = 0;
+	r4::rectangle<int> get_scissor()const{
+		return this->query(this->state.scissor, [this](){return this->get_scissor_internal();});
+	}
 	
-	virtual void set_scissor(r4::rectangle<int> r) = 0;
+	void set_scissor(r4::rectangle<int> r);
 	
-	virtual r4::rectangle<int> get_viewport()const = 0;
+	r4::rectangle<int> get_viewport()const{
+		return this->query(this->state.viewport, [this](){return this->get_viewport_internal();});
+	}
 	
-	virtual void set_viewport(r4::rectangle<int> r) = 0;
+	void set_viewport(r4::rectangle<int> r);
 	
-	virtual void set_blend_enabled(bool enable) = 0;
+	void set_blend_enabled(bool enable);
 	
+	void set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha);
+
 	/**
-	 * @brief Blending factor type.
-	 * Enumeration defines possible blending factor types.
+	 * @brief Forget the shadow copy of the render state.
+	 * Call this after changing the render state bypassing the renderer, e.g. with direct OpenGL calls.
+	 * The state will be queried from the rendering backend on next use.
 	 */
-	enum class blend_factor{
-		// WARNING: do not change order
-		
-		zero,
-		one,
-		src_color,
-		one_minus_src_color,
-		dst_color,
-		one_minus_dst_color,
-		src_alpha,
-		one_minus_src_alpha,
-		dst_alpha,
-		one_minus_dst_alpha,
-		constant_color,
-		one_minus_constant_color,
-		constant_alpha,
-		one_minus_constant_alpha,
-		src_alpha_saturate
-	};
-	
-	virtual void set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha) = 0;
-	
+	void invalidate_state()noexcept{
+		this->state = shadow_state();
+	}
+
+	/**
+	 * @brief Get render state change counters.
+	 * @return render state change counters.
+	 */
+	const state_counters& get_state_counters()const noexcept{
+		return this->counters;
+	}
+
+	/**
+	 * @brief Reset render state change counters to zero.
+	 */
+	void reset_state_counters()noexcept{
+		this->counters = state_counters();
+	}
+
+	/**
+	 * @brief Render solid color quads.
+	 * Renders all the quads in one draw call using the instanced quad shader.
+	 * In case the rendering backend does not support instancing, the quads are expanded to
+	 * vertices on CPU and rendered with the per-vertex color shader, one draw call per
+	 * max_quads_per_draw quads. The expanded vertices are streamed through vertex buffers which are
+	 * reused from call to call, in case the backend supports updating vertex buffers.
+	 * A single quad is rendered with the unit quad vertex array, without expanding and without instancing.
+	 * @param instances - quads to render, in the order of rendering.
+	 */
+	void render_quads(utki::span<const quad_instance> instances)const;
+
+	/**
+	 * @brief Render textured quads.
+	 * Renders all the quads in one draw call using the instanced quad shader.
+	 * In case the rendering backend does not support instancing, the quads are expanded to
+	 * vertices on CPU and rendered with the coloring texturing shader, one draw call per
+	 * run of subsequent quads of the same color. As for solid color quads, the expanded vertices
+	 * are streamed through reused vertex buffers. A single quad covering the whole texture
+	 * is rendered with the unit quad vertex array, also when instancing is supported.
+	 * @param instances - quads to render, in the order of rendering.
+	 * @param tex - texture to sample.
+	 */
+	void render_quads(utki::span<const quad_instance> instances, const texture_2d& tex)const;
+
+	/**
+	 * @brief Maximum number of quads rendered by one draw call when instances are expanded on CPU.
+	 * Limited by 16 bit vertex indices.
+	 */
+	constexpr static const size_t max_quads_per_draw = 0x10000 / 4;
+
+	static_assert(size_t(1) << (num_quad_stream_sizes - 1) == max_quads_per_draw, "wrong number of quad stream sizes");
+
 protected:
 	virtual void set_framebuffer_internal(frame_buffer* fb) = 0;
+
+	virtual bool is_scissor_enabled_internal()const = 0;
+
+	virtual void set_scissor_enabled_internal(bool enabled) = 0;
+
+	virtual r4::rectangle<int> get_scissor_internal()const = 0;
+
+	virtual void set_scissor_internal(r4::rectangle<int> r) = 0;
+
+	virtual r4::rectangle<int> get_viewport_internal()const = 0;
+
+	virtual void set_viewport_internal(r4::rectangle<int> r) = 0;
+
+	virtual void set_blend_enabled_internal(bool enable) = 0;
+
+	virtual void set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha) = 0;
 };
 
 }
@@ -1,5 +1,8 @@
 #include "texture_2d.hpp"
 
+#include <stdexcept>
+#include <algorithm>
+
 using namespace morda;
 
 unsigned texture_2d::bytes_per_pixel(texture_2d::type t){
@@ -16,3 +19,50 @@ unsigned texture_2d::bytes_per_pixel(texture_2d::type t){
 			return 0;
 	}
 }
+
+size_t texture_2d::compressed_size(compression c, r4::vector2<unsigned> dims){
+	size_t block_size;
+	switch(c){
+		case compression::etc1_rgb:
+		case compression::etc2_rgb:
+		case compression::bc1_rgb:
+		case compression::bc1_rgba:
+			block_size = 8;
+			break;
+		case compression::etc2_rgba:
+		case compression::bc3_rgba:
+		case compression::bc7_rgba:
+			block_size = 16;
+			break;
+		default:
+			throw std::invalid_argument("texture_2d::compressed_size(): unknown compression format");
+	}
+
+	return size_t((dims.x() + 3) / 4) * size_t((dims.y() + 3) / 4) * block_size;
+}
+
+namespace{
+r4::vector2<unsigned> mip_dims(r4::vector2<unsigned> dims, unsigned level){
+	return r4::vector2<unsigned>(
+			std::max(dims.x() >> level, 1u),
+			std::max(dims.y() >> level, 1u)
+		);
+}
+}
+
+size_t texture_2d::calc_memory_size(type t, r4::vector2<unsigned> dims, unsigned num_levels){
+	size_t ret = 0;
+	for(unsigned i = 0; i != num_levels; ++i){
+		auto d = mip_dims(dims, i);
+		ret += size_t(d.x()) * size_t(d.y()) * bytes_per_pixel(t);
+	}
+	return ret;
+}
+
+size_t texture_2d::calc_memory_size(compression c, r4::vector2<unsigned> dims, unsigned num_levels){
+	size_t ret = 0;
+	for(unsigned i = 0; i != num_levels; ++i){
+		ret += compressed_size(c, mip_dims(dims, i));
+	}
+	return ret;
+}
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <r4/vector.hpp>
+
 #include "../config.hpp"
 
 namespace morda{
 
 class texture_2d{
 	vector2 dims_v;
+
+	size_t memory_size_v;
 	
 public:
-	texture_2d(vector2 dims) :
-			dims_v(dims)
+	/**
+	 * @brief Constructor.
+	 * @param dims - dimensions of the texture in pixels.
+	 * @param memory_size - size of the texture data, including all mipmap levels, in bytes. Zero if unknown.
+	 */
+	texture_2d(vector2 dims, size_t memory_size = 0) :
+			dims_v(dims),
+			memory_size_v(memory_size)
 	{}
 	
 	texture_2d(const texture_2d&) = delete;
@@ -21,6 +31,16 @@ public:
 		return this->dims_v;
 	}
 
+	/**
+	 * @brief Get size of the texture data.
+	 * The size is as uploaded to the GPU, including all mipmap levels.
+	 * Actual GPU memory used can be bigger because of driver's alignment and padding.
+	 * @return size of the texture data in bytes, zero if unknown.
+	 */
+	size_t memory_size()const noexcept{
+		return this->memory_size_v;
+	}
+
 	enum class type{
 		grey,
 		grey_alpha,
@@ -29,6 +49,84 @@ public:
 	};
 	
 	static unsigned bytes_per_pixel(texture_2d::type t);
+
+	/**
+	 * @brief GPU compressed texture formats.
+	 * All formats use 4x4 pixel blocks.
+	 */
+	enum class compression{
+		etc1_rgb,
+		etc2_rgb,
+		etc2_rgba,
+		bc1_rgb,
+		bc1_rgba,
+		bc3_rgba,
+		bc7_rgba
+	};
+
+	/**
+	 * @brief Get size of compressed texture data.
+	 * @param c - compression format.
+	 * @param dims - dimensions of the texture in pixels.
+	 * @return size of the compressed data in bytes.
+	 */
+	static size_t compressed_size(compression c, r4::vector2<unsigned> dims);
+
+	/**
+	 * @brief Calculate size of texture data with mipmap levels.
+	 * Each next mipmap level is half the size of the previous one, but not less than 1 pixel.
+	 * @param t - texture type.
+	 * @param dims - dimensions of the texture in pixels.
+	 * @param num_levels - number of mipmap levels, including the base level.
+	 * @return size of the texture data in bytes.
+	 */
+	static size_t calc_memory_size(type t, r4::vector2<unsigned> dims, unsigned num_levels = 1);
+
+	/**
+	 * @brief Calculate size of compressed texture data with mipmap levels.
+	 * @param c - compression format.
+	 * @param dims - dimensions of the texture in pixels.
+	 * @param num_levels - number of mipmap levels, including the base level.
+	 * @return size of the compressed data in bytes.
+	 */
+	static size_t calc_memory_size(compression c, r4::vector2<unsigned> dims, unsigned num_levels = 1);
+
+	/**
+	 * @brief Texture filtering type.
+	 */
+	enum class filter{
+		nearest,
+		linear
+	};
+
+	/**
+	 * @brief Mipmap filtering type.
+	 */
+	enum class mipmap{
+		none,
+		nearest,
+		linear
+	};
+
+	/**
+	 * @brief Texture coordinates wrapping mode.
+	 */
+	enum class wrap{
+		repeat,
+		mirrored_repeat,
+		clamp
+	};
+
+	/**
+	 * @brief Texture sampling parameters.
+	 */
+	struct sampling{
+		filter min_filter = filter::linear;
+		filter mag_filter = filter::linear;
+		mipmap mipmaps = mipmap::none;
+		wrap wrap_s = wrap::repeat;
+		wrap wrap_t = wrap::repeat;
+	};
 };
 
 }
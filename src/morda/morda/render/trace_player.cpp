@@ -0,0 +1,366 @@
+#include "trace_player.hpp"
+
+#include <unordered_map>
+
+#include <utki/debug.hpp>
+
+#include "render_trace.hxx"
+
+using namespace morda;
+
+namespace{
+// objects created during the replay, by recorded id
+struct objects{
+	std::unordered_map<std::uint32_t, std::shared_ptr<texture_2d>> textures;
+	std::unordered_map<std::uint32_t, std::shared_ptr<vertex_buffer>> vertex_buffers;
+	std::unordered_map<std::uint32_t, std::shared_ptr<index_buffer>> index_buffers;
+	std::unordered_map<std::uint32_t, std::shared_ptr<vertex_array>> vertex_arrays;
+	std::unordered_map<std::uint32_t, std::shared_ptr<frame_buffer>> frame_buffers;
+
+	template <class T> static const std::shared_ptr<T>& get(const std::unordered_map<std::uint32_t, std::shared_ptr<T>>& map, std::uint32_t id){
+		auto i = map.find(id);
+		if(i == map.end()){
+			throw std::invalid_argument("trace_player::play(): trace refers to unknown object");
+		}
+		return i->second;
+	}
+
+	std::shared_ptr<texture_2d> get_texture(std::uint32_t id)const{
+		if(id == 0){
+			return nullptr;
+		}
+		return get(this->textures, id);
+	}
+
+	void destroy(std::uint32_t id){
+		this->textures.erase(id);
+		this->vertex_buffers.erase(id);
+		this->index_buffers.erase(id);
+		this->vertex_arrays.erase(id);
+		this->frame_buffers.erase(id);
+	}
+};
+
+texture_2d::sampling read_sampling(render_trace::reader& t){
+	texture_2d::sampling ret;
+	ret.min_filter = texture_2d::filter(t.u8());
+	ret.mag_filter = texture_2d::filter(t.u8());
+	ret.mipmaps = texture_2d::mipmap(t.u8());
+	ret.wrap_s = texture_2d::wrap(t.u8());
+	ret.wrap_t = texture_2d::wrap(t.u8());
+	return ret;
+}
+
+std::vector<utki::span<const std::uint8_t>> read_mips(render_trace::reader& t){
+	std::vector<utki::span<const std::uint8_t>> ret;
+	// each mip level is stored with 4 bytes size
+	for(auto n = t.count(4); n != 0; --n){
+		ret.push_back(t.bytes());
+	}
+	return ret;
+}
+
+r4::rectangle<int> read_rectangle(render_trace::reader& t){
+	auto x = t.i32();
+	auto y = t.i32();
+	auto w = t.i32();
+	auto h = t.i32();
+	return r4::rectangle<int>(x, y, w, h);
+}
+
+std::shared_ptr<vertex_buffer> read_vertex_buffer(render_trace::reader& t, render_factory& f){
+	unsigned num_components = t.u8();
+	if(num_components == 0 || num_components > 4){
+		throw std::invalid_argument("trace_player::play(): invalid number of vertex components");
+	}
+	size_t size = t.count(num_components * sizeof(float));
+	switch(num_components){
+		case 1:
+			{
+				std::vector<float> v;
+				v.reserve(size);
+				for(size_t i = 0; i != size; ++i){
+					v.push_back(t.f32());
+				}
+				return f.create_vertex_buffer(utki::make_span(v));
+			}
+		case 2:
+			{
+				std::vector<r4::vector2<float>> v;
+				v.reserve(size);
+				for(size_t i = 0; i != size; ++i){
+					v.push_back(t.vec2());
+				}
+				return f.create_vertex_buffer(utki::make_span(v));
+			}
+		case 3:
+			{
+				std::vector<r4::vector3<float>> v;
+				v.reserve(size);
+				for(size_t i = 0; i != size; ++i){
+					auto x = t.f32();
+					auto y = t.f32();
+					auto z = t.f32();
+					v.push_back(r4::vector3<float>(x, y, z));
+				}
+				return f.create_vertex_buffer(utki::make_span(v));
+			}
+		case 4:
+			{
+				std::vector<r4::vector4<float>> v;
+				v.reserve(size);
+				for(size_t i = 0; i != size; ++i){
+					v.push_back(t.vec4());
+				}
+				return f.create_vertex_buffer(utki::make_span(v));
+			}
+		default:
+			ASSERT(false)
+			return nullptr;
+	}
+}
+
+void draw(render_trace::reader& t, renderer& r, const objects& o){
+	auto s = render_trace::shader(t.u8());
+	auto& va = *objects::get(o.vertex_arrays, t.u32());
+	auto m = t.mat();
+
+	auto shaders = r.shader.get();
+
+	switch(s){
+		case render_trace::shader::pos_tex:
+			{
+				auto tex = o.get_texture(t.u32());
+				if(shaders && shaders->pos_tex && tex){
+					shaders->pos_tex->render(m, va, *tex);
+				}
+			}
+			break;
+		case render_trace::shader::color_pos:
+			{
+				auto color = t.vec4();
+				if(shaders && shaders->color_pos){
+					shaders->color_pos->render(m, va, color);
+				}
+			}
+			break;
+		case render_trace::shader::color_pos_lum:
+			{
+				auto color = t.vec4();
+				if(shaders && shaders->color_pos_lum){
+					shaders->color_pos_lum->render(m, va, color);
+				}
+			}
+			break;
+		case render_trace::shader::pos_clr:
+			if(shaders && shaders->pos_clr){
+				shaders->pos_clr->render(m, va);
+			}
+			break;
+		case render_trace::shader::color_pos_tex:
+			{
+				auto color = t.vec4();
+				auto tex = o.get_texture(t.u32());
+				if(shaders && shaders->color_pos_tex && tex){
+					shaders->color_pos_tex->render(m, va, color, *tex);
+				}
+			}
+			break;
+		case render_trace::shader::color_pos_sdf:
+			{
+				auto color = t.vec4();
+				auto tex = o.get_texture(t.u32());
+				if(shaders && shaders->color_pos_sdf && tex){
+					shaders->color_pos_sdf->render(m, va, color, *tex);
+				}
+			}
+			break;
+		default:
+			throw std::invalid_argument("trace_player::play(): unknown shader");
+	}
+}
+}
+
+trace_player::trace_player(std::vector<std::uint8_t>&& trace) :
+		trace(std::move(trace))
+{
+	// check the magic
+	render_trace::reader(utki::make_span(this->trace));
+}
+
+trace_player::trace_player(const papki::file& fi) :
+		trace_player(fi.load())
+{}
+
+trace_player::report trace_player::play(renderer& r)const{
+	report ret;
+
+	auto initial_counters = r.get_state_counters();
+
+	objects o;
+
+	auto& f = *r.factory;
+
+	render_trace::reader t(utki::make_span(this->trace));
+
+	auto start = std::chrono::steady_clock::now();
+	auto frame_start = start;
+
+	while(!t.empty()){
+		switch(t.op()){
+			case render_trace::opcode::create_texture:
+				{
+					auto id = t.u32();
+					auto type = texture_2d::type(t.u8());
+					auto w = t.u32();
+					auto h = t.u32();
+					o.textures[id] = f.create_texture_2d(type, r4::vector2<unsigned>(w, h), t.bytes());
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_mipmapped_texture:
+				{
+					auto id = t.u32();
+					auto type = texture_2d::type(t.u8());
+					auto w = t.u32();
+					auto h = t.u32();
+					auto params = read_sampling(t);
+					auto mips = read_mips(t);
+					o.textures[id] = f.create_texture_2d(type, r4::vector2<unsigned>(w, h), utki::make_span(mips), params);
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_compressed_texture:
+				{
+					auto id = t.u32();
+					auto c = texture_2d::compression(t.u8());
+					auto w = t.u32();
+					auto h = t.u32();
+					auto params = read_sampling(t);
+					auto mips = read_mips(t);
+					o.textures[id] = f.create_texture_2d(c, r4::vector2<unsigned>(w, h), utki::make_span(mips), params);
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_vertex_buffer:
+				{
+					auto id = t.u32();
+					o.vertex_buffers[id] = read_vertex_buffer(t, f);
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_index_buffer:
+				{
+					auto id = t.u32();
+					std::vector<std::uint16_t> indices(t.count(sizeof(std::uint16_t)));
+					for(auto& i : indices){
+						i = t.u16();
+					}
+					o.index_buffers[id] = f.create_index_buffer(utki::make_span(indices));
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_vertex_array:
+				{
+					auto id = t.u32();
+					std::vector<std::shared_ptr<vertex_buffer>> buffers(t.count(sizeof(std::uint32_t)));
+					for(auto& b : buffers){
+						b = objects::get(o.vertex_buffers, t.u32());
+					}
+					auto indices_id = t.u32();
+					std::shared_ptr<index_buffer> indices;
+					if(indices_id != 0){
+						indices = objects::get(o.index_buffers, indices_id);
+					}
+					auto mode = vertex_array::mode(t.u8());
+					o.vertex_arrays[id] = f.create_vertex_array(std::move(buffers), std::move(indices), mode);
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::create_framebuffer:
+				{
+					auto id = t.u32();
+					o.frame_buffers[id] = f.create_framebuffer(o.get_texture(t.u32()));
+					++ret.num_created_objects;
+				}
+				break;
+			case render_trace::opcode::destroy:
+				o.destroy(t.u32());
+				break;
+			case render_trace::opcode::set_framebuffer:
+				{
+					auto id = t.u32();
+					r.set_framebuffer(id == 0 ? nullptr : objects::get(o.frame_buffers, id));
+				}
+				break;
+			case render_trace::opcode::clear_framebuffer:
+				r.clear_framebuffer();
+				break;
+			case render_trace::opcode::set_scissor_enabled:
+				r.set_scissor_enabled(t.u8() != 0);
+				break;
+			case render_trace::opcode::set_scissor:
+				r.set_scissor(read_rectangle(t));
+				break;
+			case render_trace::opcode::set_viewport:
+				r.set_viewport(read_rectangle(t));
+				break;
+			case render_trace::opcode::set_blend_enabled:
+				r.set_blend_enabled(t.u8() != 0);
+				break;
+			case render_trace::opcode::set_blend_func:
+				{
+					auto src_color = renderer::blend_factor(t.u8());
+					auto dst_color = renderer::blend_factor(t.u8());
+					auto src_alpha = renderer::blend_factor(t.u8());
+					auto dst_alpha = renderer::blend_factor(t.u8());
+					r.set_blend_func(src_color, dst_color, src_alpha, dst_alpha);
+				}
+				break;
+			case render_trace::opcode::draw:
+				draw(t, r, o);
+				++ret.num_draws;
+				break;
+			case render_trace::opcode::draw_quads:
+				{
+					auto tex = o.get_texture(t.u32());
+					// each quad is stored as matrix, color and texture coordinates rectangle
+					std::vector<quad_instance> quads(t.count(24 * sizeof(float)));
+					for(auto& q : quads){
+						q.matrix = t.mat();
+						q.color = t.vec4();
+						q.tex_rect = t.vec4();
+					}
+					if(r.shader){
+						if(tex){
+							r.render_quads(utki::make_span(quads), *tex);
+						}else{
+							r.render_quads(utki::make_span(quads));
+						}
+					}
+					++ret.num_draws;
+					ret.num_instanced_quads += quads.size();
+				}
+				break;
+			case render_trace::opcode::end_frame:
+				{
+					auto now = std::chrono::steady_clock::now();
+					ret.frame_times.push_back(now - frame_start);
+					frame_start = now;
+					++ret.num_frames;
+				}
+				break;
+			default:
+				throw std::invalid_argument("trace_player::play(): unknown opcode");
+		}
+	}
+
+	ret.total_time = std::chrono::steady_clock::now() - start;
+
+	auto& c = r.get_state_counters();
+	ret.state_counters.num_changes = c.num_changes - initial_counters.num_changes;
+	ret.state_counters.num_skipped_changes = c.num_skipped_changes - initial_counters.num_skipped_changes;
+	ret.state_counters.num_cached_queries = c.num_cached_queries - initial_counters.num_cached_queries;
+
+	return ret;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include <papki/file.hpp>
+
+#include "renderer.hpp"
+
+namespace morda{
+
+/**
+ * @brief Render trace player.
+ * Replays render trace recorded by recording_renderer against any renderer:
+ * re-creates the recorded textures, buffers and framebuffers with the renderer's factory
+ * and re-issues the recorded render state changes and draw calls.
+ * Draw calls for which the renderer has no shader are counted, but not issued.
+ */
+class trace_player{
+	std::vector<std::uint8_t> trace;
+
+public:
+	/**
+	 * @brief Replay statistics.
+	 */
+	struct report{
+		/**
+		 * @brief Number of frames, i.e. number of recording_renderer::end_frame() calls.
+		 */
+		size_t num_frames = 0;
+
+		/**
+		 * @brief Number of shader draw calls.
+		 */
+		size_t num_draws = 0;
+
+		/**
+		 * @brief Number of quads drawn with instanced quad draw calls.
+		 */
+		size_t num_instanced_quads = 0;
+
+		/**
+		 * @brief Number of created textures, buffers, vertex arrays and framebuffers.
+		 */
+		size_t num_created_objects = 0;
+
+		/**
+		 * @brief Render state change counters of the renderer accumulated during the replay.
+		 */
+		renderer::state_counters state_counters;
+
+		/**
+		 * @brief Duration of each frame.
+		 * The commands after the last frame end are not counted as a frame.
+		 */
+		std::vector<std::chrono::steady_clock::duration> frame_times;
+
+		/**
+		 * @brief Duration of the whole replay.
+		 */
+		std::chrono::steady_clock::duration total_time{0};
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param trace - render trace.
+	 * @throw std::invalid_argument - in case the data is not a render trace.
+	 */
+	trace_player(std::vector<std::uint8_t>&& trace);
+
+	/**
+	 * @brief Constructor.
+	 * @param fi - file to load the render trace from.
+	 * @throw std::invalid_argument - in case the file is not a render trace.
+	 */
+	trace_player(const papki::file& fi);
+
+	/**
+	 * @brief Replay the trace.
+	 * The trace can be replayed several times.
+	 * @param r - renderer to replay the trace against.
+	 * @return replay statistics.
+	 * @throw std::invalid_argument - in case the trace is corrupted.
+	 */
+	report play(renderer& r)const;
+};
+
+}
@@ -2,6 +2,10 @@
 
 #include <cstddef>
 
+#include <r4/vector.hpp>
+
+#include <utki/span.hpp>
+
 namespace morda{
 	
 class vertex_buffer{
@@ -13,6 +17,33 @@ public:
 	{}
 
 	virtual ~vertex_buffer()noexcept{}
+
+	/**
+	 * @brief Replace vertex data.
+	 * Allows streaming the geometry which changes every frame through the same buffer,
+	 * instead of creating a new buffer each time.
+	 * The number of vertices and the vertex type must be the same as the buffer was created with.
+	 * Default implementation does nothing and returns false, meaning that the rendering backend
+	 * cannot update the buffer and a new one has to be created.
+	 * @param vertices - new vertex data.
+	 * @return true if the buffer was updated.
+	 * @return false if the buffer cannot be updated.
+	 */
+	virtual bool update(utki::span<const r4::vector4<float>> vertices){
+		return false;
+	}
+
+	virtual bool update(utki::span<const r4::vector3<float>> vertices){
+		return false;
+	}
+
+	virtual bool update(utki::span<const r4::vector2<float>> vertices){
+		return false;
+	}
+
+	virtual bool update(utki::span<const float> vertices){
+		return false;
+	}
 };
 
 }
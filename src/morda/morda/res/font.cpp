@@ -5,9 +5,12 @@
 #include "../util/util.hpp"
 
 #include "../fonts/texture_font.hxx"
+#include "../fonts/sdf_font.hxx"
 
 #include <utki/unicode.hpp>
 
+#include <papki/fs_file.hpp>
+
 #include <memory>
 
 using namespace morda;
@@ -20,26 +23,39 @@ res::font::font(
 		std::unique_ptr<const papki::file> file_italic,
 		std::unique_ptr<const papki::file> file_bold_italic,
 		unsigned font_size,
-		unsigned max_cached
+		unsigned max_cached,
+		bool sdf
 	) :
 		resource(std::move(context))
 {
-	this->fonts[unsigned(style::normal)] = std::make_unique<texture_font>(this->context, file_normal, font_size, max_cached);
+	// SDF fonts need the SDF shader
+	const auto& shaders = this->context->renderer->shader;
+	sdf = sdf && shaders && shaders->color_pos_sdf;
+
+	auto make_font = [this, sdf, font_size, max_cached](const papki::file& fi) -> std::unique_ptr<const morda::font>{
+		if(sdf){
+			return std::make_unique<sdf_font>(this->context, fi, real(font_size));
+		}
+		return std::make_unique<texture_font>(this->context, fi, font_size, max_cached);
+	};
+
+	this->fonts[unsigned(style::normal)] = make_font(file_normal);
 
 	if(file_bold){
-		this->fonts[unsigned(style::bold)] = std::make_unique<texture_font>(this->context, *file_bold, font_size, max_cached);
+		this->fonts[unsigned(style::bold)] = make_font(*file_bold);
 	}
 	if(file_italic){
-		this->fonts[unsigned(style::italic)] = std::make_unique<texture_font>(this->context, *file_italic, font_size, max_cached);
+		this->fonts[unsigned(style::italic)] = make_font(*file_italic);
 	}
 	if(file_bold_italic){
-		this->fonts[unsigned(style::bold_italic)] = std::make_unique<texture_font>(this->context, *file_bold_italic, font_size, max_cached);
+		this->fonts[unsigned(style::bold_italic)] = make_font(*file_bold_italic);
 	}
 }
 
 std::shared_ptr<res::font> res::font::load(morda::context& ctx, const treeml::forest& desc, const papki::file& fi){
 	unsigned fontSize = 13;
 	unsigned maxCached = unsigned(-1);
+	bool sdf = false;
 
 	std::unique_ptr<const papki::file> file_bold;
 	std::unique_ptr<const papki::file> file_italic;
@@ -50,6 +66,8 @@ std::shared_ptr<res::font> res::font::load(morda::context& ctx, const treeml::fo
 			fontSize = unsigned(parse_dimension_value(get_property_value(p), ctx.units));
 		}else if(p.value == "max_cached"){
 			maxCached = unsigned(get_property_value(p).to_uint32());
+		}else if(p.value == "sdf"){
+			sdf = get_property_value(p).to_bool();
 		}else if(p.value == "normal"){
 			fi.set_path(get_property_value(p).to_string());
 		}else if(p.value == "bold"){
@@ -68,6 +86,52 @@ std::shared_ptr<res::font> res::font::load(morda::context& ctx, const treeml::fo
 			std::move(file_italic),
 			std::move(file_bold_italic),
 			fontSize,
-			maxCached
+			maxCached,
+			sdf
 		);
 }
+
+void res::font::load_glyph_cache(const std::string& dir)const{
+	for(auto& f : this->fonts){
+		// SDF fonts have no glyph caches
+		auto tf = dynamic_cast<const texture_font*>(f.get());
+		if(!tf){
+			continue;
+		}
+		tf->load_glyph_cache(dir + tf->get_glyph_cache_name());
+	}
+}
+
+void res::font::save_glyph_cache(const std::string& dir)const{
+	for(auto& f : this->fonts){
+		auto tf = dynamic_cast<const texture_font*>(f.get());
+		if(!tf){
+			continue;
+		}
+		tf->save_glyph_cache(papki::fs_file(dir + tf->get_glyph_cache_name()));
+	}
+}
+
+morda::resource::memory_usage res::font::get_memory_usage()const{
+	memory_usage ret;
+	for(auto& f : this->fonts){
+		if(auto tf = dynamic_cast<const texture_font*>(f.get())){
+			tf->get_memory_usage(ret.cpu, ret.gpu);
+		}else if(auto sf = dynamic_cast<const sdf_font*>(f.get())){
+			sf->get_memory_usage(ret.cpu, ret.gpu);
+		}
+	}
+	return ret;
+}
+
+bool res::font::is_sdf()const noexcept{
+	return dynamic_cast<const sdf_font*>(this->fonts[unsigned(style::normal)].get()) != nullptr;
+}
+
+std::unique_ptr<const morda::font> res::font::resize(real size, style font_style)const{
+	auto sf = dynamic_cast<const sdf_font*>(&this->get(font_style));
+	if(!sf){
+		throw std::logic_error("res::font::resize(): font does not use SDF glyphs");
+	}
+	return sf->resize(size);
+}
@@ -23,6 +23,7 @@ namespace morda{ namespace res{
  * @param bold_italic - file to load bold italic font from, True-Type ttf file. If omitted, the bold italic font will be the same as normal.
  * @param chars - list of all chars for which the glyphs should be created.
  * @param size - size of glyphs, in length units, i.e.: no unit(pixels), dp, mm.
+ * @param sdf - optional, true or false. Use signed distance field glyphs, see is_sdf(). Default value is false.
  * 
  * Example:
  * @code
@@ -31,6 +32,12 @@ namespace morda{ namespace res{
  *     bold {Vera_bold.ttf}
  *     size {12dp}
  * }
+ *
+ * fnt_zoomable{
+ *     normal {Vera.ttf}
+ *     size {12dp}
+ *     sdf {true}
+ * }
  * @endcode
  */
 class font : public morda::resource{
@@ -55,7 +62,8 @@ public:
 			std::unique_ptr<const papki::file> file_italic,
 			std::unique_ptr<const papki::file> file_bold_italic,
 			unsigned font_size,
-			unsigned max_cached
+			unsigned max_cached,
+			bool sdf = false
 		);
 
 	~font()noexcept{}
@@ -72,6 +80,46 @@ public:
 		}
 		return *this->fonts[unsigned(style::normal)];
 	}
+
+	/**
+	 * @brief Check if the font uses signed distance field glyphs.
+	 * Signed distance field glyphs are rasterized once and are used for all font sizes,
+	 * they stay sharp when the text is scaled. SDF glyphs are used when requested by the resource
+	 * description and supported by the renderer, otherwise the glyphs are rasterized for the font size.
+	 * @return true in case the font uses SDF glyphs.
+	 * @return false otherwise.
+	 */
+	bool is_sdf()const noexcept;
+
+	/**
+	 * @brief Create font of another size.
+	 * The created font shares the signed distance field glyphs with this font resource,
+	 * so it is cheap to create and nothing is rasterized.
+	 * @param size - size of the font in pixels.
+	 * @param font_style - style of the font.
+	 * @return font of the requested size.
+	 * @throw std::logic_error - in case the font does not use SDF glyphs, see is_sdf().
+	 */
+	std::unique_ptr<const morda::font> resize(real size, style font_style = style::normal)const;
+
+	/**
+	 * @brief Load glyph caches.
+	 * Loads persistent glyph caches of all the font styles from the given directory.
+	 * SDF fonts do not use glyph caches.
+	 * Glyph cache files are named after the font file hash and the font size,
+	 * missing and outdated cache files are ignored.
+	 * @param dir - directory in the file system to load glyph caches from, with trailing '/'.
+	 */
+	void load_glyph_cache(const std::string& dir)const;
+
+	/**
+	 * @brief Save glyph caches.
+	 * Saves glyphs rasterized so far by all the font styles to persistent glyph caches in the given directory.
+	 * @param dir - directory in the file system to save glyph caches to, with trailing '/'.
+	 */
+	void save_glyph_cache(const std::string& dir)const;
+
+	memory_usage get_memory_usage()const override;
 	
 private:
 	static std::shared_ptr<font> load(morda::context& ctx, const ::treeml::forest& desc, const papki::file &fi);
@@ -1,4 +1,8 @@
+#include <map>
+#include <list>
+#include <array>
 #include <memory>
+#include <algorithm>
 
 #include <svgren/render.hpp>
 
@@ -14,6 +18,7 @@
 #include "../context.hpp"
 
 #include "../util/util.hpp"
+#include "../util/raster_image.hpp"
 
 using namespace morda;
 using namespace morda::res;
@@ -22,6 +27,35 @@ image::image(std::shared_ptr<morda::context> c) :
 		resource(std::move(c))
 {}
 
+void image::texture::render_quads(utki::span<const quad_instance> quads)const{
+	auto& r = *this->renderer;
+	for(auto& q : quads){
+		if(q.tex_rect == r4::vector4<float>(0, 0, 1, 1)){
+			this->render(q.matrix, *r.pos_tex_quad_01_vao);
+			continue;
+		}
+
+		// same vertex order as the unit quad
+		std::array<r4::vector2<float>, 4> tex_coords = {{
+			r4::vector2<float>(q.tex_rect.x(), q.tex_rect.y()),
+			r4::vector2<float>(q.tex_rect.x(), q.tex_rect.w()),
+			r4::vector2<float>(q.tex_rect.z(), q.tex_rect.w()),
+			r4::vector2<float>(q.tex_rect.z(), q.tex_rect.y())
+		}};
+
+		auto vao = r.factory->create_vertex_array(
+				{
+					r.quad_01_vbo,
+					r.factory->create_vertex_buffer(utki::make_span(tex_coords))
+				},
+				r.quad_indices,
+				vertex_array::mode::triangle_fan
+			);
+
+		this->render(q.matrix, *vao);
+	}
+}
+
 atlas_image::atlas_image(std::shared_ptr<morda::context> c, std::shared_ptr<res::texture> tex, const rectangle& rect) :
 		image(std::move(c)),
 		image::texture(this->context->renderer, abs(rect.d)),
@@ -69,6 +103,10 @@ void atlas_image::render(const matrix4& matrix, const vertex_array& vao)const{
 	this->context->renderer->shader->pos_tex->render(matrix, *this->vao, this->tex->tex());
 }
 
+void atlas_image::render_quads(utki::span<const quad_instance> quads)const{
+	this->context->renderer->render_quads(quads, this->tex->tex());
+}
+
 std::shared_ptr<const image::texture> atlas_image::get(vector2 forDim)const{
 	return utki::make_shared_from(*this);
 }
@@ -87,6 +125,78 @@ public:
 	void render(const matrix4& matrix, const vertex_array& vao)const override{
 		this->renderer->shader->pos_tex->render(matrix, vao, *this->tex_v);
 	}
+
+	void render_quads(utki::span<const quad_instance> quads)const override{
+		this->renderer->render_quads(quads, *this->tex_v);
+	}
+
+	size_t get_gpu_memory_usage()const noexcept{
+		return estimate_gpu_memory_usage(*this->tex_v);
+	}
+};
+
+// Cache of textures of the image rendered or decoded at different sizes.
+// The textures are shared by all users requesting the same size. The most recently requested textures
+// are also kept alive by the cache, so that the image is not rendered again when its only user goes away
+// and a new one comes, e.g. when a widget is re-created.
+template <class T> class texture_cache{
+	std::map<r4::vector2<unsigned>, std::weak_ptr<T>> textures;
+
+	// most recently requested first
+	std::list<std::shared_ptr<T>> retained;
+
+	void retain(std::shared_ptr<T> t){
+		auto i = std::find(this->retained.begin(), this->retained.end(), t);
+		if(i != this->retained.end()){
+			this->retained.splice(this->retained.begin(), this->retained, i);
+			return;
+		}
+
+		this->retained.push_front(std::move(t));
+
+		if(this->retained.size() > max_num_retained){
+			// the texture's destructor can call erase_expired()
+			this->retained.pop_back();
+		}
+	}
+public:
+	constexpr static const size_t max_num_retained = 2;
+
+	std::shared_ptr<T> get(r4::vector2<unsigned> key){
+		auto i = this->textures.find(key);
+		if(i == this->textures.end()){
+			return nullptr;
+		}
+
+		auto t = i->second.lock();
+		if(t){
+			this->retain(t);
+		}
+		return t;
+	}
+
+	void insert(r4::vector2<unsigned> key, std::shared_ptr<T> t){
+		this->textures[key] = t;
+		this->retain(std::move(t));
+	}
+
+	// to be called from the texture's destructor
+	void erase_expired(r4::vector2<unsigned> key)noexcept{
+		auto i = this->textures.find(key);
+		if(i != this->textures.end() && i->second.expired()){
+			this->textures.erase(i);
+		}
+	}
+
+	size_t get_gpu_memory_usage()const noexcept{
+		size_t ret = 0;
+		for(auto& t : this->textures){
+			if(auto p = t.second.lock()){
+				ret += p->get_gpu_memory_usage();
+			}
+		}
+		return ret;
+	}
 };
 	
 class res_raster_image :
@@ -106,9 +216,87 @@ public:
 	vector2 dims(real dpi)const noexcept override{
 		return this->tex_v->dims();
 	}
+
+	memory_usage get_memory_usage()const override{
+		memory_usage ret;
+		ret.gpu = estimate_gpu_memory_usage(*this->tex_v);
+		return ret;
+	}
 	
-	static std::shared_ptr<res_raster_image> load(morda::context& ctx, const papki::file& fi){
-		return std::make_shared<res_raster_image>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi));
+	static std::shared_ptr<res_raster_image> load(morda::context& ctx, const papki::file& fi, const texture_2d::sampling& params = texture_2d::sampling()){
+		return std::make_shared<res_raster_image>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi, params));
+	}
+};
+
+class res_decoded_raster_image : public image{
+	const std::unique_ptr<const papki::file> fi;
+	const r4::vector2<unsigned> full_dims;
+	const texture_2d::sampling params;
+public:
+	res_decoded_raster_image(std::shared_ptr<morda::context> c, std::unique_ptr<const papki::file> fi, const texture_2d::sampling& params) :
+			image(std::move(c)),
+			fi(std::move(fi)),
+			full_dims(raster_image::read_dims(*this->fi)),
+			params(params)
+	{}
+
+	vector2 dims(real dpi)const noexcept override{
+		return this->full_dims.to<real>();
+	}
+
+	class decoded_texture : public fixed_texture{
+		std::weak_ptr<const res_decoded_raster_image> parent;
+		const r4::vector2<unsigned> key;
+	public:
+		decoded_texture(std::shared_ptr<morda::renderer> r, std::shared_ptr<const res_decoded_raster_image> parent, r4::vector2<unsigned> key, std::shared_ptr<texture_2d> tex) :
+				fixed_texture(std::move(r), std::move(tex)),
+				parent(parent),
+				key(key)
+		{}
+
+		~decoded_texture()noexcept{
+			if(auto p = this->parent.lock()){
+				p->cache.erase_expired(this->key);
+			}
+		}
+	};
+
+	std::shared_ptr<const texture> get(vector2 forDim)const override{
+		auto dims_request = forDim.to<unsigned>();
+
+		// image is decoded at the smallest size which is not less than requested,
+		// so different requests may share the same texture
+		auto dims = raster_image::get_decoded_dims(*this->fi, this->full_dims, dims_request);
+
+		if(auto t = this->cache.get(dims)){
+			return t;
+		}
+
+		auto tex = load_texture(*this->context->renderer, *this->fi, this->params, dims_request);
+		ASSERT_INFO(tex->dims().to<unsigned>() == dims, "tex->dims() = " << tex->dims() << ", dims = " << dims)
+
+		auto img = std::make_shared<decoded_texture>(
+				this->context->renderer,
+				utki::make_shared_from(*this),
+				dims,
+				std::move(tex)
+			);
+
+		this->cache.insert(dims, img);
+
+		return img;
+	}
+
+	memory_usage get_memory_usage()const override{
+		memory_usage ret;
+		ret.gpu = this->cache.get_gpu_memory_usage();
+		return ret;
+	}
+
+	mutable texture_cache<decoded_texture> cache;
+
+	static std::shared_ptr<res_decoded_raster_image> load(morda::context& ctx, const papki::file& fi, const texture_2d::sampling& params = texture_2d::sampling()){
+		return std::make_shared<res_decoded_raster_image>(utki::make_shared_from(ctx), fi.spawn(fi.path()), params);
 	}
 };
 
@@ -128,16 +316,17 @@ public:
 	
 	class svg_texture : public fixed_texture{
 		std::weak_ptr<const res_svg_image> parent;
+		const r4::vector2<unsigned> key;
 	public:
-		svg_texture(std::shared_ptr<morda::renderer> r, std::shared_ptr<const res_svg_image> parent, std::shared_ptr<texture_2d> tex) :
+		svg_texture(std::shared_ptr<morda::renderer> r, std::shared_ptr<const res_svg_image> parent, r4::vector2<unsigned> key, std::shared_ptr<texture_2d> tex) :
 				fixed_texture(std::move(r), std::move(tex)),
-				parent(parent)
+				parent(parent),
+				key(key)
 		{}
 
 		~svg_texture()noexcept{
 			if(auto p = this->parent.lock()){
-				r4::vector2<unsigned> d = this->tex_v->dims().to<unsigned>();
-				p->cache.erase(d);
+				p->cache.erase_expired(this->key);
 			}
 		}
 	};
@@ -145,13 +334,12 @@ public:
 	std::shared_ptr<const texture> get(vector2 forDim)const override{
 //		TRACE(<< "forDim = " << forDim << std::endl)
 
-		{ // check if in cache
-			auto i = this->cache.find(forDim.to<unsigned>());
-			if(i != this->cache.end()){
-				if(auto p = i->second.lock()){
-					return p;
-				}
-			}
+		// the texture is cached by requested dimensions, as the dimensions of the rendered image
+		// are not known before rendering
+		auto dims_request = forDim.to<unsigned>();
+
+		if(auto t = this->cache.get(dims_request)){
+			return t;
 		}
 //		TRACE(<< "not in cache" << std::endl)
 
@@ -162,7 +350,7 @@ public:
 //		TRACE(<< "id = " << this->dom->id << std::endl)
 		svgren::parameters svg_params;
 		svg_params.dpi = unsigned(this->context->units.dots_per_inch);
-		svg_params.dims_request = forDim.to<unsigned>();
+		svg_params.dims_request = dims_request;
 		auto svg = svgren::render(*this->dom, svg_params);
 		ASSERT(svg.dims.x() != 0)
 		ASSERT(svg.dims.y() != 0)
@@ -171,15 +359,22 @@ public:
 		auto img = std::make_shared<svg_texture>(
 				this->context->renderer,
 				utki::make_shared_from(*this),
+				dims_request,
 				this->context->renderer->factory->create_texture_2d(svg.dims, utki::make_span(svg.pixels))
 			);
 
-		this->cache[svg.dims] = img;
+		this->cache.insert(dims_request, img);
 
 		return img;
 	}
+
+	memory_usage get_memory_usage()const override{
+		memory_usage ret;
+		ret.gpu = this->cache.get_gpu_memory_usage();
+		return ret;
+	}
 	
-	mutable std::map<r4::vector2<unsigned>, std::weak_ptr<texture>> cache;
+	mutable texture_cache<svg_texture> cache;
 	
 	static std::shared_ptr<res_svg_image> load(morda::context& ctx, const papki::file& fi){
 		return std::make_shared<res_svg_image>(utki::make_shared_from(ctx), svgdom::load(fi));
@@ -187,11 +382,23 @@ public:
 };
 }
 
+namespace{
+bool is_decoded_raster_image(const papki::file& fi){
+	auto ext = fi.suffix();
+	return ext == "png" || ext == "jpg";
+}
+}
+
 std::shared_ptr<image> image::load(morda::context& ctx, const treeml::forest& desc, const papki::file& fi) {
 	for(auto& p : desc){
 		if(p.value == "file"){
 			fi.set_path(get_property_value(p).to_string());
-			return image::load(ctx, fi);
+			if(fi.suffix().compare("svg") == 0){
+				return res_svg_image::load(ctx, fi);
+			}else if(is_decoded_raster_image(fi)){
+				return res_decoded_raster_image::load(ctx, fi, parse_texture_sampling(desc));
+			}
+			return res_raster_image::load(ctx, fi, parse_texture_sampling(desc));
 		}
 	}
 
@@ -201,6 +408,8 @@ std::shared_ptr<image> image::load(morda::context& ctx, const treeml::forest& de
 std::shared_ptr<image> image::load(morda::context& ctx, const papki::file& fi) {
 	if(fi.suffix().compare("svg") == 0){
 		return res_svg_image::load(ctx, fi);
+	}else if(is_decoded_raster_image(fi)){
+		return res_decoded_raster_image::load(ctx, fi);
 	}else{
 		return res_raster_image::load(ctx, fi);
 	}
@@ -17,7 +17,16 @@ namespace morda{ namespace res{
  * 
  * %resource description:
  * 
- * @param file - name of the file to read the image from, can be raster image or SVG.
+ * @param file - name of the file to read the image from, can be raster image, KTX texture file or SVG.
+ * @param filter, min_filter, mag_filter, mipmap, wrap, wrap_s, wrap_t - optional, texture sampling parameters
+ *        for raster images, see morda::res::texture.
+ * 
+ * PNG and JPG images are decoded lazily, at the size requested by get(), so that a big image
+ * shown in a small widget does not occupy memory for its full resolution.
+ * SVG images are rendered at the size requested by get().
+ * Textures of decoded PNG, JPG and SVG images are shared between requests of the same size,
+ * the most recently requested ones are kept alive by the resource even when unused,
+ * their memory is reported by get_memory_usage().
  * 
  * Example:
  * @code
@@ -64,6 +73,15 @@ public:
 		 * @param vao - vertex array to use for rendering.
 		 */
 		virtual void render(const matrix4& matrix, const vertex_array& vao)const = 0;
+
+		/**
+		 * @brief Render quads with this texture.
+		 * The quads are rendered with renderer::render_quads(), i.e. all at once in case the rendering backend supports instancing.
+		 * The default implementation renders the quads one by one with render(), the quad colors are not applied then.
+		 * @param quads - quads to render. Texture coordinates rectangles are given relative to the image,
+		 *                i.e. (0, 0, 1, 1) covers the whole image.
+		 */
+		virtual void render_quads(utki::span<const quad_instance> quads)const;
 	};
 
 	/**
@@ -82,6 +100,7 @@ public:
 	 * @param forDims - dimensions request for raster texture.
 	 *        If any of the dimensions is 0 then it will be adjusted to preserve aspect ratio.
 	 *        If both dimensions are zero, then dimensions which are natural for the particular image will be used.
+	 *        Raster images may return a texture bigger than requested, but not bigger than the natural dimensions.
 	 */
 	virtual std::shared_ptr<const texture> get(vector2 forDims = 0)const = 0;
 private:
@@ -122,6 +141,8 @@ public:
 	virtual std::shared_ptr<const image::texture> get(vector2 forDim)const override;
 	
 	void render(const matrix4& matrix, const vertex_array& vao) const override;
+
+	void render_quads(utki::span<const quad_instance> quads)const override;
 	
 private:
 	static std::shared_ptr<atlas_image> load(morda::context& ctx, const ::treeml::forest& desc, const papki::file& fi);
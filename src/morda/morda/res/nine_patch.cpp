@@ -1,5 +1,8 @@
 #include "nine_patch.hpp"
 
+#include <array>
+#include <vector>
+#include <algorithm>
 #include <iomanip>
 
 #include "../context.hpp"
@@ -20,6 +23,9 @@ class ResSubImage :
 	std::shared_ptr<const res::image::texture> tex;
 	
 	std::shared_ptr<vertex_array> vao;
+
+	// texture coordinates of the top left and bottom right corners of the sub-image within the parent image
+	r4::vector4<float> tex_rect;
 	
 public:
 	// rect is a rectangle on the texture, Y axis down.
@@ -34,6 +40,7 @@ public:
 		texCoords[1] = rect.x1_y2().comp_div(this->tex->dims);
 		texCoords[2] = rect.x2_y2().comp_div(this->tex->dims);
 		texCoords[3] = rect.x2_y1().comp_div(this->tex->dims);
+		this->tex_rect = r4::vector4<float>(texCoords[0].x(), texCoords[0].y(), texCoords[2].x(), texCoords[2].y());
 //		TRACE(<< "this->texCoords = (" << texCoords[0] << ", " << texCoords[1] << ", " << texCoords[2] << ", " << texCoords[3] << ")" << std::endl)
 		auto& r = *this->context->renderer;
 		this->vao = r.factory->create_vertex_array(
@@ -61,6 +68,35 @@ public:
 		ASSERT(this->tex)
 		this->tex->render(matrix, *this->vao);
 	}
+
+	void render_quads(utki::span<const quad_instance> quads)const override{
+		ASSERT(this->tex)
+
+		// single quad covering the whole sub-image, e.g. a nine-patch part, is drawn with own vertex array
+		if(quads.size() == 1 && quads.front().tex_rect == r4::vector4<float>(0, 0, 1, 1) && quads.front().color == r4::vector4<float>(1)){
+			this->tex->render(quads.front().matrix, *this->vao);
+			return;
+		}
+
+		auto d = vector2(this->tex_rect.z() - this->tex_rect.x(), this->tex_rect.w() - this->tex_rect.y());
+
+		// map texture coordinates of the quads to the sub-image, in chunks, to avoid heap allocation
+		std::array<quad_instance, 16> mapped;
+		for(size_t i = 0; i != quads.size();){
+			size_t n = std::min(quads.size() - i, mapped.size());
+			for(size_t j = 0; j != n; ++j, ++i){
+				auto& q = mapped[j];
+				q = quads[i];
+				q.tex_rect = r4::vector4<float>(
+						this->tex_rect.x() + q.tex_rect.x() * d.x(),
+						this->tex_rect.y() + q.tex_rect.y() * d.y(),
+						this->tex_rect.x() + q.tex_rect.z() * d.x(),
+						this->tex_rect.y() + q.tex_rect.w() * d.y()
+					);
+			}
+			this->tex->render_quads(utki::make_span(mapped.data(), n));
+		}
+	}
 };
 
 }
@@ -8,11 +8,28 @@ using namespace morda;
 using namespace morda::res;
 
 std::shared_ptr<texture> texture::load(morda::context& ctx, const treeml::forest& desc, const papki::file& fi){
+	std::string fallback_file;
+
 	for(auto& p: desc){
 		if(p.value == "file"){
 			fi.set_path(get_property_value(p).to_string());
+		}else if(p.value == "fallback_file"){
+			fallback_file = get_property_value(p).to_string();
 		}
 	}
 
-	return std::make_shared<texture>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi));
+	auto params = parse_texture_sampling(desc);
+
+	if(fallback_file.empty()){
+		return std::make_shared<texture>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi, params));
+	}
+
+	try{
+		return std::make_shared<texture>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi, params));
+	}catch(std::runtime_error& e){
+		TRACE(<< "texture::load(): could not load texture, using fallback file: " << e.what() << std::endl)
+	}
+
+	fi.set_path(fallback_file);
+	return std::make_shared<texture>(utki::make_shared_from(ctx), load_texture(*ctx.renderer, fi, params));
 }
@@ -15,13 +15,28 @@ namespace morda{ namespace res{
  * 
  * %resource description:
  * 
- * @param file - name of the image file, can be raster image.
+ * @param file - name of the image file, can be raster image or KTX texture file.
+ * @param fallback_file - optional, name of the image file to use in case the main file could not be loaded,
+ *                        e.g. when the KTX file holds GPU compressed texture in the format not supported by the renderer.
+ * @param filter - optional, texture filtering: nearest or linear. Default value is linear.
+ *                 Can be set separately for minification and magnification by min_filter and mag_filter.
+ * @param mipmap - optional, mipmap filtering: none, nearest or linear. Default value is none.
+ *                 Mipmaps are taken from the KTX file or generated by the renderer.
+ * @param wrap - optional, texture coordinates wrapping: repeat, mirrored_repeat or clamp. Default value is repeat.
+ *               Can be set separately for each coordinate by wrap_s and wrap_t.
  * 
  * Example:
  * @code
  * tex_sample{
  *     file{texture_sample.png}
  * }
+ *
+ * tex_catalog_background{
+ *     file{catalog_background.ktx}
+ *     fallback_file{catalog_background.png}
+ *     mipmap{linear}
+ *     wrap{clamp}
+ * }
  * @endcode
  */
 class texture : public morda::resource{
@@ -51,6 +66,12 @@ public:
 		return *this->tex_v;
 	}
 
+	memory_usage get_memory_usage()const override{
+		memory_usage ret;
+		ret.gpu = estimate_gpu_memory_usage(*this->tex_v);
+		return ret;
+	}
+
 private:
 	static std::shared_ptr<texture> load(morda::context& ctx, const ::treeml::forest& desc, const papki::file& fi);
 };
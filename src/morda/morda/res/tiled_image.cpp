@@ -0,0 +1,484 @@
+#include "tiled_image.hpp"
+
+#include <array>
+#include <algorithm>
+
+#include "../context.hpp"
+
+#include "../util/util.hpp"
+
+using namespace morda;
+using namespace morda::res;
+
+namespace{
+r4::vector2<unsigned> calc_level_dims(r4::vector2<unsigned> dims, unsigned level)noexcept{
+	r4::vector2<unsigned> ret;
+	for(unsigned i = 0; i != ret.size(); ++i){
+		// round up
+		ret[i] = unsigned(((std::uint64_t(dims[i]) + (std::uint64_t(1) << level)) - 1) >> level);
+	}
+	return ret;
+}
+}
+
+namespace{
+unsigned calc_num_levels(r4::vector2<unsigned> dims, unsigned tile_size){
+	if(tile_size == 0){
+		throw std::invalid_argument("tiled_image::tiled_image(): tile size is zero");
+	}
+
+	if(dims.x() == 0 || dims.y() == 0){
+		throw std::invalid_argument("tiled_image::tiled_image(): image dimensions are zero");
+	}
+
+	unsigned ret = 1;
+	for(auto d = dims; d.x() > tile_size || d.y() > tile_size; d = calc_level_dims(dims, ret - 1)){
+		++ret;
+	}
+	return ret;
+}
+}
+
+namespace{
+// pyramid levels are generated when a tile of the level is requested, on the loading thread,
+// the least recently used levels are dropped when the generated levels exceed the memory budget
+class pyramid{
+	std::mutex mutex;
+
+	// image file to decode the levels from, null if the image is in memory
+	const std::unique_ptr<const papki::file> fi;
+
+	const r4::vector2<unsigned> dims;
+
+	struct level{
+		// empty image if the level is not generated
+		raster_image image;
+
+		// value of the use counter when a tile was last cut from the level
+		std::uint64_t last_used = 0;
+	};
+
+	std::vector<level> levels;
+
+	std::uint64_t use_counter = 0;
+
+	const size_t memory_budget;
+
+	// bytes held by the generated levels, the full resolution image in memory is not counted
+	size_t memory_used = 0;
+
+	bool is_evictable(unsigned level)const noexcept{
+		// level 0 of the image in memory cannot be generated again
+		return level != 0 || this->fi;
+	}
+
+	void evict(unsigned keep_level){
+		while(this->memory_used > this->memory_budget){
+			auto lru = this->levels.size();
+			for(unsigned l = 0; l != this->levels.size(); ++l){
+				if(l == keep_level || !this->is_evictable(l) || this->levels[l].image.dims().x() == 0){
+					continue;
+				}
+				if(lru == this->levels.size() || this->levels[l].last_used < this->levels[lru].last_used){
+					lru = l;
+				}
+			}
+
+			if(lru == this->levels.size()){
+				return;
+			}
+
+			auto& im = this->levels[lru].image;
+			this->memory_used -= im.pixels().size();
+			im = raster_image();
+		}
+	}
+
+	raster_image generate_level(unsigned level){
+		auto level_dims = calc_level_dims(this->dims, level);
+
+		// downscale the closest finer level which is generated already
+		for(unsigned l = level; l != 0;){
+			--l;
+			if(this->levels[l].image.dims().x() != 0){
+				return this->levels[l].image.downscale(level_dims);
+			}
+		}
+
+		// level 0 of the image in memory is always there
+		ASSERT(this->fi)
+
+		// PNG is downscaled while decoding, so the full resolution image is not held in memory,
+		// JPG reduction while decoding is limited, so it may need to be downscaled further
+		raster_image ret(*this->fi, level_dims);
+		if(ret.dims() != level_dims){
+			ret = ret.downscale(level_dims);
+		}
+		return ret;
+	}
+
+	const raster_image& get_level(unsigned level){
+		ASSERT(level < this->levels.size())
+		auto& l = this->levels[level];
+		l.last_used = ++this->use_counter;
+
+		if(l.image.dims().x() == 0){
+			l.image = this->generate_level(level);
+			if(this->is_evictable(level)){
+				this->memory_used += l.image.pixels().size();
+			}
+			this->evict(level);
+		}
+
+		return l.image;
+	}
+
+public:
+	pyramid(raster_image&& image, unsigned num_levels, size_t memory_budget) :
+			dims(image.dims()),
+			levels(num_levels),
+			memory_budget(memory_budget)
+	{
+		this->levels.front().image = std::move(image);
+	}
+
+	pyramid(std::unique_ptr<const papki::file> fi, r4::vector2<unsigned> dims, unsigned num_levels, size_t memory_budget) :
+			fi(std::move(fi)),
+			dims(dims),
+			levels(num_levels),
+			memory_budget(memory_budget)
+	{
+		// full resolution tiles are cut from the fully decoded image, assume the worst case of 4 bytes per pixel
+		if(std::uint64_t(dims.x()) * std::uint64_t(dims.y()) * 4 > this->memory_budget){
+			throw std::invalid_argument(
+					"tiled_image::tiled_image(): decoded image does not fit into memory budget, "
+					"cut the image into tile files instead"
+				);
+		}
+	}
+
+	raster_image get_tile(unsigned level, r4::vector2<unsigned> index, unsigned tile_size){
+		std::lock_guard<std::mutex> lock_guard(this->mutex);
+
+		auto& im = this->get_level(level);
+
+		auto pos = index * tile_size;
+		ASSERT(pos.x() < im.dims().x() && pos.y() < im.dims().y())
+
+		using std::min;
+		r4::vector2<unsigned> d(
+				min(tile_size, im.dims().x() - pos.x()),
+				min(tile_size, im.dims().y() - pos.y())
+			);
+
+		return raster_image(pos, d, im);
+	}
+};
+
+tiled_image::tile_loader_type make_pyramid_loader(std::shared_ptr<pyramid> p, unsigned tile_size){
+	return [p, tile_size](unsigned level, r4::vector2<unsigned> index){
+		return p->get_tile(level, index, tile_size);
+	};
+}
+}
+
+tiled_image::tiled_image(
+		std::shared_ptr<morda::context> c,
+		r4::vector2<unsigned> dims,
+		unsigned tile_size,
+		tile_loader_type&& load_tile,
+		const texture_2d::sampling& params
+	) :
+		resource(std::move(c)),
+		dims_v(dims),
+		tile_size_v(tile_size),
+		num_levels_v(calc_num_levels(this->dims_v, this->tile_size_v)),
+		params(params),
+		load_tile(std::move(load_tile))
+{
+	if(!this->load_tile){
+		throw std::invalid_argument("tiled_image::tiled_image(): tile loading function is not set");
+	}
+}
+
+tiled_image::tiled_image(
+		std::shared_ptr<morda::context> c,
+		raster_image&& image,
+		unsigned tile_size,
+		const texture_2d::sampling& params,
+		size_t decoded_memory_budget
+	) :
+		resource(std::move(c)),
+		dims_v(image.dims()),
+		tile_size_v(tile_size),
+		num_levels_v(calc_num_levels(this->dims_v, this->tile_size_v)),
+		params(params),
+		load_tile(make_pyramid_loader(
+				std::make_shared<pyramid>(std::move(image), this->num_levels_v, decoded_memory_budget),
+				this->tile_size_v
+			))
+{}
+
+tiled_image::tiled_image(
+		std::shared_ptr<morda::context> c,
+		std::unique_ptr<const papki::file> fi,
+		unsigned tile_size,
+		const texture_2d::sampling& params,
+		size_t decoded_memory_budget
+	) :
+		resource(std::move(c)),
+		dims_v(raster_image::read_dims(*fi)),
+		tile_size_v(tile_size),
+		num_levels_v(calc_num_levels(this->dims_v, this->tile_size_v)),
+		params(params),
+		load_tile(make_pyramid_loader(
+				std::make_shared<pyramid>(std::move(fi), this->dims_v, this->num_levels_v, decoded_memory_budget),
+				this->tile_size_v
+			))
+{}
+
+tiled_image::~tiled_image()noexcept{
+	{
+		std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+		this->quit = true;
+	}
+	this->cv.notify_all();
+
+	if(this->thread.joinable()){
+		this->thread.join();
+	}
+}
+
+std::shared_ptr<tiled_image> tiled_image::load(morda::context& ctx, const treeml::forest& desc, const papki::file& fi){
+	r4::vector2<unsigned> dims(0);
+	unsigned tile_size = default_tile_size;
+	std::string format = "png";
+
+	for(auto& p : desc){
+		if(p.value == "file"){
+			fi.set_path(get_property_value(p).to_string());
+		}else if(p.value == "dims"){
+			dims = parse_vec2(p.children).to<unsigned>();
+		}else if(p.value == "tile_size"){
+			tile_size = get_property_value(p).to_uint32();
+		}else if(p.value == "format"){
+			format = get_property_value(p).to_string();
+		}
+	}
+
+	if(!fi.is_dir()){
+		// single image file, the pyramid is generated from it
+		return std::make_shared<tiled_image>(
+				utki::make_shared_from(ctx),
+				fi.spawn(fi.path()),
+				tile_size,
+				parse_texture_sampling(desc)
+			);
+	}
+
+	if(dims.x() == 0 || dims.y() == 0){
+		throw std::invalid_argument("tiled_image::load(): image dimensions are not specified");
+	}
+
+	std::shared_ptr<const papki::file> dir = fi.spawn(fi.path());
+
+	// file objects are not thread safe, so the tile files are spawned under the mutex
+	auto mutex = std::make_shared<std::mutex>();
+
+	return std::make_shared<tiled_image>(
+			utki::make_shared_from(ctx),
+			dims,
+			tile_size,
+			[dir, mutex, format](unsigned level, r4::vector2<unsigned> index){
+				std::unique_ptr<papki::file> f;
+				{
+					std::lock_guard<std::mutex> lock_guard(*mutex);
+					f = dir->spawn(
+							dir->path() + std::to_string(level) + "/" +
+									std::to_string(index.x()) + "_" + std::to_string(index.y()) + "." + format
+						);
+				}
+				return raster_image(*f);
+			},
+			parse_texture_sampling(desc)
+		);
+}
+
+r4::vector2<unsigned> tiled_image::get_level_dims(unsigned level)const noexcept{
+	ASSERT(level < this->num_levels())
+	return calc_level_dims(this->dims_v, level);
+}
+
+r4::vector2<unsigned> tiled_image::get_num_tiles(unsigned level)const noexcept{
+	auto d = this->get_level_dims(level);
+	return r4::vector2<unsigned>(
+			(d.x() + this->tile_size_v - 1) / this->tile_size_v,
+			(d.y() + this->tile_size_v - 1) / this->tile_size_v
+		);
+}
+
+r4::rectangle<unsigned> tiled_image::get_tile_rect(unsigned level, r4::vector2<unsigned> index, bool full_res)const noexcept{
+	ASSERT(index.x() < this->get_num_tiles(level).x() && index.y() < this->get_num_tiles(level).y())
+
+	auto level_dims = this->get_level_dims(level);
+
+	r4::rectangle<unsigned> ret;
+	ret.p = index * this->tile_size_v;
+
+	using std::min;
+	ret.d.x() = min(this->tile_size_v, level_dims.x() - ret.p.x());
+	ret.d.y() = min(this->tile_size_v, level_dims.y() - ret.p.y());
+
+	if(!full_res){
+		return ret;
+	}
+
+	// each pixel of the level covers 2^level x 2^level square of full resolution pixels,
+	// the last row and column can be cut by the image edge
+	for(unsigned i = 0; i != ret.p.size(); ++i){
+		std::uint64_t begin = std::uint64_t(ret.p[i]) << level;
+		std::uint64_t end = min(std::uint64_t(ret.p[i] + ret.d[i]) << level, std::uint64_t(this->dims_v[i]));
+		ret.p[i] = unsigned(begin);
+		ret.d[i] = unsigned(end - begin);
+	}
+
+	return ret;
+}
+
+std::shared_ptr<texture_2d> tiled_image::get_tile(unsigned level, r4::vector2<unsigned> index){
+	auto i = this->cache.find(get_tile_key(level, index));
+	if(i == this->cache.end()){
+		return nullptr;
+	}
+
+	this->lru.splice(this->lru.begin(), this->lru, i->second.lru_iter);
+
+	return i->second.tex;
+}
+
+void tiled_image::request_tile(unsigned level, r4::vector2<unsigned> index){
+	ASSERT(level < this->num_levels())
+	ASSERT(index.x() < this->get_num_tiles(level).x() && index.y() < this->get_num_tiles(level).y())
+
+	auto key = get_tile_key(level, index);
+
+	if(this->cache.find(key) != this->cache.end() || this->failed.find(key) != this->failed.end()){
+		return;
+	}
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	if(this->loading.find(key) != this->loading.end()){
+		// move to the front of the queue, unless the tile is being loaded already
+		auto i = this->queued.find(key);
+		if(i != this->queued.end()){
+			this->queue.splice(this->queue.begin(), this->queue, i->second);
+		}
+		return;
+	}
+
+	this->loading.insert(key);
+	this->queue.push_front(key);
+	this->queued.insert(std::make_pair(key, this->queue.begin()));
+
+	if(this->queue.size() > max_num_queued_tiles){
+		auto k = this->queue.back();
+		this->queue.pop_back();
+		this->queued.erase(k);
+		this->loading.erase(k);
+	}
+
+	if(!this->thread.joinable()){
+		this->thread = std::thread([this, w = utki::make_weak_from(*this)](){
+			this->thread_func(w);
+		});
+	}
+
+	this->cv.notify_one();
+}
+
+void tiled_image::thread_func(std::weak_ptr<tiled_image> weak_this){
+	for(;;){
+		std::uint64_t key;
+		{
+			std::unique_lock<decltype(this->mutex)> lock(this->mutex);
+			this->cv.wait(lock, [this](){
+				return this->quit || !this->queue.empty();
+			});
+
+			if(this->quit){
+				return;
+			}
+
+			key = this->queue.front();
+			this->queue.pop_front();
+			this->queued.erase(key);
+		}
+
+		unsigned level = unsigned(key >> 58);
+		r4::vector2<unsigned> index(
+				unsigned((key >> 29) & ((std::uint64_t(1) << 29) - 1)),
+				unsigned(key & ((std::uint64_t(1) << 29) - 1))
+			);
+
+		std::shared_ptr<raster_image> im;
+		try{
+			im = std::make_shared<raster_image>(this->load_tile(level, index));
+		}catch(std::exception& e){
+			TRACE(<< "tiled_image::thread_func(): could not load tile " << level << " " << index << ": " << e.what() << std::endl)
+		}
+
+		// textures can only be created on UI thread
+		this->context->task_queue.post([weak_this, key, im](){
+			if(auto t = weak_this.lock()){
+				t->on_tile_loaded(key, im.get());
+			}
+		});
+	}
+}
+
+void tiled_image::on_tile_loaded(std::uint64_t key, const raster_image* im){
+	this->loading.erase(key);
+
+	if(!im || im->dims().x() == 0 || im->dims().y() == 0){
+		this->failed.insert(key);
+		return;
+	}
+
+	std::array<utki::span<const std::uint8_t>, 1> mips = {{im->pixels()}};
+	auto tex = this->context->renderer->factory->create_texture_2d(
+			num_channels_to_texture_type(im->num_channels()),
+			im->dims(),
+			utki::make_span(mips),
+			this->params
+		);
+
+	auto size = estimate_gpu_memory_usage(*tex);
+
+	this->lru.push_front(key);
+
+	cached_tile t;
+	t.tex = std::move(tex);
+	t.memory_usage = size;
+	t.lru_iter = this->lru.begin();
+	this->cache.insert(std::make_pair(key, std::move(t)));
+
+	this->memory_used += size;
+
+	this->evict();
+}
+
+void tiled_image::evict(){
+	while(this->memory_used > this->memory_budget && this->lru.size() > 1){
+		auto i = this->cache.find(this->lru.back());
+		ASSERT(i != this->cache.end())
+		this->memory_used -= i->second.memory_usage;
+		this->cache.erase(i);
+		this->lru.pop_back();
+	}
+}
+
+void tiled_image::set_memory_budget(size_t bytes){
+	this->memory_budget = bytes;
+	this->evict();
+}
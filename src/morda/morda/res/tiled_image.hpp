@@ -0,0 +1,310 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+
+#include "../resource_loader.hpp"
+
+#include "../render/texture_2d.hpp"
+
+#include "../util/raster_image.hpp"
+
+namespace morda{ namespace res{
+
+/**
+ * @brief Tiled image resource.
+ * Tiled image is meant for showing images which are too big to be uploaded as a single texture,
+ * like scans and maps. The image is represented by a pyramid of levels, level 0 is the full resolution image,
+ * each next level is half the size of the previous one, down to the level which fits into a single tile.
+ * Each level is split into square tiles, tiles at the right and bottom edges can be smaller.
+ *
+ * Tiles are decoded on a background thread only when requested, see request_tile(), and uploaded to textures on UI thread.
+ * Tile textures are cached, the least recently used tiles are evicted when the cache exceeds the memory budget.
+ * Use the tiled_image widget to display the image.
+ *
+ * %resource description:
+ *
+ * @param file - directory with tiles. Tile files are named as "<level>/<column>_<row>.<format>",
+ *               e.g. "0/12_7.jpg" is the tile in the 13th column and 8th row of the full resolution level.
+ *               Can also be a single PNG or JPG image file, then the pyramid levels are generated from it,
+ *               see the constructor taking image file for details. Loading fails if the decoded image
+ *               does not fit into the default decoded memory budget, such images have to be cut into tile files.
+ * @param dims - dimensions of the full resolution image in pixels. Not needed for single image file.
+ * @param tile_size - optional, size of the tile side in pixels. Default value is 256.
+ * @param format - optional, file format of the tiles: png or jpg. Default value is png.
+ * @param filter, min_filter, mag_filter, mipmap, wrap, wrap_s, wrap_t - optional, tile texture sampling parameters,
+ *        see morda::res::texture.
+ *
+ * Example:
+ * @code
+ * tiled_img_city_map{
+ *     file{city_map/}
+ *     dims{20000 20000}
+ *     format{jpg}
+ * }
+ *
+ * tiled_img_scan{
+ *     file{scan.png}
+ * }
+ * @endcode
+ */
+class tiled_image : public resource{
+	friend class morda::resource_loader;
+
+public:
+	/**
+	 * @brief Default tile size.
+	 */
+	constexpr static const unsigned default_tile_size = 256;
+
+	/**
+	 * @brief Default memory budget for the pyramid levels generated from single image.
+	 */
+	constexpr static const size_t default_decoded_memory_budget = 256 * 1024 * 1024;
+
+	/**
+	 * @brief Tile loading function.
+	 * The function is called from the background thread, it must return decoded tile image.
+	 * Dimensions of the returned image must be as given by get_tile_rect().
+	 * @param level - pyramid level of the tile.
+	 * @param index - column and row of the tile.
+	 * @return decoded tile image.
+	 */
+	typedef std::function<raster_image(unsigned level, r4::vector2<unsigned> index)> tile_loader_type;
+
+private:
+	const r4::vector2<unsigned> dims_v;
+	const unsigned tile_size_v;
+	const unsigned num_levels_v;
+
+	const texture_2d::sampling params;
+
+	const tile_loader_type load_tile;
+
+	// UI thread side
+
+	struct cached_tile{
+		std::shared_ptr<texture_2d> tex;
+		size_t memory_usage;
+		std::list<std::uint64_t>::iterator lru_iter;
+	};
+
+	std::unordered_map<std::uint64_t, cached_tile> cache;
+
+	// keys of the cached tiles, most recently used first
+	std::list<std::uint64_t> lru;
+
+	// tiles which are requested but not yet loaded
+	std::unordered_set<std::uint64_t> loading;
+
+	// tiles which could not be loaded, those are not requested again
+	std::unordered_set<std::uint64_t> failed;
+
+	size_t memory_budget = 64 * 1024 * 1024;
+	size_t memory_used = 0;
+
+	// shared with the loading thread
+
+	std::mutex mutex;
+	std::condition_variable cv;
+
+	// tiles to load, most recently requested first
+	std::list<std::uint64_t> queue;
+	std::unordered_map<std::uint64_t, decltype(queue)::iterator> queued;
+
+	bool quit = false;
+
+	std::thread thread;
+
+	// the weak pointer to this object is obtained on UI thread, as on the loading thread the object can already be
+	// in the middle of destruction
+	void thread_func(std::weak_ptr<tiled_image> weak_this);
+
+	void on_tile_loaded(std::uint64_t key, const raster_image* im);
+
+	void evict();
+
+public:
+	/**
+	 * @brief Maximal number of tiles waiting to be loaded.
+	 * When more tiles are requested, the least recently requested ones are dropped from the loading queue.
+	 */
+	constexpr static const size_t max_num_queued_tiles = 128;
+
+	/**
+	 * @brief Constructor.
+	 * @param c - context.
+	 * @param dims - dimensions of the full resolution image in pixels.
+	 * @param tile_size - size of the tile side in pixels.
+	 * @param load_tile - tile loading function.
+	 * @param params - tile texture sampling parameters.
+	 */
+	tiled_image(
+			std::shared_ptr<morda::context> c,
+			r4::vector2<unsigned> dims,
+			unsigned tile_size,
+			tile_loader_type&& load_tile,
+			const texture_2d::sampling& params = texture_2d::sampling()
+		);
+
+	/**
+	 * @brief Constructor.
+	 * Creates tiled image from image in memory.
+	 * This can be used for images which fit into memory, but are too big for a single texture.
+	 * Each pyramid level is generated on the loading thread when its tile is requested,
+	 * the least recently used generated levels are dropped when those exceed the decoded memory budget.
+	 * @param c - context.
+	 * @param image - full resolution image.
+	 * @param tile_size - size of the tile side in pixels.
+	 * @param params - tile texture sampling parameters.
+	 * @param decoded_memory_budget - memory budget for the generated levels in bytes, the full resolution image is not counted.
+	 */
+	tiled_image(
+			std::shared_ptr<morda::context> c,
+			raster_image&& image,
+			unsigned tile_size = default_tile_size,
+			const texture_2d::sampling& params = texture_2d::sampling(),
+			size_t decoded_memory_budget = default_decoded_memory_budget
+		);
+
+	/**
+	 * @brief Constructor.
+	 * Creates tiled image from PNG or JPG image file. Only the image header is read by the constructor.
+	 * Each pyramid level is decoded from the file on the loading thread when its tile is requested,
+	 * at the level's size, so that showing the coarse levels does not need the full resolution image in memory.
+	 * Non-interlaced PNG is downscaled while decoding, JPG can be reduced while decoding down to 1/8 at most.
+	 * Tiles of the full resolution level are cut from the fully decoded image though.
+	 * The least recently used decoded levels are dropped when those exceed the decoded memory budget.
+	 * Destroying the tiled image waits for the level being decoded, if any.
+	 * @param c - context.
+	 * @param fi - image file.
+	 * @param tile_size - size of the tile side in pixels.
+	 * @param params - tile texture sampling parameters.
+	 * @param decoded_memory_budget - memory budget for the decoded levels in bytes.
+	 * @throw std::invalid_argument - if the full resolution image, taken as 4 bytes per pixel, does not fit into
+	 *                                the decoded memory budget. Such images have to be cut into tile files beforehand,
+	 *                                see the resource description.
+	 */
+	tiled_image(
+			std::shared_ptr<morda::context> c,
+			std::unique_ptr<const papki::file> fi,
+			unsigned tile_size = default_tile_size,
+			const texture_2d::sampling& params = texture_2d::sampling(),
+			size_t decoded_memory_budget = default_decoded_memory_budget
+		);
+
+	tiled_image(const tiled_image&) = delete;
+	tiled_image& operator=(const tiled_image&) = delete;
+
+	~tiled_image()noexcept;
+
+	/**
+	 * @brief Get dimensions of the full resolution image.
+	 * @return dimensions of the image in pixels.
+	 */
+	const r4::vector2<unsigned>& dims()const noexcept{
+		return this->dims_v;
+	}
+
+	unsigned tile_size()const noexcept{
+		return this->tile_size_v;
+	}
+
+	/**
+	 * @brief Get number of pyramid levels.
+	 * The last level fits into a single tile.
+	 * @return number of levels.
+	 */
+	unsigned num_levels()const noexcept{
+		return this->num_levels_v;
+	}
+
+	/**
+	 * @brief Get dimensions of the pyramid level.
+	 * @param level - pyramid level.
+	 * @return dimensions of the level in pixels.
+	 */
+	r4::vector2<unsigned> get_level_dims(unsigned level)const noexcept;
+
+	/**
+	 * @brief Get number of tiles in pyramid level.
+	 * @param level - pyramid level.
+	 * @return number of tile columns and rows.
+	 */
+	r4::vector2<unsigned> get_num_tiles(unsigned level)const noexcept;
+
+	/**
+	 * @brief Get area of the tile.
+	 * @param level - pyramid level of the tile.
+	 * @param index - column and row of the tile.
+	 * @param full_res - if true, the area is given in full resolution image pixels, otherwise in pixels of the tile's level.
+	 * @return area covered by the tile.
+	 */
+	r4::rectangle<unsigned> get_tile_rect(unsigned level, r4::vector2<unsigned> index, bool full_res = false)const noexcept;
+
+	/**
+	 * @brief Get key uniquely identifying the tile.
+	 * @param level - pyramid level of the tile.
+	 * @param index - column and row of the tile.
+	 * @return tile key.
+	 */
+	static std::uint64_t get_tile_key(unsigned level, r4::vector2<unsigned> index)noexcept{
+		return (std::uint64_t(level) << 58) | (std::uint64_t(index.x()) << 29) | std::uint64_t(index.y());
+	}
+
+	/**
+	 * @brief Get loaded tile texture.
+	 * Must be called from UI thread.
+	 * The tile is marked as recently used.
+	 * @param level - pyramid level of the tile.
+	 * @param index - column and row of the tile.
+	 * @return tile texture or nullptr if the tile is not loaded.
+	 */
+	std::shared_ptr<texture_2d> get_tile(unsigned level, r4::vector2<unsigned> index);
+
+	/**
+	 * @brief Request tile loading.
+	 * Must be called from UI thread.
+	 * The tile is decoded on the background thread, then the texture is created on UI thread.
+	 * Most recently requested tiles are loaded first, requesting a tile which is already waiting
+	 * to be loaded moves it to the front of the queue.
+	 * Does nothing if the tile is already loaded.
+	 * @param level - pyramid level of the tile.
+	 * @param index - column and row of the tile.
+	 */
+	void request_tile(unsigned level, r4::vector2<unsigned> index);
+
+	/**
+	 * @brief Set memory budget for tile textures.
+	 * The least recently used tiles are evicted when the estimated GPU memory used by the tile textures
+	 * exceeds the budget. The most recently used tile is never evicted.
+	 * The budget should be big enough to hold the tiles visible at once.
+	 * Default budget is 64 megabytes.
+	 * @param bytes - memory budget in bytes.
+	 */
+	void set_memory_budget(size_t bytes);
+
+	size_t get_memory_budget()const noexcept{
+		return this->memory_budget;
+	}
+
+	size_t get_num_cached_tiles()const noexcept{
+		return this->cache.size();
+	}
+
+	memory_usage get_memory_usage()const override{
+		memory_usage ret;
+		ret.gpu = this->memory_used;
+		return ret;
+	}
+
+private:
+	static std::shared_ptr<tiled_image> load(morda::context& ctx, const ::treeml::forest& desc, const papki::file& fi);
+};
+
+}}
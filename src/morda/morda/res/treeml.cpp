@@ -19,3 +19,19 @@ std::shared_ptr<morda::res::treeml> morda::res::treeml::load(morda::context& ctx
 
 	return std::make_shared<treeml>(utki::make_shared_from(ctx), ::treeml::read(fi));
 }
+
+namespace{
+size_t get_forest_size(const ::treeml::forest& f)noexcept{
+	size_t ret = f.capacity() * sizeof(::treeml::tree);
+	for(auto& t : f){
+		ret += t.value.length() + get_forest_size(t.children);
+	}
+	return ret;
+}
+}
+
+morda::resource::memory_usage morda::res::treeml::get_memory_usage()const{
+	memory_usage ret;
+	ret.cpu = get_forest_size(this->s);
+	return ret;
+}
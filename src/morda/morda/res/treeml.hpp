@@ -40,6 +40,8 @@ public:
 	const ::treeml::forest& forest()const noexcept{
 		return this->s;
 	}
+
+	memory_usage get_memory_usage()const override;
 	
 private:
 	static std::shared_ptr<treeml> load(morda::context& ctx, const ::treeml::forest& desc, const papki::file& fi);
@@ -4,6 +4,7 @@
 #include "resource_loader.hpp"
 
 #include "util/util.hpp"
+#include "util/res_pack.hpp"
 
 using namespace morda;
 
@@ -14,6 +15,13 @@ const char* wording_include_subdirs = "include_subdirs";
 
 void resource_loader::mount_res_pack(const papki::file& fi){
 	ASSERT(!fi.is_open())
+
+	if(fi.suffix() == "respack"){
+		// resource pack archive, mount its root directory
+		res_pack::file archive_root(res_pack::load(fi));
+		this->mount_res_pack(archive_root);
+		return;
+	}
 	
 	std::string dir = fi.dir();
 	
@@ -43,7 +51,12 @@ void resource_loader::mount_res_pack(const papki::file& fi){
 	}
 	
 	ResPackEntry rpe;
-	rpe.fi = papki::root_dir::make(fi.spawn(), dir);
+	if(auto rf = dynamic_cast<const res_pack::file*>(&fi)){
+		// keep the resource pack archive file type, so that resources can access the mapped data directly
+		rpe.fi = std::make_unique<res_pack::file>(rf->get_pack(), rf->get_root_dir() + dir);
+	}else{
+		rpe.fi = papki::root_dir::make(fi.spawn(), dir);
+	}
 	rpe.script = std::move(script);
 
 	this->resPacks.push_back(std::move(rpe));
@@ -80,3 +93,108 @@ void resource_loader::addResource(const std::shared_ptr<resource>& res, const st
 //	}
 //#endif
 }
+
+void resource_loader::retain(const std::string& name, const std::shared_ptr<resource>& res){
+	if(!res){
+		return;
+	}
+
+	auto i = this->cacheIndex.find(name);
+	if(i != this->cacheIndex.end()){
+		auto& e = *i->second;
+		ASSERT(e.res == res)
+
+		// move to front
+		this->cache.splice(this->cache.begin(), this->cache, i->second);
+
+		// memory usage of the resource may change over time, update it
+		if(!e.pinned){
+			this->cacheSize -= e.size;
+			e.size = res->get_memory_usage().total();
+			this->cacheSize += e.size;
+			this->trimCache();
+		}
+		return;
+	}
+
+	bool pinned = this->pinned.find(name) != this->pinned.end();
+
+	if(this->cacheBudget == 0 && !pinned){
+		return;
+	}
+
+	this->cache.push_front(CacheEntry{name, res, res->get_memory_usage().total(), pinned});
+	this->cacheIndex.insert(std::make_pair(name, this->cache.begin()));
+
+	if(!pinned){
+		this->cacheSize += this->cache.front().size;
+		this->trimCache();
+	}
+}
+
+void resource_loader::trimCache(){
+	for(auto i = this->cache.end(); this->cacheSize > this->cacheBudget && i != this->cache.begin();){
+		--i;
+		if(i->pinned){
+			continue;
+		}
+		ASSERT(this->cacheSize >= i->size)
+		this->cacheSize -= i->size;
+		this->cacheIndex.erase(i->name);
+		i = this->cache.erase(i);
+		++this->counters.num_evictions;
+	}
+}
+
+void resource_loader::set_cache_budget(size_t bytes){
+	this->cacheBudget = bytes;
+	this->trimCache();
+}
+
+void resource_loader::pin(const std::string& name){
+	this->pinned.insert(name);
+
+	auto i = this->cacheIndex.find(name);
+	if(i != this->cacheIndex.end()){
+		auto& e = *i->second;
+		if(!e.pinned){
+			e.pinned = true;
+			this->cacheSize -= e.size;
+		}
+		return;
+	}
+
+	// retain the resource if it is already loaded
+	auto j = this->resMap.find(name);
+	if(j != this->resMap.end()){
+		if(auto r = j->second.lock()){
+			this->retain(name, r);
+		}
+	}
+}
+
+void resource_loader::unpin(const std::string& name){
+	this->pinned.erase(name);
+
+	auto i = this->cacheIndex.find(name);
+	if(i == this->cacheIndex.end()){
+		return;
+	}
+
+	auto& e = *i->second;
+	if(!e.pinned){
+		return;
+	}
+	e.pinned = false;
+	e.size = e.res->get_memory_usage().total();
+	this->cacheSize += e.size;
+	this->trimCache();
+}
+
+void resource_loader::clear_cache()noexcept{
+	// move the resources out first, so that the loader is in consistent state when resources are destroyed
+	auto c = std::move(this->cache);
+	this->cache.clear();
+	this->cacheIndex.clear();
+	this->cacheSize = 0;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <map>
+#include <set>
+#include <list>
 
 #include <utki/shared.hpp>
 #include <papki/file.hpp>
@@ -48,6 +50,24 @@ class resource_loader{
 
 	std::map<const std::string, std::weak_ptr<resource>> resMap;
 
+	struct CacheEntry{
+		std::string name;
+		std::shared_ptr<resource> res;
+		size_t size;
+		bool pinned;
+	};
+
+	// retained resources, most recently used first
+	std::list<CacheEntry> cache;
+	std::map<std::string, decltype(cache)::iterator> cacheIndex;
+
+	std::set<std::string> pinned;
+
+	size_t cacheBudget = 0;
+
+	// total size of unpinned retained resources
+	size_t cacheSize = 0;
+
 	class ResPackEntry{
 	public:
 		ResPackEntry() = default;
@@ -83,6 +103,12 @@ class resource_loader{
 	// Add resource to resources map
 	void addResource(const std::shared_ptr<resource>& res, const std::string& name);
 
+	// Add resource to retention cache or mark it as most recently used
+	void retain(const std::string& name, const std::shared_ptr<resource>& res);
+
+	// Evict least recently used unpinned resources until the cache fits the budget
+	void trimCache();
+
 private:
 	context& ctx;
 	resource_loader(context& ctx) :
@@ -98,6 +124,8 @@ public:
 	 * @param fi - file interface pointing to the resource pack's STOB description.
 	 *             If file interface points to a directory instead of a file then
 	 *             resource description filename is assumed to be "main.res.stob".
+	 *             If the file has 'respack' suffix, then it is treated as resource pack archive (see res_pack)
+	 *             and the resource description is loaded from "main.res" file in the root of the archive.
 	 */
 	void mount_res_pack(const papki::file& fi);
 
@@ -121,7 +149,98 @@ public:
 		return this->load<T>(name.c_str());
 	}
 
+	/**
+	 * @brief Set retention cache budget.
+	 * The loader keeps only weak references to the loaded resources, so a resource is destroyed
+	 * as soon as nobody uses it and has to be loaded again next time it is needed.
+	 * The retention cache holds strong references to the recently loaded resources, so that
+	 * resources which go out of use and come back soon, e.g. when switching pages of a book widget,
+	 * are not reloaded. When the total memory usage of the retained resources exceeds the budget,
+	 * the least recently used ones are released.
+	 * Memory usage of each resource is reported by resource::get_memory_usage().
+	 * Since resources hold the context, call clear_cache() before releasing the context;
+	 * the gui does that on destruction.
+	 * @param bytes - cache budget in bytes. Zero disables the retention cache, this is the default.
+	 */
+	void set_cache_budget(size_t bytes);
+
+	/**
+	 * @brief Get retention cache budget.
+	 * @return cache budget in bytes.
+	 */
+	size_t get_cache_budget()const noexcept{
+		return this->cacheBudget;
+	}
+
+	/**
+	 * @brief Get total memory usage of the retained resources.
+	 * Pinned resources are not counted.
+	 * @return memory usage in bytes.
+	 */
+	size_t get_cache_size()const noexcept{
+		return this->cacheSize;
+	}
+
+	/**
+	 * @brief Pin resource.
+	 * Pinned resource is retained regardless of the cache budget and is not counted against it.
+	 * Resource can be pinned before it is loaded, it will be retained when it gets loaded.
+	 * Pinning works also when the retention cache is disabled.
+	 * @param name - name of the resource.
+	 */
+	void pin(const std::string& name);
+
+	/**
+	 * @brief Unpin resource.
+	 * The resource becomes subject to the retention cache budget.
+	 * @param name - name of the resource.
+	 */
+	void unpin(const std::string& name);
+
+	/**
+	 * @brief Release all retained resources.
+	 * Pinned resources are released as well, but stay pinned, so those will be retained again when loaded.
+	 * Released resources are not counted as evictions.
+	 */
+	void clear_cache()noexcept;
+
+	/**
+	 * @brief Resource loading statistics.
+	 */
+	struct cache_counters{
+		/**
+		 * @brief Number of load() calls which returned already loaded resource.
+		 */
+		size_t num_hits = 0;
+
+		/**
+		 * @brief Number of load() calls which loaded the resource from resource pack.
+		 */
+		size_t num_misses = 0;
+
+		/**
+		 * @brief Number of resources released from the retention cache due to budget limit.
+		 */
+		size_t num_evictions = 0;
+	};
+
+	/**
+	 * @brief Get resource loading statistics.
+	 * @return statistics accumulated since creation or since last reset_cache_counters() call.
+	 */
+	const cache_counters& get_cache_counters()const noexcept{
+		return this->counters;
+	}
+
+	/**
+	 * @brief Reset resource loading statistics.
+	 */
+	void reset_cache_counters()noexcept{
+		this->counters = cache_counters();
+	}
+
 private:
+	cache_counters counters;
 };
 
 
@@ -144,6 +263,36 @@ protected:
 	}
 public:
 	virtual ~resource()noexcept{}
+
+	/**
+	 * @brief Memory usage of a resource.
+	 */
+	struct memory_usage{
+		/**
+		 * @brief Bytes of main memory.
+		 */
+		size_t cpu = 0;
+
+		/**
+		 * @brief Bytes of GPU memory, estimated.
+		 */
+		size_t gpu = 0;
+
+		size_t total()const noexcept{
+			return this->cpu + this->gpu;
+		}
+	};
+
+	/**
+	 * @brief Get memory usage of the resource.
+	 * Used by resource loader to account retained resources against the retention cache budget.
+	 * Resources holding significant amounts of data should override this.
+	 * Memory of other resources referred by this one should not be included.
+	 * @return memory usage. Default implementation returns zero usage.
+	 */
+	virtual memory_usage get_memory_usage()const{
+		return memory_usage();
+	}
 };
 
 
@@ -165,9 +314,13 @@ template <class T> std::shared_ptr<T> resource_loader::load(const char* resName)
 //	TRACE(<< "ResMan::Load(): enter" << std::endl)
 	if(auto r = this->findResourceInResMap<T>(resName)){
 //		TRACE(<< "ResManHGE::Load(): resource found in map" << std::endl)
+		++this->counters.num_hits;
+		this->retain(resName, r);
 		return r;
 	}
 
+	++this->counters.num_misses;
+
 //	TRACE(<< "ResMan::Load(): searching for resource in script..." << std::endl)
 	FindInScriptRet ret = this->findResourceInScript(resName);
 	ASSERT(ret.rp.fi)
@@ -176,7 +329,10 @@ template <class T> std::shared_ptr<T> resource_loader::load(const char* resName)
 
 	auto resource = T::load(this->ctx, ret.e.children, *ret.rp.fi);
 
-	this->addResource(resource, ret.e.value.to_string());
+	auto name = ret.e.value.to_string();
+
+	this->addResource(resource, name);
+	this->retain(name, resource);
 
 //	TRACE(<< "ResMan::LoadTexture(): exit" << std::endl)
 	return resource;
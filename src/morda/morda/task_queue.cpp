@@ -0,0 +1,160 @@
+#include "task_queue.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+task_queue::task_queue(std::function<void()>&& wake_up) :
+		wake_up(std::move(wake_up))
+{
+	if(!this->wake_up){
+		throw std::invalid_argument("task_queue::task_queue(): wake up function is not provided");
+	}
+
+	for(auto& s : this->posted){
+		s.store(nullptr);
+	}
+}
+
+task_queue::~task_queue()noexcept{
+	for(auto& s : this->posted){
+		for(node* n = s.load(); n;){
+			auto next = n->next;
+			delete n;
+			n = next;
+		}
+	}
+
+	for(auto& q : this->pending){
+		for(node* n = q.head; n;){
+			auto next = n->next;
+			delete n;
+			n = next;
+		}
+	}
+}
+
+void task_queue::push(node* n, priority p){
+	ASSERT(n)
+	ASSERT(size_t(p) < this->posted.size())
+
+	auto& s = this->posted[size_t(p)];
+
+	n->next = s.load(std::memory_order_relaxed);
+	while(!s.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed)){}
+
+	this->request_wake_up();
+}
+
+void task_queue::request_wake_up(){
+	if(this->wake_up_requested.exchange(true)){
+		return;
+	}
+
+	try{
+		this->wake_up();
+	}catch(...){
+		this->wake_up_requested.store(false);
+		throw;
+	}
+}
+
+void task_queue::collect(){
+	for(size_t p = 0; p != this->posted.size(); ++p){
+		node* n = this->posted[p].exchange(nullptr, std::memory_order_acquire);
+
+		// reverse the stack to get the posting order
+		node* reversed = nullptr;
+		while(n){
+			auto next = n->next;
+			n->next = reversed;
+			reversed = n;
+			n = next;
+		}
+
+		auto& q = this->pending[p];
+
+		for(n = reversed; n;){
+			auto next = n->next;
+			n->next = nullptr;
+
+			if(n->key){
+				auto res = this->pending_keys.emplace(n->key, n);
+				if(!res.second){
+					ASSERT(!res.first->second->is_canceled)
+					res.first->second->is_canceled = true;
+					res.first->second = n;
+					--this->num_pending;
+				}
+			}
+
+			if(q.tail){
+				q.tail->next = n;
+			}else{
+				q.head = n;
+			}
+			q.tail = n;
+			++this->num_pending;
+
+			n = next;
+		}
+	}
+}
+
+size_t task_queue::run(std::chrono::steady_clock::duration budget){
+	// tasks posted after this point will request another wake up
+	this->wake_up_requested.store(false);
+
+	this->collect();
+
+	auto start = std::chrono::steady_clock::now();
+	bool is_first = true;
+
+	for(auto& q : this->pending){
+		while(q.head){
+			if(!is_first && std::chrono::steady_clock::now() - start >= budget){
+				break;
+			}
+
+			std::unique_ptr<node> n(q.head);
+			q.head = n->next;
+			if(!q.head){
+				q.tail = nullptr;
+			}
+
+			if(n->is_canceled){
+				continue;
+			}
+
+			ASSERT(this->num_pending != 0)
+			--this->num_pending;
+
+			if(n->key){
+				auto i = this->pending_keys.find(n->key);
+				ASSERT(i != this->pending_keys.end())
+				ASSERT(i->second == n.get())
+				this->pending_keys.erase(i);
+			}
+
+			is_first = false;
+
+			try{
+				n->run();
+			}catch(...){
+				if(this->num_pending != 0){
+					this->request_wake_up();
+				}
+				throw;
+			}
+		}
+	}
+
+	if(this->num_pending != 0){
+		this->request_wake_up();
+	}
+
+	return this->num_pending;
+}
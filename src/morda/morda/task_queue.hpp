@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+
+namespace morda{
+
+/**
+ * @brief Queue of tasks to be executed on UI thread.
+ * Tasks can be posted from any thread, they are executed on the UI thread by run().
+ * Posting is lock-free: there is an intrusive stack per priority level, producers push tasks
+ * to it with compare-and-swap and the consumer takes away the whole stack at once.
+ * The closure is stored inside of the task node, so posting a task makes only one memory allocation.
+ *
+ * Tasks of higher priority are executed first, tasks of the same priority are executed
+ * in the order they were posted.
+ * A task can be posted with a coalescing key. In this case the pending task posted with the same key, if any,
+ * is dropped and only the latest one is executed.
+ *
+ * When the queue becomes non-empty, the wake up function is called to request the UI thread to call run().
+ */
+class task_queue{
+public:
+	/**
+	 * @brief Task priorities.
+	 * Listed from highest to lowest.
+	 */
+	enum class priority{
+		input,
+		layout,
+		background,
+
+		enum_size
+	};
+
+private:
+	struct node{
+		node* next = nullptr;
+		const void* key = nullptr;
+		bool is_canceled = false;
+
+		virtual ~node()noexcept{}
+
+		virtual void run() = 0;
+	};
+
+	template <class function_type> struct closure_node : public node{
+		function_type func;
+
+		template <class F> closure_node(F&& func) :
+				func(std::forward<F>(func))
+		{}
+
+		void run()override{
+			this->func();
+		}
+	};
+
+	// stacks of just posted tasks, last posted first
+	std::array<std::atomic<node*>, size_t(priority::enum_size)> posted;
+
+	std::atomic<bool> wake_up_requested{false};
+
+	const std::function<void()> wake_up;
+
+	// Consumer side, accessed only from the UI thread.
+
+	struct fifo{
+		node* head = nullptr;
+		node* tail = nullptr;
+	};
+
+	std::array<fifo, size_t(priority::enum_size)> pending;
+
+	size_t num_pending = 0;
+
+	std::unordered_map<const void*, node*> pending_keys;
+
+	std::chrono::steady_clock::duration time_budget = std::chrono::milliseconds(4);
+
+	void push(node* n, priority p);
+
+	void request_wake_up();
+
+	void collect();
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param wake_up - function which requests the UI thread to call run(). Can be called from any thread.
+	 */
+	task_queue(std::function<void()>&& wake_up);
+
+	task_queue(const task_queue&) = delete;
+	task_queue& operator=(const task_queue&) = delete;
+
+	~task_queue()noexcept;
+
+	/**
+	 * @brief Post task.
+	 * Thread safe.
+	 * @param func - function to execute on UI thread.
+	 * @param p - priority of the task.
+	 */
+	template <class F> void post(F&& func, priority p = priority::background){
+		this->push(new closure_node<std::decay_t<F>>(std::forward<F>(func)), p);
+	}
+
+	/**
+	 * @brief Post task with coalescing key.
+	 * Thread safe.
+	 * In case there is a pending task posted with the same key, that task will not be executed.
+	 * Typically, the key is the address of the object the task updates.
+	 * @param key - coalescing key, must not be nullptr.
+	 * @param func - function to execute on UI thread.
+	 * @param p - priority of the task.
+	 */
+	template <class F> void post(const void* key, F&& func, priority p = priority::background){
+		auto n = new closure_node<std::decay_t<F>>(std::forward<F>(func));
+		n->key = key;
+		this->push(n, p);
+	}
+
+	/**
+	 * @brief Set time budget for single run() call.
+	 * By default it is 4 milliseconds.
+	 * @param budget - time budget.
+	 */
+	void set_time_budget(std::chrono::steady_clock::duration budget)noexcept{
+		this->time_budget = budget;
+	}
+
+	/**
+	 * @brief Execute pending tasks.
+	 * Must be called from UI thread.
+	 * Executes pending tasks until the time budget is exhausted. At least one task is executed, if any.
+	 * Tasks posted from within the executed tasks are not executed by this call.
+	 * In case not all the tasks were executed, the wake up function is called.
+	 * @return number of tasks left pending.
+	 */
+	size_t run(){
+		return this->run(this->time_budget);
+	}
+
+	/**
+	 * @brief Execute pending tasks.
+	 * Same as run(), but with the given time budget instead of the one set by set_time_budget().
+	 * @param budget - time budget.
+	 * @return number of tasks left pending.
+	 */
+	size_t run(std::chrono::steady_clock::duration budget);
+};
+
+}
@@ -121,6 +121,9 @@ uint32_t updater::update(){
 	
 //	TRACE(<< "updateable::Updater::Update(): invoked" << std::endl)
 	
+	// advance animations to the same frame time before updating updateables
+	this->animator.advance(curTime);
+
 	this->addPending(); // add pending before updating this->lastUpdatedTimestamp
 	
 	// check if there is a warp around
@@ -160,10 +163,21 @@ uint32_t updater::update(){
 	}else if(this->inactiveQueue->size() != 0){
 		ASSERT(curTime > this->inactiveQueue->front().first)
 		closestTime = this->inactiveQueue->front().first;
+	}else if(this->animator.is_active()){
+		closestTime = curTime + this->animator.get_next_update_delay();
 	}else{
 		return uint32_t(-1);
 	}
 	
+	// while animating, the next update is needed when the animated values change,
+	// which is one frame period at most
+	if(this->animator.is_active()){
+		uint32_t delay = this->animator.get_next_update_delay();
+		if(closestTime - curTime > delay){
+			closestTime = curTime + delay;
+		}
+	}
+
 	uint32_t uncorrectedDt = closestTime - curTime;
 	
 	uint32_t correction = utki::get_ticks_ms() - curTime;
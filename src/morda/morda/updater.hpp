@@ -4,6 +4,8 @@
 
 #include <list>
 
+#include "animator.hpp"
+
 namespace morda{
 
 class updateable;
@@ -39,6 +41,12 @@ class updater : public std::enable_shared_from_this<updater>{
 
 	void removeFromToAdd(updateable* u);
 public:
+	/**
+	 * @brief Animation clock and tween engine.
+	 * The animations are advanced by update() on each UI cycle before the updateables are updated.
+	 */
+	morda::animator animator;
+
 	updater() :
 			activeQueue(&q1),
 			inactiveQueue(&q2)
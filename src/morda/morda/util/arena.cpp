@@ -0,0 +1,129 @@
+#include "arena.hpp"
+
+#include <new>
+#include <cstddef>
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+arena::arena(size_t block_size) :
+		block_size(block_size)
+{}
+
+void* arena::allocate(size_t size, size_t alignment){
+	ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0)
+
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	void* p = this->cur;
+	if(!p || !std::align(alignment, size, p, this->num_bytes_left)){
+		// reserve new block, big enough to align the allocation
+		size_t size_to_reserve = std::max(this->block_size, size + alignment);
+		this->blocks.emplace_back(new std::uint8_t[size_to_reserve]);
+		this->num_bytes_reserved += size_to_reserve;
+
+		p = this->blocks.back().get();
+		size_t num_bytes_left = size_to_reserve;
+		if(!std::align(alignment, size, p, num_bytes_left)){
+			ASSERT(false)
+		}
+
+		// dedicated block for big allocation, keep allocating from the current block
+		if(size_to_reserve != this->block_size){
+			++this->num_allocations;
+			this->num_bytes_allocated += size;
+			return p;
+		}
+
+		this->num_bytes_left = num_bytes_left;
+	}
+
+	this->cur = static_cast<std::uint8_t*>(p) + size;
+	this->num_bytes_left -= size;
+
+	++this->num_allocations;
+	this->num_bytes_allocated += size;
+
+	return p;
+}
+
+void arena::deallocate(void* p, size_t size)noexcept{
+	ASSERT(p)
+	++this->num_deallocations;
+	this->num_bytes_deallocated += size;
+}
+
+arena::statistics arena::get_statistics()const{
+	std::lock_guard<decltype(this->mutex)> lock_guard(this->mutex);
+
+	statistics ret;
+	ret.num_allocations = this->num_allocations;
+	ret.num_deallocations = this->num_deallocations;
+	ret.num_bytes_allocated = this->num_bytes_allocated;
+	ret.num_bytes_deallocated = this->num_bytes_deallocated;
+	ret.num_bytes_reserved = this->num_bytes_reserved;
+	ret.num_blocks = this->blocks.size();
+	return ret;
+}
+
+namespace{
+thread_local arena* current_arena = nullptr;
+}
+
+arena::scope::scope(arena* a)noexcept :
+		prev(current_arena)
+{
+	current_arena = a;
+}
+
+arena::scope::~scope()noexcept{
+	current_arena = this->prev;
+}
+
+arena* arena::get_current()noexcept{
+	return current_arena;
+}
+
+namespace{
+// placed before each arena_object
+struct arena_object_header{
+	// nullptr if the object is allocated on the heap
+	std::shared_ptr<arena> owner;
+};
+
+// keep the object aligned as if it was allocated by global operator new
+const size_t arena_object_header_size = (sizeof(arena_object_header) + alignof(std::max_align_t) - 1)
+		/ alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+void* arena_object::operator new(size_t size){
+	auto a = arena::get_current();
+
+	void* p = a ?
+			a->allocate(arena_object_header_size + size, alignof(std::max_align_t)) :
+			::operator new(arena_object_header_size + size);
+
+	new(p) arena_object_header{a ? a->shared_from_this() : nullptr};
+
+	return static_cast<std::uint8_t*>(p) + arena_object_header_size;
+}
+
+void arena_object::operator delete(void* p, size_t size)noexcept{
+	if(!p){
+		return;
+	}
+
+	auto h = reinterpret_cast<arena_object_header*>(static_cast<std::uint8_t*>(p) - arena_object_header_size);
+
+	auto owner = std::move(h->owner);
+	h->~arena_object_header();
+
+	if(owner){
+		// the arena can be destroyed when the owner pointer goes out of scope, after deallocation
+		owner->deallocate(h, arena_object_header_size + size);
+	}else{
+		::operator delete(h);
+	}
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace morda{
+
+/**
+ * @brief Memory arena.
+ * Arena allocates memory by bumping a pointer inside of big blocks, so that objects allocated
+ * together are placed contiguously in memory. Deallocation of an individual object only updates
+ * the statistics, the memory blocks are all freed at once when the arena is destroyed.
+ * Arena is normally used via arena_allocator, which holds the arena alive as long as there are
+ * objects allocated from it, so all the memory is freed in bulk when the last object is gone.
+ * Note, that memory of an object created with std::allocate_shared() is only released when the last
+ * weak pointer to the object is gone, so a single weak pointer to one object keeps the whole arena allocated.
+ *
+ * Allocation and deallocation are thread safe, e.g. widgets laid out concurrently can lazily allocate
+ * their data from the arena they were inflated into.
+ */
+class arena : public std::enable_shared_from_this<arena>{
+	const size_t block_size;
+
+	// guards allocation state and statistics, deallocation statistics are atomic
+	mutable std::mutex mutex;
+
+	std::vector<std::unique_ptr<std::uint8_t[]>> blocks;
+
+	std::uint8_t* cur = nullptr;
+	size_t num_bytes_left = 0;
+
+	size_t num_allocations = 0;
+	size_t num_bytes_allocated = 0;
+	size_t num_bytes_reserved = 0;
+
+	std::atomic<size_t> num_deallocations{0};
+	std::atomic<size_t> num_bytes_deallocated{0};
+
+public:
+	/**
+	 * @brief Arena statistics.
+	 */
+	struct statistics{
+		/**
+		 * @brief Number of allocations done from the arena.
+		 */
+		size_t num_allocations;
+
+		/**
+		 * @brief Number of deallocations.
+		 */
+		size_t num_deallocations;
+
+		/**
+		 * @brief Number of bytes allocated from the arena.
+		 * Alignment padding is not counted.
+		 */
+		size_t num_bytes_allocated;
+
+		/**
+		 * @brief Number of bytes deallocated.
+		 */
+		size_t num_bytes_deallocated;
+
+		/**
+		 * @brief Total size of the memory blocks reserved by the arena.
+		 */
+		size_t num_bytes_reserved;
+
+		/**
+		 * @brief Number of memory blocks reserved by the arena.
+		 */
+		size_t num_blocks;
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param block_size - size of the memory blocks to reserve, in bytes.
+	 *                     Allocations bigger than the block size get a dedicated block.
+	 */
+	arena(size_t block_size = 64 * 1024);
+
+	arena(const arena&) = delete;
+	arena& operator=(const arena&) = delete;
+
+	/**
+	 * @brief Allocate memory.
+	 * @param size - number of bytes to allocate.
+	 * @param alignment - alignment of the memory to allocate, must be a power of 2.
+	 * @return pointer to the allocated memory.
+	 */
+	void* allocate(size_t size, size_t alignment);
+
+	/**
+	 * @brief Deallocate memory.
+	 * The memory is not reused, the function only updates the statistics.
+	 * @param p - pointer to the memory previously allocated from this arena.
+	 * @param size - number of bytes which were allocated.
+	 */
+	void deallocate(void* p, size_t size)noexcept;
+
+	/**
+	 * @brief Get arena statistics.
+	 * @return arena statistics.
+	 */
+	statistics get_statistics()const;
+
+	/**
+	 * @brief Current arena of the thread.
+	 * Objects of classes derived from arena_object are allocated from the current arena of the thread
+	 * which creates them. The scope object sets the current arena for its lifetime and restores the previous one
+	 * on destruction.
+	 */
+	class scope{
+		arena* prev;
+	public:
+		/**
+		 * @brief Constructor.
+		 * @param a - arena to make current, the arena must be owned by std::shared_ptr.
+		 *            nullptr makes arena_objects to be allocated on the heap.
+		 */
+		scope(arena* a)noexcept;
+
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+
+		~scope()noexcept;
+	};
+
+	/**
+	 * @brief Get current arena of the thread.
+	 * @return current arena.
+	 * @return nullptr if there is no current arena.
+	 */
+	static arena* get_current()noexcept;
+};
+
+/**
+ * @brief Base class for objects allocated from current arena.
+ * Objects of derived classes created with new, including std::make_unique(), are allocated from
+ * the current arena of the thread, see arena::scope, or on the heap in case there is no current arena.
+ * Each object holds the arena it is allocated from alive.
+ */
+class arena_object{
+public:
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size)noexcept;
+};
+
+/**
+ * @brief Standard library compatible allocator which allocates from arena.
+ * The allocator holds the arena alive, so, for example, objects created with std::allocate_shared()
+ * keep the arena alive until the last of them is destroyed.
+ * @param T - type of the objects to allocate.
+ */
+template <class T> class arena_allocator{
+	template <class> friend class arena_allocator;
+
+	std::shared_ptr<morda::arena> arena;
+public:
+	typedef T value_type;
+
+	/**
+	 * @brief Constructor.
+	 * @param a - arena to allocate from.
+	 */
+	arena_allocator(std::shared_ptr<morda::arena> a)noexcept :
+			arena(std::move(a))
+	{}
+
+	template <class U> arena_allocator(const arena_allocator<U>& a)noexcept :
+			arena(a.arena)
+	{}
+
+	T* allocate(size_t n){
+		return static_cast<T*>(this->arena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t n)noexcept{
+		this->arena->deallocate(p, n * sizeof(T));
+	}
+
+	template <class U> bool operator==(const arena_allocator<U>& a)const noexcept{
+		return this->arena == a.arena;
+	}
+
+	template <class U> bool operator!=(const arena_allocator<U>& a)const noexcept{
+		return !this->operator==(a);
+	}
+};
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utki/span.hpp>
+
 #include "../config.hpp"
 
 namespace morda{
@@ -28,6 +30,7 @@ struct mouse_move_event{
 	vector2 pos; /// position of the mouse cursor at the moment when the button event has occurred, in widget local coordinates
 	unsigned pointer_id; /// id of the mouse pointer on systems with multiple mouse pointers, like multitouch screens
 	bool ignore_mouse_capture; /// ignore mouse capturing and distribute mouse move event to all child widgets
+	utki::span<const vector2> history = utki::span<const vector2>(); /// earlier pointer positions coalesced into this event, oldest first, relative to pos
 };
 
 }
@@ -0,0 +1,57 @@
+#include "interned_string.hpp"
+
+#include <unordered_set>
+#include <mutex>
+
+using namespace morda;
+
+namespace{
+struct string_pool{
+	std::mutex mutex;
+	std::unordered_set<std::string> strings;
+};
+
+string_pool& get_pool(){
+	// pool is never destroyed, because interned strings can be used in destructors of static objects
+	static string_pool* pool = new string_pool();
+	return *pool;
+}
+
+const std::string empty_string;
+}
+
+interned_string::interned_string(const std::string& str){
+	if(str.empty()){
+		return;
+	}
+
+	auto& pool = get_pool();
+
+	std::lock_guard<decltype(pool.mutex)> lock_guard(pool.mutex);
+
+	// pointers to elements of unordered_set remain valid on rehashing
+	this->s = &*pool.strings.insert(str).first;
+}
+
+interned_string interned_string::find(const std::string& str){
+	if(str.empty()){
+		return interned_string();
+	}
+
+	auto& pool = get_pool();
+
+	std::lock_guard<decltype(pool.mutex)> lock_guard(pool.mutex);
+
+	auto i = pool.strings.find(str);
+	if(i == pool.strings.end()){
+		return interned_string();
+	}
+	return interned_string(&*i);
+}
+
+const std::string& interned_string::to_string()const noexcept{
+	if(!this->s){
+		return empty_string;
+	}
+	return *this->s;
+}
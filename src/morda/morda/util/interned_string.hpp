@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <functional>
+
+namespace morda{
+
+/**
+ * @brief Interned string.
+ * All equal strings are stored only once in a global pool, the interned_string object itself
+ * holds just a pointer to the pooled string. So, copying and comparing two interned strings
+ * is as cheap as copying and comparing pointers.
+ * Strings are never removed from the pool, so interned strings are intended for a limited set of values,
+ * like widget IDs, and not for arbitrary text.
+ * Interning a string is thread safe.
+ */
+class interned_string{
+	// nullptr means empty string
+	const std::string* s = nullptr;
+
+	explicit interned_string(const std::string* s) :
+			s(s)
+	{}
+public:
+	interned_string() = default;
+
+	interned_string(const std::string& str);
+
+	interned_string(const char* str) :
+			interned_string(std::string(str))
+	{}
+
+	const std::string& to_string()const noexcept;
+
+	operator const std::string&()const noexcept{
+		return this->to_string();
+	}
+
+	bool empty()const noexcept{
+		return !this->s;
+	}
+
+	size_t size()const noexcept{
+		return this->to_string().size();
+	}
+
+	size_t length()const noexcept{
+		return this->size();
+	}
+
+	const char* c_str()const noexcept{
+		return this->to_string().c_str();
+	}
+
+	bool operator==(const interned_string& str)const noexcept{
+		return this->s == str.s;
+	}
+
+	bool operator!=(const interned_string& str)const noexcept{
+		return !this->operator==(str);
+	}
+
+	bool operator==(const std::string& str)const noexcept{
+		return this->to_string() == str;
+	}
+
+	bool operator!=(const std::string& str)const noexcept{
+		return !this->operator==(str);
+	}
+
+	bool operator==(const char* str)const noexcept{
+		return this->to_string() == str;
+	}
+
+	bool operator!=(const char* str)const noexcept{
+		return !this->operator==(str);
+	}
+
+	friend bool operator==(const std::string& a, const interned_string& b)noexcept{
+		return b == a;
+	}
+
+	friend bool operator!=(const std::string& a, const interned_string& b)noexcept{
+		return b != a;
+	}
+
+	friend std::ostream& operator<<(std::ostream& o, const interned_string& str){
+		return o << str.to_string();
+	}
+
+	/**
+	 * @brief Find interned string without interning it.
+	 * Since strings are interned when interned_string objects are created, the string which has never been interned
+	 * cannot be equal to any existing interned_string object.
+	 * @param str - string to find.
+	 * @return interned string equal to the given one.
+	 * @return empty interned string in case the given string has never been interned.
+	 */
+	static interned_string find(const std::string& str);
+
+	/**
+	 * @brief Get hash value.
+	 * @return hash value of the interned string.
+	 */
+	size_t hash()const noexcept{
+		return std::hash<const void*>()(this->s);
+	}
+};
+
+}
+
+namespace std{
+template <> struct hash<morda::interned_string>{
+	size_t operator()(const morda::interned_string& s)const noexcept{
+		return s.hash();
+	}
+};
+}
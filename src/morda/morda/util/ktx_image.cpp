@@ -0,0 +1,291 @@
+#include "ktx_image.hpp"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+namespace{
+const std::array<std::uint8_t, 12> identifier = {{0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a}};
+
+const size_t header_size = identifier.size() + 13 * 4;
+
+const std::uint32_t endianness_native = 0x04030201;
+const std::uint32_t endianness_swapped = 0x01020304;
+
+// OpenGL enumerations used in KTX header
+const std::uint32_t gl_unsigned_byte = 0x1401;
+const std::uint32_t gl_red = 0x1903;
+const std::uint32_t gl_rgb = 0x1907;
+const std::uint32_t gl_rgba = 0x1908;
+const std::uint32_t gl_luminance = 0x1909;
+const std::uint32_t gl_luminance_alpha = 0x190a;
+const std::uint32_t gl_rg = 0x8227;
+const std::uint32_t gl_luminance8 = 0x8040;
+const std::uint32_t gl_luminance8_alpha8 = 0x8045;
+const std::uint32_t gl_rgb8 = 0x8051;
+const std::uint32_t gl_rgba8 = 0x8058;
+
+const std::array<std::pair<std::uint32_t, texture_2d::compression>, 7> compressed_formats = {{
+	{0x8d64, texture_2d::compression::etc1_rgb}, // GL_ETC1_RGB8_OES
+	{0x9274, texture_2d::compression::etc2_rgb}, // GL_COMPRESSED_RGB8_ETC2
+	{0x9278, texture_2d::compression::etc2_rgba}, // GL_COMPRESSED_RGBA8_ETC2_EAC
+	{0x83f0, texture_2d::compression::bc1_rgb}, // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	{0x83f1, texture_2d::compression::bc1_rgba}, // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+	{0x83f3, texture_2d::compression::bc3_rgba}, // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	{0x8e8c, texture_2d::compression::bc7_rgba} // GL_COMPRESSED_RGBA_BPTC_UNORM
+}};
+
+std::uint32_t read_u32(const std::uint8_t* p, bool swap)noexcept{
+	if(swap){
+		return std::uint32_t(p[3]) | (std::uint32_t(p[2]) << 8) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[0]) << 24);
+	}
+	return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+void append_u32(std::vector<std::uint8_t>& v, std::uint32_t n){
+	for(unsigned i = 0; i != 4; ++i){
+		v.push_back(std::uint8_t(n >> (i * 8)));
+	}
+}
+
+size_t align_4(size_t n)noexcept{
+	return (n + 3) & ~size_t(3);
+}
+
+r4::vector2<unsigned> mip_dims(r4::vector2<unsigned> dims, unsigned level)noexcept{
+	return r4::vector2<unsigned>(
+			std::max(dims.x() >> level, 1u),
+			std::max(dims.y() >> level, 1u)
+		);
+}
+}
+
+bool ktx_image::is_ktx(utki::span<const std::uint8_t> data)noexcept{
+	return data.size() >= identifier.size() && std::memcmp(data.data(), identifier.data(), identifier.size()) == 0;
+}
+
+ktx_image::ktx_image(utki::span<const std::uint8_t> data){
+	if(data.size() < header_size || !is_ktx(data)){
+		throw std::invalid_argument("ktx_image::ktx_image(): not a KTX file");
+	}
+
+	auto p = data.data() + identifier.size();
+
+	bool swap;
+	switch(read_u32(p, false)){
+		case endianness_native:
+			swap = false;
+			break;
+		case endianness_swapped:
+			swap = true;
+			break;
+		default:
+			throw std::invalid_argument("ktx_image::ktx_image(): invalid endianness value");
+	}
+
+	std::array<std::uint32_t, 12> h;
+	for(unsigned i = 0; i != h.size(); ++i){
+		h[i] = read_u32(p + (i + 1) * 4, swap);
+	}
+
+	std::uint32_t gl_type = h[0];
+	std::uint32_t gl_format = h[2];
+	std::uint32_t gl_internal_format = h[3];
+	this->dims_v = r4::vector2<unsigned>(h[5], h[6]);
+	std::uint32_t pixel_depth = h[7];
+	std::uint32_t num_array_elements = h[8];
+	std::uint32_t num_faces = h[9];
+	std::uint32_t num_mips = std::max(h[10], std::uint32_t(1));
+	std::uint32_t key_value_data_size = h[11];
+
+	if(this->dims_v.x() == 0 || this->dims_v.y() == 0 || pixel_depth != 0 || num_array_elements != 0 || num_faces != 1){
+		throw std::invalid_argument("ktx_image::ktx_image(): only 2d textures are supported");
+	}
+
+	if(num_mips > 32){
+		throw std::invalid_argument("ktx_image::ktx_image(): invalid number of mipmap levels");
+	}
+
+	unsigned bytes_per_pixel = 0;
+
+	if(gl_type == 0){
+		auto i = std::find_if(
+				compressed_formats.begin(),
+				compressed_formats.end(),
+				[gl_internal_format](const decltype(compressed_formats)::value_type& f){
+					return f.first == gl_internal_format;
+				}
+			);
+		if(i == compressed_formats.end()){
+			throw std::invalid_argument("ktx_image::ktx_image(): unsupported compressed texture format");
+		}
+		this->is_compressed_v = true;
+		this->compression_v = i->second;
+	}else{
+		if(gl_type != gl_unsigned_byte){
+			throw std::invalid_argument("ktx_image::ktx_image(): only 8 bit per channel uncompressed textures are supported");
+		}
+		this->is_compressed_v = false;
+		switch(gl_format){
+			case gl_red:
+			case gl_luminance:
+				this->type_v = texture_2d::type::grey;
+				break;
+			case gl_rg:
+			case gl_luminance_alpha:
+				this->type_v = texture_2d::type::grey_alpha;
+				break;
+			case gl_rgb:
+				this->type_v = texture_2d::type::rgb;
+				break;
+			case gl_rgba:
+				this->type_v = texture_2d::type::rgba;
+				break;
+			default:
+				throw std::invalid_argument("ktx_image::ktx_image(): unsupported texture format");
+		}
+		bytes_per_pixel = texture_2d::bytes_per_pixel(this->type_v);
+	}
+
+	size_t pos = header_size;
+	if(data.size() - pos < key_value_data_size){
+		throw std::invalid_argument("ktx_image::ktx_image(): file is truncated");
+	}
+	pos += key_value_data_size;
+
+	this->mips_v.reserve(num_mips);
+	this->repacked_mips.reserve(num_mips);
+
+	for(unsigned level = 0; level != num_mips; ++level){
+		if(data.size() - pos < 4){
+			throw std::invalid_argument("ktx_image::ktx_image(): file is truncated");
+		}
+		size_t image_size = read_u32(data.data() + pos, swap);
+		pos += 4;
+
+		if(data.size() - pos < image_size){
+			throw std::invalid_argument("ktx_image::ktx_image(): file is truncated");
+		}
+
+		auto dims = mip_dims(this->dims_v, level);
+		auto level_data = data.data() + pos;
+
+		if(this->is_compressed_v){
+			size_t size = texture_2d::compressed_size(this->compression_v, dims);
+			if(image_size < size){
+				throw std::invalid_argument("ktx_image::ktx_image(): mipmap level data is too small");
+			}
+			this->mips_v.push_back(utki::make_span(level_data, size));
+		}else{
+			// rows of uncompressed data are aligned to 4 bytes
+			size_t row_size = size_t(dims.x()) * bytes_per_pixel;
+			size_t stride = align_4(row_size);
+			if(image_size < stride * dims.y()){
+				throw std::invalid_argument("ktx_image::ktx_image(): mipmap level data is too small");
+			}
+
+			if(stride == row_size){
+				this->mips_v.push_back(utki::make_span(level_data, row_size * dims.y()));
+			}else{
+				this->repacked_mips.emplace_back(row_size * dims.y());
+				auto& buf = this->repacked_mips.back();
+				for(unsigned y = 0; y != dims.y(); ++y){
+					std::memcpy(buf.data() + y * row_size, level_data + y * stride, row_size);
+				}
+				this->mips_v.push_back(utki::make_span(buf));
+			}
+		}
+
+		pos = align_4(pos + image_size);
+		pos = std::min(pos, data.size());
+	}
+}
+
+std::vector<std::uint8_t> ktx_image::write(const raster_image& im, bool mipmaps){
+	if(im.dims().x() == 0 || im.dims().y() == 0){
+		throw std::invalid_argument("ktx_image::write(): image is empty");
+	}
+
+	std::uint32_t gl_format;
+	std::uint32_t gl_internal_format;
+	switch(im.depth()){
+		case raster_image::color_depth::grey:
+			gl_format = gl_luminance;
+			gl_internal_format = gl_luminance8;
+			break;
+		case raster_image::color_depth::grey_alpha:
+			gl_format = gl_luminance_alpha;
+			gl_internal_format = gl_luminance8_alpha8;
+			break;
+		case raster_image::color_depth::rgb:
+			gl_format = gl_rgb;
+			gl_internal_format = gl_rgb8;
+			break;
+		case raster_image::color_depth::rgba:
+			gl_format = gl_rgba;
+			gl_internal_format = gl_rgba8;
+			break;
+		default:
+			throw std::invalid_argument("ktx_image::write(): unknown image color depth");
+	}
+
+	unsigned num_mips = 1;
+	if(mipmaps){
+		for(auto d = std::max(im.dims().x(), im.dims().y()); d > 1; d /= 2){
+			++num_mips;
+		}
+	}
+
+	std::vector<std::uint8_t> ret(identifier.begin(), identifier.end());
+	append_u32(ret, endianness_native);
+	append_u32(ret, gl_unsigned_byte); // glType
+	append_u32(ret, 1); // glTypeSize
+	append_u32(ret, gl_format);
+	append_u32(ret, gl_internal_format);
+	append_u32(ret, gl_format); // glBaseInternalFormat
+	append_u32(ret, im.dims().x());
+	append_u32(ret, im.dims().y());
+	append_u32(ret, 0); // pixelDepth
+	append_u32(ret, 0); // numberOfArrayElements
+	append_u32(ret, 1); // numberOfFaces
+	append_u32(ret, num_mips);
+	append_u32(ret, 0); // bytesOfKeyValueData
+	ASSERT(ret.size() == header_size)
+
+	raster_image mip;
+	const raster_image* level_image = &im;
+
+	for(unsigned level = 0; level != num_mips; ++level){
+		if(level != 0){
+			mip = level_image->downscale(mip_dims(im.dims(), level));
+			level_image = &mip;
+		}
+
+		auto& dims = level_image->dims();
+		size_t row_size = size_t(dims.x()) * level_image->num_channels();
+		size_t stride = align_4(row_size);
+
+		append_u32(ret, std::uint32_t(stride * dims.y()));
+
+		auto pixels = level_image->pixels();
+		for(unsigned y = 0; y != dims.y(); ++y){
+			auto row = pixels.data() + y * row_size;
+			ret.insert(ret.end(), row, row + row_size);
+			ret.resize(ret.size() + stride - row_size, 0);
+		}
+	}
+
+	return ret;
+}
+
+void ktx_image::write(const raster_image& im, bool mipmaps, const papki::file& dst){
+	auto data = write(im, mipmaps);
+
+	papki::file::guard file_guard(dst, papki::file::mode::create);
+	dst.write(utki::make_span(data));
+}
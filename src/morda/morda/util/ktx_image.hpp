@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <utki/span.hpp>
+
+#include <papki/file.hpp>
+
+#include "../render/texture_2d.hpp"
+
+#include "raster_image.hpp"
+
+namespace morda{
+
+/**
+ * @brief KTX texture container.
+ * Parser and writer of KTX 1.1 texture files.
+ * KTX file holds texture data ready to be uploaded to GPU, optionally with precomputed mipmap levels.
+ * The data can be uncompressed 8 bit per channel pixels or GPU compressed (ETC1, ETC2, BC1, BC3, BC7).
+ *
+ * Compressed KTX files are produced by external texture compression tools,
+ * uncompressed ones with mipmaps can be produced with ktx_image::write().
+ */
+class ktx_image{
+	r4::vector2<unsigned> dims_v;
+
+	bool is_compressed_v;
+	texture_2d::type type_v = texture_2d::type::rgba;
+	texture_2d::compression compression_v = texture_2d::compression::etc2_rgb;
+
+	std::vector<utki::span<const std::uint8_t>> mips_v;
+
+	// mipmap levels with row padding removed
+	std::vector<std::vector<std::uint8_t>> repacked_mips;
+
+public:
+	/**
+	 * @brief Parse KTX file data.
+	 * The mipmap level spans point into the given data, so it has to stay alive while this object is used.
+	 * @param data - KTX file data.
+	 * @throw std::invalid_argument - in case the data is not a valid KTX file or the texture format is not supported.
+	 */
+	ktx_image(utki::span<const std::uint8_t> data);
+
+	/**
+	 * @brief Check if data is a KTX file.
+	 * @param data - file data.
+	 * @return true in case the data starts with KTX file identifier.
+	 * @return false otherwise.
+	 */
+	static bool is_ktx(utki::span<const std::uint8_t> data)noexcept;
+
+	/**
+	 * @brief Get base mipmap level dimensions.
+	 * @return Dimensions of the texture.
+	 */
+	const r4::vector2<unsigned>& dims()const noexcept{
+		return this->dims_v;
+	}
+
+	/**
+	 * @brief Check if texture data is GPU compressed.
+	 * @return true in case texture is compressed, then compression() gives compression format.
+	 * @return false in case texture is uncompressed, then type() gives pixel format.
+	 */
+	bool is_compressed()const noexcept{
+		return this->is_compressed_v;
+	}
+
+	/**
+	 * @brief Get uncompressed texture pixel format.
+	 * @return Texture pixel format.
+	 */
+	texture_2d::type type()const noexcept{
+		return this->type_v;
+	}
+
+	/**
+	 * @brief Get compression format.
+	 * @return Compression format of the texture.
+	 */
+	texture_2d::compression compression()const noexcept{
+		return this->compression_v;
+	}
+
+	/**
+	 * @brief Get mipmap levels.
+	 * @return Data of mipmap levels, base level first. Uncompressed pixel rows are tightly packed.
+	 */
+	utki::span<const utki::span<const std::uint8_t>> mips()const noexcept{
+		return utki::make_span(this->mips_v);
+	}
+
+	/**
+	 * @brief Write image to KTX file.
+	 * This is the offline conversion of raster images to textures with precomputed mipmaps.
+	 * Mipmaps are computed with box filter.
+	 * @param im - image to write.
+	 * @param mipmaps - whether to write full mipmap chain.
+	 * @return KTX file data.
+	 */
+	static std::vector<std::uint8_t> write(const raster_image& im, bool mipmaps);
+
+	/**
+	 * @brief Write image to KTX file.
+	 * @param im - image to write.
+	 * @param mipmaps - whether to write full mipmap chain.
+	 * @param dst - file to write to.
+	 */
+	static void write(const raster_image& im, bool mipmaps, const papki::file& dst);
+};
+
+}
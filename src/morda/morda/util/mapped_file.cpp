@@ -0,0 +1,114 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#if M_OS == M_OS_WINDOWS
+#	include <utki/windows.hpp>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+using namespace morda;
+
+#if M_OS == M_OS_WINDOWS
+
+mapped_file::mapped_file(const std::string& path){
+	this->file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(this->file_handle == INVALID_HANDLE_VALUE){
+		this->file_handle = nullptr;
+		throw std::runtime_error("mapped_file::mapped_file(): could not open file: " + path);
+	}
+
+	LARGE_INTEGER file_size;
+	if(!GetFileSizeEx(this->file_handle, &file_size)){
+		this->unmap();
+		throw std::runtime_error("mapped_file::mapped_file(): could not get file size: " + path);
+	}
+
+	this->size = size_t(file_size.QuadPart);
+
+	if(this->size == 0){
+		// empty files cannot be mapped
+		return;
+	}
+
+	this->mapping_handle = CreateFileMapping(this->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!this->mapping_handle){
+		this->unmap();
+		throw std::runtime_error("mapped_file::mapped_file(): could not create file mapping: " + path);
+	}
+
+	this->ptr = reinterpret_cast<const std::uint8_t*>(MapViewOfFile(this->mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if(!this->ptr){
+		this->unmap();
+		throw std::runtime_error("mapped_file::mapped_file(): could not map file: " + path);
+	}
+}
+
+void mapped_file::unmap()noexcept{
+	if(this->ptr){
+		UnmapViewOfFile(this->ptr);
+		this->ptr = nullptr;
+	}
+	if(this->mapping_handle){
+		CloseHandle(this->mapping_handle);
+		this->mapping_handle = nullptr;
+	}
+	if(this->file_handle){
+		CloseHandle(this->file_handle);
+		this->file_handle = nullptr;
+	}
+	this->size = 0;
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& path){
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0){
+		throw std::runtime_error("mapped_file::mapped_file(): could not open file: " + path);
+	}
+
+	// the mapping stays valid after closing the file descriptor
+	struct fd_closer{
+		int fd;
+		~fd_closer()noexcept{
+			close(this->fd);
+		}
+	} fd_closer{fd};
+
+	struct stat st;
+	if(fstat(fd, &st) != 0){
+		throw std::runtime_error("mapped_file::mapped_file(): could not get file size: " + path);
+	}
+
+	if(st.st_size == 0){
+		// empty files cannot be mapped
+		return;
+	}
+
+	void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if(p == MAP_FAILED){
+		throw std::runtime_error("mapped_file::mapped_file(): could not map file: " + path);
+	}
+
+	this->ptr = reinterpret_cast<const std::uint8_t*>(p);
+	this->size = size_t(st.st_size);
+}
+
+void mapped_file::unmap()noexcept{
+	if(this->ptr){
+		munmap(const_cast<std::uint8_t*>(this->ptr), this->size);
+		this->ptr = nullptr;
+	}
+	this->size = 0;
+}
+
+#endif
+
+mapped_file::~mapped_file()noexcept{
+	this->unmap();
+}
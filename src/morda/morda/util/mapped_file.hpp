@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <utki/config.hpp>
+#include <utki/span.hpp>
+
+namespace morda{
+
+/**
+ * @brief Read-only memory mapped file.
+ * The whole file is mapped into the address space of the process, so its contents
+ * can be accessed directly in memory without copying. The pages are loaded by the
+ * operating system on first access.
+ */
+class mapped_file{
+#if M_OS == M_OS_WINDOWS
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+	const std::uint8_t* ptr = nullptr;
+	size_t size = 0;
+
+	void unmap()noexcept;
+public:
+	/**
+	 * @brief Constructor.
+	 * Maps the file into memory.
+	 * @param path - path to the file in the file system.
+	 * @throw std::runtime_error - in case the file could not be opened or mapped.
+	 */
+	mapped_file(const std::string& path);
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file()noexcept;
+
+	/**
+	 * @brief Get file contents.
+	 * @return span of the mapped file contents.
+	 */
+	utki::span<const std::uint8_t> data()const noexcept{
+		return utki::make_span(this->ptr, this->size);
+	}
+};
+
+}
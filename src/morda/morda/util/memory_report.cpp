@@ -0,0 +1,54 @@
+#include "memory_report.hpp"
+
+#include <map>
+#include <typeindex>
+#include <algorithm>
+
+#include "../context.hpp"
+
+using namespace morda;
+
+namespace{
+void gather(const widget& w, std::map<std::type_index, widget_memory_usage>& report){
+	auto ti = w.context->inflater.find_type_info(typeid(w));
+
+	auto& r = report[std::type_index(typeid(w))];
+	if(r.count == 0){
+		r.type_name = ti ? ti->name : std::string(typeid(w).name());
+	}
+
+	++r.count;
+	if(ti){
+		r.object_bytes += ti->size;
+	}
+	r.heap_bytes += w.get_heap_size();
+
+	if(auto c = dynamic_cast<const container*>(&w)){
+		for(auto& cw : c->children()){
+			gather(*cw, report);
+		}
+	}
+}
+}
+
+std::vector<widget_memory_usage> morda::make_memory_report(const widget& root){
+	std::map<std::type_index, widget_memory_usage> report;
+
+	gather(root, report);
+
+	std::vector<widget_memory_usage> ret;
+	ret.reserve(report.size());
+	for(auto& r : report){
+		ret.push_back(std::move(r.second));
+	}
+
+	std::sort(
+			ret.begin(),
+			ret.end(),
+			[](const widget_memory_usage& a, const widget_memory_usage& b){
+				return a.object_bytes + a.heap_bytes > b.object_bytes + b.heap_bytes;
+			}
+		);
+
+	return ret;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../widgets/widget.hpp"
+
+namespace morda{
+
+/**
+ * @brief Memory usage by widgets of a single type.
+ */
+struct widget_memory_usage{
+	/**
+	 * @brief Name of the widget type.
+	 * Name under which the widget type is registered in the inflater.
+	 * If the widget type is not registered, then it is the name provided by RTTI.
+	 */
+	std::string type_name;
+
+	/**
+	 * @brief Number of widgets of this type.
+	 */
+	size_t count = 0;
+
+	/**
+	 * @brief Total size of the widget objects.
+	 * The size of the widget object is only known for widget types registered in the inflater,
+	 * for other widget types this value is 0.
+	 */
+	size_t object_bytes = 0;
+
+	/**
+	 * @brief Total heap memory owned by the widgets.
+	 * See widget::get_heap_size() for details.
+	 */
+	size_t heap_bytes = 0;
+};
+
+/**
+ * @brief Gather memory usage report for the widget hierarchy.
+ * Walks through the whole widget hierarchy starting from the given root widget
+ * and collects memory usage statistics per widget type.
+ * @param root - root of the widget hierarchy to make the report for.
+ * @return list of memory usage records, one per widget type, sorted by total size in descending order.
+ */
+std::vector<widget_memory_usage> make_memory_report(const widget& root);
+
+}
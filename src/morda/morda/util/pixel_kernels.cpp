@@ -0,0 +1,649 @@
+#include "pixel_kernels.hpp"
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define MORDA_PIXEL_KERNELS_SSE2
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define MORDA_PIXEL_KERNELS_NEON
+#	include <arm_neon.h>
+#endif
+
+using namespace morda;
+
+namespace{
+// rounded v / 255 for v <= 255 * 255, gives same result as the vectorized versions
+std::uint8_t div_255(unsigned v)noexcept{
+	v += 128;
+	return std::uint8_t((v + (v >> 8)) >> 8);
+}
+}
+
+const char* pixel_kernels::instruction_set()noexcept{
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+	return "sse2";
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+void pixel_kernels::copy_rows(
+		std::uint8_t* dst,
+		size_t dst_stride,
+		const std::uint8_t* src,
+		size_t src_stride,
+		size_t row_size,
+		unsigned num_rows
+	)noexcept
+{
+	if(dst_stride == row_size && src_stride == row_size){
+		std::memcpy(dst, src, row_size * num_rows);
+		return;
+	}
+
+	for(unsigned j = 0; j != num_rows; ++j, dst += dst_stride, src += src_stride){
+		std::memcpy(dst, src, row_size);
+	}
+}
+
+namespace{
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+// returns number of processed pixels
+size_t insert_channel(std::uint8_t* dst, unsigned dst_num_channels, unsigned dst_chan, const std::uint8_t* src, size_t num_pixels)noexcept{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i shift = _mm_cvtsi32_si128(int(dst_chan * 8));
+
+	size_t i = 0;
+	switch(dst_num_channels){
+		case 2:
+			{
+				const __m128i mask = _mm_set1_epi16(short(~(0xff << (dst_chan * 8))));
+				for(; i + 16 <= num_pixels; i += 16){
+					__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+					__m128i v[] = {
+						_mm_sll_epi16(_mm_unpacklo_epi8(s, zero), shift),
+						_mm_sll_epi16(_mm_unpackhi_epi8(s, zero), shift)
+					};
+					auto d = reinterpret_cast<__m128i*>(dst + i * 2);
+					for(unsigned k = 0; k != 2; ++k){
+						_mm_storeu_si128(d + k, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(d + k), mask), v[k]));
+					}
+				}
+			}
+			break;
+		case 4:
+			{
+				const __m128i mask = _mm_set1_epi32(int(~(0xffu << (dst_chan * 8))));
+				for(; i + 16 <= num_pixels; i += 16){
+					__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+					__m128i lo = _mm_unpacklo_epi8(s, zero);
+					__m128i hi = _mm_unpackhi_epi8(s, zero);
+					__m128i v[] = {
+						_mm_sll_epi32(_mm_unpacklo_epi16(lo, zero), shift),
+						_mm_sll_epi32(_mm_unpackhi_epi16(lo, zero), shift),
+						_mm_sll_epi32(_mm_unpacklo_epi16(hi, zero), shift),
+						_mm_sll_epi32(_mm_unpackhi_epi16(hi, zero), shift)
+					};
+					auto d = reinterpret_cast<__m128i*>(dst + i * 4);
+					for(unsigned k = 0; k != 4; ++k){
+						_mm_storeu_si128(d + k, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(d + k), mask), v[k]));
+					}
+				}
+			}
+			break;
+		default:
+			break;
+	}
+	return i;
+}
+
+// returns number of processed pixels
+size_t extract_channel(std::uint8_t* dst, const std::uint8_t* src, unsigned src_num_channels, unsigned src_chan, size_t num_pixels)noexcept{
+	const __m128i shift = _mm_cvtsi32_si128(int(src_chan * 8));
+
+	size_t i = 0;
+	switch(src_num_channels){
+		case 2:
+			{
+				const __m128i mask = _mm_set1_epi16(0xff);
+				for(; i + 16 <= num_pixels; i += 16){
+					auto s = reinterpret_cast<const __m128i*>(src + i * 2);
+					__m128i a = _mm_and_si128(_mm_srl_epi16(_mm_loadu_si128(s), shift), mask);
+					__m128i b = _mm_and_si128(_mm_srl_epi16(_mm_loadu_si128(s + 1), shift), mask);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+				}
+			}
+			break;
+		case 4:
+			{
+				const __m128i mask = _mm_set1_epi32(0xff);
+				for(; i + 16 <= num_pixels; i += 16){
+					auto s = reinterpret_cast<const __m128i*>(src + i * 4);
+					__m128i v[4];
+					for(unsigned k = 0; k != 4; ++k){
+						v[k] = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(s + k), shift), mask);
+					}
+					// values fit into 8 bits, so signed saturation does not change them
+					__m128i lo = _mm_packs_epi32(v[0], v[1]);
+					__m128i hi = _mm_packs_epi32(v[2], v[3]);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+				}
+			}
+			break;
+		default:
+			break;
+	}
+	return i;
+}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+// returns number of processed pixels
+size_t insert_channel(std::uint8_t* dst, unsigned dst_num_channels, unsigned dst_chan, const std::uint8_t* src, size_t num_pixels)noexcept{
+	size_t i = 0;
+	switch(dst_num_channels){
+		case 2:
+			for(; i + 16 <= num_pixels; i += 16){
+				uint8x16x2_t d = vld2q_u8(dst + i * 2);
+				d.val[dst_chan] = vld1q_u8(src + i);
+				vst2q_u8(dst + i * 2, d);
+			}
+			break;
+		case 4:
+			for(; i + 16 <= num_pixels; i += 16){
+				uint8x16x4_t d = vld4q_u8(dst + i * 4);
+				d.val[dst_chan] = vld1q_u8(src + i);
+				vst4q_u8(dst + i * 4, d);
+			}
+			break;
+		default:
+			break;
+	}
+	return i;
+}
+
+// returns number of processed pixels
+size_t extract_channel(std::uint8_t* dst, const std::uint8_t* src, unsigned src_num_channels, unsigned src_chan, size_t num_pixels)noexcept{
+	size_t i = 0;
+	switch(src_num_channels){
+		case 2:
+			for(; i + 16 <= num_pixels; i += 16){
+				vst1q_u8(dst + i, vld2q_u8(src + i * 2).val[src_chan]);
+			}
+			break;
+		case 4:
+			for(; i + 16 <= num_pixels; i += 16){
+				vst1q_u8(dst + i, vld4q_u8(src + i * 4).val[src_chan]);
+			}
+			break;
+		default:
+			break;
+	}
+	return i;
+}
+#endif
+}
+
+void pixel_kernels::copy_channel(
+		std::uint8_t* dst,
+		unsigned dst_num_channels,
+		unsigned dst_chan,
+		const std::uint8_t* src,
+		unsigned src_num_channels,
+		unsigned src_chan,
+		size_t num_pixels
+	)noexcept
+{
+	ASSERT(dst_chan < dst_num_channels)
+	ASSERT(src_chan < src_num_channels)
+
+	size_t i = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2) || defined(MORDA_PIXEL_KERNELS_NEON)
+	if(src_num_channels == 1){
+		i = insert_channel(dst, dst_num_channels, dst_chan, src, num_pixels);
+	}else if(dst_num_channels == 1){
+		i = extract_channel(dst, src, src_num_channels, src_chan, num_pixels);
+	}
+#endif
+
+	auto d = dst + i * dst_num_channels + dst_chan;
+	auto s = src + i * src_num_channels + src_chan;
+	for(; i != num_pixels; ++i, d += dst_num_channels, s += src_num_channels){
+		*d = *s;
+	}
+}
+
+void pixel_kernels::fill_channel(
+		std::uint8_t* buf,
+		unsigned num_channels,
+		unsigned chan,
+		std::uint8_t val,
+		size_t num_pixels
+	)noexcept
+{
+	ASSERT(chan < num_channels)
+
+	if(num_channels == 1){
+		std::memset(buf, val, num_pixels);
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+	if(num_channels == 2 || num_channels == 4){
+		// 16 bytes hold whole number of pixels
+		alignas(16) std::uint8_t mask_bytes[16];
+		alignas(16) std::uint8_t val_bytes[16];
+		for(unsigned k = 0; k != 16; ++k){
+			bool is_chan = k % num_channels == chan;
+			mask_bytes[k] = is_chan ? 0 : 0xff;
+			val_bytes[k] = is_chan ? val : 0;
+		}
+		const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(mask_bytes));
+		const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(val_bytes));
+
+		size_t num_bytes = num_pixels * num_channels;
+		size_t b = 0;
+		for(; b + 16 <= num_bytes; b += 16){
+			auto p = reinterpret_cast<__m128i*>(buf + b);
+			_mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(p), mask), v));
+		}
+		i = b / num_channels;
+	}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+	const uint8x16_t v = vdupq_n_u8(val);
+	switch(num_channels){
+		case 2:
+			for(; i + 16 <= num_pixels; i += 16){
+				uint8x16x2_t d = vld2q_u8(buf + i * 2);
+				d.val[chan] = v;
+				vst2q_u8(buf + i * 2, d);
+			}
+			break;
+		case 4:
+			for(; i + 16 <= num_pixels; i += 16){
+				uint8x16x4_t d = vld4q_u8(buf + i * 4);
+				d.val[chan] = v;
+				vst4q_u8(buf + i * 4, d);
+			}
+			break;
+		default:
+			break;
+	}
+#endif
+
+	for(auto p = buf + i * num_channels + chan; i != num_pixels; ++i, p += num_channels){
+		*p = val;
+	}
+}
+
+namespace{
+// interleaves source values with constant value, source values go to the channel with given index
+void interleave_with_constant(std::uint8_t* dst, const std::uint8_t* src, size_t num_pixels, std::uint8_t constant, unsigned src_chan)noexcept{
+	ASSERT(src_chan < 2)
+
+	size_t i = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+	const __m128i c = _mm_set1_epi8(char(constant));
+	for(; i + 16 <= num_pixels; i += 16){
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		auto d = reinterpret_cast<__m128i*>(dst + i * 2);
+		if(src_chan == 0){
+			_mm_storeu_si128(d, _mm_unpacklo_epi8(s, c));
+			_mm_storeu_si128(d + 1, _mm_unpackhi_epi8(s, c));
+		}else{
+			_mm_storeu_si128(d, _mm_unpacklo_epi8(c, s));
+			_mm_storeu_si128(d + 1, _mm_unpackhi_epi8(c, s));
+		}
+	}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+	uint8x16x2_t d;
+	d.val[1 - src_chan] = vdupq_n_u8(constant);
+	for(; i + 16 <= num_pixels; i += 16){
+		d.val[src_chan] = vld1q_u8(src + i);
+		vst2q_u8(dst + i * 2, d);
+	}
+#endif
+
+	for(; i != num_pixels; ++i){
+		dst[i * 2 + src_chan] = src[i];
+		dst[i * 2 + 1 - src_chan] = constant;
+	}
+}
+}
+
+void pixel_kernels::grey_to_grey_alpha(std::uint8_t* dst, const std::uint8_t* src, size_t num_pixels, std::uint8_t alpha)noexcept{
+	interleave_with_constant(dst, src, num_pixels, alpha, 0);
+}
+
+void pixel_kernels::alpha_to_grey_alpha(std::uint8_t* dst, const std::uint8_t* src, size_t num_pixels, std::uint8_t grey)noexcept{
+	interleave_with_constant(dst, src, num_pixels, grey, 1);
+}
+
+namespace{
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+// multiplies 16 bit channel values by alpha, alpha_lanes mask selects lanes holding alpha values
+template <unsigned num_channels> __m128i premultiply_lanes(__m128i c, __m128i alpha_lanes)noexcept{
+	__m128i a;
+	if constexpr (num_channels == 4){
+		a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	}else{
+		static_assert(num_channels == 2, "only grey-alpha and RGBA are supported");
+		a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+	}
+
+	// alpha itself is multiplied by 255 to stay unchanged
+	a = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a), _mm_and_si128(alpha_lanes, _mm_set1_epi16(0xff)));
+
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+template <unsigned num_channels> size_t premultiply_alpha_simd(std::uint8_t* buf, size_t num_pixels)noexcept{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_lanes = num_channels == 4 ?
+			_mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0) :
+			_mm_set_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+
+	const size_t pixels_per_iteration = 16 / num_channels;
+
+	size_t i = 0;
+	for(; i + pixels_per_iteration <= num_pixels; i += pixels_per_iteration){
+		auto p = reinterpret_cast<__m128i*>(buf + i * num_channels);
+		__m128i v = _mm_loadu_si128(p);
+		__m128i lo = premultiply_lanes<num_channels>(_mm_unpacklo_epi8(v, zero), alpha_lanes);
+		__m128i hi = premultiply_lanes<num_channels>(_mm_unpackhi_epi8(v, zero), alpha_lanes);
+		_mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+	}
+	return i;
+}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+uint8x16_t premultiply_vector(uint8x16_t c, uint8x16_t a)noexcept{
+	uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+	uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+	return vcombine_u8(
+			vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+			vraddhn_u16(hi, vrshrq_n_u16(hi, 8))
+		);
+}
+
+template <unsigned num_channels> size_t premultiply_alpha_simd(std::uint8_t* buf, size_t num_pixels)noexcept{
+	size_t i = 0;
+	for(; i + 16 <= num_pixels; i += 16){
+		auto p = buf + i * num_channels;
+		if constexpr (num_channels == 4){
+			uint8x16x4_t v = vld4q_u8(p);
+			for(unsigned k = 0; k != 3; ++k){
+				v.val[k] = premultiply_vector(v.val[k], v.val[3]);
+			}
+			vst4q_u8(p, v);
+		}else{
+			static_assert(num_channels == 2, "only grey-alpha and RGBA are supported");
+			uint8x16x2_t v = vld2q_u8(p);
+			v.val[0] = premultiply_vector(v.val[0], v.val[1]);
+			vst2q_u8(p, v);
+		}
+	}
+	return i;
+}
+#endif
+}
+
+void pixel_kernels::premultiply_alpha(std::uint8_t* buf, unsigned num_channels, size_t num_pixels)noexcept{
+	ASSERT(num_channels == 2 || num_channels == 4)
+
+	size_t i = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2) || defined(MORDA_PIXEL_KERNELS_NEON)
+	if(num_channels == 4){
+		i = premultiply_alpha_simd<4>(buf, num_pixels);
+	}else{
+		i = premultiply_alpha_simd<2>(buf, num_pixels);
+	}
+#endif
+
+	auto alpha_chan = num_channels - 1;
+	for(auto p = buf + i * num_channels; i != num_pixels; ++i, p += num_channels){
+		unsigned a = p[alpha_chan];
+		for(unsigned k = 0; k != alpha_chan; ++k){
+			p[k] = div_255(p[k] * a);
+		}
+	}
+}
+
+void pixel_kernels::downscale_2x(std::uint8_t* dst, const std::uint8_t* src, r4::vector2<unsigned> src_dims, unsigned num_channels)noexcept{
+	auto dst_dims = src_dims / 2;
+	size_t src_stride = size_t(src_dims.x()) * num_channels;
+
+	for(unsigned y = 0; y != dst_dims.y(); ++y){
+		const std::uint8_t* r0 = src + size_t(y) * 2 * src_stride;
+		const std::uint8_t* r1 = r0 + src_stride;
+
+		unsigned x = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+		if(num_channels == 4){
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+
+			// sums 2x2 blocks of 4 source pixels in each row, gives 2 pixels as 16 bit values
+			auto sum_blocks = [&zero](__m128i a, __m128i b){
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+				return _mm_unpacklo_epi64(lo, hi);
+			};
+
+			for(; x + 4 <= dst_dims.x(); x += 4){
+				auto a = reinterpret_cast<const __m128i*>(r0 + size_t(x) * 8);
+				auto b = reinterpret_cast<const __m128i*>(r1 + size_t(x) * 8);
+				__m128i s0 = sum_blocks(_mm_loadu_si128(a), _mm_loadu_si128(b));
+				__m128i s1 = sum_blocks(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+				s0 = _mm_srli_epi16(_mm_add_epi16(s0, two), 2);
+				s1 = _mm_srli_epi16(_mm_add_epi16(s1, two), 2);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + size_t(x) * 4), _mm_packus_epi16(s0, s1));
+			}
+		}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+		if(num_channels == 4){
+			for(; x + 8 <= dst_dims.x(); x += 8){
+				uint8x16x4_t a = vld4q_u8(r0 + size_t(x) * 8);
+				uint8x16x4_t b = vld4q_u8(r1 + size_t(x) * 8);
+				uint8x8x4_t d;
+				for(unsigned k = 0; k != 4; ++k){
+					d.val[k] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[k]), b.val[k]), 2);
+				}
+				vst4_u8(dst + size_t(x) * 4, d);
+			}
+		}
+#endif
+
+		auto d = dst + size_t(x) * num_channels;
+		for(; x != dst_dims.x(); ++x){
+			auto p0 = r0 + size_t(x) * 2 * num_channels;
+			auto p1 = r1 + size_t(x) * 2 * num_channels;
+			for(unsigned k = 0; k != num_channels; ++k, ++d){
+				*d = std::uint8_t((unsigned(p0[k]) + p0[k + num_channels] + p1[k] + p1[k + num_channels] + 2) >> 2);
+			}
+		}
+
+		dst += size_t(dst_dims.x()) * num_channels;
+	}
+}
+
+namespace{
+// source pixels range [begin, end) covered by each destination pixel
+std::vector<std::pair<unsigned, unsigned>> make_box_ranges(unsigned dst_size, unsigned src_size){
+	std::vector<std::pair<unsigned, unsigned>> ret(dst_size);
+	for(unsigned i = 0; i != dst_size; ++i){
+		unsigned begin = unsigned(std::uint64_t(i) * src_size / dst_size);
+		unsigned end = unsigned(std::uint64_t(i + 1) * src_size / dst_size);
+		ret[i] = std::make_pair(begin, std::max(end, begin + 1));
+	}
+	return ret;
+}
+}
+
+namespace{
+// adds source row to the row sums
+void accumulate_row(std::uint32_t* sums, const std::uint8_t* src, size_t size)noexcept{
+	size_t i = 0;
+
+#if defined(MORDA_PIXEL_KERNELS_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for(; i + 16 <= size; i += 16){
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i lo = _mm_unpacklo_epi8(s, zero);
+		__m128i hi = _mm_unpackhi_epi8(s, zero);
+		auto d = reinterpret_cast<__m128i*>(sums + i);
+		_mm_storeu_si128(d, _mm_add_epi32(_mm_loadu_si128(d), _mm_unpacklo_epi16(lo, zero)));
+		_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi16(lo, zero)));
+		_mm_storeu_si128(d + 2, _mm_add_epi32(_mm_loadu_si128(d + 2), _mm_unpacklo_epi16(hi, zero)));
+		_mm_storeu_si128(d + 3, _mm_add_epi32(_mm_loadu_si128(d + 3), _mm_unpackhi_epi16(hi, zero)));
+	}
+#elif defined(MORDA_PIXEL_KERNELS_NEON)
+	for(; i + 16 <= size; i += 16){
+		uint8x16_t s = vld1q_u8(src + i);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(s));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(s));
+		auto d = sums + i;
+		vst1q_u32(d, vaddw_u16(vld1q_u32(d), vget_low_u16(lo)));
+		vst1q_u32(d + 4, vaddw_u16(vld1q_u32(d + 4), vget_high_u16(lo)));
+		vst1q_u32(d + 8, vaddw_u16(vld1q_u32(d + 8), vget_low_u16(hi)));
+		vst1q_u32(d + 12, vaddw_u16(vld1q_u32(d + 12), vget_high_u16(hi)));
+	}
+#endif
+
+	for(; i != size; ++i){
+		sums[i] += src[i];
+	}
+}
+}
+
+pixel_kernels::box_downscaler::box_downscaler(r4::vector2<unsigned> dst_dims, r4::vector2<unsigned> src_dims, unsigned num_channels) :
+		dst_dims(dst_dims),
+		num_channels(num_channels),
+		cols(make_box_ranges(dst_dims.x(), src_dims.x())),
+		rows(make_box_ranges(dst_dims.y(), src_dims.y())),
+		row_sums(size_t(src_dims.x()) * num_channels, 0)
+{
+	ASSERT(dst_dims.x() <= src_dims.x() && dst_dims.y() <= src_dims.y())
+}
+
+void pixel_kernels::box_downscaler::push_row(std::uint8_t* dst, const std::uint8_t* src_row)noexcept{
+	if(this->dst_y == this->rows.size()){
+		return;
+	}
+
+	accumulate_row(this->row_sums.data(), src_row, this->row_sums.size());
+	++this->src_y;
+
+	const auto& r = this->rows[this->dst_y];
+	if(this->src_y != r.second){
+		return;
+	}
+
+	dst += size_t(this->dst_y) * this->dst_dims.x() * this->num_channels;
+
+	for(auto& c : this->cols){
+		std::uint32_t count = (c.second - c.first) * (r.second - r.first);
+		for(unsigned k = 0; k != this->num_channels; ++k, ++dst){
+			std::uint32_t sum = 0;
+			for(unsigned x = c.first; x != c.second; ++x){
+				sum += this->row_sums[size_t(x) * this->num_channels + k];
+			}
+			*dst = std::uint8_t((sum + count / 2) / count);
+		}
+	}
+
+	std::fill(this->row_sums.begin(), this->row_sums.end(), 0);
+	++this->dst_y;
+}
+
+void pixel_kernels::downscale_box(
+		std::uint8_t* dst,
+		r4::vector2<unsigned> dst_dims,
+		const std::uint8_t* src,
+		r4::vector2<unsigned> src_dims,
+		unsigned num_channels
+	)
+{
+	box_downscaler d(dst_dims, src_dims, num_channels);
+
+	size_t src_stride = size_t(src_dims.x()) * num_channels;
+
+	for(unsigned y = 0; y != src_dims.y(); ++y){
+		d.push_row(dst, src + size_t(y) * src_stride);
+	}
+}
+
+namespace{
+// source sample positions for destination pixel centers, in 24.8 fixed point
+struct bilinear_sample{
+	unsigned index0;
+	unsigned index1;
+	unsigned weight1; // weight of index1, weight of index0 is 256 - weight1
+};
+
+std::vector<bilinear_sample> make_bilinear_samples(unsigned dst_size, unsigned src_size){
+	std::vector<bilinear_sample> ret(dst_size);
+	for(unsigned i = 0; i != dst_size; ++i){
+		// (i + 0.5) * src_size / dst_size - 0.5
+		std::int64_t pos = (std::int64_t(2 * i + 1) * src_size * 256) / (2 * std::int64_t(dst_size)) - 128;
+		pos = std::max(pos, std::int64_t(0));
+
+		unsigned index0 = std::min(unsigned(pos >> 8), src_size - 1);
+		ret[i].index0 = index0;
+		ret[i].index1 = std::min(index0 + 1, src_size - 1);
+		ret[i].weight1 = unsigned(pos & 0xff);
+	}
+	return ret;
+}
+}
+
+void pixel_kernels::resize_bilinear(
+		std::uint8_t* dst,
+		r4::vector2<unsigned> dst_dims,
+		const std::uint8_t* src,
+		r4::vector2<unsigned> src_dims,
+		unsigned num_channels
+	)
+{
+	if(src_dims.x() == 0 || src_dims.y() == 0){
+		return;
+	}
+
+	auto cols = make_bilinear_samples(dst_dims.x(), src_dims.x());
+	auto rows = make_bilinear_samples(dst_dims.y(), src_dims.y());
+
+	size_t src_stride = size_t(src_dims.x()) * num_channels;
+
+	for(auto& r : rows){
+		auto r0 = src + size_t(r.index0) * src_stride;
+		auto r1 = src + size_t(r.index1) * src_stride;
+		unsigned wy1 = r.weight1;
+		unsigned wy0 = 256 - wy1;
+
+		for(auto& c : cols){
+			auto o0 = size_t(c.index0) * num_channels;
+			auto o1 = size_t(c.index1) * num_channels;
+			unsigned wx1 = c.weight1;
+			unsigned wx0 = 256 - wx1;
+
+			for(unsigned k = 0; k != num_channels; ++k, ++dst){
+				std::uint32_t top = r0[o0 + k] * wx0 + r0[o1 + k] * wx1;
+				std::uint32_t bottom = r1[o0 + k] * wx0 + r1[o1 + k] * wx1;
+				*dst = std::uint8_t((top * wy0 + bottom * wy1 + (1 << 15)) >> 16);
+			}
+		}
+	}
+}
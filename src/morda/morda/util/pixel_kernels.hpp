@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+#include <r4/vector.hpp>
+
+namespace morda{
+
+/**
+ * @brief Low level pixel processing routines.
+ * The routines work on raw 8 bit per channel pixel buffers with interleaved channels.
+ * Where possible, the routines are vectorized with SSE2 (x86) or NEON (ARM) instructions,
+ * otherwise scalar implementation is used. All implementations give bitwise identical results.
+ */
+namespace pixel_kernels{
+
+/**
+ * @brief Name of the instruction set used by the kernels.
+ * @return "sse2", "neon" or "scalar".
+ */
+const char* instruction_set()noexcept;
+
+/**
+ * @brief Copy rectangular block of bytes.
+ * @param dst - destination buffer.
+ * @param dst_stride - size of destination row in bytes.
+ * @param src - source buffer.
+ * @param src_stride - size of source row in bytes.
+ * @param row_size - number of bytes to copy from each row.
+ * @param num_rows - number of rows to copy.
+ */
+void copy_rows(
+		std::uint8_t* dst,
+		size_t dst_stride,
+		const std::uint8_t* src,
+		size_t src_stride,
+		size_t row_size,
+		unsigned num_rows
+	)noexcept;
+
+/**
+ * @brief Copy single channel of pixels.
+ * @param dst - destination pixels.
+ * @param dst_num_channels - number of channels of destination pixels.
+ * @param dst_chan - index of destination channel.
+ * @param src - source pixels.
+ * @param src_num_channels - number of channels of source pixels.
+ * @param src_chan - index of source channel.
+ * @param num_pixels - number of pixels to process.
+ */
+void copy_channel(
+		std::uint8_t* dst,
+		unsigned dst_num_channels,
+		unsigned dst_chan,
+		const std::uint8_t* src,
+		unsigned src_num_channels,
+		unsigned src_chan,
+		size_t num_pixels
+	)noexcept;
+
+/**
+ * @brief Fill single channel of pixels with given value.
+ * @param buf - pixels buffer.
+ * @param num_channels - number of channels of the pixels.
+ * @param chan - index of the channel to fill.
+ * @param val - value to fill with.
+ * @param num_pixels - number of pixels to process.
+ */
+void fill_channel(
+		std::uint8_t* buf,
+		unsigned num_channels,
+		unsigned chan,
+		std::uint8_t val,
+		size_t num_pixels
+	)noexcept;
+
+/**
+ * @brief Expand grey pixels to grey-alpha pixels.
+ * @param dst - destination grey-alpha pixels.
+ * @param src - source grey pixels.
+ * @param num_pixels - number of pixels to process.
+ * @param alpha - alpha value for all destination pixels.
+ */
+void grey_to_grey_alpha(std::uint8_t* dst, const std::uint8_t* src, size_t num_pixels, std::uint8_t alpha)noexcept;
+
+/**
+ * @brief Expand alpha mask to grey-alpha pixels.
+ * This is how font glyph bitmaps are converted to textures.
+ * @param dst - destination grey-alpha pixels.
+ * @param src - source alpha values.
+ * @param num_pixels - number of pixels to process.
+ * @param grey - grey value for all destination pixels.
+ */
+void alpha_to_grey_alpha(std::uint8_t* dst, const std::uint8_t* src, size_t num_pixels, std::uint8_t grey)noexcept;
+
+/**
+ * @brief Multiply color channels by alpha channel.
+ * Alpha is the last channel of the pixel, so supported pixel formats are grey-alpha and RGBA.
+ * Values are rounded to nearest.
+ * @param buf - pixels buffer.
+ * @param num_channels - number of channels of the pixels, 2 or 4.
+ * @param num_pixels - number of pixels to process.
+ */
+void premultiply_alpha(std::uint8_t* buf, unsigned num_channels, size_t num_pixels)noexcept;
+
+/**
+ * @brief Downscale image twice with box filter.
+ * Each destination pixel is an average of 2x2 source pixels, rounded to nearest.
+ * Destination dimensions are src_dims / 2. In case source dimension is odd, the last
+ * source row or column is ignored.
+ * @param dst - destination pixels buffer.
+ * @param src - source pixels buffer.
+ * @param src_dims - source image dimensions.
+ * @param num_channels - number of channels of the pixels.
+ */
+void downscale_2x(std::uint8_t* dst, const std::uint8_t* src, r4::vector2<unsigned> src_dims, unsigned num_channels)noexcept;
+
+/**
+ * @brief Downscale image with box filter.
+ * Each destination pixel is an average of the source pixels it covers.
+ * @param dst - destination pixels buffer.
+ * @param dst_dims - destination image dimensions, must not be greater than source dimensions.
+ * @param src - source pixels buffer.
+ * @param src_dims - source image dimensions.
+ * @param num_channels - number of channels of the pixels.
+ */
+void downscale_box(
+		std::uint8_t* dst,
+		r4::vector2<unsigned> dst_dims,
+		const std::uint8_t* src,
+		r4::vector2<unsigned> src_dims,
+		unsigned num_channels
+	);
+
+/**
+ * @brief Streaming box filter downscaler.
+ * Downscales image with box filter, same as downscale_box(), but takes the source image row by row,
+ * so that the whole source image does not need to be held in memory, e.g. while decoding it.
+ */
+class box_downscaler{
+	const r4::vector2<unsigned> dst_dims;
+	const unsigned num_channels;
+
+	// source pixels range [begin, end) covered by each destination column and row
+	const std::vector<std::pair<unsigned, unsigned>> cols;
+	const std::vector<std::pair<unsigned, unsigned>> rows;
+
+	// sums of the source rows covered by current destination row
+	std::vector<std::uint32_t> row_sums;
+
+	unsigned src_y = 0;
+	unsigned dst_y = 0;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param dst_dims - destination image dimensions, must not be greater than source dimensions.
+	 * @param src_dims - source image dimensions.
+	 * @param num_channels - number of channels of the pixels.
+	 */
+	box_downscaler(r4::vector2<unsigned> dst_dims, r4::vector2<unsigned> src_dims, unsigned num_channels);
+
+	/**
+	 * @brief Push next source row.
+	 * When the source row completes a destination row, the destination row is written to the destination buffer.
+	 * @param dst - destination pixels buffer of the whole destination image.
+	 * @param src_row - source row pixels.
+	 */
+	void push_row(std::uint8_t* dst, const std::uint8_t* src_row)noexcept;
+};
+
+/**
+ * @brief Resize image with bilinear filter.
+ * For downscaling more than twice use downscale_box(), otherwise source pixels are skipped.
+ * @param dst - destination pixels buffer.
+ * @param dst_dims - destination image dimensions.
+ * @param src - source pixels buffer.
+ * @param src_dims - source image dimensions.
+ * @param num_channels - number of channels of the pixels.
+ */
+void resize_bilinear(
+		std::uint8_t* dst,
+		r4::vector2<unsigned> dst_dims,
+		const std::uint8_t* src,
+		r4::vector2<unsigned> src_dims,
+		unsigned num_channels
+	);
+
+}
+
+}
@@ -1,5 +1,6 @@
 #include <cstring>
 #include <algorithm>
+#include <limits>
 
 #include <png.h>
 
@@ -11,6 +12,8 @@ extern "C"{
 }
 
 #include "raster_image.hpp"
+#include "res_pack.hpp"
+#include "pixel_kernels.hpp"
 
 using namespace morda;
 
@@ -38,10 +41,17 @@ raster_image::raster_image(r4::vector2<unsigned> pos, r4::vector2<unsigned> dime
 
 	this->init(dimensions, src.depth());
 
-	// copy image data
-	throw std::runtime_error("Image::Image(unsigned x, unsigned y, unsigned width, unsigned height, const Image& src): is not implemented");
-	//for(unsigned j=0; j<this->H(); ++j)
-	//    memcpy(data+j*w*channels,src->data+((j+y)*src->w+x)*channels,w*channels);
+	size_t src_stride = size_t(src.dims().x()) * src.num_channels();
+	size_t stride = size_t(this->dims().x()) * this->num_channels();
+
+	pixel_kernels::copy_rows(
+			this->buf_v.data(),
+			stride,
+			src.buf_v.data() + size_t(pos.y()) * src_stride + size_t(pos.x()) * src.num_channels(),
+			src_stride,
+			stride,
+			this->dims().y()
+		);
 }
 
 // fills image buffer with zeroes
@@ -53,9 +63,10 @@ void raster_image::clear(std::uint8_t val){
 }
 
 void raster_image::clear(unsigned chan, std::uint8_t val){
-	for(unsigned i = 0; i < this->dims().x() * this->dims().y(); ++i){
-		this->buf_v[i * this->num_channels() + chan] = val;
+	if(chan >= this->num_channels()){
+		throw std::invalid_argument("raster_image::clear(): channel index is greater than number of channels in the image");
 	}
+	pixel_kernels::fill_channel(this->buf_v.data(), this->num_channels(), chan, val, size_t(this->dims().x()) * this->dims().y());
 }
 
 void raster_image::reset(){
@@ -87,31 +98,25 @@ void raster_image::blit(r4::vector2<unsigned> pos, const raster_image& src){
 		throw std::invalid_argument("Image::Blit(): bits per pixel values do not match");
 	}
 
+	if(pos.x() >= this->dims().x() || pos.y() >= this->dims().y()){
+		return;
+	}
+
 	using std::min;
 
 	auto blit_area = min(src.dims(), this->dims() - pos);
 
-	//TODO: implement blitting for all image types
-	switch(this->depth()){
-		case color_depth::grey:
-			for(unsigned j = 0; j < blit_area.y(); ++j){
-				for(unsigned i = 0; i < blit_area.x(); ++i){
-					this->pix_chan(i + pos.x(), j + pos.y(), 0) = src.pix_chan(i, j, 0);
-				}
-			}
-			break;
-		case color_depth::grey_alpha:
-			for(unsigned j = 0; j < blit_area.y(); ++j){
-				for(unsigned i = 0; i < blit_area.x(); ++i){
-					this->pix_chan(i + pos.x(), j + pos.y(), 0) = src.pix_chan(i, j, 0);
-					this->pix_chan(i + pos.x(), j + pos.y(), 1) = src.pix_chan(i, j, 1);
-				}
-			}
-			break;
-		default:
-			ASSERT_INFO(false, "Image::Blit(): unknown image type")
-			break;
-	}
+	size_t stride = size_t(this->dims().x()) * this->num_channels();
+	size_t src_stride = size_t(src.dims().x()) * src.num_channels();
+
+	pixel_kernels::copy_rows(
+			this->buf_v.data() + size_t(pos.y()) * stride + size_t(pos.x()) * this->num_channels(),
+			stride,
+			src.buf_v.data(),
+			src_stride,
+			size_t(blit_area.x()) * this->num_channels(),
+			blit_area.y()
+		);
 }
 
 void raster_image::blit(r4::vector2<unsigned> pos, const raster_image& src, unsigned dstChan, unsigned srcChan){
@@ -124,15 +129,166 @@ void raster_image::blit(r4::vector2<unsigned> pos, const raster_image& src, unsi
 		throw std::invalid_argument("Image::Blit(): source channel index is greater than number of channels in the image");
 	}
 
+	if(pos.x() >= this->dims().x() || pos.y() >= this->dims().y()){
+		return;
+	}
+
 	using std::min;
 
 	auto blit_area = min(src.dims(), this->dims() - pos);
+	if(blit_area.x() == 0){
+		return;
+	}
 
 	for(unsigned j = 0; j < blit_area.y(); ++j){
-		for(unsigned i = 0; i < blit_area.x(); ++i){
-			this->pix_chan(i + pos.x(), j + pos.y(), dstChan) = src.pix_chan(i, j, srcChan);
+		pixel_kernels::copy_channel(
+				&this->pix_chan(pos.x(), j + pos.y(), 0),
+				this->num_channels(),
+				dstChan,
+				&src.pix_chan(0, j, 0),
+				src.num_channels(),
+				srcChan,
+				blit_area.x()
+			);
+	}
+}
+
+void raster_image::premultiply_alpha(){
+	switch(this->depth()){
+		case color_depth::grey_alpha:
+		case color_depth::rgba:
+			pixel_kernels::premultiply_alpha(this->buf_v.data(), this->num_channels(), size_t(this->dims().x()) * this->dims().y());
+			break;
+		default:
+			// no alpha channel
+			break;
+	}
+}
+
+raster_image raster_image::convert(color_depth to_depth)const{
+	if(to_depth == color_depth::unknown || this->depth() == color_depth::unknown){
+		throw std::invalid_argument("raster_image::convert(): unknown color depth");
+	}
+
+	if(to_depth == this->depth()){
+		return *this;
+	}
+
+	raster_image ret(this->dims(), to_depth);
+
+	size_t num_pixels = size_t(this->dims().x()) * this->dims().y();
+	const std::uint8_t* src = this->buf_v.data();
+	std::uint8_t* dst = ret.buf_v.data();
+
+	if(this->depth() == color_depth::grey && to_depth == color_depth::grey_alpha){
+		pixel_kernels::grey_to_grey_alpha(dst, src, num_pixels, 0xff);
+		return ret;
+	}
+
+	bool src_has_alpha = this->num_channels() % 2 == 0;
+	bool dst_has_alpha = ret.num_channels() % 2 == 0;
+
+	unsigned src_color_channels = src_has_alpha ? this->num_channels() - 1 : this->num_channels();
+	unsigned dst_color_channels = dst_has_alpha ? ret.num_channels() - 1 : ret.num_channels();
+
+	if(src_color_channels == dst_color_channels){
+		for(unsigned k = 0; k != dst_color_channels; ++k){
+			pixel_kernels::copy_channel(dst, ret.num_channels(), k, src, this->num_channels(), k, num_pixels);
 		}
+	}else if(src_color_channels == 1){
+		// grey to RGB
+		for(unsigned k = 0; k != dst_color_channels; ++k){
+			pixel_kernels::copy_channel(dst, ret.num_channels(), k, src, this->num_channels(), 0, num_pixels);
+		}
+	}else{
+		// RGB to grey, using luminance weights
+		ASSERT(dst_color_channels == 1)
+		for(size_t i = 0; i != num_pixels; ++i, src += this->num_channels(), dst += ret.num_channels()){
+			*dst = std::uint8_t((unsigned(src[0]) * 77 + unsigned(src[1]) * 150 + unsigned(src[2]) * 29 + 128) >> 8);
+		}
+		src = this->buf_v.data();
+		dst = ret.buf_v.data();
+	}
+
+	if(dst_has_alpha){
+		unsigned dst_alpha = ret.num_channels() - 1;
+		if(src_has_alpha){
+			pixel_kernels::copy_channel(dst, ret.num_channels(), dst_alpha, src, this->num_channels(), this->num_channels() - 1, num_pixels);
+		}else{
+			pixel_kernels::fill_channel(dst, ret.num_channels(), dst_alpha, 0xff, num_pixels);
+		}
+	}
+
+	return ret;
+}
+
+raster_image raster_image::downscale(r4::vector2<unsigned> dimensions)const{
+	if(dimensions.x() > this->dims().x() || dimensions.y() > this->dims().y()){
+		throw std::invalid_argument("raster_image::downscale(): requested dimensions are greater than image dimensions");
+	}
+
+	if(dimensions.x() == 0 || dimensions.y() == 0){
+		throw std::invalid_argument("raster_image::downscale(): requested dimensions are zero");
+	}
+
+	if(dimensions == this->dims()){
+		return *this;
 	}
+
+	raster_image ret(dimensions, this->depth());
+
+	if(this->dims() / 2 == dimensions && this->dims().x() % 2 == 0 && this->dims().y() % 2 == 0){
+		pixel_kernels::downscale_2x(ret.buf_v.data(), this->buf_v.data(), this->dims(), this->num_channels());
+	}else{
+		pixel_kernels::downscale_box(ret.buf_v.data(), dimensions, this->buf_v.data(), this->dims(), this->num_channels());
+	}
+
+	return ret;
+}
+
+raster_image raster_image::resize_bilinear(r4::vector2<unsigned> dimensions)const{
+	if(this->buf_v.size() == 0){
+		throw std::logic_error("raster_image::resize_bilinear(): image is empty");
+	}
+
+	raster_image ret(dimensions, this->depth());
+	pixel_kernels::resize_bilinear(ret.buf_v.data(), dimensions, this->buf_v.data(), this->dims(), this->num_channels());
+	return ret;
+}
+
+namespace{
+// largest power of 2 reduction of the image dimensions which keeps them not less than requested
+unsigned get_reduction(r4::vector2<unsigned> dims, r4::vector2<unsigned> dims_request, unsigned max_reduction){
+	unsigned ret = 1;
+
+	if(dims_request.x() == 0 && dims_request.y() == 0){
+		return ret;
+	}
+
+	using std::max;
+	max_reduction = std::min(max_reduction, max(dims.x(), dims.y()));
+
+	while(ret < max_reduction){
+		unsigned r = ret * 2;
+		// reduced dimensions are rounded up
+		if((dims.x() + r - 1) / r < dims_request.x() || (dims.y() + r - 1) / r < dims_request.y()){
+			break;
+		}
+		ret = r;
+	}
+
+	return ret;
+}
+
+// libjpeg can decode the image scaled by 1/2, 1/4 or 1/8 with DCT scaling
+const unsigned max_jpeg_reduction = 8;
+
+r4::vector2<unsigned> reduce(r4::vector2<unsigned> dims, unsigned reduction){
+	return r4::vector2<unsigned>(
+			(dims.x() + reduction - 1) / reduction,
+			(dims.y() + reduction - 1) / reduction
+		);
+}
 }
 
 // custom file read function for PNG
@@ -153,7 +309,7 @@ void PNG_CustomReadFunction(png_structp pngPtr, png_bytep data, png_size_t lengt
 }
 
 // read PNG file
-void raster_image::load_png(const papki::file& fi){
+void raster_image::load_png(const papki::file& fi, r4::vector2<unsigned> dims_request){
 	ASSERT(!fi.is_open())
 
 	if(this->buf_v.size() > 0){
@@ -187,12 +343,12 @@ void raster_image::load_png(const papki::file& fi){
 	// create internal PNG-structure to work with PNG file
 	// (no warning and error callbacks)
 	png_structp pngPtr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
-	utki::scope_exit png_scope_exit([&pngPtr](){
-		png_destroy_read_struct(&pngPtr, 0, 0); // free libpng memory
+	png_infop infoPtr = nullptr;
+	utki::scope_exit png_scope_exit([&pngPtr, &infoPtr](){
+		png_destroy_read_struct(&pngPtr, infoPtr ? &infoPtr : 0, 0); // free libpng memory
 	});
 
-	// NOTE: the memory freed by png_destroy_read_struct()
-	png_infop infoPtr = png_create_info_struct(pngPtr);
+	infoPtr = png_create_info_struct(pngPtr);
 	
 	png_set_sig_bytes(pngPtr, png_sig_size); // we've already read png_sig_size bytes
 
@@ -259,6 +415,27 @@ void raster_image::load_png(const papki::file& fi){
 			throw std::runtime_error("Image::LoadPNG(): unknown colorType");
 	}
 
+	r4::vector2<unsigned> full_dims(width, height);
+	auto dims = reduce(full_dims, get_reduction(full_dims, dims_request, std::numeric_limits<unsigned>::max()));
+
+	// non-interlaced image is downscaled while decoding, row by row
+	if(dims != full_dims && png_get_interlace_type(pngPtr, infoPtr) == PNG_INTERLACE_NONE){
+		this->init(dims, imageType);
+
+		png_size_t bytesPerRow = png_get_rowbytes(pngPtr, infoPtr);
+		if(bytesPerRow != full_dims.x() * this->num_channels()){
+			throw std::runtime_error("Image::LoadPNG(): number of bytes per row does not match expected value");
+		}
+
+		std::vector<png_byte> row(bytesPerRow);
+		pixel_kernels::box_downscaler downscaler(dims, full_dims, this->num_channels());
+		for(unsigned y = 0; y != full_dims.y(); ++y){
+			png_read_row(pngPtr, row.data(), nullptr);
+			downscaler.push_row(this->buf_v.data(), row.data());
+		}
+		return;
+	}
+
 	// set image dimensions and set buffer size
 	this->init(r4::vector2<unsigned>(width, height), imageType); // set buf array size (allocate memory)
 
@@ -289,6 +466,13 @@ void raster_image::load_png(const papki::file& fi){
 		png_read_image(pngPtr, &*rows.begin());
 //		TRACE(<< "Image::LoadPNG(): image data read" << std::endl)
 	}
+
+	// interlaced image is decoded at full size and then downscaled
+	if(dims != full_dims){
+		auto im = this->downscale(dims);
+		this->dims_v = im.dims_v;
+		this->buf_v = std::move(im.buf_v);
+	}
 }
 
 namespace{
@@ -365,52 +549,32 @@ void JPEG_SkipInputData(j_decompress_ptr cinfo, long numBytes){
 // (nothing to do in this function in our case)
 void JPEG_TermSource(j_decompress_ptr cinfo){}
 
-}
-
-// read JPEG function
-void raster_image::load_jpg(const papki::file& fi){
-	ASSERT(!fi.is_open())
-
-//	TRACE(<< "Image::LoadJPG(): enter" << std::endl)
-	if(this->buf_v.size()){
-		this->reset();
-	}
-	
-	papki::file::guard file_guard(fi);
-//	TRACE(<< "Image::LoadJPG(): file opened" << std::endl)
-
-	jpeg_decompress_struct cinfo; // decompression object
-	jpeg_error_mgr jerr;
-
-	cinfo.err = jpeg_std_error(&jerr);
-
-	jpeg_create_decompress(&cinfo); // creat decompress object
-
+void set_jpeg_source(j_decompress_ptr cinfo, const papki::file& fi){
 	DataManagerJPEGSource* src = 0;
 
 	// check if memory for JPEG-decompressor manager is allocated,
 	// it is possible that several libraries accessing the source
-	if(cinfo.src == 0){
+	if(cinfo->src == 0){
 		// Allocate memory for our manager and set a pointer of global library
 		// structure to it. We use JPEG library memory manager, this means that
 		// the library will take care of memory freeing for us.
 		// JPOOL_PERMANENT means that the memory is allocated for a whole
 		// time  of working with the library.
-		cinfo.src = reinterpret_cast<jpeg_source_mgr*>(
-				(cinfo.mem->alloc_small)(
-						j_common_ptr(&cinfo),
+		cinfo->src = reinterpret_cast<jpeg_source_mgr*>(
+				(cinfo->mem->alloc_small)(
+						j_common_ptr(cinfo),
 						JPOOL_PERMANENT,
 						sizeof(DataManagerJPEGSource)
 					)
 			);
-		src = reinterpret_cast<DataManagerJPEGSource*>(cinfo.src);
+		src = reinterpret_cast<DataManagerJPEGSource*>(cinfo->src);
 		if(!src){
 			throw std::bad_alloc();
 		}
 		// allocate memory for read data
 		src->buffer = reinterpret_cast<JOCTET*>(
-				(cinfo.mem->alloc_small)(
-						j_common_ptr(&cinfo),
+				(cinfo->mem->alloc_small)(
+						j_common_ptr(cinfo),
 						JPOOL_PERMANENT,
 						DJpegInputBufferSize * sizeof(JOCTET)
 					)
@@ -422,7 +586,7 @@ void raster_image::load_jpg(const papki::file& fi){
 
 		memset(src->buffer, 0, DJpegInputBufferSize * sizeof(JOCTET));
 	}else{
-		src = reinterpret_cast<DataManagerJPEGSource*>(cinfo.src);
+		src = reinterpret_cast<DataManagerJPEGSource*>(cinfo->src);
 	}
 
 	// set handler functions
@@ -436,9 +600,36 @@ void raster_image::load_jpg(const papki::file& fi){
 	// set pointers to the buffers
 	src->pub.bytes_in_buffer = 0; // forces fill_input_buffer on first read
 	src->pub.next_input_byte = 0; // until buffer loaded
+}
+
+}
+
+// read JPEG function
+void raster_image::load_jpg(const papki::file& fi, r4::vector2<unsigned> dims_request){
+	ASSERT(!fi.is_open())
+
+//	TRACE(<< "Image::LoadJPG(): enter" << std::endl)
+	if(this->buf_v.size()){
+		this->reset();
+	}
+	
+	papki::file::guard file_guard(fi);
+//	TRACE(<< "Image::LoadJPG(): file opened" << std::endl)
+
+	jpeg_decompress_struct cinfo; // decompression object
+	jpeg_error_mgr jerr;
+
+	cinfo.err = jpeg_std_error(&jerr);
+
+	jpeg_create_decompress(&cinfo); // creat decompress object
+
+	set_jpeg_source(&cinfo, fi);
 
 	jpeg_read_header(&cinfo, TRUE); // read parametrs of a JPEG file
 
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = get_reduction(r4::vector2<unsigned>(cinfo.image_width, cinfo.image_height), dims_request, max_jpeg_reduction);
+
 	jpeg_start_decompress(&cinfo); // start decompression
 
 	raster_image::color_depth imageType;
@@ -490,16 +681,98 @@ void raster_image::load_jpg(const papki::file& fi){
 	jpeg_destroy_decompress(&cinfo); // clean decompression object
 }
 
-void raster_image::load(const papki::file& fi){
+void raster_image::load(const papki::file& fi, r4::vector2<unsigned> dims_request){
+	{
+		res_pack::pre_decoded_image im;
+		if(res_pack::get_pre_decoded_image(fi, im)){
+			auto dims = reduce(im.dims, get_reduction(im.dims, dims_request, std::numeric_limits<unsigned>::max()));
+			this->init(dims, color_depth(im.num_channels));
+			if(dims == im.dims){
+				ASSERT(this->buf_v.size() == im.pixels.size())
+				memcpy(this->buf_v.data(), im.pixels.data(), im.pixels.size());
+			}else{
+				pixel_kernels::downscale_box(this->buf_v.data(), dims, im.pixels.data(), im.dims, im.num_channels);
+			}
+			return;
+		}
+	}
+
 	std::string ext = fi.suffix();
 
 	if(ext == "png"){
 //		TRACE(<< "Image::Load(): loading PNG image" << std::endl)
-		this->load_png(fi);
+		this->load_png(fi, dims_request);
 	}else if(ext == "jpg"){
 //		TRACE(<< "Image::Load(): loading JPG image" << std::endl)
-		this->load_jpg(fi);
+		this->load_jpg(fi, dims_request);
 	}else{
 		throw std::invalid_argument("Image::Load(): unknown image format");
 	}
 }
+
+r4::vector2<unsigned> raster_image::read_dims(const papki::file& fi){
+	{
+		res_pack::pre_decoded_image im;
+		if(res_pack::get_pre_decoded_image(fi, im)){
+			return im.dims;
+		}
+	}
+
+	std::string ext = fi.suffix();
+
+	if(ext == "png"){
+		// PNG signature is followed by IHDR chunk: 4 bytes of length, 4 bytes of chunk type, 4 bytes of width, 4 bytes of height
+		std::array<std::uint8_t, 24> header;
+
+		papki::file::guard file_guard(fi);
+		if(fi.read(utki::make_span(header)) != header.size()){
+			throw std::invalid_argument("raster_image::read_dims(): could not read PNG header");
+		}
+
+		if(png_sig_cmp(header.data(), 0, 8) != 0 || memcmp(&header[12], "IHDR", 4) != 0){
+			throw std::invalid_argument("raster_image::read_dims(): not a PNG file");
+		}
+
+		auto read_u32_be = [](const std::uint8_t* p){
+			return (unsigned(p[0]) << 24) | (unsigned(p[1]) << 16) | (unsigned(p[2]) << 8) | unsigned(p[3]);
+		};
+
+		return r4::vector2<unsigned>(read_u32_be(&header[16]), read_u32_be(&header[20]));
+	}else if(ext == "jpg"){
+		papki::file::guard file_guard(fi);
+
+		jpeg_decompress_struct cinfo;
+		jpeg_error_mgr jerr;
+
+		cinfo.err = jpeg_std_error(&jerr);
+
+		jpeg_create_decompress(&cinfo);
+		utki::scope_exit jpeg_scope_exit([&cinfo](){
+			jpeg_destroy_decompress(&cinfo);
+		});
+
+		set_jpeg_source(&cinfo, fi);
+
+		jpeg_read_header(&cinfo, TRUE);
+
+		return r4::vector2<unsigned>(cinfo.image_width, cinfo.image_height);
+	}
+
+	throw std::invalid_argument("raster_image::read_dims(): unknown image format");
+}
+
+r4::vector2<unsigned> raster_image::get_decoded_dims(const papki::file& fi, r4::vector2<unsigned> dims, r4::vector2<unsigned> dims_request){
+	unsigned max_reduction = std::numeric_limits<unsigned>::max();
+
+	if(fi.suffix() == "jpg"){
+		max_reduction = max_jpeg_reduction;
+
+		// pre-decoded images are downscaled with box filter
+		res_pack::pre_decoded_image im;
+		if(res_pack::get_pre_decoded_image(fi, im)){
+			max_reduction = std::numeric_limits<unsigned>::max();
+		}
+	}
+
+	return reduce(dims, get_reduction(dims, dims_request, max_reduction));
+}
@@ -39,6 +39,10 @@ public:
 	{}
 
 	raster_image(const raster_image& im) = default;
+	raster_image(raster_image&& im) = default;
+
+	raster_image& operator=(const raster_image& im) = default;
+	raster_image& operator=(raster_image&& im) = default;
 
 	/**
 	 * @brief Constructor.
@@ -77,6 +81,16 @@ public:
 		this->load(f);
 	}
 
+	/**
+	 * @brief Constructor.
+	 * Creates an image by loading it from file decoded to the requested dimensions, see load() for details.
+	 * @param f - file to load image from.
+	 * @param dims_request - dimensions to decode the image to.
+	 */
+	raster_image(const papki::file& f, r4::vector2<unsigned> dims_request){
+		this->load(f, dims_request);
+	}
+
 	/**
 	 * @brief Get image dimensions.
 	 * @return Image dimensions.
@@ -178,6 +192,36 @@ public:
 	 */
 	void blit(r4::vector2<unsigned> pos, const raster_image& src, unsigned dstChan, unsigned srcChan);
 
+	/**
+	 * @brief Multiply color channels by alpha.
+	 * Converts the image to premultiplied alpha format.
+	 * Images without alpha channel are left unchanged.
+	 */
+	void premultiply_alpha();
+
+	/**
+	 * @brief Convert image to another color depth.
+	 * Missing alpha channel is filled with 0xff. Color is converted to grey using luminance weights.
+	 * @param to_depth - color depth to convert to.
+	 * @return converted image.
+	 */
+	raster_image convert(color_depth to_depth)const;
+
+	/**
+	 * @brief Downscale image with box filter.
+	 * @param dimensions - dimensions of the resulting image, must not be greater than this image dimensions.
+	 * @return downscaled image.
+	 */
+	raster_image downscale(r4::vector2<unsigned> dimensions)const;
+
+	/**
+	 * @brief Resize image with bilinear filter.
+	 * For downscaling more than twice use downscale(), it takes all source pixels into account.
+	 * @param dimensions - dimensions of the resulting image.
+	 * @return resized image.
+	 */
+	raster_image resize_bilinear(r4::vector2<unsigned> dimensions)const;
+
 	/**
 	 * @brief Get reference to specific channel for given pixel.
 	 * @param x - X pixel location.
@@ -206,22 +250,51 @@ public:
 
 	/**
 	 * @brief Load image from PNG file.
+	 * In case the dimensions are requested, the image is downscaled with box filter while the rows are decoded,
+	 * so that the full size image is not held in memory (except for interlaced PNG files).
 	 * @param f - PNG file.
+	 * @param dims_request - dimensions to decode the image to, see load() for details.
 	 */
-	void load_png(const papki::file& f);
+	void load_png(const papki::file& f, r4::vector2<unsigned> dims_request = r4::vector2<unsigned>(0));
 
 	/**
 	 * @brief Load image from JPG file.
+	 * In case the dimensions are requested, the image is decoded at reduced size with DCT scaling,
+	 * the reduction is limited to 1/8.
 	 * @param f - JPG file.
+	 * @param dims_request - dimensions to decode the image to, see load() for details.
 	 */
-	void load_jpg(const papki::file& f);
+	void load_jpg(const papki::file& f, r4::vector2<unsigned> dims_request = r4::vector2<unsigned>(0));
 
 	/**
 	 * @brief Load image from file.
 	 * It will try to determine the file type from file name.
+	 * Pre-decoded images from resource pack archive are also supported, see res_pack.
+	 * The image can be decoded at reduced size: the image dimensions are divided by the largest power of 2,
+	 * rounded up, which keeps them not less than the requested dimensions. The aspect ratio is preserved.
 	 * @param f - file to load image from.
+	 * @param dims_request - dimensions to decode the image to. Zero component means the dimension is not constrained.
+	 *                       Zero dimensions mean decoding the image at full size.
+	 */
+	void load(const papki::file& f, r4::vector2<unsigned> dims_request = r4::vector2<unsigned>(0));
+
+	/**
+	 * @brief Read image dimensions.
+	 * Only the image header is read, the image is not decoded.
+	 * Supports same image formats as load().
+	 * @param f - file to read the image dimensions from.
+	 * @return full size dimensions of the image.
+	 */
+	static r4::vector2<unsigned> read_dims(const papki::file& f);
+
+	/**
+	 * @brief Get dimensions to which the image is decoded.
+	 * @param f - image file.
+	 * @param dims - full size dimensions of the image, see read_dims().
+	 * @param dims_request - requested dimensions, see load() for details.
+	 * @return dimensions to which load() decodes the image for the requested dimensions.
 	 */
-	void load(const papki::file& f);
+	static r4::vector2<unsigned> get_decoded_dims(const papki::file& f, r4::vector2<unsigned> dims, r4::vector2<unsigned> dims_request);
 };
 
 
@@ -0,0 +1,396 @@
+#include "res_pack.hpp"
+
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+#include <papki/fs_file.hpp>
+#include <papki/util.hpp>
+
+#include "raster_image.hpp"
+
+using namespace morda;
+
+namespace{
+const char archive_magic[] = "MORDARP1";
+const size_t archive_magic_size = sizeof(archive_magic) - 1;
+
+const char image_magic[] = "MRI1";
+const size_t image_magic_size = sizeof(image_magic) - 1;
+const size_t image_header_size = image_magic_size + 3 * 4;
+
+const size_t data_alignment = 16;
+
+// index entry is the path length, the path, the data offset and the data size
+const size_t min_index_entry_size = 4 + 8 + 8;
+
+std::uint32_t read_u32(const std::uint8_t* p)noexcept{
+	return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+std::uint64_t read_u64(const std::uint8_t* p)noexcept{
+	return std::uint64_t(read_u32(p)) | (std::uint64_t(read_u32(p + 4)) << 32);
+}
+
+void append_u32(std::vector<std::uint8_t>& v, std::uint32_t n){
+	for(unsigned i = 0; i != 4; ++i){
+		v.push_back(std::uint8_t(n >> (i * 8)));
+	}
+}
+
+void append_u64(std::vector<std::uint8_t>& v, std::uint64_t n){
+	append_u32(v, std::uint32_t(n));
+	append_u32(v, std::uint32_t(n >> 32));
+}
+
+bool starts_with(std::string_view str, std::string_view prefix)noexcept{
+	return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+}
+
+res_pack::res_pack(const std::string& path) :
+		mapping(std::make_unique<mapped_file>(path))
+{
+	this->parse_index(this->mapping->data());
+}
+
+res_pack::res_pack(std::vector<std::uint8_t>&& data) :
+		buffer(std::move(data))
+{
+	this->parse_index(utki::make_span(this->buffer));
+}
+
+std::shared_ptr<res_pack> res_pack::load(const papki::file& fi){
+	// file system files are mapped by their path
+	if(dynamic_cast<const papki::fs_file*>(&fi)){
+		return std::make_shared<res_pack>(fi.path());
+	}
+	return std::make_shared<res_pack>(fi.load());
+}
+
+void res_pack::parse_index(utki::span<const std::uint8_t> archive){
+	auto p = archive.data();
+	size_t size = archive.size();
+
+	if(size < archive_magic_size + 4 || std::memcmp(p, archive_magic, archive_magic_size) != 0){
+		throw std::runtime_error("res_pack::parse_index(): not a resource pack archive");
+	}
+
+	size_t pos = archive_magic_size;
+
+	std::uint32_t num_entries = read_u32(p + pos);
+	pos += 4;
+
+	// check the number of entries before reserving memory for those, so that a corrupted archive
+	// does not cause a huge allocation
+	if(num_entries > (size - pos) / min_index_entry_size){
+		throw std::runtime_error("res_pack::parse_index(): archive index is corrupted");
+	}
+
+	this->index.reserve(num_entries);
+
+	for(std::uint32_t i = 0; i != num_entries; ++i){
+		if(size - pos < 4){
+			throw std::runtime_error("res_pack::parse_index(): archive index is corrupted");
+		}
+		std::uint32_t path_len = read_u32(p + pos);
+		pos += 4;
+
+		if(size - pos < size_t(path_len) + 16){
+			throw std::runtime_error("res_pack::parse_index(): archive index is corrupted");
+		}
+		std::string_view path(reinterpret_cast<const char*>(p + pos), path_len);
+		pos += path_len;
+
+		std::uint64_t offset = read_u64(p + pos);
+		pos += 8;
+		std::uint64_t data_size = read_u64(p + pos);
+		pos += 8;
+
+		if(offset > size || data_size > size - offset){
+			throw std::runtime_error("res_pack::parse_index(): file data is out of archive bounds");
+		}
+
+		this->index.push_back(entry{path, utki::make_span(p + offset, size_t(data_size))});
+	}
+
+	auto less = [](const entry& a, const entry& b){
+		return a.path < b.path;
+	};
+
+	if(!std::is_sorted(this->index.begin(), this->index.end(), less)){
+		std::sort(this->index.begin(), this->index.end(), less);
+	}
+}
+
+const res_pack::entry* res_pack::find_entry(std::string_view path)const noexcept{
+	auto i = std::lower_bound(
+			this->index.begin(),
+			this->index.end(),
+			path,
+			[](const entry& e, std::string_view p){
+				return e.path < p;
+			}
+		);
+	if(i == this->index.end() || i->path != path){
+		return nullptr;
+	}
+	return &*i;
+}
+
+bool res_pack::has_dir(std::string_view dir)const noexcept{
+	auto i = std::lower_bound(
+			this->index.begin(),
+			this->index.end(),
+			dir,
+			[](const entry& e, std::string_view p){
+				return e.path < p;
+			}
+		);
+	return i != this->index.end() && starts_with(i->path, dir);
+}
+
+std::vector<std::string> res_pack::list_dir(std::string_view dir)const{
+	std::vector<std::string> ret;
+
+	// entries of the directory go one after another in the sorted index
+	auto i = std::lower_bound(
+			this->index.begin(),
+			this->index.end(),
+			dir,
+			[](const entry& e, std::string_view p){
+				return e.path < p;
+			}
+		);
+	for(; i != this->index.end() && starts_with(i->path, dir); ++i){
+		auto rest = i->path.substr(dir.size());
+
+		auto slash = rest.find('/');
+		if(slash != std::string_view::npos){
+			// subdirectory
+			rest = rest.substr(0, slash + 1);
+		}
+
+		if(ret.empty() || ret.back() != rest){
+			ret.emplace_back(rest);
+		}
+	}
+
+	return ret;
+}
+
+bool res_pack::parse_pre_decoded_image(utki::span<const std::uint8_t> data, pre_decoded_image& out_image)noexcept{
+	if(data.size() < image_header_size || std::memcmp(data.data(), image_magic, image_magic_size) != 0){
+		return false;
+	}
+
+	auto p = data.data() + image_magic_size;
+
+	r4::vector2<unsigned> dims(read_u32(p), read_u32(p + 4));
+	unsigned num_channels = read_u32(p + 8);
+
+	if(num_channels == 0 || num_channels > 4 || dims.x() == 0 || dims.y() == 0){
+		return false;
+	}
+
+	// the header comes from the file, so check that the pixels fit into the data without calculating
+	// the pixels size first, as it can overflow
+	size_t payload_size = data.size() - image_header_size;
+	if(size_t(dims.x()) > payload_size / num_channels / dims.y()){
+		return false;
+	}
+
+	size_t pixels_size = size_t(dims.x()) * size_t(dims.y()) * num_channels;
+
+	out_image.dims = dims;
+	out_image.num_channels = num_channels;
+	out_image.pixels = utki::make_span(data.data() + image_header_size, pixels_size);
+	return true;
+}
+
+bool res_pack::get_pre_decoded_image(const papki::file& fi, pre_decoded_image& out_image){
+	auto rf = dynamic_cast<const res_pack::file*>(&fi);
+	if(!rf){
+		return false;
+	}
+
+	auto suffix = fi.suffix();
+	if(suffix != "png" && suffix != "jpg"){
+		return false;
+	}
+
+	return parse_pre_decoded_image(rf->data(), out_image);
+}
+
+namespace{
+void collect_files(const papki::file& fi, const std::string& root, const std::string& dir, std::vector<std::string>& files){
+	fi.set_path(root + dir);
+	for(auto& f : fi.list_dir()){
+		if(papki::is_dir(f)){
+			collect_files(fi, root, dir + f, files);
+		}else{
+			files.push_back(dir + f);
+		}
+	}
+}
+
+std::vector<std::uint8_t> load_file_data(const papki::file& fi, bool pre_decode_images){
+	if(pre_decode_images){
+		auto suffix = fi.suffix();
+		if(suffix == "png" || suffix == "jpg"){
+			raster_image im(fi);
+
+			std::vector<std::uint8_t> ret(image_magic, image_magic + image_magic_size);
+			append_u32(ret, im.dims().x());
+			append_u32(ret, im.dims().y());
+			append_u32(ret, im.num_channels());
+			ASSERT(ret.size() == image_header_size)
+			ret.insert(ret.end(), im.pixels().begin(), im.pixels().end());
+			return ret;
+		}
+	}
+	return fi.load();
+}
+}
+
+void res_pack::write(const papki::file& src_dir, const papki::file& dst, bool pre_decode_images){
+	std::string root = src_dir.path();
+
+	std::vector<std::string> files;
+	collect_files(src_dir, root, std::string(), files);
+
+	std::sort(files.begin(), files.end());
+
+	size_t index_size = archive_magic_size + 4;
+	for(auto& f : files){
+		index_size += 4 + f.size() + 16;
+	}
+
+	// load all files to know their sizes
+	std::vector<std::vector<std::uint8_t>> datas;
+	datas.reserve(files.size());
+	for(auto& f : files){
+		src_dir.set_path(root + f);
+		datas.push_back(load_file_data(src_dir, pre_decode_images));
+	}
+
+	src_dir.set_path(root);
+
+	auto align = [](size_t offset){
+		return (offset + data_alignment - 1) / data_alignment * data_alignment;
+	};
+
+	std::vector<std::uint8_t> header(archive_magic, archive_magic + archive_magic_size);
+	append_u32(header, std::uint32_t(files.size()));
+
+	size_t offset = align(index_size);
+	for(size_t i = 0; i != files.size(); ++i){
+		auto& f = files[i];
+		append_u32(header, std::uint32_t(f.size()));
+		header.insert(header.end(), f.begin(), f.end());
+		append_u64(header, offset);
+		append_u64(header, datas[i].size());
+		offset = align(offset + datas[i].size());
+	}
+	ASSERT(header.size() == index_size)
+
+	papki::file::guard file_guard(dst, papki::file::mode::create);
+
+	const std::array<std::uint8_t, data_alignment> padding = {{0}};
+
+	dst.write(utki::make_span(header));
+	offset = header.size();
+
+	for(auto& d : datas){
+		size_t aligned = align(offset);
+		dst.write(utki::make_span(padding.data(), aligned - offset));
+		dst.write(utki::make_span(d));
+		offset = aligned + d.size();
+	}
+}
+
+res_pack::file::file(std::shared_ptr<const res_pack> pack, std::string root_dir, const std::string& path) :
+		papki::file(path),
+		pack(std::move(pack)),
+		root_dir(std::move(root_dir))
+{
+	if(!this->pack){
+		throw std::invalid_argument("res_pack::file::file(): pack is null");
+	}
+}
+
+void res_pack::file::open_internal(mode io_mode){
+	if(io_mode != mode::read){
+		throw std::invalid_argument("res_pack::file::open(): only read mode is supported");
+	}
+
+	this->opened_data = this->data();
+	this->cur_pos = 0;
+}
+
+void res_pack::file::close_internal()const noexcept{
+	this->opened_data = utki::span<const std::uint8_t>();
+	this->cur_pos = 0;
+}
+
+size_t res_pack::file::read_internal(utki::span<std::uint8_t> buf)const{
+	ASSERT(this->cur_pos <= this->opened_data.size())
+	size_t num_to_read = std::min(buf.size(), this->opened_data.size() - this->cur_pos);
+	std::memcpy(buf.data(), this->opened_data.data() + this->cur_pos, num_to_read);
+	this->cur_pos += num_to_read;
+	return num_to_read;
+}
+
+size_t res_pack::file::seek_forward_internal(size_t num_bytes_to_seek)const{
+	ASSERT(this->cur_pos <= this->opened_data.size())
+	size_t n = std::min(num_bytes_to_seek, this->opened_data.size() - this->cur_pos);
+	this->cur_pos += n;
+	return n;
+}
+
+size_t res_pack::file::seek_backward_internal(size_t num_bytes_to_seek)const{
+	size_t n = std::min(num_bytes_to_seek, this->cur_pos);
+	this->cur_pos -= n;
+	return n;
+}
+
+void res_pack::file::rewind_internal()const{
+	this->cur_pos = 0;
+}
+
+bool res_pack::file::exists()const{
+	auto p = this->full_path();
+	if(p.empty() || p.back() == '/'){
+		return this->pack->has_dir(p);
+	}
+	return this->pack->find(p) != nullptr;
+}
+
+std::vector<std::string> res_pack::file::list_dir(size_t max_entries)const{
+	auto p = this->full_path();
+	if(!p.empty() && p.back() != '/'){
+		throw std::logic_error("res_pack::file::list_dir(): this is not a directory");
+	}
+
+	auto ret = this->pack->list_dir(p);
+	if(max_entries != 0 && ret.size() > max_entries){
+		ret.resize(max_entries);
+	}
+	return ret;
+}
+
+std::unique_ptr<papki::file> res_pack::file::spawn(){
+	return std::make_unique<file>(this->pack, this->root_dir);
+}
+
+utki::span<const std::uint8_t> res_pack::file::data()const{
+	auto p = this->full_path();
+	auto d = this->pack->find(p);
+	if(!d){
+		throw std::runtime_error("res_pack::file::data(): file not found in resource pack: " + p);
+	}
+	return *d;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <utki/span.hpp>
+
+#include <r4/vector.hpp>
+
+#include <papki/file.hpp>
+
+#include "mapped_file.hpp"
+
+namespace morda{
+
+/**
+ * @brief Resource pack archive.
+ * Resource pack archive is a single file containing all files of a resource pack directory.
+ * The archive is memory mapped when possible, so the files are accessed directly from the mapped pages,
+ * without opening separate files and without copying.
+ *
+ * Archive format, all numbers are little-endian:
+ * - 8 bytes: magic "MORDARP1".
+ * - 4 bytes: number of entries.
+ * - index of entries, sorted by path, each entry is:
+ *   - 4 bytes: path length in bytes.
+ *   - path, '/' separated, relative to the resource pack root directory, no terminating zero.
+ *   - 8 bytes: offset of the file data from the beginning of the archive.
+ *   - 8 bytes: size of the file data.
+ * - file data, each file data is aligned to 16 bytes.
+ *
+ * PNG and JPG images can be stored pre-decoded, then those are uploaded to textures right from the
+ * mapped memory. Pre-decoded image format:
+ * - 4 bytes: magic "MRI1".
+ * - 4 bytes: width.
+ * - 4 bytes: height.
+ * - 4 bytes: number of channels.
+ * - pixels, rows are tightly packed.
+ *
+ * To mount the resource pack archive, pass a file with 'respack' suffix to resource_loader::mount_res_pack().
+ */
+class res_pack{
+	std::unique_ptr<mapped_file> mapping;
+
+	// in case the archive could not be memory mapped, it is loaded to memory
+	std::vector<std::uint8_t> buffer;
+
+	struct entry{
+		std::string_view path;
+		utki::span<const std::uint8_t> data;
+	};
+
+	// sorted by path
+	std::vector<entry> index;
+
+	void parse_index(utki::span<const std::uint8_t> archive);
+
+	const entry* find_entry(std::string_view path)const noexcept;
+
+public:
+	/**
+	 * @brief Open memory mapped archive.
+	 * @param path - path to the archive file in the file system.
+	 */
+	res_pack(const std::string& path);
+
+	/**
+	 * @brief Create archive from memory buffer.
+	 * @param data - archive data.
+	 */
+	res_pack(std::vector<std::uint8_t>&& data);
+
+	res_pack(const res_pack&) = delete;
+	res_pack& operator=(const res_pack&) = delete;
+
+	/**
+	 * @brief Load archive.
+	 * In case the file is a file system file, then the archive is memory mapped.
+	 * Otherwise, it is loaded into memory.
+	 * @param fi - archive file.
+	 * @return loaded archive.
+	 */
+	static std::shared_ptr<res_pack> load(const papki::file& fi);
+
+	/**
+	 * @brief Find file in the archive.
+	 * @param path - path of the file within the archive.
+	 * @return pointer to the file data span.
+	 * @return nullptr in case there is no such file in the archive.
+	 */
+	const utki::span<const std::uint8_t>* find(std::string_view path)const noexcept{
+		auto e = this->find_entry(path);
+		if(!e){
+			return nullptr;
+		}
+		return &e->data;
+	}
+
+	/**
+	 * @brief Check if directory exists in the archive.
+	 * @param dir - directory path, with trailing '/'.
+	 * @return true in case there is at least one file in the directory or its subdirectories.
+	 * @return false otherwise.
+	 */
+	bool has_dir(std::string_view dir)const noexcept;
+
+	/**
+	 * @brief List directory contents.
+	 * @param dir - directory path, with trailing '/'. Empty string means root directory.
+	 * @return list of files and subdirectories of the directory, subdirectory names have trailing '/'.
+	 */
+	std::vector<std::string> list_dir(std::string_view dir)const;
+
+	/**
+	 * @brief Create archive.
+	 * Writes all files of the directory and its subdirectories to the archive.
+	 * @param src_dir - directory to pack, path must have trailing '/'.
+	 * @param dst - file to write the archive to.
+	 * @param pre_decode_images - whether to store PNG and JPG images pre-decoded.
+	 */
+	static void write(const papki::file& src_dir, const papki::file& dst, bool pre_decode_images = false);
+
+	/**
+	 * @brief Pre-decoded image.
+	 */
+	struct pre_decoded_image{
+		r4::vector2<unsigned> dims;
+		unsigned num_channels;
+		utki::span<const std::uint8_t> pixels;
+	};
+
+	/**
+	 * @brief Parse pre-decoded image.
+	 * @param data - file data.
+	 * @param out_image - pre-decoded image to fill, the pixels span points into the given file data.
+	 * @return true in case the file data is a pre-decoded image.
+	 * @return false otherwise, also in case the image dimensions are zero or the pixels do not fit into the data.
+	 */
+	static bool parse_pre_decoded_image(utki::span<const std::uint8_t> data, pre_decoded_image& out_image)noexcept;
+
+	/**
+	 * @brief Get pre-decoded image from resource pack file.
+	 * Images are only stored pre-decoded in place of PNG and JPG files, so files with other suffixes are not parsed.
+	 * @param fi - file.
+	 * @param out_image - pre-decoded image to fill, the pixels span points into the mapped archive.
+	 * @return true in case the file is a pre-decoded image from resource pack archive.
+	 * @return false otherwise.
+	 */
+	static bool get_pre_decoded_image(const papki::file& fi, pre_decoded_image& out_image);
+
+	class file;
+};
+
+/**
+ * @brief File interface to a file within resource pack archive.
+ */
+class res_pack::file : public papki::file{
+	std::shared_ptr<const res_pack> pack;
+
+	// directory within the archive, all paths are relative to it
+	std::string root_dir;
+
+	mutable utki::span<const std::uint8_t> opened_data;
+	mutable size_t cur_pos = 0;
+
+	std::string full_path()const{
+		return this->root_dir + this->path();
+	}
+
+protected:
+	void open_internal(mode io_mode)override;
+
+	void close_internal()const noexcept override;
+
+	size_t read_internal(utki::span<std::uint8_t> buf)const override;
+
+	size_t seek_forward_internal(size_t num_bytes_to_seek)const override;
+
+	size_t seek_backward_internal(size_t num_bytes_to_seek)const override;
+
+	void rewind_internal()const override;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param pack - resource pack archive.
+	 * @param root_dir - directory within the archive which is treated as root directory, with trailing '/'.
+	 * @param path - path of the file relative to the root directory.
+	 */
+	file(std::shared_ptr<const res_pack> pack, std::string root_dir = std::string(), const std::string& path = std::string());
+
+	bool exists()const override;
+
+	std::vector<std::string> list_dir(size_t max_entries = 0)const override;
+
+	std::unique_ptr<papki::file> spawn()override;
+
+	/**
+	 * @brief Get file contents without copying.
+	 * The returned data stays valid as long as the archive object is alive.
+	 * @return file contents.
+	 * @throw std::runtime_error - in case there is no such file in the archive.
+	 */
+	utki::span<const std::uint8_t> data()const;
+
+	/**
+	 * @brief Get the archive this file belongs to.
+	 * @return the archive.
+	 */
+	const std::shared_ptr<const res_pack>& get_pack()const noexcept{
+		return this->pack;
+	}
+
+	/**
+	 * @brief Get root directory of this file interface within the archive.
+	 * @return root directory.
+	 */
+	const std::string& get_root_dir()const noexcept{
+		return this->root_dir;
+	}
+};
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace morda{
+
+/**
+ * @brief Set of values with inline storage for few elements.
+ * Up to N elements are stored inside of the object itself, so no heap allocation is done.
+ * When more than N elements are inserted, all elements are moved to a heap allocated buffer.
+ * Lookup is linear, so the class is only intended for sets which normally contain just a few elements.
+ * Order of iteration is the order of insertion.
+ */
+template <class T, size_t N> class small_set{
+	static_assert(N != 0, "small_set: inline capacity must be non-zero");
+
+	std::array<T, N> inline_buffer;
+	unsigned num_inline = 0;
+
+	// in case this pointer is set, all the elements are stored in the heap buffer
+	std::unique_ptr<std::vector<T>> heap_buffer;
+
+public:
+	typedef const T* const_iterator;
+
+	small_set() = default;
+
+	small_set(const small_set&) = delete;
+	small_set& operator=(const small_set&) = delete;
+
+	small_set(small_set&& s) :
+			inline_buffer(s.inline_buffer),
+			num_inline(s.num_inline),
+			heap_buffer(std::move(s.heap_buffer))
+	{
+		s.num_inline = 0;
+	}
+
+	small_set& operator=(small_set&& s){
+		this->inline_buffer = s.inline_buffer;
+		this->num_inline = s.num_inline;
+		this->heap_buffer = std::move(s.heap_buffer);
+		s.num_inline = 0;
+		return *this;
+	}
+
+	const_iterator begin()const noexcept{
+		if(this->heap_buffer){
+			return this->heap_buffer->data();
+		}
+		return this->inline_buffer.data();
+	}
+
+	const_iterator end()const noexcept{
+		return this->begin() + this->size();
+	}
+
+	size_t size()const noexcept{
+		if(this->heap_buffer){
+			return this->heap_buffer->size();
+		}
+		return this->num_inline;
+	}
+
+	bool empty()const noexcept{
+		return this->size() == 0;
+	}
+
+	/**
+	 * @brief Get number of bytes allocated on heap.
+	 * @return number of bytes allocated on heap by this set.
+	 */
+	size_t heap_size()const noexcept{
+		if(this->heap_buffer){
+			return sizeof(*this->heap_buffer) + this->heap_buffer->capacity() * sizeof(T);
+		}
+		return 0;
+	}
+
+	const_iterator find(const T& v)const noexcept{
+		return std::find(this->begin(), this->end(), v);
+	}
+
+	bool contains(const T& v)const noexcept{
+		return this->find(v) != this->end();
+	}
+
+	/**
+	 * @brief Insert element.
+	 * @param v - value to insert.
+	 * @return true if the value was inserted.
+	 * @return false if the value was already in the set.
+	 */
+	bool insert(const T& v){
+		if(this->contains(v)){
+			return false;
+		}
+
+		if(this->heap_buffer){
+			this->heap_buffer->push_back(v);
+			return true;
+		}
+
+		if(this->num_inline != N){
+			this->inline_buffer[this->num_inline] = v;
+			++this->num_inline;
+			return true;
+		}
+
+		auto hb = std::make_unique<std::vector<T>>(this->inline_buffer.begin(), this->inline_buffer.end());
+		hb->push_back(v);
+		this->heap_buffer = std::move(hb);
+		this->num_inline = 0;
+		return true;
+	}
+
+	/**
+	 * @brief Erase element.
+	 * @param v - value to erase.
+	 * @return true if the value was erased.
+	 * @return false if the value was not in the set.
+	 */
+	bool erase(const T& v)noexcept{
+		auto i = this->find(v);
+		if(i == this->end()){
+			return false;
+		}
+
+		if(this->heap_buffer){
+			this->heap_buffer->erase(std::next(this->heap_buffer->begin(), std::distance(this->begin(), i)));
+			return true;
+		}
+
+		auto j = std::next(this->inline_buffer.begin(), std::distance(this->begin(), i));
+		std::move(std::next(j), std::next(this->inline_buffer.begin(), this->num_inline), j);
+		--this->num_inline;
+		return true;
+	}
+
+	void clear()noexcept{
+		this->heap_buffer.reset();
+		this->num_inline = 0;
+	}
+};
+
+}
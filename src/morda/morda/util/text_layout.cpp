@@ -0,0 +1,406 @@
+#include "text_layout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+using namespace morda;
+
+namespace{
+bool is_space(char32_t c)noexcept{
+	return c == U' ' || c == U'\t';
+}
+}
+
+text_layout::text_layout(){
+	this->set_text(std::u32string());
+}
+
+void text_layout::set_font(const morda::font& f){
+	this->font = &f;
+	for(auto& p : this->paragraphs){
+		p.is_measured = false;
+	}
+	this->is_dirty = true;
+	this->dirty_from = 0;
+}
+
+void text_layout::set_tab_size(size_t tab_size){
+	if(this->tab_size == tab_size){
+		return;
+	}
+	this->tab_size = tab_size;
+	for(auto& p : this->paragraphs){
+		p.is_measured = false;
+	}
+	this->is_dirty = true;
+	this->dirty_from = 0;
+}
+
+void text_layout::set_max_width(real width){
+	if(width < 0){
+		width = -1;
+	}
+	if(this->max_width == width){
+		return;
+	}
+	this->max_width = width;
+	for(auto& p : this->paragraphs){
+		p.is_wrapped = false;
+	}
+	this->is_dirty = true;
+	this->dirty_from = 0;
+}
+
+void text_layout::split(size_t begin, size_t end, std::vector<paragraph>& out)const{
+	ASSERT(begin <= end)
+	ASSERT(end <= this->text.size())
+
+	for(;;){
+		auto i = std::find(this->text.begin() + begin, this->text.begin() + end, U'\n');
+
+		paragraph p;
+		p.begin = begin;
+		p.length = size_t(i - this->text.begin()) - begin;
+		out.push_back(std::move(p));
+
+		if(i == this->text.begin() + end){
+			break;
+		}
+		begin = size_t(i - this->text.begin()) + 1;
+	}
+}
+
+void text_layout::set_text(std::u32string&& text){
+	this->text = std::move(text);
+	this->paragraphs.clear();
+	this->split(0, this->text.size(), this->paragraphs);
+	this->is_dirty = true;
+	this->dirty_from = 0;
+}
+
+void text_layout::update_begins()const{
+	size_t begin = 0;
+	if(this->dirty_from != 0){
+		auto& prev = this->paragraphs[this->dirty_from - 1];
+		begin = prev.begin + prev.length + 1;
+	}
+	for(auto i = this->paragraphs.begin() + this->dirty_from; i != this->paragraphs.end(); ++i){
+		i->begin = begin;
+		begin += i->length + 1; // + line feed
+	}
+	ASSERT(begin == this->text.size() + 1)
+}
+
+size_t text_layout::find_paragraph(size_t index)const{
+	ASSERT(!this->paragraphs.empty())
+	auto i = std::upper_bound(
+			this->paragraphs.begin(),
+			this->paragraphs.end(),
+			index,
+			[](size_t index, const paragraph& p){
+				return index < p.begin;
+			}
+		);
+	ASSERT(i != this->paragraphs.begin())
+	return size_t(i - this->paragraphs.begin()) - 1;
+}
+
+size_t text_layout::find_paragraph_by_line(size_t line_index)const{
+	ASSERT(!this->paragraphs.empty())
+	auto i = std::upper_bound(
+			this->paragraphs.begin(),
+			this->paragraphs.end(),
+			line_index,
+			[](size_t index, const paragraph& p){
+				return index < p.first_line;
+			}
+		);
+	ASSERT(i != this->paragraphs.begin())
+	return size_t(i - this->paragraphs.begin()) - 1;
+}
+
+void text_layout::replace(size_t begin, size_t end, std::u32string_view str){
+	end = std::min(end, this->text.size());
+	if(begin > end){
+		throw std::invalid_argument("text_layout::replace(): begin is greater than end");
+	}
+
+	if(this->is_dirty){
+		this->update_begins();
+	}
+
+	auto first = this->find_paragraph(begin);
+	auto last = this->find_paragraph(end);
+	ASSERT(first <= last)
+
+	size_t region_begin = this->paragraphs[first].begin;
+	size_t region_end = this->paragraphs[last].begin + this->paragraphs[last].length;
+
+	this->text.replace(begin, end - begin, str);
+
+	region_end = region_end + str.size() - (end - begin);
+
+	std::vector<paragraph> edited;
+	this->split(region_begin, region_end, edited);
+
+	// reuse the paragraph objects, in most cases the number of paragraphs stays the same
+	size_t num_old = last - first + 1;
+	size_t num_common = std::min(num_old, edited.size());
+	for(size_t i = 0; i != num_common; ++i){
+		auto& p = this->paragraphs[first + i];
+		p.begin = edited[i].begin;
+		p.length = edited[i].length;
+		p.is_measured = false;
+	}
+	if(edited.size() > num_old){
+		this->paragraphs.insert(
+				this->paragraphs.begin() + (last + 1),
+				std::make_move_iterator(edited.begin() + num_common),
+				std::make_move_iterator(edited.end())
+			);
+	}else{
+		this->paragraphs.erase(
+				this->paragraphs.begin() + (first + num_common),
+				this->paragraphs.begin() + (last + 1)
+			);
+	}
+
+	this->is_dirty = true;
+	this->dirty_from = std::min(this->dirty_from, first);
+}
+
+void text_layout::measure(paragraph& p)const{
+	ASSERT(this->font)
+
+	// the positions are taken from the paragraph rendered as a whole, so that kerning is taken into account
+	// and the lines are wrapped and hit-tested at the positions where the characters are drawn
+	p.offsets = this->font->get_char_offsets(this->text.substr(p.begin, p.length), this->tab_size);
+	ASSERT(p.offsets.size() == p.length + 1)
+
+	p.is_measured = true;
+	p.is_wrapped = false;
+}
+
+size_t text_layout::wrap(const paragraph& p, real width, std::vector<line>* lines)const{
+	ASSERT(p.is_measured)
+	ASSERT(p.offsets.size() == p.length + 1)
+
+	auto str = this->text.data() + p.begin;
+	const auto& o = p.offsets;
+
+	size_t num_lines = 0;
+
+	auto add_line = [&num_lines, lines, &o, str](size_t begin, size_t end){
+		++num_lines;
+		if(!lines){
+			return;
+		}
+		size_t trimmed_end = end;
+		while(trimmed_end != begin && is_space(str[trimmed_end - 1])){
+			--trimmed_end;
+		}
+		lines->push_back(line{begin, end, o[trimmed_end] - o[begin]});
+	};
+
+	size_t line_begin = 0;
+	size_t break_pos = 0;
+
+	if(width >= 0){
+		for(size_t i = 0; i != p.length; ++i){
+			bool space = is_space(str[i]);
+
+			if(!space && i != line_begin && o[i + 1] - o[line_begin] > width){
+				// break after last space, or break the word in case there were no spaces
+				size_t end = break_pos > line_begin ? break_pos : i;
+				add_line(line_begin, end);
+				line_begin = end;
+			}
+
+			if(space){
+				break_pos = i + 1;
+			}
+		}
+	}
+
+	add_line(line_begin, p.length);
+
+	return num_lines;
+}
+
+void text_layout::update()const{
+	if(!this->is_dirty){
+		return;
+	}
+
+	this->num_lines_width = -2;
+
+	if(!this->font){
+		throw std::logic_error("text_layout::update(): font is not set");
+	}
+
+	this->update_begins();
+
+	size_t num_lines = 0;
+	if(this->dirty_from != 0){
+		auto& prev = this->paragraphs[this->dirty_from - 1];
+		num_lines = prev.first_line + prev.lines.size();
+	}
+
+	for(auto i = this->paragraphs.begin() + this->dirty_from; i != this->paragraphs.end(); ++i){
+		auto& p = *i;
+		if(!p.is_measured){
+			this->measure(p);
+		}
+		if(!p.is_wrapped){
+			p.lines.clear();
+			this->wrap(p, this->max_width, &p.lines);
+			p.is_wrapped = true;
+
+			p.width = 0;
+			p.natural_width = 0;
+			for(auto& l : p.lines){
+				using std::max;
+				p.width = max(p.width, l.width);
+				p.natural_width = max(p.natural_width, p.offsets[l.begin] + l.width);
+			}
+		}
+
+		p.first_line = num_lines;
+		num_lines += p.lines.size();
+	}
+
+	real width = 0;
+	real natural_width = 0;
+	for(auto& p : this->paragraphs){
+		using std::max;
+		width = max(width, p.width);
+		natural_width = max(natural_width, p.natural_width);
+	}
+
+	this->num_lines_v = num_lines;
+	this->width_v = width;
+	this->natural_width_v = natural_width;
+
+	this->is_dirty = false;
+	this->dirty_from = this->paragraphs.size();
+}
+
+size_t text_layout::num_lines()const{
+	this->update();
+	return this->num_lines_v;
+}
+
+size_t text_layout::num_lines(real width)const{
+	if(width < 0){
+		width = -1;
+	}
+
+	if(width == this->max_width){
+		return this->num_lines();
+	}
+
+	// make sure all paragraphs are measured
+	this->update();
+
+	if(width == this->num_lines_width){
+		return this->num_lines_for_width;
+	}
+
+	size_t ret = 0;
+	for(auto& p : this->paragraphs){
+		ret += this->wrap(p, width, nullptr);
+	}
+
+	this->num_lines_width = width;
+	this->num_lines_for_width = ret;
+
+	return ret;
+}
+
+text_layout::line text_layout::get_line(size_t index)const{
+	this->update();
+
+	if(index >= this->num_lines_v){
+		throw std::out_of_range("text_layout::get_line(): line index is out of range");
+	}
+
+	auto& p = this->paragraphs[this->find_paragraph_by_line(index)];
+	auto l = p.lines[index - p.first_line];
+	l.begin += p.begin;
+	l.end += p.begin;
+	return l;
+}
+
+size_t text_layout::get_line_index(size_t char_index)const{
+	this->update();
+
+	char_index = std::min(char_index, this->text.size());
+
+	auto& p = this->paragraphs[this->find_paragraph(char_index)];
+
+	size_t i = char_index - p.begin;
+
+	// the character belongs to the last line which starts at or before it
+	auto l = std::upper_bound(
+			p.lines.begin(),
+			p.lines.end(),
+			i,
+			[](size_t index, const line& l){
+				return index < l.begin;
+			}
+		);
+	ASSERT(l != p.lines.begin())
+
+	return p.first_line + size_t(l - p.lines.begin()) - 1;
+}
+
+real text_layout::get_x(size_t char_index)const{
+	auto line_index = this->get_line_index(char_index);
+
+	char_index = std::min(char_index, this->text.size());
+
+	auto& p = this->paragraphs[this->find_paragraph_by_line(line_index)];
+	auto& l = p.lines[line_index - p.first_line];
+
+	return p.offsets[char_index - p.begin] - p.offsets[l.begin];
+}
+
+size_t text_layout::get_char_index(size_t line_index, real x)const{
+	this->update();
+
+	line_index = std::min(line_index, this->num_lines_v - 1);
+
+	auto& p = this->paragraphs[this->find_paragraph_by_line(line_index)];
+	auto& l = p.lines[line_index - p.first_line];
+
+	const auto& o = p.offsets;
+
+	real pos = x + o[l.begin];
+
+	// find the character under the position
+	auto i = std::upper_bound(o.begin() + l.begin + 1, o.begin() + l.end + 1, pos);
+	if(i == o.begin() + l.end + 1){
+		return p.begin + l.end;
+	}
+
+	size_t index = size_t(i - o.begin()) - 1;
+
+	// select nearest character boundary
+	if(pos >= (o[index] + o[index + 1]) / 2){
+		++index;
+	}
+
+	return p.begin + index;
+}
+
+real text_layout::get_width()const{
+	this->update();
+	return this->width_v;
+}
+
+real text_layout::get_natural_width()const{
+	this->update();
+	return this->natural_width_v;
+}
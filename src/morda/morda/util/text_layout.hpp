@@ -0,0 +1,221 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+
+#include "../config.hpp"
+
+#include "../fonts/font.hpp"
+
+namespace morda{
+
+/**
+ * @brief Multi-line text layout.
+ * Breaks text into lines at line feed characters and, optionally, wraps the lines
+ * at the given width. Lines are wrapped at spaces, words which do not fit into the width are broken.
+ *
+ * The text is held as a sequence of paragraphs, i.e. pieces of text separated by line feeds.
+ * For each paragraph the character positions and the lines are cached. Editing the text with replace()
+ * invalidates only the edited paragraphs, changing the width re-wraps the paragraphs without measuring
+ * the characters again.
+ *
+ * The layout is updated lazily, when the layout information is requested.
+ */
+class text_layout{
+public:
+	/**
+	 * @brief Line of text.
+	 */
+	struct line{
+		/**
+		 * @brief Index of the first character of the line.
+		 */
+		size_t begin;
+
+		/**
+		 * @brief Index of the character after the last character of the line.
+		 * Line feed character is not included.
+		 */
+		size_t end;
+
+		/**
+		 * @brief Width of the line.
+		 * Trailing spaces are not included.
+		 */
+		real width;
+	};
+
+private:
+	const morda::font* font = nullptr;
+
+	size_t tab_size = 4;
+
+	real max_width = -1;
+
+	std::u32string text;
+
+	struct paragraph{
+		size_t begin;
+		size_t length;
+
+		size_t first_line;
+
+		real width;
+		real natural_width;
+
+		bool is_measured = false;
+		bool is_wrapped = false;
+
+		// offsets[i] is the position of the i'th character from the paragraph start, has length + 1 elements
+		std::vector<real> offsets;
+
+		// character indices are relative to the paragraph start
+		std::vector<line> lines;
+	};
+
+	// the layout is updated lazily from the const methods, so the cached data is mutable
+	mutable std::vector<paragraph> paragraphs;
+
+	mutable bool is_dirty = true;
+
+	// index of the first paragraph which needs its position to be updated
+	mutable size_t dirty_from = 0;
+
+	mutable size_t num_lines_v = 0;
+	mutable real width_v = 0;
+	mutable real natural_width_v = 0;
+
+	// number of lines for the last width requested with num_lines(real), other than the max width,
+	// negative width means there is no cached value
+	mutable real num_lines_width = -2;
+	mutable size_t num_lines_for_width = 0;
+
+	void split(size_t begin, size_t end, std::vector<paragraph>& out)const;
+
+	void measure(paragraph& p)const;
+
+	// wrap the paragraph at the given width, the lines are stored to the given vector if it is not null,
+	// returns number of lines
+	size_t wrap(const paragraph& p, real width, std::vector<line>* lines)const;
+
+	void update_begins()const;
+
+	void update()const;
+
+	size_t find_paragraph(size_t index)const;
+
+	size_t find_paragraph_by_line(size_t line_index)const;
+
+public:
+	text_layout();
+
+	/**
+	 * @brief Set font.
+	 * The font object must remain alive while it is set to the layout.
+	 * @param f - font to measure the text with.
+	 */
+	void set_font(const morda::font& f);
+
+	/**
+	 * @brief Set tabulation size.
+	 * @param tab_size - tabulation size in widths of space character.
+	 */
+	void set_tab_size(size_t tab_size);
+
+	/**
+	 * @brief Set width to wrap lines at.
+	 * @param width - maximum width of lines. Negative value means no wrapping.
+	 */
+	void set_max_width(real width);
+
+	/**
+	 * @brief Get width the lines are wrapped at.
+	 * @return maximum width of lines, negative value means no wrapping.
+	 */
+	real get_max_width()const noexcept{
+		return this->max_width;
+	}
+
+	/**
+	 * @brief Set text.
+	 * Invalidates the whole layout.
+	 * @param text - new text.
+	 */
+	void set_text(std::u32string&& text);
+
+	/**
+	 * @brief Get text.
+	 * @return the text.
+	 */
+	const std::u32string& get_text()const noexcept{
+		return this->text;
+	}
+
+	/**
+	 * @brief Replace part of the text.
+	 * Only the paragraphs touched by the replaced range are laid out again.
+	 * @param begin - index of the first character to replace.
+	 * @param end - index of the character after the last one to replace.
+	 * @param str - string to replace the range with.
+	 */
+	void replace(size_t begin, size_t end, std::u32string_view str);
+
+	/**
+	 * @brief Get number of lines.
+	 * @return number of lines, it is always at least one.
+	 */
+	size_t num_lines()const;
+
+	/**
+	 * @brief Get number of lines for the given wrapping width.
+	 * The layout is not changed, so this can be used for measuring the text at other width than the max width.
+	 * The result for the last requested width is cached.
+	 * @param width - width to wrap lines at. Negative value means no wrapping.
+	 * @return number of lines, it is always at least one.
+	 */
+	size_t num_lines(real width)const;
+
+	/**
+	 * @brief Get line.
+	 * @param index - index of the line.
+	 * @return the line.
+	 */
+	line get_line(size_t index)const;
+
+	/**
+	 * @brief Get index of the line which contains character.
+	 * @param char_index - index of the character.
+	 * @return index of the line.
+	 */
+	size_t get_line_index(size_t char_index)const;
+
+	/**
+	 * @brief Get position of the character within its line.
+	 * @param char_index - index of the character.
+	 * @return horizontal distance from the line start to the character.
+	 */
+	real get_x(size_t char_index)const;
+
+	/**
+	 * @brief Find character boundary nearest to the position within the line.
+	 * @param line_index - index of the line.
+	 * @param x - horizontal position from the line start.
+	 * @return index of the character which starts at the boundary.
+	 */
+	size_t get_char_index(size_t line_index, real x)const;
+
+	/**
+	 * @brief Get width of the widest line.
+	 * @return width of the laid out text.
+	 */
+	real get_width()const;
+
+	/**
+	 * @brief Get width of the text without wrapping.
+	 * @return width of the widest paragraph.
+	 */
+	real get_natural_width()const;
+};
+
+}
@@ -1,11 +1,15 @@
 #include "util.hpp"
 
+#include <array>
+
 #include <utki/debug.hpp>
 #include <utki/config.hpp>
 
 #include "../context.hpp"
 
 #include "raster_image.hpp"
+#include "res_pack.hpp"
+#include "ktx_image.hpp"
 
 using namespace morda;
 
@@ -69,6 +73,14 @@ real morda::parse_layout_dimension_value(const treeml::leaf& l, const morda::uni
 }
 
 
+size_t morda::estimate_gpu_memory_usage(const texture_2d& tex)noexcept{
+	if(tex.memory_size() != 0){
+		return tex.memory_size();
+	}
+	auto d = tex.dims();
+	return size_t(d.x()) * size_t(d.y()) * texture_2d::bytes_per_pixel(texture_2d::type::rgba);
+}
+
 morda::texture_2d::type morda::num_channels_to_texture_type(unsigned numChannels){
 	switch(numChannels){
 		default:
@@ -88,14 +100,124 @@ morda::texture_2d::type morda::num_channels_to_texture_type(unsigned numChannels
 	}
 }
 
-std::shared_ptr<texture_2d> morda::load_texture(renderer& r, const papki::file& fi){
-	raster_image image(fi);
+namespace{
+texture_2d::filter parse_filter(const treeml::tree& p){
+	const auto& v = get_property_value(p);
+	if(v == "nearest"){
+		return texture_2d::filter::nearest;
+	}else if(v == "linear"){
+		return texture_2d::filter::linear;
+	}
+	throw std::invalid_argument("parse_texture_sampling(): unknown filter value: " + v.to_string());
+}
+
+texture_2d::wrap parse_wrap(const treeml::tree& p){
+	const auto& v = get_property_value(p);
+	if(v == "repeat"){
+		return texture_2d::wrap::repeat;
+	}else if(v == "mirrored_repeat"){
+		return texture_2d::wrap::mirrored_repeat;
+	}else if(v == "clamp"){
+		return texture_2d::wrap::clamp;
+	}
+	throw std::invalid_argument("parse_texture_sampling(): unknown wrap value: " + v.to_string());
+}
+}
+
+texture_2d::sampling morda::parse_texture_sampling(const treeml::forest& desc){
+	texture_2d::sampling ret;
+
+	for(auto& p : desc){
+		if(!is_property(p)){
+			continue;
+		}
+
+		if(p.value == "filter"){
+			ret.min_filter = parse_filter(p);
+			ret.mag_filter = ret.min_filter;
+		}else if(p.value == "min_filter"){
+			ret.min_filter = parse_filter(p);
+		}else if(p.value == "mag_filter"){
+			ret.mag_filter = parse_filter(p);
+		}else if(p.value == "mipmap"){
+			const auto& v = get_property_value(p);
+			if(v == "none"){
+				ret.mipmaps = texture_2d::mipmap::none;
+			}else if(v == "nearest"){
+				ret.mipmaps = texture_2d::mipmap::nearest;
+			}else if(v == "linear"){
+				ret.mipmaps = texture_2d::mipmap::linear;
+			}else{
+				throw std::invalid_argument("parse_texture_sampling(): unknown mipmap value: " + v.to_string());
+			}
+		}else if(p.value == "wrap"){
+			ret.wrap_s = parse_wrap(p);
+			ret.wrap_t = ret.wrap_s;
+		}else if(p.value == "wrap_s"){
+			ret.wrap_s = parse_wrap(p);
+		}else if(p.value == "wrap_t"){
+			ret.wrap_t = parse_wrap(p);
+		}
+	}
+
+	return ret;
+}
+
+std::shared_ptr<texture_2d> morda::load_texture(
+		renderer& r,
+		const papki::file& fi,
+		const texture_2d::sampling& params,
+		r4::vector2<unsigned> dims_request
+	)
+{
+	auto rf = dynamic_cast<const res_pack::file*>(&fi);
+
+	if(fi.suffix() == "ktx"){
+		// files from resource pack archive are used right from the mapped memory
+		std::vector<std::uint8_t> loaded_data;
+		utki::span<const std::uint8_t> data;
+		if(rf){
+			data = rf->data();
+		}else{
+			loaded_data = fi.load();
+			data = utki::make_span(loaded_data);
+		}
+
+		ktx_image ktx(data);
+
+		if(ktx.is_compressed()){
+			if(!r.factory->is_supported(ktx.compression())){
+				throw std::runtime_error("load_texture(): compressed texture format is not supported by renderer: " + fi.path());
+			}
+			return r.factory->create_texture_2d(ktx.compression(), ktx.dims(), ktx.mips(), params);
+		}
+		return r.factory->create_texture_2d(ktx.type(), ktx.dims(), ktx.mips(), params);
+	}
+
+	// pre-decoded images from resource pack archive are uploaded right from the mapped memory,
+	// unless those are to be downscaled
+	if(dims_request == r4::vector2<unsigned>(0)){
+		res_pack::pre_decoded_image im;
+		if(res_pack::get_pre_decoded_image(fi, im)){
+			std::array<utki::span<const std::uint8_t>, 1> mips = {{im.pixels}};
+			return r.factory->create_texture_2d(
+					num_channels_to_texture_type(im.num_channels),
+					im.dims,
+					utki::make_span(mips),
+					params
+				);
+		}
+	}
+
+	raster_image image(fi, dims_request);
 //	TRACE(<< "ResTexture::Load(): image loaded" << std::endl)
 
+	std::array<utki::span<const std::uint8_t>, 1> mips = {{image.pixels()}};
 	return r.factory->create_texture_2d(
 			num_channels_to_texture_type(image.num_channels()),
 			image.dims(),
-			image.pixels()
+			utki::make_span(mips),
+			params
 		);
 }
 
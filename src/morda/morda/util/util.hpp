@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <string_view>
+
 #include <utki/config.hpp>
 
 #include <r4/vector.hpp>
@@ -75,13 +78,48 @@ bool is_leaf_property(const treeml::leaf& l);
 
 bool is_leaf_child(const treeml::leaf& l);
 
+/**
+ * @brief Parse texture sampling parameters.
+ * Recognized properties:
+ * - filter{nearest|linear} - sets both minification and magnification filters.
+ * - min_filter{nearest|linear}, mag_filter{nearest|linear} - set the filters separately.
+ * - mipmap{none|nearest|linear} - mipmap filtering.
+ * - wrap{repeat|mirrored_repeat|clamp} - sets wrapping mode for both texture coordinates.
+ * - wrap_s{...}, wrap_t{...} - set wrapping modes separately.
+ * Other properties are ignored.
+ * @param desc - properties to parse.
+ * @return Parsed sampling parameters, not given ones have default values.
+ */
+texture_2d::sampling parse_texture_sampling(const treeml::forest& desc);
+
 /**
  * @brief Load texture from file.
+ * Raster images and KTX texture files are supported. KTX files can hold precomputed mipmaps and
+ * GPU compressed data, see ktx_image.
  * @param r - renderer.
  * @param fi - file to load texture from.
+ * @param params - texture sampling parameters.
+ * @param dims_request - dimensions to decode raster image to, see raster_image::load() for details.
+ *                       KTX textures are always loaded at full size.
  * @return Loaded texture.
+ * @throw std::runtime_error - in case the file is compressed texture and its format is not supported by the renderer.
  */
-std::shared_ptr<texture_2d> load_texture(renderer& r, const papki::file& fi);
+std::shared_ptr<texture_2d> load_texture(
+		renderer& r,
+		const papki::file& fi,
+		const texture_2d::sampling& params = texture_2d::sampling(),
+		r4::vector2<unsigned> dims_request = r4::vector2<unsigned>(0)
+	);
+
+/**
+ * @brief Estimate GPU memory used by texture.
+ * The estimate is the size of the texture data as reported by texture_2d::memory_size(),
+ * i.e. taking into account the pixel format, compression and mipmap levels.
+ * If the rendering backend does not report the size, 4 bytes per pixel of the base level is assumed.
+ * @param tex - texture to estimate memory usage of.
+ * @return estimated memory usage in bytes.
+ */
+size_t estimate_gpu_memory_usage(const texture_2d& tex)noexcept;
 
 /**
  * @brief Set simple alpha blending to rendering context.
@@ -102,4 +140,36 @@ inline const treeml::leaf& get_property_value(const treeml::tree& p){
     return p.children.front().value;
 }
 
+/**
+ * @brief Calculate hash of property name.
+ * The function is constexpr, so it can be used in case labels to dispatch property parsing
+ * with a switch statement instead of comparing the property name to each of the known names:
+ * @code
+ * switch(property_hash(p.value.to_string())){
+ *     case property_hash("color"):
+ *         if(p.value != "color"){
+ *             break;
+ *         }
+ *         ...
+ *         break;
+ *     default:
+ *         break;
+ * }
+ * @endcode
+ * This is 64 bit FNV-1a hash. Hashes of the known property names do not collide with each other,
+ * duplicate case labels within one switch are rejected by the compiler. But an unknown, e.g. misspelled,
+ * property name can have the same hash as a known one, so each case has to check the actual name.
+ * This is one string comparison per property instead of comparing the name to each of the known names.
+ * @param name - property name.
+ * @return hash of the property name.
+ */
+constexpr uint64_t property_hash(std::string_view name)noexcept{
+	uint64_t h = 0xcbf29ce484222325;
+	for(auto c : name){
+		h ^= uint64_t(uint8_t(c));
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
 }
@@ -43,16 +43,39 @@ blending_widget::blending_widget(std::shared_ptr<morda::context> c, const treeml
 			continue;
 		}
 
-		if(p.value == "blend"){
-			this->isBlendingEnabled_v = get_property_value(p).to_bool();
-		}else if(p.value == "blend_src"){
-			this->blend_v.src = blendFactorFromString(get_property_value(p).to_string());
-		}else if(p.value == "blend_dst"){
-			this->blend_v.dst = blendFactorFromString(get_property_value(p).to_string());
-		}else if(p.value == "blend_src_alpha"){
-			this->blend_v.src_alpha = blendFactorFromString(get_property_value(p).to_string());
-		}else if(p.value == "blend_dst_alpha"){
-			this->blend_v.dst_alpha = blendFactorFromString(get_property_value(p).to_string());
+		switch(property_hash(p.value.to_string())){
+			case property_hash("blend"):
+				if(p.value != "blend"){
+					break;
+				}
+				this->isBlendingEnabled_v = get_property_value(p).to_bool();
+				break;
+			case property_hash("blend_src"):
+				if(p.value != "blend_src"){
+					break;
+				}
+				this->blend_v.src = blendFactorFromString(get_property_value(p).to_string());
+				break;
+			case property_hash("blend_dst"):
+				if(p.value != "blend_dst"){
+					break;
+				}
+				this->blend_v.dst = blendFactorFromString(get_property_value(p).to_string());
+				break;
+			case property_hash("blend_src_alpha"):
+				if(p.value != "blend_src_alpha"){
+					break;
+				}
+				this->blend_v.src_alpha = blendFactorFromString(get_property_value(p).to_string());
+				break;
+			case property_hash("blend_dst_alpha"):
+				if(p.value != "blend_dst_alpha"){
+					break;
+				}
+				this->blend_v.dst_alpha = blendFactorFromString(get_property_value(p).to_string());
+				break;
+			default:
+				break;
 		}
 	}
 }
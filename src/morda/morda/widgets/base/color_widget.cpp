@@ -12,10 +12,21 @@ color_widget::color_widget(std::shared_ptr<morda::context> c, const treeml::fore
 			continue;
 		}
 
-		if(p.value == "color"){
-			this->color = get_property_value(p).to_uint32();
-		}else if(p.value == "disabled_color"){
-			this->disabled_color = get_property_value(p).to_uint32();
+		switch(property_hash(p.value.to_string())){
+			case property_hash("color"):
+				if(p.value != "color"){
+					break;
+				}
+				this->color = get_property_value(p).to_uint32();
+				break;
+			case property_hash("disabled_color"):
+				if(p.value != "disabled_color"){
+					break;
+				}
+				this->disabled_color = get_property_value(p).to_uint32();
+				break;
+			default:
+				break;
 		}
 	}
 }
@@ -72,7 +72,15 @@ protected:
 	}
 
 	void recompute_bounding_box(){
-		this->bb = this->get_font().get().get_bounding_box(this->get_text());
+		this->bb = this->get_font().get().get_bounding_box(this->text);
+	}
+
+	/**
+	 * @brief Get text without copying it.
+	 * @return reference to the text.
+	 */
+	const std::u32string& get_text_ref()const noexcept{
+		return this->text;
 	}
 public:
 	using text_widget::set_text;
@@ -121,7 +121,8 @@ bool click_drop_down_box::on_mouse_move(const mouse_move_event& e){
 					mouse_move_event{
 						e.pos + this->get_absolute_pos() - cm->get_absolute_pos(),
 						e.pointer_id,
-						e.ignore_mouse_capture
+						e.ignore_mouse_capture,
+						e.history
 					}
 				);
     	}
@@ -140,7 +141,12 @@ void click_drop_down_box::show_drop_down_menu(){
 		throw std::logic_error("drop_down_box: no overlay parent found");
 	}
 
-	auto np = this->context->inflater.inflate(drop_down_menu_layout);
+	if(!this->drop_down_menu_blueprint){
+		this->drop_down_menu_blueprint = this->context->inflater.compile(drop_down_menu_layout);
+		this->item_blueprint = this->context->inflater.compile(item_layout);
+	}
+
+	auto np = this->context->inflater.inflate(*this->drop_down_menu_blueprint);
 	ASSERT(np)
 
 	// force minimum horizontal size of the drop down menu to be the same as the drop down box horizontal size
@@ -200,7 +206,8 @@ void click_drop_down_box::handle_mouse_button_up(bool is_first_button_up_event){
 }
 
 std::shared_ptr<widget> click_drop_down_box::wrap_item(std::shared_ptr<widget>&& w, size_t index){
-	auto wd = std::dynamic_pointer_cast<pile>(this->context->inflater.inflate(item_layout));
+	ASSERT(this->item_blueprint)
+	auto wd = this->context->inflater.inflate_as<pile>(*this->item_blueprint);
 	ASSERT(wd)
 
 	auto mp = wd->try_get_widget_as<mouse_proxy>("morda_dropdown_mouseproxy");
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../../inflater.hpp"
+
 #include "drop_down_box.hpp"
 #include "nine_patch_push_button.hpp"
 
@@ -13,6 +15,10 @@ class click_drop_down_box :
 	std::weak_ptr<widget> current_drop_down_menu;
 
 	unsigned num_mouse_buttons_pressed = 0;
+
+	// compiled on first showing of the drop down menu
+	std::shared_ptr<const inflater::blueprint> drop_down_menu_blueprint;
+	std::shared_ptr<const inflater::blueprint> item_blueprint;
 public:
 	click_drop_down_box(std::shared_ptr<morda::context> c, const treeml::forest& desc);
 
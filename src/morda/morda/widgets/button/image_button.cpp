@@ -33,10 +33,21 @@ image_button::image_button(std::shared_ptr<morda::context> c, const treeml::fore
 					continue;
 				}
 
-				if(pp.value == "pressed"){
-					this->pressedImage_v = this->context->loader.load<res::image>(get_property_value(pp).to_string());
-				}else if(pp.value == "unpressed"){
-					this->unpressedImage_v = this->context->loader.load<res::image>(get_property_value(pp).to_string());
+				switch(property_hash(pp.value.to_string())){
+					case property_hash("pressed"):
+						if(pp.value != "pressed"){
+							break;
+						}
+						this->pressedImage_v = this->context->loader.load<res::image>(get_property_value(pp).to_string());
+						break;
+					case property_hash("unpressed"):
+						if(pp.value != "unpressed"){
+							break;
+						}
+						this->unpressedImage_v = this->context->loader.load<res::image>(get_property_value(pp).to_string());
+						break;
+					default:
+						break;
 				}
 				this->update_image();
 			}
@@ -22,10 +22,21 @@ nine_patch_button::nine_patch_button(std::shared_ptr<morda::context> c, const tr
 					continue;
 				}
 
-				if(pp.value == "unpressed"){
-					this->set_unpressed_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(pp).to_string()));
-				}else if(pp.value == "pressed"){
-					this->set_pressed_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(pp).to_string()));
+				switch(property_hash(pp.value.to_string())){
+					case property_hash("unpressed"):
+						if(pp.value != "unpressed"){
+							break;
+						}
+						this->set_unpressed_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(pp).to_string()));
+						break;
+					case property_hash("pressed"):
+						if(pp.value != "pressed"){
+							break;
+						}
+						this->set_pressed_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(pp).to_string()));
+						break;
+					default:
+						break;
 				}
 			}
 		}
@@ -66,7 +66,7 @@ morda::vector2 tab_group::measure(const morda::vector2& quotum)const{
 			}
 		}
 
-		d = c->measure(d);
+		d = c->measure_cached(d);
 
 		length += d.x();
 
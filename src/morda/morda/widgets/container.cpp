@@ -4,11 +4,30 @@
 
 #include "../util/util.hpp"
 
+#include <utki/util.hpp>
+
+#include <algorithm>
+
 using namespace morda;
 
 container::container(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 		widget(std::move(c), desc)
 {
+	for(const auto& p : desc){
+		if(!is_property(p)){
+			continue;
+		}
+
+		try{
+			if(p.value == "parallel_layout"){
+				this->parallel_layout = get_property_value(p).to_bool();
+			}
+		}catch(std::invalid_argument&){
+			TRACE(<< "could not parse value of " << treeml::to_string(p) << std::endl)
+			throw;
+		}
+	}
+
 	this->push_back_inflate(desc);
 }
 
@@ -31,29 +50,83 @@ widget::layout_params& container::get_layout_params(widget& w){
 				>::type>(lp);
 }
 
+namespace{
+// checks if the layout description has only the properties which are carried over
+// to the new layout parameters object by container::recreate_layout_params()
+bool is_basic_layout_desc(const treeml::forest& desc){
+	for(const auto& p : desc){
+		if(p.value != "dx" && p.value != "dy"){
+			return false;
+		}
+	}
+	return true;
+}
+}
+
 const widget::layout_params& container::get_layout_params_const(const widget& w)const{
 	if(w.parent() && w.parent() != this){
 		throw std::invalid_argument("container::get_layout_params(): the given widget is not a child of this container");
 	}
 
 	if(!w.layoutParams){
-		w.layoutParams = this->create_layout_params(w.layout_desc);
+		// layout parameters of the widget inflated in arena are allocated from the same arena
+		arena::scope arena_scope(w.owner_arena ? w.owner_arena : arena::get_current());
+
+		if(w.rare){
+			w.layoutParams = this->create_layout_params(w.rare->layout_desc);
+
+			// The raw description is only needed in case the widget is moved to a container of other type,
+			// which needs to parse container specific layout properties, e.g. weight.
+			// Basic properties are carried over from the parsed layout parameters, so in case there are no other
+			// properties, the raw description can be dropped.
+			if(is_basic_layout_desc(w.rare->layout_desc)){
+				w.rare->layout_desc = treeml::forest();
+				w.shrink_rare();
+			}
+		}else{
+			w.layoutParams = this->create_layout_params(treeml::forest());
+		}
 	}
 
 	return *w.layoutParams;
 }
 
+void container::recreate_layout_params(const widget& w)const{
+	auto old = std::move(w.layoutParams);
+
+	this->get_layout_params_const(w);
+	ASSERT(w.layoutParams)
+
+	// container specific properties are parsed from the retained raw layout description, if any,
+	// the basic layout parameters are carried over since those could have been changed programmatically
+	if(old){
+		w.layoutParams->dims = old->dims;
+	}
+}
+
+std::vector<container::mouse_capture_info>::iterator container::find_mouse_capture(unsigned pointer_id)noexcept{
+	return std::find_if(
+			this->mouse_captures.begin(),
+			this->mouse_captures.end(),
+			[pointer_id](const mouse_capture_info& mci){
+				return mci.pointer_id == pointer_id;
+			}
+		);
+}
+
 std::unique_ptr<widget::layout_params> container::create_layout_params(const treeml::forest& desc)const{
 	return std::make_unique<widget::layout_params>(desc, this->context->units);
 }
 
 void container::push_back_inflate(const treeml::forest& desc){
+	edit e(*this);
 	for(auto i = desc.begin(); i != desc.end(); ++i){
 		if(is_leaf_property(i->value)){
 			continue;
 		}
-		this->push_back(this->context->inflater.inflate(i, i + 1));
+		e.push_back(this->context->inflater.inflate(i, i + 1));
 	}
+	e.commit();
 
 	// in case this widget is initially disabled, as specified in gui script
 	// we need to update enabled state of children
@@ -86,9 +159,9 @@ bool container::on_mouse_button(const mouse_button_event& e){
 
 	// check if mouse captured
 	{
-		auto i = this->mouse_capture_map.find(e.pointer_id);
-		if(i != this->mouse_capture_map.end()){
-			if(auto w = i->second.capturing_widget.lock()){
+		auto i = this->find_mouse_capture(e.pointer_id);
+		if(i != this->mouse_captures.end()){
+			if(auto w = i->capturing_widget.lock()){
 				if(w->is_interactive()){
 					w->on_mouse_button(mouse_button_event{
 							e.is_down,
@@ -98,7 +171,7 @@ bool container::on_mouse_button(const mouse_button_event& e){
 						});
 					w->set_hovered(w->rect().overlaps(e.pos), e.pointer_id);
 
-					unsigned& num_buttons_captured = i->second.num_buttons_captured;
+					unsigned& num_buttons_captured = i->num_buttons_captured;
 					if(e.is_down){
 						// if we get button down event for mouse capturing widget, then it is not for the buttons
 						// which are already down, so we increase the button counter.
@@ -109,7 +182,7 @@ bool container::on_mouse_button(const mouse_button_event& e){
 						--num_buttons_captured;
 					}
 					if(num_buttons_captured == 0){
-						this->mouse_capture_map.erase(i);
+						this->mouse_captures.erase(i);
 					}
 
 					// doesn't matter what to return because parent widget also captured
@@ -117,7 +190,7 @@ bool container::on_mouse_button(const mouse_button_event& e){
 					return true;
 				}
 			}
-			this->mouse_capture_map.erase(i);
+			this->mouse_captures.erase(i);
 		}
 	}
 
@@ -144,7 +217,7 @@ bool container::on_mouse_button(const mouse_button_event& e){
 				e.pointer_id
 			}))
 		{
-			ASSERT(this->mouse_capture_map.find(e.pointer_id) == this->mouse_capture_map.end())
+			ASSERT(this->find_mouse_capture(e.pointer_id) == this->mouse_captures.end())
 
 			// normally, we get here only when the mouse was not captured by widget, because
 			// as soon as mouse button down event comes to some widget, it captures the mouse.
@@ -152,13 +225,11 @@ bool container::on_mouse_button(const mouse_button_event& e){
 			// But, in theory, it can be button up event here, if some widget which captured
 			// mouse was removed from its parent. So, check if we have button down event.
 			if(e.is_down){
-				this->mouse_capture_map.insert(std::make_pair(
+				this->mouse_captures.push_back(mouse_capture_info{
 						e.pointer_id,
-						mouse_capture_info{
-							utki::make_weak(c),
-							1
-						}
-					));
+						utki::make_weak(c),
+						1
+					});
 			}
 
 			// widget has consumed the mouse button event,
@@ -182,14 +253,15 @@ bool container::on_mouse_move(const mouse_move_event& e){
 
 	// check if mouse captured
 	if(!e.ignore_mouse_capture){
-		auto i = this->mouse_capture_map.find(e.pointer_id);
-		if(i != this->mouse_capture_map.end()){
-			if(auto w = i->second.capturing_widget.lock()){
+		auto i = this->find_mouse_capture(e.pointer_id);
+		if(i != this->mouse_captures.end()){
+			if(auto w = i->capturing_widget.lock()){
 				if(w->is_interactive()){
 					w->on_mouse_move(mouse_move_event{
 							e.pos - w->rect().p,
 							e.pointer_id,
-							e.ignore_mouse_capture
+							e.ignore_mouse_capture,
+							e.history
 						});
 					w->set_hovered(w->rect().overlaps(e.pos), e.pointer_id);
 
@@ -198,7 +270,7 @@ bool container::on_mouse_move(const mouse_move_event& e){
 					return true;
 				}
 			}
-			this->mouse_capture_map.erase(i);
+			this->mouse_captures.erase(i);
 		}
 	}
 
@@ -222,7 +294,8 @@ bool container::on_mouse_move(const mouse_move_event& e){
 		if(c->on_mouse_move(mouse_move_event{
 				e.pos - c->rect().p,
 				e.pointer_id,
-				e.ignore_mouse_capture
+				e.ignore_mouse_capture,
+				e.history
 			}))
 		{
 			// widget has consumed the mouse move event,
@@ -251,6 +324,92 @@ void container::on_hover_change(unsigned pointer_id){
 	}
 }
 
+void container::lay_out_children(const std::function<void()>& resize_children){
+	if(!this->parallel_layout || !this->context->layout_scheduler || this->children().size() < 2){
+		resize_children();
+		return;
+	}
+
+	layout_batch batch{this, {}};
+	batch.deferred.reserve(this->children().size());
+
+	{
+		auto prev_batch = current_layout_batch;
+		current_layout_batch = &batch;
+		utki::scope_exit batch_scope_exit([prev_batch, &batch](){
+			current_layout_batch = prev_batch;
+
+			// reset the flags right after resizing, also in case of exception, so that the flags are not left set
+			for(auto w : batch.deferred){
+				w->lay_out_deferred = false;
+			}
+		});
+
+		resize_children();
+	}
+
+	if(batch.deferred.empty()){
+		return;
+	}
+
+	// sub-hierarchies which measure widgets from outside of themselves could read the widgets which are
+	// being laid out concurrently, so those are laid out on this thread after all the other children
+	auto serial_begin = std::partition(
+			batch.deferred.begin(),
+			batch.deferred.end(),
+			[](const widget* w){
+				return !w->depends_on_outer_layout;
+			}
+		);
+
+	auto lay_out_deferred = [](widget& w){
+		if(w.resize_deferred){
+			w.on_resize();
+		}else{
+			w.lay_out();
+		}
+	};
+
+	if(serial_begin != batch.deferred.begin()){
+		layout_barrier barrier{this};
+
+		// replay the invalidations which were stopped by the barrier
+		utki::scope_exit barrier_scope_exit([this, &barrier](){
+			if(barrier.cache_cleared){
+				this->clear_cache();
+			}
+			if(barrier.layout_invalidated){
+				this->invalidate_layout();
+			}
+			for(auto& d : barrier.dependents){
+				if(auto w = d.lock()){
+					w->invalidate_layout();
+				}
+			}
+		});
+
+		this->context->layout_scheduler->for_each(
+				size_t(std::distance(batch.deferred.begin(), serial_begin)),
+				[&batch, &barrier, &lay_out_deferred](size_t i){
+					auto prev_batch = current_layout_batch;
+					auto prev_barrier = current_layout_barrier;
+					current_layout_batch = nullptr;
+					current_layout_barrier = &barrier;
+					utki::scope_exit scope_exit([prev_batch, prev_barrier](){
+						current_layout_batch = prev_batch;
+						current_layout_barrier = prev_barrier;
+					});
+
+					lay_out_deferred(*batch.deferred[i]);
+				}
+			);
+	}
+
+	for(auto i = serial_begin; i != batch.deferred.end(); ++i){
+		lay_out_deferred(**i);
+	}
+}
+
 void container::lay_out(){
 //	TRACE(<< "container::lay_out(): invoked" << std::endl)
 	for(auto& w : this->children()){
@@ -283,6 +442,10 @@ container::widget_list::const_iterator container::insert(std::shared_ptr<widget>
 	auto ret = this->children_v.variable.emplace(before, std::move(w));
 
 	ww.parent_container = this;
+
+	this->add_to_id_indices(ww);
+	this->propagate_outer_layout_dependency(ww);
+
 	ww.on_parent_change();
 
 	this->on_children_change();
@@ -306,6 +469,8 @@ container::widget_list::const_iterator container::erase(widget_list::const_itera
 
 	auto w = *child;
 
+	this->remove_from_id_indices(*w);
+
 	auto ret = this->children_v.variable.erase(child);
 
 	w->parent_container = nullptr;
@@ -321,13 +486,294 @@ void container::clear(){
 	for(auto i = this->children().begin(); i != this->children().end(); i = this->erase(i)){}
 }
 
-std::shared_ptr<widget> container::try_get_widget(const std::string& id, bool allow_itself)noexcept{
+container::edit::edit(container& c) :
+		owner(c)
+{
+	if(this->owner.is_blocked){
+		throw std::logic_error("container::edit::edit(): children list is locked");
+	}
+
+	auto num_children = this->owner.children().size();
+
+	this->nodes.resize(num_children + 1);
+	for(size_t i = 0; i != this->nodes.size(); ++i){
+		auto& n = this->nodes[i];
+		n.index = i - 1;
+		n.prev = i == 0 ? num_children : i - 1;
+		n.next = i == num_children ? 0 : i + 1;
+	}
+	this->nodes[0].index = npos;
+
+	this->num_widgets = num_children;
+
+	this->owner.is_blocked = true;
+}
+
+container::edit::~edit()noexcept{
+	if(!this->is_committed){
+		this->owner.is_blocked = false;
+	}
+}
+
+void container::edit::link(size_t n, size_t before)noexcept{
+	auto& nd = this->nodes[n];
+	auto& b = this->nodes[before];
+	nd.prev = b.prev;
+	nd.next = before;
+	this->nodes[b.prev].next = n;
+	b.prev = n;
+}
+
+void container::edit::unlink(size_t n)noexcept{
+	auto& nd = this->nodes[n];
+	this->nodes[nd.prev].next = nd.next;
+	this->nodes[nd.next].prev = nd.prev;
+}
+
+bool container::edit::is_valid(const iterator& i, bool allow_end)const noexcept{
+	if(i.owner != this || i.n >= this->nodes.size()){
+		return false;
+	}
+	if(i.n == 0){
+		return allow_end;
+	}
+	return this->nodes[i.n].prev != npos;
+}
+
+container::edit::iterator container::edit::insert(std::shared_ptr<widget> w, iterator before){
+	if(this->is_committed){
+		throw std::logic_error("container::edit::insert(): edit is already committed");
+	}
+
+	if(!w){
+		throw std::invalid_argument("container::edit::insert(): pointer to widget is a null pointer");
+	}
+
+	if(w->parent()){
+		throw std::invalid_argument("container::edit::insert(): given widget is already added to some container");
+	}
+
+	if(!this->is_valid(before, true)){
+		throw std::invalid_argument("container::edit::insert(): given 'before' iterator does not belong to this edit");
+	}
+
+	if(!this->added.insert(w.get()).second){
+		throw std::invalid_argument("container::edit::insert(): given widget is already inserted");
+	}
+
+	size_t n;
+	if(this->free_nodes.empty()){
+		n = this->nodes.size();
+		try{
+			this->nodes.emplace_back();
+		}catch(...){
+			this->added.erase(w.get());
+			throw;
+		}
+	}else{
+		n = this->free_nodes.back();
+		this->free_nodes.pop_back();
+	}
+
+	auto& nd = this->nodes[n];
+	nd.index = npos;
+	nd.inserted = std::move(w);
+	this->link(n, before.n);
+
+	++this->num_widgets;
+	this->is_changed = true;
+
+	return iterator(this, n);
+}
+
+container::edit::iterator container::edit::erase(iterator child){
+	if(this->is_committed){
+		throw std::logic_error("container::edit::erase(): edit is already committed");
+	}
+
+	if(!this->is_valid(child, false)){
+		throw std::invalid_argument("container::edit::erase(): given 'child' iterator is invalid");
+	}
+
+	auto next = std::next(child);
+
+	auto& nd = this->nodes[child.n];
+	if(nd.index == npos){
+		this->added.erase(nd.inserted.get());
+		nd.inserted.reset();
+	}else{
+		this->removed.push_back(this->owner.children_v.variable[nd.index]);
+	}
+
+	this->unlink(child.n);
+	nd.prev = npos;
+	this->free_nodes.push_back(child.n);
+
+	--this->num_widgets;
+	this->is_changed = true;
+
+	return next;
+}
+
+void container::edit::clear(){
+	for(auto i = this->begin(); i != this->end(); i = this->erase(i)){}
+}
+
+container::edit::iterator container::edit::change_child_z_position(iterator child, iterator before){
+	if(this->is_committed){
+		throw std::logic_error("container::edit::change_child_z_position(): edit is already committed");
+	}
+
+	if(!this->is_valid(child, false)){
+		throw std::invalid_argument("container::edit::change_child_z_position(): given 'child' iterator is invalid");
+	}
+
+	if(!this->is_valid(before, true)){
+		throw std::invalid_argument("container::edit::change_child_z_position(): given 'before' iterator does not belong to this edit");
+	}
+
+	if(child != before){
+		this->unlink(child.n);
+		this->link(child.n, before.n);
+		this->is_changed = true;
+	}
+
+	return child;
+}
+
+void container::edit::commit(){
+	if(this->is_committed){
+		throw std::logic_error("container::edit::commit(): edit is already committed");
+	}
+
+	this->is_committed = true;
+
+	auto& c = this->owner;
+
+	c.is_blocked = false;
+
+	if(!this->is_changed){
+		return;
+	}
+
+	widget_list children;
+	children.reserve(this->num_widgets);
+
+	std::vector<std::shared_ptr<widget>> inserted;
+	inserted.reserve(this->added.size());
+
+	for(auto n = this->nodes[0].next; n != 0; n = this->nodes[n].next){
+		auto& nd = this->nodes[n];
+		if(nd.index == npos){
+			inserted.push_back(nd.inserted);
+			children.push_back(std::move(nd.inserted));
+		}else{
+			// the old children list is replaced below, so the widgets are moved out of it
+			children.push_back(std::move(c.children_v.variable[nd.index]));
+		}
+	}
+	this->nodes.resize(1);
+	this->nodes[0].prev = 0;
+	this->nodes[0].next = 0;
+	this->free_nodes.clear();
+	this->num_widgets = 0;
+
+	for(auto& w : this->removed){
+		c.remove_from_id_indices(*w);
+	}
+
+	c.children_v.variable = std::move(children);
+
+	for(auto& w : this->removed){
+		w->parent_container = nullptr;
+	}
+
+	for(auto& w : inserted){
+		w->parent_container = &c;
+		c.add_to_id_indices(*w);
+		c.propagate_outer_layout_dependency(*w);
+	}
+
+	// notifications are fired after the children list is updated, so that the notified widgets see the final state
+
+	for(auto& w : this->removed){
+		w->set_unhovered();
+		w->on_parent_change();
+	}
+
+	for(auto& w : inserted){
+		ASSERT(!w->is_hovered())
+		w->on_parent_change();
+	}
+
+	c.on_children_change();
+}
+
+namespace{
+void visit_sub_hierarchy(widget& w, const std::function<void(widget&)>& visit){
+	visit(w);
+	if(auto c = dynamic_cast<container*>(&w)){
+		for(auto& cw : c->children()){
+			visit_sub_hierarchy(*cw, visit);
+		}
+	}
+}
+
+bool is_in_sub_hierarchy(const widget& w, const container& c){
+	for(auto p = w.parent(); p; p = p->parent()){
+		if(p == &c){
+			return true;
+		}
+	}
+	return false;
+}
+}
+
+std::shared_ptr<widget> container::try_get_widget(const std::string& id, bool allow_itself){
 	if(allow_itself){
 		if(auto r = this->widget::try_get_widget(id, true)){
 			return r;
 		}
 	}
 
+	if(this->id_index && !id.empty()){
+		auto iid = interned_string::find(id);
+		if(iid.empty()){
+			// the ID has never been interned, so there is no widget with such ID
+			return nullptr;
+		}
+
+		auto range = this->id_index->equal_range(iid);
+		std::shared_ptr<widget> found;
+		bool is_unique = true;
+		for(auto i = range.first; i != range.second;){
+			auto w = i->second.lock();
+			if(!w){
+				i = this->id_index->erase(i);
+				continue;
+			}
+			++i;
+
+			// widget ID could be changed after the widget was indexed, or the widget could be moved
+			// out of the sub-hierarchy without being removed from the index, so check it
+			if(w->id != iid || !is_in_sub_hierarchy(*w, *this)){
+				continue;
+			}
+
+			if(found){
+				is_unique = false;
+				break;
+			}
+			found = std::move(w);
+		}
+
+		// in case there are several widgets with the same ID, fall back to searching,
+		// so that the first widget in the hierarchy is returned, same as without index
+		if(found && is_unique){
+			return found;
+		}
+	}
+
 	for(auto& w : this->children()){
 		if(auto r = w->try_get_widget(id, true)){
 			return r;
@@ -336,6 +782,123 @@ std::shared_ptr<widget> container::try_get_widget(const std::string& id, bool al
 	return nullptr;
 }
 
+void container::propagate_outer_layout_dependency(const widget& w)noexcept{
+	if(!w.depends_on_outer_layout){
+		return;
+	}
+
+	// the flag is not cleared when the widget is removed, so the sub-hierarchy can be laid out serially needlessly,
+	// which is still correct
+	for(container* c = this; c && !c->depends_on_outer_layout; c = c->parent()){
+		c->depends_on_outer_layout = true;
+	}
+}
+
+void container::add_to_id_indices(widget& w){
+	for(container* c = this; c; c = c->parent()){
+		if(!c->id_index){
+			continue;
+		}
+		auto& index = *c->id_index;
+		visit_sub_hierarchy(w, [&index](widget& sw){
+			if(!sw.id.empty()){
+				index.insert(std::make_pair(sw.id, utki::make_weak_from(sw)));
+			}
+		});
+	}
+}
+
+void container::remove_from_id_indices(widget& w){
+	for(container* c = this; c; c = c->parent()){
+		if(!c->id_index){
+			continue;
+		}
+		auto& index = *c->id_index;
+		visit_sub_hierarchy(w, [&index](widget& sw){
+			if(sw.id.empty()){
+				return;
+			}
+			// in case widget ID was changed after the widget was indexed, the entry
+			// will not be found here and will be filtered out during lookup
+			auto range = index.equal_range(sw.id);
+			for(auto i = range.first; i != range.second; ++i){
+				if(i->second.lock().get() == &sw){
+					index.erase(i);
+					return;
+				}
+			}
+		});
+	}
+}
+
+void container::set_id_index_enabled(bool enable){
+	if(!enable){
+		this->id_index.reset();
+		return;
+	}
+
+	if(this->id_index){
+		return;
+	}
+
+	this->id_index = std::make_unique<decltype(this->id_index)::element_type>();
+
+	auto& index = *this->id_index;
+	for(auto& c : this->children()){
+		visit_sub_hierarchy(*c, [&index](widget& sw){
+			if(!sw.id.empty()){
+				index.insert(std::make_pair(sw.id, utki::make_weak_from(sw)));
+			}
+		});
+	}
+}
+
+std::vector<std::shared_ptr<widget>> container::try_get_widgets(const std::vector<std::string>& ids, bool allow_itself){
+	std::vector<std::shared_ptr<widget>> ret(ids.size());
+
+	if(this->id_index){
+		for(size_t i = 0; i != ids.size(); ++i){
+			ret[i] = this->try_get_widget(ids[i], allow_itself);
+		}
+		return ret;
+	}
+
+	// map interned ID to indices in the list of requested IDs
+	std::unordered_multimap<interned_string, size_t> requested;
+	for(size_t i = 0; i != ids.size(); ++i){
+		auto iid = interned_string::find(ids[i]);
+		if(iid.empty()){
+			// no widget has such ID
+			continue;
+		}
+		requested.insert(std::make_pair(iid, i));
+	}
+
+	auto visit = [&requested, &ret](widget& w){
+		if(requested.empty() || w.id.empty()){
+			return;
+		}
+		auto range = requested.equal_range(w.id);
+		if(range.first == range.second){
+			return;
+		}
+		for(auto i = range.first; i != range.second; ++i){
+			ret[i->second] = utki::make_shared_from(w);
+		}
+		requested.erase(range.first, range.second);
+	};
+
+	if(allow_itself){
+		visit_sub_hierarchy(*this, visit);
+	}else{
+		for(auto& c : this->children()){
+			visit_sub_hierarchy(*c, visit);
+		}
+	}
+
+	return ret;
+}
+
 vector2 container::dims_for_widget(const widget& w, const layout_params& lp)const{
 	vector2 d;
 	for(unsigned i = 0; i != 2; ++i){
@@ -348,7 +911,7 @@ vector2 container::dims_for_widget(const widget& w, const layout_params& lp)cons
 		}
 	}
 	if(d.x() < 0 || d.y() < 0){
-		vector2 md = w.measure(d);
+		vector2 md = w.measure_cached(d);
 		for(unsigned i = 0; i != md.size(); ++i){
 			if(d[i] < 0){
 				d[i] = md[i];
@@ -426,3 +989,9 @@ void container::on_enable_change(){
 		c->set_enabled(this->is_enabled());
 	}
 }
+
+size_t container::get_heap_size()const noexcept{
+	return this->widget::get_heap_size()
+			+ this->children().capacity() * sizeof(widget_list::value_type)
+			+ this->mouse_captures.capacity() * sizeof(mouse_capture_info);
+}
@@ -1,7 +1,10 @@
 #pragma once
 
-#include <map>
 #include <vector>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
 
 #include "../util/util.hpp"
 #include "widget.hpp"
@@ -22,6 +25,8 @@ namespace morda{
  *     }
  * }
  * @endcode
+ * It can have the following parameters:
+ * @param parallel_layout - allow laying out children concurrently, see container::lay_out_children(). Default value is false.
  */
 class container : virtual public widget{
 public:
@@ -46,17 +51,38 @@ private:
 	} children_v;
 
 	struct mouse_capture_info{
+		unsigned pointer_id;
 		std::weak_ptr<widget> capturing_widget;
 		unsigned num_buttons_captured;
 	};
 
-	// map which maps pointer ID to a pair holding reference to capturing widget and number of mouse capture clicks
-	std::map<unsigned, mouse_capture_info> mouse_capture_map;
+	// list of mouse captures, there is at most one capture per pointer ID,
+	// normally there are no more than one or two entries in the list, so linear search is fine
+	std::vector<mouse_capture_info> mouse_captures;
+
+	decltype(mouse_captures)::iterator find_mouse_capture(unsigned pointer_id)noexcept;
+
+	// recreate layout parameters of the child widget in case those are not of the type needed by this container
+	void recreate_layout_params(const widget& w)const;
+
+	// index of all widgets in the sub-hierarchy by their IDs, does not include this container itself.
+	// Widget ID can be changed after the widget has been indexed, so the index can contain stale entries,
+	// these are filtered out during lookup.
+	std::unique_ptr<std::unordered_multimap<interned_string, std::weak_ptr<widget>>> id_index;
+
+	// add/remove the widget with its sub-hierarchy to/from ID indices of this container and its ancestors
+	void add_to_id_indices(widget& w);
+	void remove_from_id_indices(widget& w);
+
+	// set the outer layout dependency flag to this container and its ancestors in case the inserted widget has it
+	void propagate_outer_layout_dependency(const widget& w)noexcept;
 
 private:
 	// flag indicating that modifications to children list are blocked
 	bool is_blocked = false;
 
+	bool parallel_layout = false;
+
 	class blocked_flag_guard{
 		bool& blocked;
 	public:
@@ -92,6 +118,49 @@ protected:
 	 */
 	vector2 dims_for_widget(const widget& w, const layout_params& lp)const;
 
+	/**
+	 * @brief Resize children with parallel laying out of their sub-hierarchies.
+	 * Calls the given function which is supposed to resize and position the children of this container.
+	 * In case the layout scheduler is set to the context and parallel layout is enabled for this container,
+	 * the resize() calls on the children, made from within the function, only update the children dimensions,
+	 * while laying out of the children is deferred. After the function returns, the children are laid out
+	 * concurrently using the layout scheduler. Otherwise, the function is just called.
+	 *
+	 * Thread safety rules for widgets inside of a container with parallel layout enabled:
+	 * - measure(), lay_out() and on_resize() overrides must only access the widget's own sub-hierarchy and
+	 *   thread-safe objects, like fonts. They must not load resources, inflate or render widgets,
+	 *   or call back to the user code which is not thread-safe.
+	 * - they must not release render objects, like textures, as those are not thread-safe.
+	 * - invalidate_layout() and clear_cache() calls are allowed, those are propagated to the ancestors
+	 *   after all the children are laid out.
+	 * - children whose sub-hierarchies contain widgets measuring widgets from outside of their sub-hierarchy,
+	 *   like min_proxy, or widgets adding children during layout, like list and tree_view,
+	 *   are laid out on the calling thread after all the other children are laid out,
+	 *   see widget::set_depends_on_outer_layout().
+	 * - the function itself is called on the calling thread and can do anything which is allowed in lay_out().
+	 *
+	 * @param resize_children - function which resizes and positions the children.
+	 */
+	void lay_out_children(const std::function<void()>& resize_children);
+
+	/**
+	 * @brief Check if parallel layout of children is enabled.
+	 * @return true if parallel layout is enabled for this container.
+	 * @return false otherwise.
+	 */
+	bool is_parallel_layout_enabled()const noexcept{
+		return this->parallel_layout;
+	}
+
+	/**
+	 * @brief Enable or disable parallel layout of children.
+	 * Parallel layout only takes effect if the layout scheduler is set to the context.
+	 * @param enable - whether to enable (true) or disable (false) the parallel layout.
+	 */
+	void set_parallel_layout_enabled(bool enable)noexcept{
+		this->parallel_layout = enable;
+	}
+
 public:
 
 	/**
@@ -103,7 +172,7 @@ public:
 	template <class T> const T& get_layout_params_as_const(const widget& w)const{
 		auto p = dynamic_cast<const T*>(&this->get_layout_params_const(w));
 		if(!p){
-			w.layoutParams.reset();
+			this->recreate_layout_params(w);
 			p = dynamic_cast<const T*>(&this->get_layout_params_const(w));
 		}
 
@@ -122,7 +191,7 @@ public:
 	template <class T> T& get_layout_params_as(widget& w){
 		auto p = dynamic_cast<T*>(&this->get_layout_params(w));
 		if(!p){
-			w.layoutParams.reset();
+			this->recreate_layout_params(w);
 			p = dynamic_cast<T*>(&this->get_layout_params(w));
 		}
 
@@ -244,6 +313,219 @@ public:
 	 */
 	void clear();
 
+	/**
+	 * @brief Batch edit of the children list.
+	 * Edit collects inserts, removals and reorderings of child widgets and applies them all at once
+	 * on commit(), with a single reallocation of the children list and a single on_children_change() call.
+	 * The on_parent_change() notifications of the inserted and removed widgets are also fired on commit.
+	 * Inserting and reordering widgets in the edit does not shift the other widgets, so populating
+	 * a container with many widgets is linear in the number of widgets.
+	 *
+	 * The children list of the container is locked while the edit exists, so the container cannot be
+	 * modified directly until the edit is committed or destroyed. Destroying the edit without committing
+	 * discards the changes.
+	 *
+	 * The edited list is a linked list stored in a vector, its nodes refer to the original children
+	 * by their indices, so starting an edit is a single allocation regardless of the number of children.
+	 */
+	class edit{
+		container& owner;
+
+		struct node{
+			// index of the original child in the children list of the container, npos for inserted widgets
+			size_t index;
+
+			// inserted widget
+			std::shared_ptr<widget> inserted;
+
+			// node indices, npos in prev means the node is free
+			size_t prev;
+			size_t next;
+		};
+
+		constexpr static const size_t npos = ~size_t(0);
+
+		// node 0 is the end of the list
+		std::vector<node> nodes;
+
+		// erased nodes to be reused
+		std::vector<size_t> free_nodes;
+
+		size_t num_widgets;
+
+		// widgets inserted during the edit
+		std::unordered_set<const widget*> added;
+
+		// original children removed during the edit
+		std::vector<std::shared_ptr<widget>> removed;
+
+		bool is_changed = false;
+		bool is_committed = false;
+
+		const std::shared_ptr<widget>& get(size_t n)const noexcept{
+			ASSERT(n != 0 && n < this->nodes.size())
+			const auto& nd = this->nodes[n];
+			return nd.index == npos ? nd.inserted : this->owner.children_v.variable[nd.index];
+		}
+
+		void link(size_t n, size_t before)noexcept;
+		void unlink(size_t n)noexcept;
+
+	public:
+		/**
+		 * @brief Iterator into the edited children list.
+		 */
+		class iterator{
+			friend class edit;
+
+			const edit* owner = nullptr;
+			size_t n = 0;
+
+			iterator(const edit* owner, size_t n) :
+					owner(owner),
+					n(n)
+			{}
+		public:
+			typedef std::bidirectional_iterator_tag iterator_category;
+			typedef std::shared_ptr<widget> value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const value_type* pointer;
+			typedef const value_type& reference;
+
+			iterator() = default;
+
+			reference operator*()const noexcept{
+				return this->owner->get(this->n);
+			}
+
+			pointer operator->()const noexcept{
+				return &this->operator*();
+			}
+
+			iterator& operator++()noexcept{
+				this->n = this->owner->nodes[this->n].next;
+				return *this;
+			}
+
+			iterator operator++(int)noexcept{
+				auto ret = *this;
+				this->operator++();
+				return ret;
+			}
+
+			iterator& operator--()noexcept{
+				this->n = this->owner->nodes[this->n].prev;
+				return *this;
+			}
+
+			iterator operator--(int)noexcept{
+				auto ret = *this;
+				this->operator--();
+				return ret;
+			}
+
+			bool operator==(const iterator& i)const noexcept{
+				return this->owner == i.owner && this->n == i.n;
+			}
+
+			bool operator!=(const iterator& i)const noexcept{
+				return !this->operator==(i);
+			}
+		};
+
+	private:
+		// checks that the iterator points into this edit, end iterator is allowed if allow_end is true
+		bool is_valid(const iterator& i, bool allow_end)const noexcept;
+
+	public:
+		/**
+		 * @brief Start editing children of the container.
+		 * @param c - container to edit children of.
+		 * @throw std::logic_error - in case children list of the container is locked.
+		 */
+		edit(container& c);
+
+		edit(const edit&) = delete;
+		edit& operator=(const edit&) = delete;
+
+		~edit()noexcept;
+
+		/**
+		 * @brief Get begin iterator into the edited children list.
+		 * @return begin iterator into the edited children list.
+		 */
+		iterator begin()const noexcept{
+			return iterator(this, this->nodes[0].next);
+		}
+
+		/**
+		 * @brief Get end iterator into the edited children list.
+		 * @return end iterator into the edited children list.
+		 */
+		iterator end()const noexcept{
+			return iterator(this, 0);
+		}
+
+		/**
+		 * @brief Get number of widgets in the edited children list.
+		 * @return number of widgets in the edited children list.
+		 */
+		size_t size()const noexcept{
+			return this->num_widgets;
+		}
+
+		/**
+		 * @brief Insert a widget.
+		 * Iterators obtained before calling this function stay valid.
+		 * @param w - widget to insert.
+		 * @param before - iterator into the edited children list before which the widget is inserted.
+		 * @return iterator pointing to the inserted widget.
+		 * @throw std::invalid_argument - in case the widget is null, already added to some container or already inserted in this edit.
+		 * @throw std::invalid_argument - in case the 'before' iterator does not belong to this edit.
+		 */
+		iterator insert(std::shared_ptr<widget> w, iterator before);
+
+		/**
+		 * @brief Insert a widget to the end.
+		 * @param w - widget to insert.
+		 * @return iterator pointing to the inserted widget.
+		 */
+		iterator push_back(std::shared_ptr<widget> w){
+			return this->insert(std::move(w), this->end());
+		}
+
+		/**
+		 * @brief Remove a widget.
+		 * Only the iterator of the removed widget is invalidated.
+		 * @param child - iterator of the widget to remove.
+		 * @return iterator pointing to the next widget after the removed one.
+		 * @throw std::invalid_argument - in case the 'child' iterator does not point to a widget of this edit.
+		 */
+		iterator erase(iterator child);
+
+		/**
+		 * @brief Remove all widgets.
+		 */
+		void clear();
+
+		/**
+		 * @brief Move widget to another position.
+		 * Iterators stay valid.
+		 * @param child - iterator of the widget to move.
+		 * @param before - iterator of the widget before which the widget is moved.
+		 * @return iterator pointing to the moved widget.
+		 * @throw std::invalid_argument - in case any of the iterators does not belong to this edit.
+		 */
+		iterator change_child_z_position(iterator child, iterator before);
+
+		/**
+		 * @brief Apply the changes to the container.
+		 * After commit the edit becomes empty and cannot be used anymore.
+		 * @throw std::logic_error - in case the edit is already committed.
+		 */
+		void commit();
+	};
+
 	/**
 	 * @brief Try get widget by id.
 	 * It searches through the whole widget sub-hierarchy, not just direct children of this container.
@@ -252,7 +534,39 @@ public:
 	 * @return pointer to widget with given id if found.
 	 * @return nullptr if there is no widget with given id found.
 	 */
-	std::shared_ptr<widget> try_get_widget(const std::string& id, bool allow_itself = true)noexcept override;
+	std::shared_ptr<widget> try_get_widget(const std::string& id, bool allow_itself = true) override;
+
+	/**
+	 * @brief Try get several widgets by their IDs.
+	 * Searches for many widgets at once. In case ID index is enabled the lookup of each ID is done through the index,
+	 * otherwise the whole widget sub-hierarchy is traversed only once.
+	 * @param ids - list of IDs to look for.
+	 * @param allow_itself - whether it is allowed to return itself in case id matches.
+	 * @return list of found widgets, i-th element corresponds to i-th ID, nullptr if widget with that ID was not found.
+	 */
+	std::vector<std::shared_ptr<widget>> try_get_widgets(const std::vector<std::string>& ids, bool allow_itself = true);
+
+	/**
+	 * @brief Enable/disable ID index.
+	 * ID index maps IDs to widgets of the whole sub-hierarchy of the container, this makes try_get_widget()
+	 * and get_widget() calls on this container to be done in constant time instead of searching through all the widgets.
+	 * The index is maintained when widgets are added to or removed from any container of the sub-hierarchy,
+	 * so adding and removing widgets becomes a bit slower.
+	 * Normally, the ID index is enabled on the root widget.
+	 * If widget ID is changed after the widget has been added to the indexed sub-hierarchy, then lookups for that
+	 * widget fall back to searching through the whole sub-hierarchy.
+	 * @param enable - whether to enable (true) or disable (false) the ID index.
+	 */
+	void set_id_index_enabled(bool enable);
+
+	/**
+	 * @brief Check if ID index is enabled.
+	 * @return true if ID index is enabled.
+	 * @return false otherwise.
+	 */
+	bool is_id_index_enabled()const noexcept{
+		return this->id_index != nullptr;
+	}
 
 	/**
 	 * @brief Get list of child widgets.
@@ -382,6 +696,8 @@ public:
 	 * This implementation sets the same enabled state to all children of the container.
 	 */
 	void on_enable_change()override;
+
+	size_t get_heap_size()const noexcept override;
 };
 
 template <class T>
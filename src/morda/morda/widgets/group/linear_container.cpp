@@ -31,25 +31,16 @@ linear_container::linear_container(std::shared_ptr<morda::context> c, const tree
 		oriented_widget(this->context, treeml::forest(), vertical)
 {}
 
-namespace{
-struct info{
-	vector2 measured_dims;
-};
-}
-
 void linear_container::lay_out(){
 	unsigned long_index = this->get_long_index();
 	unsigned trans_index = this->get_trans_index();
 
-	std::vector<info> info_array(this->children().size());
-
-	// calculate rigid size, net weight and store weights
+	// calculate rigid size and net weight
 	real rigid = 0;
 	real net_weight = 0;
 
 	{
-		auto info = info_array.begin();
-		for(auto i = this->children().cbegin(); i != this->children().cend(); ++i, ++info){
+		for(auto i = this->children().cbegin(); i != this->children().cend(); ++i){
 			auto& lp = this->get_layout_params_as_const<layout_params>(**i);
 
 			net_weight += lp.weight;
@@ -58,28 +49,29 @@ void linear_container::lay_out(){
 			ASSERT(lp.dims[long_index] != layout_params::fill)
 
 			vector2 d = this->dims_for_widget(**i, lp);
-			info->measured_dims = d;
 
 			rigid += d[long_index];
 		}
 	}
 
 	// arrange widgets
-	{
+	this->lay_out_children([&](){
 		real flexible = this->rect().d[long_index] - rigid;
 
 		real pos = 0;
 
 		real remainder = 0;
 
-		auto info = info_array.begin();
-		for(auto i = this->children().begin(); i != this->children().end(); ++i, ++info){
+		for(auto i = this->children().begin(); i != this->children().end(); ++i){
 			auto& lp = this->get_layout_params_as_const<layout_params>(**i);
 
+			// children measure results are cached, so measuring again is cheap
+			vector2 measured_dims = this->dims_for_widget(**i, lp);
+
 			if(lp.weight != 0){
 				ASSERT(lp.weight > 0)
 				vector2 d;
-				d[long_index] = info->measured_dims[long_index];
+				d[long_index] = measured_dims[long_index];
 				if(flexible > 0){
 					ASSERT(net_weight > 0)
 					real dl = flexible * lp.weight / net_weight;
@@ -102,7 +94,7 @@ void linear_container::lay_out(){
 						d[trans_index] = lp.dims[trans_index];
 					}
 					if(d.x() < 0 || d.y() < 0){
-						vector2 md = (*i)->measure(d);
+						vector2 md = (*i)->measure_cached(d);
 						for(unsigned i = 0; i != md.size(); ++i){
 							if(d[i] < 0){
 								d[i] = md[i];
@@ -112,7 +104,7 @@ void linear_container::lay_out(){
 				}
 				(*i)->resize(d);
 			}else{
-				(*i)->resize(info->measured_dims);
+				(*i)->resize(measured_dims);
 			}
 
 			vector2 newPos;
@@ -133,23 +125,52 @@ void linear_container::lay_out(){
 			this->children().back()->resize_by(d);
 			this->children().back()->move_by(-d);
 		}
+	});
+}
+
+namespace{
+vector2 get_child_quotum(const linear_container::layout_params& lp, const vector2& quotum, unsigned long_index, unsigned trans_index){
+	vector2 child_quotum;
+	if(lp.dims[trans_index] == linear_container::layout_params::max){
+		if(quotum[trans_index] >= 0){
+			child_quotum[trans_index] = quotum[trans_index];
+		}else{
+			child_quotum[trans_index] = -1;
+		}
+	}else if(lp.dims[trans_index] == linear_container::layout_params::min){
+		child_quotum[trans_index] = -1;
+	}else if(lp.dims[trans_index] == linear_container::layout_params::fill){
+		if(quotum[trans_index] >= 0){
+			child_quotum[trans_index] = quotum[trans_index];
+		}else{
+			child_quotum[trans_index] = 0;
+		}
+	}else{
+		child_quotum[trans_index] = lp.dims[trans_index];
+	}
+
+	ASSERT(lp.dims[long_index] != linear_container::layout_params::max)
+	ASSERT(lp.dims[long_index] != linear_container::layout_params::fill)
+	if(lp.dims[long_index] == linear_container::layout_params::min){
+		child_quotum[long_index] = -1;
+	}else{
+		child_quotum[long_index] = lp.dims[long_index];
 	}
+	return child_quotum;
+}
 }
 
 morda::vector2 linear_container::measure(const morda::vector2& quotum)const{
 	unsigned long_index = this->get_long_index();
 	unsigned trans_index = this->get_trans_index();
 
-	std::vector<info> info_array(this->children().size());
-
 	// calculate rigid length
 	real rigid_length = 0;
 	real height = quotum[trans_index] >= 0 ? quotum[trans_index] : 0;
 	real net_weight = 0;
 
 	{
-		auto info = info_array.begin();
-		for(auto i = this->children().begin(); i != this->children().end(); ++i, ++info){
+		for(auto i = this->children().begin(); i != this->children().end(); ++i){
 			auto& lp = this->get_layout_params_as_const<layout_params>(**i);
 
 			net_weight += lp.weight;
@@ -158,41 +179,14 @@ morda::vector2 linear_container::measure(const morda::vector2& quotum)const{
 				throw std::logic_error("linear_container::measure(): 'max' or 'fill' in longitudional direction specified in layout parameters");
 			}
 
-			vector2 child_quotum;
-			if(lp.dims[trans_index] == layout_params::max){
-				if(quotum[trans_index] >= 0){
-					child_quotum[trans_index] = quotum[trans_index];
-				}else{
-					child_quotum[trans_index] = -1;
-				}
-			}else if(lp.dims[trans_index] == layout_params::min){
-				child_quotum[trans_index] = -1;
-			}else if(lp.dims[trans_index] == layout_params::fill){
-				if(quotum[trans_index] >= 0){
-					child_quotum[trans_index] = quotum[trans_index];
-				}else{
-					child_quotum[trans_index] = 0;
-				}
-			}else{
-				child_quotum[trans_index] = lp.dims[trans_index];
-			}
-
-			ASSERT(lp.dims[long_index] != layout_params::max)
-			ASSERT(lp.dims[long_index] != layout_params::fill)
-			if(lp.dims[long_index] == layout_params::min){
-				child_quotum[long_index] = -1;
-			}else{
-				child_quotum[long_index] = lp.dims[long_index];
-			}
-
-			info->measured_dims = (*i)->measure(child_quotum);
+			vector2 measured_dims = (*i)->measure_cached(get_child_quotum(lp, quotum, long_index, trans_index));
 
-			rigid_length += info->measured_dims[long_index];
+			rigid_length += measured_dims[long_index];
 
 			if(lp.weight == 0){
 				if(quotum[trans_index] < 0){
 					using std::max;
-					height = max(height, info->measured_dims[trans_index]);
+					height = max(height, measured_dims[trans_index]);
 				}
 			}
 		}
@@ -215,8 +209,7 @@ morda::vector2 linear_container::measure(const morda::vector2& quotum)const{
 
 		auto last_child = this->children().size() != 0 ? this->children().back().get() : nullptr;
 
-		auto info = info_array.begin();
-		for(auto i = this->children().begin(); i != this->children().end(); ++i, ++info){
+		for(auto i = this->children().begin(); i != this->children().end(); ++i){
 			auto& lp = this->get_layout_params_as_const<layout_params>(**i);
 			ASSERT(lp.weight >= 0)
 			if(lp.weight == 0){
@@ -225,8 +218,9 @@ morda::vector2 linear_container::measure(const morda::vector2& quotum)const{
 
 			ASSERT(net_weight > 0)
 
+			// children measure results are cached, so measuring again is cheap
 			vector2 d;
-			d[long_index] = info->measured_dims[long_index];
+			d[long_index] = (*i)->measure_cached(get_child_quotum(lp, quotum, long_index, trans_index))[long_index];
 
 			if(flex_len > 0){
 				real dl = flex_len * lp.weight / net_weight;
@@ -268,7 +262,7 @@ morda::vector2 linear_container::measure(const morda::vector2& quotum)const{
 
 			if(quotum[trans_index] < 0){
 				using std::max;
-				height = max(height, (*i)->measure(d)[trans_index]);
+				height = max(height, (*i)->measure_cached(d)[trans_index]);
 			}
 		}
 	}
@@ -37,6 +37,9 @@ list_widget::list_widget(std::shared_ptr<morda::context> c, const treeml::forest
 		container(this->context, treeml::forest()),
 		oriented_widget(this->context, treeml::forest(), vertical)
 {
+	// items are inflated and added during layout, which is not thread safe
+	this->set_depends_on_outer_layout();
+
 	std::shared_ptr<static_provider> pr = std::make_shared<static_provider>();
 
 	for(const auto& p : desc){
@@ -57,13 +60,16 @@ void list_widget::lay_out(){
 
 	this->update_children_list();
 
-	// defer the scroll position change notification, because layouting happens during render phase
-	this->context->run_from_ui_thread(
+	// defer the scroll position change notification, because layouting happens during render phase,
+	// repeated layouts before the notification is delivered result in just one notification
+	this->context->task_queue.post(
+			this,
 			[wl = utki::make_weak_from(*this)](){
 				if(auto l = wl.lock()){
 					l->notify_scroll_pos_changed();
 				}
-			}
+			},
+			task_queue::priority::layout
 		);
 }
 
@@ -470,10 +476,14 @@ void list_widget::provider::notify_data_set_change(){
 		return;
 	}
 
-	this->get_list()->context->run_from_ui_thread(
+	// data set changes posted before the list has handled the previous one are coalesced,
+	// posted with same priority as scroll position notification, so that those are delivered in order
+	this->get_list()->context->task_queue.post(
+		this,
 		[this](){
 			this->get_list()->handle_data_set_changed();
-		}
+		},
+		task_queue::priority::layout
 	);
 }
 
@@ -11,14 +11,16 @@ pile::pile(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 
 void pile::lay_out(){
 //	TRACE(<< "pile::lay_out(): invoked" << std::endl)
-	for(auto i = this->children().begin(); i != this->children().end(); ++i){
-		auto& lp = this->get_layout_params_as_const<container::layout_params>(**i);
+	this->lay_out_children([this](){
+		for(auto i = this->children().begin(); i != this->children().end(); ++i){
+			auto& lp = this->get_layout_params_as_const<container::layout_params>(**i);
 
-		(*i)->resize(this->dims_for_widget(**i, lp));
+			(*i)->resize(this->dims_for_widget(**i, lp));
 
-		using std::round;
-		(*i)->move_to(round((this->rect().d - (*i)->rect().d) / 2));
-	}
+			using std::round;
+			(*i)->move_to(round((this->rect().d - (*i)->rect().d) / 2));
+		}
+	});
 }
 
 morda::vector2 pile::measure(const morda::vector2& quotum)const{
@@ -51,7 +53,7 @@ morda::vector2 pile::measure(const morda::vector2& quotum)const{
 			}
 		}
 
-		d = (*i)->measure(d);
+		d = (*i)->measure_cached(d);
 
 		for(unsigned j = 0; j != d.size(); ++j){
 			if(quotum[j] < 0){
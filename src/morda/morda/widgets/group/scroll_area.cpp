@@ -26,7 +26,8 @@ bool scroll_area::on_mouse_move(const mouse_move_event& e){
 	return this->container::on_mouse_move(mouse_move_event{
 			e.pos - d,
 			e.pointer_id,
-			e.ignore_mouse_capture
+			e.ignore_mouse_capture,
+			e.history
 		});
 }
 
@@ -94,7 +95,7 @@ vector2 scroll_area::dims_for_widget(const widget& w, const layout_params& lp)co
 		}
 	}
 	if(d.x() < 0 || d.y() < 0){
-		vector2 md = w.measure(d);
+		vector2 md = w.measure_cached(d);
 		for(unsigned i = 0; i != md.size(); ++i){
 			if(d[i] < 0){
 				if(lp.dims[i] == layout_params::max && md[i] < this->rect().d[i]){
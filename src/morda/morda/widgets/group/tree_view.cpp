@@ -133,6 +133,17 @@ const treeml::forest empty_layout = treeml::read(R"qwertyuiop(
 	)qwertyuiop");
 }
 
+void tree_view::provider::compile_layouts(morda::inflater& inflater){
+	if(this->plus_minus_blueprint){
+		return;
+	}
+	this->plus_minus_blueprint = inflater.compile(plus_minus_layout);
+	this->vert_line_blueprint = inflater.compile(vert_line_layout);
+	this->line_end_blueprint = inflater.compile(line_end_layout);
+	this->line_middle_blueprint = inflater.compile(line_middle_layout);
+	this->empty_blueprint = inflater.compile(empty_layout);
+}
+
 std::shared_ptr<widget> tree_view::provider::get_widget(size_t index){
 	auto& i = this->iter_for(index);
 
@@ -153,20 +164,24 @@ std::shared_ptr<widget> tree_view::provider::get_widget(size_t index){
 
 	ASSERT_INFO(this->get_list(), "provider is not set to a list_widget")
 
+	auto& inflater = this->get_list()->context->inflater;
+
+	this->compile_layouts(inflater);
+
 	auto ret = std::make_shared<morda::row>(this->get_list()->context, treeml::forest());
 
 	ASSERT(isLastItemInParent.size() == path.size())
 
 	for(unsigned i = 0; i != path.size() - 1; ++i){
-		ret->push_back_inflate(isLastItemInParent[i] ? empty_layout : vert_line_layout);
+		ret->push_back(inflater.inflate(isLastItemInParent[i] ? *this->empty_blueprint : *this->vert_line_blueprint));
 	}
 
 	{
-		auto widget = this->get_list()->context->inflater.inflate_as<morda::pile>(isLastItemInParent.back() ? line_end_layout : line_middle_layout);
+		auto widget = inflater.inflate_as<morda::pile>(isLastItemInParent.back() ? *this->line_end_blueprint : *this->line_middle_blueprint);
 		ASSERT(widget)
 
 		if(this->count(utki::make_span(path)) != 0){
-			auto w = this->get_list()->context->inflater.inflate(plus_minus_layout);
+			auto w = inflater.inflate(*this->plus_minus_blueprint);
 
 			auto plusminus = w->try_get_widget_as<morda::image>("plusminus");
 			ASSERT(plusminus)
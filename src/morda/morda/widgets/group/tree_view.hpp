@@ -5,6 +5,7 @@
 #include <utki/tree.hpp>
 
 #include "../widget.hpp"
+#include "../../inflater.hpp"
 #include "list.hpp"
 
 #include "scroll_area.hpp"
@@ -54,6 +55,15 @@ public:
 		void remove_children(decltype(iter) from);
 		void set_children(decltype(iter) i, size_t num_children);
 
+		// compiled tree line layouts, compiled on first use
+		std::shared_ptr<const inflater::blueprint> plus_minus_blueprint;
+		std::shared_ptr<const inflater::blueprint> vert_line_blueprint;
+		std::shared_ptr<const inflater::blueprint> line_end_blueprint;
+		std::shared_ptr<const inflater::blueprint> line_middle_blueprint;
+		std::shared_ptr<const inflater::blueprint> empty_blueprint;
+
+		void compile_layouts(morda::inflater& inflater);
+
 	protected:
 		provider() = default;
 	public:
@@ -163,30 +163,72 @@ morda::window::window(std::shared_ptr<morda::context> c, const treeml::forest& d
 			continue;
 		}
 
-		if(p.value == "title"){
-			this->set_title(get_property_value(p).to_string());
-		}else if(p.value == "look"){
-			for(const auto& pp : p.children){
-				if(!is_property(pp)){
-					continue;
+		switch(property_hash(p.value.to_string())){
+			case property_hash("title"):
+				if(p.value != "title"){
+					break;
 				}
+				this->set_title(get_property_value(p).to_string());
+				break;
+			case property_hash("look"):
+				if(p.value != "look"){
+					break;
+				}
+				for(const auto& pp : p.children){
+					if(!is_property(pp)){
+						continue;
+					}
 
-				if(pp.value == "title_color_active"){
-					this->titleBgColorTopmost = get_property_value(pp).to_uint32();
-				}else if(pp.value == "title_color_inactive"){
-					this->titleBgColorNonTopmost = get_property_value(pp).to_uint32();
-				}else if(pp.value == "background"){
-					this->set_background(this->context->inflater.inflate(pp.children));
-				}else if(pp.value == "left"){
-					borders.left() = parse_dimension_value(get_property_value(pp), this->context->units);
-				}else if(pp.value == "top"){
-					borders.top() = parse_dimension_value(get_property_value(pp), this->context->units);
-				}else if(pp.value == "right"){
-					borders.right() = parse_dimension_value(get_property_value(pp), this->context->units);
-				}else if(pp.value == "bottom"){
-					borders.bottom() = parse_dimension_value(get_property_value(pp), this->context->units);
+					switch(property_hash(pp.value.to_string())){
+						case property_hash("title_color_active"):
+							if(pp.value != "title_color_active"){
+								break;
+							}
+							this->titleBgColorTopmost = get_property_value(pp).to_uint32();
+							break;
+						case property_hash("title_color_inactive"):
+							if(pp.value != "title_color_inactive"){
+								break;
+							}
+							this->titleBgColorNonTopmost = get_property_value(pp).to_uint32();
+							break;
+						case property_hash("background"):
+							if(pp.value != "background"){
+								break;
+							}
+							this->set_background(this->context->inflater.inflate(pp.children));
+							break;
+						case property_hash("left"):
+							if(pp.value != "left"){
+								break;
+							}
+							borders.left() = parse_dimension_value(get_property_value(pp), this->context->units);
+							break;
+						case property_hash("top"):
+							if(pp.value != "top"){
+								break;
+							}
+							borders.top() = parse_dimension_value(get_property_value(pp), this->context->units);
+							break;
+						case property_hash("right"):
+							if(pp.value != "right"){
+								break;
+							}
+							borders.right() = parse_dimension_value(get_property_value(pp), this->context->units);
+							break;
+						case property_hash("bottom"):
+							if(pp.value != "bottom"){
+								break;
+							}
+							borders.bottom() = parse_dimension_value(get_property_value(pp), this->context->units);
+							break;
+						default:
+							break;
+					}
 				}
-			}
+				break;
+			default:
+				break;
 		}
 	}
 	this->set_borders(borders);
@@ -4,6 +4,9 @@
 #include "../../util/key.hpp"
 #include "../../util/util.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 #if M_OS == M_OS_WINDOWS
 #	ifdef DELETE
 #		undef DELETE
@@ -30,15 +33,16 @@ text_input_line::text_input_line(std::shared_ptr<morda::context> c, const treeml
 void text_input_line::render(const morda::matrix4& matrix) const{
 	// render selection
 	if(this->cursorIndex != this->selectionStartIndex){
-		morda::matrix4 matr(matrix);
-		matr.translate(
+		quad_instance q;
+		q.matrix = matrix;
+		q.matrix.translate(
 				this->selectionStartIndex < this->cursorIndex ? this->selectionStartPos : this->cursorPos,
 				0
 			);
-		matr.scale(vector2(std::abs(this->cursorPos - this->selectionStartPos), this->rect().d.y()));
+		q.matrix.scale(vector2(std::abs(this->cursorPos - this->selectionStartPos), this->rect().d.y()));
+		q.color = color_to_vec4f(0xff804040);
 
-		auto& r = *this->context->renderer;
-		r.shader->color_pos->render(matr, *r.pos_quad_01_vao, 0xff804040);
+		this->context->renderer->render_quads(utki::make_span(&q, 1));
 	}
 	
 	{
@@ -50,21 +54,34 @@ void text_input_line::render(const morda::matrix4& matrix) const{
 
 		matr.translate(-this->get_bounding_box().p.x() + this->xOffset, round((font.get_height() + font.get_ascender() - font.get_descender()) / 2));
 		
-		ASSERT(this->firstVisibleCharIndex <= this->get_text().size())
+		const auto& text = this->get_text_ref();
+		const auto& adv = this->get_advances();
+
+		ASSERT(this->firstVisibleCharIndex <= text.size())
+
+		// render only the characters which fit into the widget, the last one can be partially visible
+		auto end = std::upper_bound(
+				adv.begin() + this->firstVisibleCharIndex,
+				adv.end(),
+				adv[this->firstVisibleCharIndex] + this->rect().d.x() - this->xOffset
+			);
+		size_t end_index = std::min(size_t(end - adv.begin()), text.size());
+
 		font.render(
 				matr,
 				morda::color_to_vec4f(this->get_current_color()),
-				this->get_text().substr(this->firstVisibleCharIndex, this->get_text().size() - this->firstVisibleCharIndex)
+				text.substr(this->firstVisibleCharIndex, end_index - this->firstVisibleCharIndex)
 			);
 	}
 	
-	if(this->is_focused() && this->cursorBlinkVisible){
-		morda::matrix4 matr(matrix);
-		matr.translate(this->cursorPos, 0);
-		matr.scale(vector2(cursorWidth_c * this->context->units.dots_per_dp, this->rect().d.y()));
+	if(this->is_focused() && this->cursorBlinkPhase < real(0.5)){
+		quad_instance q;
+		q.matrix = matrix;
+		q.matrix.translate(this->cursorPos, 0);
+		q.matrix.scale(vector2(cursorWidth_c * this->context->units.dots_per_dp, this->rect().d.y()));
+		q.color = color_to_vec4f(this->get_current_color());
 
-		auto& r = *this->context->renderer;
-		r.shader->color_pos->render(matr, *r.pos_quad_01_vao, this->get_current_color());
+		this->context->renderer->render_quads(utki::make_span(&q, 1));
 	}
 }
 
@@ -109,11 +126,35 @@ vector2 text_input_line::measure(const morda::vector2& quotum)const noexcept{
 	return ret;
 }
 
+const std::vector<real>& text_input_line::get_advances()const{
+	if(this->advances_valid){
+		return this->advances;
+	}
+
+	// positions are taken from the shaped text, so that the cursor stays at the glyph boundaries of the kerned text
+	this->advances = this->get_font().get().get_char_offsets(this->get_text_ref());
+	ASSERT(this->advances.size() == this->get_text_ref().size() + 1)
+
+	this->advances_valid = true;
+
+	return this->advances;
+}
+
+void text_input_line::on_text_change(){
+	this->advances_valid = false;
+	this->single_line_text_widget::on_text_change();
+}
+
+void text_input_line::on_font_change(){
+	this->advances_valid = false;
+	this->single_line_text_widget::on_font_change();
+}
+
 void text_input_line::set_cursor_index(size_t index, bool selection){
 	this->cursorIndex = index;
 	
 	using std::min;
-	this->cursorIndex = min(this->cursorIndex, this->get_text().size()); // clamp top
+	this->cursorIndex = min(this->cursorIndex, this->get_text_ref().size()); // clamp top
 	
 	if(!selection){
 		this->selectionStartIndex = this->cursorIndex;
@@ -137,98 +178,75 @@ void text_input_line::set_cursor_index(size_t index, bool selection){
 		return;
 	}
 	
-	const auto& font = this->get_font().get();
+	const auto& adv = this->get_advances();
 
-	ASSERT(this->firstVisibleCharIndex <= this->get_text().size())
+	ASSERT(this->firstVisibleCharIndex <= this->get_text_ref().size())
 	ASSERT(this->cursorIndex > this->firstVisibleCharIndex)
-	this->cursorPos = font.get_advance(
-			std::u32string(this->get_text(), this->firstVisibleCharIndex, this->cursorIndex - this->firstVisibleCharIndex)
-		) + this->xOffset;
+	this->cursorPos = adv[this->cursorIndex] - adv[this->firstVisibleCharIndex] + this->xOffset;
 	
 	ASSERT(this->cursorPos >= 0)
 	
 	if(this->cursorPos > this->rect().d.x() - cursorWidth_c * this->context->units.dots_per_dp){
 		this->cursorPos = this->rect().d.x() - cursorWidth_c * this->context->units.dots_per_dp;
 		
-		this->xOffset = this->cursorPos; // start from rightmost cursor position
-		this->firstVisibleCharIndex = this->cursorIndex;
-		
-		// calculate advance backwards
-		for(auto i = this->get_text().rbegin() + (this->get_text().size() - this->cursorIndex);
-				this->xOffset > 0;
-				++i
-			)
-		{
-			ASSERT(i != this->get_text().rend())
-			this->xOffset -= font.get_advance(*i);
-			ASSERT(this->firstVisibleCharIndex > 0)
-			--this->firstVisibleCharIndex;
-		}
+		// Find the first visible character, it is the last one which starts at or before
+		// the left edge when the cursor is at its rightmost position.
+		auto i = std::upper_bound(
+				adv.begin(),
+				adv.begin() + this->cursorIndex + 1,
+				adv[this->cursorIndex] - this->cursorPos
+			);
+		this->firstVisibleCharIndex = i == adv.begin() ? 0 : size_t(i - adv.begin()) - 1;
+		this->xOffset = this->cursorPos - (adv[this->cursorIndex] - adv[this->firstVisibleCharIndex]);
 	}
 }
 
 real text_input_line::indexToPos(size_t index){
-	ASSERT(this->firstVisibleCharIndex <= this->get_text().size())
+	ASSERT(this->firstVisibleCharIndex <= this->get_text_ref().size())
 	
 	if(index <= this->firstVisibleCharIndex){
 		return 0;
 	}
 	
 	using std::min;
-	index = min(index, this->get_text().size()); // clamp top
-	
-	real ret = this->xOffset;
+	index = min(index, this->get_text_ref().size()); // clamp top
 	
-	for(auto i = this->get_text().begin() + this->firstVisibleCharIndex;
-			i != this->get_text().end() && index != this->firstVisibleCharIndex;
-			++i, --index
-		)
-	{
-		ret += this->get_font().get().get_advance(*i);
-		if(ret >= this->rect().d.x()){
-			ret = this->rect().d.x();
-			break;
-		}
-	}
-	
-	return ret;
+	const auto& adv = this->get_advances();
+
+	return min(adv[index] - adv[this->firstVisibleCharIndex] + this->xOffset, this->rect().d.x());
 }
 
 size_t text_input_line::posToIndex(real pos){
-	size_t index = this->firstVisibleCharIndex;
-	real p = this->xOffset;
-	
-	for(auto i = this->get_text().begin() + this->firstVisibleCharIndex; i != this->get_text().end(); ++i){
-		real w = this->get_font().get().get_advance(*i);
-		
-		if(pos < p + w){
-			if(pos < p + w / 2){
-				break;
-			}
-			p += w;
-			++index;
-			break;
-		}
-		
-		p += w;
-		++index;
+	const auto& adv = this->get_advances();
+
+	ASSERT(this->firstVisibleCharIndex < adv.size())
+
+	// position relative to the start of the text
+	real p = pos - this->xOffset + adv[this->firstVisibleCharIndex];
+
+	// find the character under the position
+	auto i = std::upper_bound(adv.begin() + this->firstVisibleCharIndex + 1, adv.end(), p);
+	if(i == adv.end()){
+		return this->get_text_ref().size();
 	}
-	
-	return index;
-}
 
+	size_t index = size_t(i - adv.begin()) - 1;
 
-void text_input_line::update(uint32_t dt){
-	this->cursorBlinkVisible = !this->cursorBlinkVisible;
+	// select nearest character boundary
+	if(p < (adv[index] + adv[index + 1]) / 2){
+		return index;
+	}
+	return index + 1;
 }
 
+
 void text_input_line::on_focus_change(){
 	if(this->is_focused()){
 		this->ctrlPressed = false;
 		this->shiftPressed = false;
 		this->startCursorBlinking();
 	}else{
-		this->context->updater->stop(*this);
+		this->cursorBlinking.stop();
 	}
 }
 
@@ -239,11 +257,16 @@ void text_input_line::on_resize(){
 
 
 void text_input_line::startCursorBlinking(){
-	this->context->updater->stop(*this);
-	this->cursorBlinkVisible = true;
-	this->context->updater->start(
-			utki::make_shared_from(*static_cast<updateable*>(this)),
-			cursorBlinkPeriod_c
+	// restarting the animation makes the cursor visible right away,
+	// step easing wakes up the UI only when the cursor is shown or hidden
+	this->context->updater->animator.start(
+			this->cursorBlinking,
+			this->cursorBlinkPhase,
+			0,
+			1,
+			2 * cursorBlinkPeriod_c,
+			animator::easing::step,
+			true
 		);
 }
 
@@ -268,12 +291,12 @@ void text_input_line::on_character_input(const std::u32string& unicode, morda::k
 		case morda::key::enter:
 			break;
 		case morda::key::right:
-			if(this->cursorIndex != this->get_text().size()){
+			if(this->cursorIndex != this->get_text_ref().size()){
 				size_t newIndex;
 				if(this->ctrlPressed){
 					bool spaceSkipped = false;
 					newIndex = this->cursorIndex;
-					for(auto i = this->get_text().begin() + this->cursorIndex; i != this->get_text().end(); ++i, ++newIndex){
+					for(auto i = this->get_text_ref().begin() + this->cursorIndex; i != this->get_text_ref().end(); ++i, ++newIndex){
 						if(*i == uint32_t(' ')){
 							if(spaceSkipped){
 								break;
@@ -295,8 +318,8 @@ void text_input_line::on_character_input(const std::u32string& unicode, morda::k
 				if(this->ctrlPressed){
 					bool spaceSkipped = false;
 					newIndex = this->cursorIndex;
-					for(auto i = this->get_text().rbegin() + (this->get_text().size() - this->cursorIndex);
-							i != this->get_text().rend();
+					for(auto i = this->get_text_ref().rbegin() + (this->get_text_ref().size() - this->cursorIndex);
+							i != this->get_text_ref().rend();
 							++i, --newIndex
 						)
 					{
@@ -315,7 +338,7 @@ void text_input_line::on_character_input(const std::u32string& unicode, morda::k
 			}
 			break;
 		case morda::key::end:
-			this->set_cursor_index(this->get_text().size(), this->shiftPressed);
+			this->set_cursor_index(this->get_text_ref().size(), this->shiftPressed);
 			break;
 		case morda::key::home:
 			this->set_cursor_index(0, this->shiftPressed);
@@ -337,7 +360,7 @@ void text_input_line::on_character_input(const std::u32string& unicode, morda::k
 			if(this->thereIsSelection()){
 				this->set_cursor_index(this->deleteSelection());
 			}else{
-				if(this->cursorIndex < this->get_text().size()){
+				if(this->cursorIndex < this->get_text_ref().size()){
 					auto t = this->get_text();
 					this->clear();
 					t.erase(t.begin() + this->cursorIndex);
@@ -352,7 +375,7 @@ void text_input_line::on_character_input(const std::u32string& unicode, morda::k
 		case morda::key::a:
 			if(this->ctrlPressed){
 				this->selectionStartIndex = 0;
-				this->set_cursor_index(this->get_text().size(), true);
+				this->set_cursor_index(this->get_text_ref().size(), true);
 				break;
 			}
 			// fall through
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <vector>
+
 #include "../widget.hpp"
 #include "../base/text_widget.hpp"
 
-#include "../../updateable.hpp"
+#include "../../animator.hpp"
 #include "../character_input_widget.hpp"
 
 namespace morda{
@@ -14,27 +16,35 @@ namespace morda{
 class text_input_line :
 		public single_line_text_widget,
 		public character_input_widget,
-		public color_widget,
-		private updateable
+		public color_widget
 {
 	size_t firstVisibleCharIndex = 0;
 	real xOffset = 0;
 
-	real cursorPos;
+	real cursorPos = 0;
 
 	size_t cursorIndex = 0;
 
-	real selectionStartPos;
+	real selectionStartPos = 0;
 
 	size_t selectionStartIndex = 0;
 
-	bool cursorBlinkVisible;
+	// cursor is visible during the first half of the blink period
+	real cursorBlinkPhase = 0;
+	animation cursorBlinking;
 
 	bool ctrlPressed;
 	bool shiftPressed;
 
 	bool leftMouseButtonDown = false;
 
+	// advances[i] is the position of the i-th character of the text as rendered with kerning,
+	// the last element is the advance of the whole text, lazily recomputed after the text or font change
+	mutable std::vector<real> advances;
+	mutable bool advances_valid = false;
+
+	const std::vector<real>& get_advances()const;
+
 public:
 	text_input_line(const text_input_line&) = delete;
 	text_input_line& operator=(const text_input_line&) = delete;
@@ -57,12 +67,30 @@ public:
 
 	void on_resize()override;
 
-	void update(uint32_t dt)override;
-
 	void on_character_input(const std::u32string& unicode, morda::key key)override;
 
+	void on_text_change()override;
+
+	void on_font_change()override;
+
 	void set_cursor_index(size_t index, bool selection = false);
 
+	/**
+	 * @brief Get cursor index.
+	 * @return index of the character before which the cursor is placed.
+	 */
+	size_t get_cursor_index()const noexcept{
+		return this->cursorIndex;
+	}
+
+	/**
+	 * @brief Get cursor position.
+	 * @return horizontal position of the cursor within the widget.
+	 */
+	real get_cursor_pos()const noexcept{
+		return this->cursorPos;
+	}
+
 private:
 	void updateCursorPosBasedOnIndex();
 
@@ -15,8 +15,10 @@ void color::render(const morda::matrix4& matrix)const{
 	auto& r = *this->context->renderer;
 	set_simple_alpha_blending(r);
 	
-	morda::matrix4 matr(matrix);
-	matr.scale(this->rect().d);
+	quad_instance q;
+	q.matrix = matrix;
+	q.matrix.scale(this->rect().d);
+	q.color = color_to_vec4f(this->get_current_color());
 
-	r.shader->color_pos->render(matr, *r.pos_quad_01_vao, this->get_current_color());
+	r.render_quads(utki::make_span(&q, 1));
 }
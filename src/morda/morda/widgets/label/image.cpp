@@ -15,26 +15,43 @@ image::image(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 			continue;
 		}
 
-		if(p.value == "image"){
-			this->img = this->context->loader.load<res::image>(get_property_value(p).to_string());
-		}else if(p.value == "disabled_image"){
-			this->disabled_img = this->context->loader.load<res::image>(get_property_value(p).to_string());
-		}else if(p.value == "keep_aspect_ratio"){
-			this->keep_aspect_ratio = get_property_value(p).to_bool();
-		}else if(p.value == "repeat_x"){
-			this->repeat_v.x() = get_property_value(p).to_bool();
-		}else if(p.value == "repeat_y"){
-			this->repeat_v.y() = get_property_value(p).to_bool();
+		switch(property_hash(p.value.to_string())){
+			case property_hash("image"):
+				if(p.value != "image"){
+					break;
+				}
+				this->img = this->context->loader.load<res::image>(get_property_value(p).to_string());
+				break;
+			case property_hash("disabled_image"):
+				if(p.value != "disabled_image"){
+					break;
+				}
+				this->disabled_img = this->context->loader.load<res::image>(get_property_value(p).to_string());
+				break;
+			case property_hash("keep_aspect_ratio"):
+				if(p.value != "keep_aspect_ratio"){
+					break;
+				}
+				this->keep_aspect_ratio = get_property_value(p).to_bool();
+				break;
+			case property_hash("repeat_x"):
+				if(p.value != "repeat_x"){
+					break;
+				}
+				this->repeat_v.x() = get_property_value(p).to_bool();
+				break;
+			case property_hash("repeat_y"):
+				if(p.value != "repeat_y"){
+					break;
+				}
+				this->repeat_v.y() = get_property_value(p).to_bool();
+				break;
+			default:
+				break;
 		}
 	}
 }
 
-namespace{
-const std::array<r4::vector2<float>, 4> quadFanTexCoords = {{
-	r4::vector2<float>(0, 0), r4::vector2<float>(1, 0), r4::vector2<float>(1, 1), r4::vector2<float>(0, 1)
-}};
-}
-
 void image::render(const morda::matrix4& matrix) const{
 	auto img = this->img.get();
 
@@ -48,44 +65,28 @@ void image::render(const morda::matrix4& matrix) const{
 
 	this->set_blending_to_renderer();
 	
-	auto& r = *this->context->renderer;
-	
-	if(!this->texture){
+	if(!this->texture || this->texture_outdated){
+		this->texture_outdated = false;
 		this->texture = img->get(this->rect().d);
-
-		if(this->repeat_v.x() || this->repeat_v.y()){
-			std::array<r4::vector2<float>, 4> texCoords;
-			ASSERT(quadFanTexCoords.size() == texCoords.size())
-			auto src = quadFanTexCoords.cbegin();
-			auto dst = texCoords.begin();
-			auto scale = this->rect().d.comp_div(img->dims());
-			if(!this->repeat_v.x()){
-				scale.x() = 1;
-			}
-			if(!this->repeat_v.y()){
-				scale.y() = 1;
-			}
-			for(; dst != texCoords.end(); ++src, ++dst){
-				*dst = src->comp_mul(scale);
-			}
-			this->vao = r.factory->create_vertex_array(
-					{
-						r.quad_01_vbo,
-						r.factory->create_vertex_buffer(utki::make_span(texCoords))
-					},
-					r.quad_indices,
-					vertex_array::mode::triangle_fan
-				);
-		}else{
-			this->vao = this->context->renderer->pos_tex_quad_01_vao;
-		}
 	}
 	ASSERT(this->texture)
 
-	morda::matrix4 matr(matrix);
-	matr.scale(this->rect().d);
+	quad_instance q;
+	q.matrix = matrix;
+	q.matrix.scale(this->rect().d);
+	q.color = r4::vector4<float>(1);
 
-	this->texture->render(matr, *this->vao);
+	if(this->repeat_v.x() || this->repeat_v.y()){
+		auto scale = this->rect().d.comp_div(img->dims());
+		if(this->repeat_v.x()){
+			q.tex_rect.z() = scale.x();
+		}
+		if(this->repeat_v.y()){
+			q.tex_rect.w() = scale.y();
+		}
+	}
+
+	this->texture->render_quads(utki::make_span(&q, 1));
 }
 
 morda::vector2 image::measure(const morda::vector2& quotum)const{
@@ -174,7 +175,10 @@ void image::set_disabled_image(std::shared_ptr<const res::image> image){
 
 void image::on_resize(){
 	this->widget::on_resize();
-	this->texture.reset();
+
+	// do not release the texture right away, since in case of parallel layout
+	// this method can be called from a layout thread
+	this->texture_outdated = true;
 }
 
 void image::on_enable_change(){
@@ -30,11 +30,12 @@ class image :
 
 	mutable std::shared_ptr<const morda::res::image::texture> texture;
 
+	// the texture needs to be re-created because the widget has been resized
+	mutable bool texture_outdated = false;
+
 	bool keep_aspect_ratio = false;
 
 	r4::vector2<bool> repeat_v = r4::vector2<bool>(false);
-	
-	mutable std::shared_ptr<vertex_array> vao;
 
 public:
 	image(std::shared_ptr<morda::context> c, const treeml::forest& desc);
@@ -0,0 +1,170 @@
+#include "multiline_text.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../../context.hpp"
+#include "../../util/util.hpp"
+
+using namespace morda;
+
+multiline_text::multiline_text(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
+		widget(std::move(c), desc),
+		text_widget(this->context, desc),
+		color_widget(this->context, desc)
+{
+	this->layout.set_font(this->get_font().get());
+
+	for(const auto& p : desc){
+		if(!is_property(p)){
+			continue;
+		}
+
+		switch(property_hash(p.value.to_string())){
+			case property_hash("text"):
+				if(p.value != "text"){
+					break;
+				}
+				this->layout.set_text(utki::to_utf32(get_property_value(p).to_string()));
+				break;
+			case property_hash("wrap"):
+				if(p.value != "wrap"){
+					break;
+				}
+				this->wrap = get_property_value(p).to_bool();
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void multiline_text::set_text(std::u32string&& text){
+	this->layout.set_text(std::move(text));
+	this->invalidate_layout();
+	this->on_text_change();
+}
+
+std::u32string multiline_text::get_text()const{
+	return this->layout.get_text();
+}
+
+void multiline_text::replace_text(size_t begin, size_t end, std::u32string_view str){
+	this->layout.replace(begin, end, str);
+	this->invalidate_layout();
+	this->on_text_change();
+}
+
+void multiline_text::set_wrap(bool wrap){
+	if(this->wrap == wrap){
+		return;
+	}
+	this->wrap = wrap;
+	this->layout.set_max_width(wrap ? this->rect().d.x() : real(-1));
+	this->invalidate_layout();
+}
+
+void multiline_text::on_font_change(){
+	this->layout.set_font(this->get_font().get());
+	this->text_widget::on_font_change();
+}
+
+void multiline_text::on_resize(){
+	if(this->wrap){
+		this->layout.set_max_width(this->rect().d.x());
+	}
+}
+
+vector2 multiline_text::measure(const morda::vector2& quotum)const noexcept{
+	vector2 ret;
+
+	if(quotum.x() < 0){
+		ret.x() = this->layout.get_natural_width();
+	}else{
+		ret.x() = quotum.x();
+	}
+
+	if(quotum.y() < 0){
+		// the layout itself stays wrapped at the widget width, the number of lines is only calculated
+		ret.y() = this->get_font().get().get_height() * this->layout.num_lines(this->wrap ? ret.x() : real(-1));
+	}else{
+		ret.y() = quotum.y();
+	}
+
+	return ret;
+}
+
+void multiline_text::render(const morda::matrix4& matrix)const{
+	const auto& font = this->get_font().get();
+
+	real line_height = font.get_height();
+	size_t num_lines = this->layout.num_lines();
+
+	if(line_height <= 0){
+		return;
+	}
+
+	// find the range of lines which are visible on the screen
+	size_t first_line = 0;
+	size_t end_line = num_lines;
+	{
+		auto top = matrix * vector2(0, 0);
+		real dy = (matrix * vector2(0, 1)).y() - top.y();
+
+		if(dy != 0){
+			real ndc_min = -1;
+			real ndc_max = 1;
+
+			auto& r = *this->context->renderer;
+			if(r.is_scissor_enabled()){
+				auto vp = r.get_viewport();
+				if(vp.d.y() != 0){
+					auto s = r.get_scissor();
+					using std::max;
+					using std::min;
+					ndc_min = max(ndc_min, real(s.p.y()) / real(vp.d.y()) * 2 - 1);
+					ndc_max = min(ndc_max, real(s.p.y() + s.d.y()) / real(vp.d.y()) * 2 - 1);
+				}
+			}
+
+			real y0 = (ndc_min - top.y()) / dy;
+			real y1 = (ndc_max - top.y()) / dy;
+			if(y0 > y1){
+				std::swap(y0, y1);
+			}
+
+			using std::floor;
+			using std::ceil;
+
+			real first = std::max(floor(y0 / line_height), real(0));
+			real end = std::max(ceil(y1 / line_height), real(0));
+
+			first_line = std::min(size_t(first), num_lines);
+			end_line = std::min(size_t(end), num_lines);
+		}
+	}
+
+	using std::round;
+
+	real baseline = round((line_height + font.get_ascender() - font.get_descender()) / 2);
+
+	auto color = morda::color_to_vec4f(this->get_current_color());
+
+	const auto& text = this->layout.get_text();
+
+	for(size_t i = first_line; i < end_line; ++i){
+		auto l = this->layout.get_line(i);
+		if(l.begin == l.end){
+			continue;
+		}
+
+		morda::matrix4 matr(matrix);
+		matr.translate(0, real(i) * line_height + baseline);
+
+		font.render(
+				matr,
+				color,
+				std::u32string_view(text.data() + l.begin, l.end - l.begin)
+			);
+	}
+}
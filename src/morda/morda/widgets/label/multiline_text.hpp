@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string_view>
+
+#include "../widget.hpp"
+#include "../base/text_widget.hpp"
+#include "../base/color_widget.hpp"
+
+#include "../../util/text_layout.hpp"
+
+namespace morda{
+
+/**
+ * @brief Multi-line text label widget.
+ * This widget shows text broken into lines at line feed characters and,
+ * optionally, wrapped at the widget width.
+ * The text layout is cached, so that editing the text lays out only the edited paragraphs
+ * and only the lines visible on the screen are rendered. This makes the widget suitable for showing
+ * big texts, like logs and documents, for example inside of a scroll_area.
+ * From GUI script it can be instantiated as "multiline_text".
+ *
+ * @param text - text to show.
+ * @param wrap - whether to wrap lines at the widget width, true or false. Default value is true.
+ */
+class multiline_text :
+		public text_widget,
+		public color_widget
+{
+	text_layout layout;
+
+	bool wrap = true;
+
+public:
+	multiline_text(std::shared_ptr<morda::context> c, const treeml::forest& desc);
+
+	multiline_text(const multiline_text&) = delete;
+	multiline_text& operator=(const multiline_text&) = delete;
+
+	using text_widget::set_text;
+
+	void set_text(std::u32string&& text)override;
+
+	std::u32string get_text()const override;
+
+	/**
+	 * @brief Replace part of the text.
+	 * Only the paragraphs touched by the edit are laid out again.
+	 * @param begin - index of the first character to replace.
+	 * @param end - index of the character after the last one to replace.
+	 * @param str - string to replace the range with.
+	 */
+	void replace_text(size_t begin, size_t end, std::u32string_view str);
+
+	/**
+	 * @brief Append string to the text.
+	 * @param str - string to append.
+	 */
+	void append_text(std::u32string_view str){
+		auto size = this->layout.get_text().size();
+		this->replace_text(size, size, str);
+	}
+
+	/**
+	 * @brief Set line wrapping mode.
+	 * @param wrap - whether to wrap lines at the widget width.
+	 */
+	void set_wrap(bool wrap);
+
+	bool is_wrap()const noexcept{
+		return this->wrap;
+	}
+
+	/**
+	 * @brief Get text layout.
+	 * Can be used to map between character indices and positions within the widget.
+	 * Line i occupies vertical range [i * h, (i + 1) * h), where h is the font height.
+	 * @return text layout.
+	 */
+	const text_layout& get_layout()const noexcept{
+		return this->layout;
+	}
+
+	vector2 measure(const morda::vector2& quotum)const noexcept override;
+
+	void render(const morda::matrix4& matrix)const override;
+
+	void on_resize()override;
+
+	void on_font_change()override;
+};
+
+}
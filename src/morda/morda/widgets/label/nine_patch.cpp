@@ -105,18 +105,41 @@ nine_patch::nine_patch(std::shared_ptr<morda::context> c, const treeml::forest&
 			continue;
 		}
 
-		if(p.value == "left"){
-			// 'min' is by default, but not allowed to specify explicitly, as well as 'max' and 'fill',
-			// so, use parse_dimension_value().
-			this->borders.left() = parse_dimension_value(get_property_value(p), this->context->units);
-		}else if(p.value == "right"){
-			this->borders.right() = parse_dimension_value(get_property_value(p), this->context->units);
-		}else if(p.value == "top"){
-			this->borders.top() = parse_dimension_value(get_property_value(p), this->context->units);
-		}else if(p.value == "bottom"){
-			this->borders.bottom() = parse_dimension_value(get_property_value(p), this->context->units);
-		}else if(p.value == "center_visible"){
-			this->set_center_visible(get_property_value(p).to_bool());
+		switch(property_hash(p.value.to_string())){
+			case property_hash("left"):
+				if(p.value != "left"){
+					break;
+				}
+				// 'min' is by default, but not allowed to specify explicitly, as well as 'max' and 'fill',
+				// so, use parse_dimension_value().
+				this->borders.left() = parse_dimension_value(get_property_value(p), this->context->units);
+				break;
+			case property_hash("right"):
+				if(p.value != "right"){
+					break;
+				}
+				this->borders.right() = parse_dimension_value(get_property_value(p), this->context->units);
+				break;
+			case property_hash("top"):
+				if(p.value != "top"){
+					break;
+				}
+				this->borders.top() = parse_dimension_value(get_property_value(p), this->context->units);
+				break;
+			case property_hash("bottom"):
+				if(p.value != "bottom"){
+					break;
+				}
+				this->borders.bottom() = parse_dimension_value(get_property_value(p), this->context->units);
+				break;
+			case property_hash("center_visible"):
+				if(p.value != "center_visible"){
+					break;
+				}
+				this->set_center_visible(get_property_value(p).to_bool());
+				break;
+			default:
+				break;
 		}
 	}
 
@@ -4,6 +4,11 @@
 
 using namespace morda;
 
+namespace{
+// half a turn per second
+const uint32_t rotation_period_ms = 2000;
+}
+
 spinner::spinner(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 		widget(std::move(c), desc),
 		image(this->context, desc)
@@ -20,13 +25,20 @@ void spinner::render(const matrix4& matrix)const{
 }
 
 void spinner::set_active(bool active){
+	if(active == this->is_active()){
+		return;
+	}
 	if(active){
-		this->context->updater->start(utki::make_shared_from(*this));
+		this->context->updater->animator.start(
+				this->rotation,
+				this->angle,
+				this->angle,
+				this->angle + utki::deg_to_rad(real(360)),
+				rotation_period_ms,
+				animator::easing::linear,
+				true
+			);
 	}else{
-		this->context->updater->stop(*this);
+		this->rotation.stop();
 	}
 }
-
-void spinner::update(uint32_t dt_ms){
-	angle += utki::deg_to_rad(real(180)) / real(1000) * real(dt_ms);
-}
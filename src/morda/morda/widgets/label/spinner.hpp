@@ -4,7 +4,7 @@
 
 #include "../../res/image.hpp"
 
-#include "../../updateable.hpp"
+#include "../../animator.hpp"
 
 namespace morda{
 
@@ -12,19 +12,25 @@ namespace morda{
  * @brief Spinning image label.
  * @param active - whether the spinner is initially active or not, can be true/false.
  */
-class spinner :
-		public image,
-		public updateable
-{
+class spinner : public image{
 	real angle = 0;
+
+	animation rotation;
 public:
 	spinner(std::shared_ptr<morda::context> c, const treeml::forest& desc);
 
 	void set_active(bool active);
 
+	/**
+	 * @brief Check if the spinner is spinning.
+	 * @return true if the spinner is active.
+	 * @return false otherwise.
+	 */
+	bool is_active()const noexcept{
+		return this->rotation.is_active();
+	}
+
 	void render(const matrix4& matrix)const override;
-private:
-	void update(uint32_t dt_ms)override;
 };
 
 }
@@ -0,0 +1,218 @@
+#include "tiled_image.hpp"
+
+#include <array>
+#include <cmath>
+
+#include "../../context.hpp"
+
+#include "../../util/util.hpp"
+
+using namespace morda;
+
+tiled_image::tiled_image(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
+		widget(std::move(c), desc),
+		blending_widget(this->context, desc)
+{
+	for(const auto& p : desc){
+		if(!is_property(p)){
+			continue;
+		}
+
+		switch(property_hash(p.value.to_string())){
+			case property_hash("image"):
+				if(p.value != "image"){
+					break;
+				}
+				this->img = this->context->loader.load<res::tiled_image>(get_property_value(p).to_string());
+				break;
+			case property_hash("zoom"):
+				if(p.value != "zoom"){
+					break;
+				}
+				this->set_zoom(get_property_value(p).to_float());
+				break;
+			default:
+				break;
+		}
+	}
+
+	this->set_clip_enabled(true);
+}
+
+void tiled_image::set_image(std::shared_ptr<res::tiled_image> image){
+	this->img = std::move(image);
+	this->fallbacks.clear();
+	this->invalidate_layout();
+}
+
+void tiled_image::set_zoom(real zoom){
+	if(zoom <= 0){
+		throw std::invalid_argument("tiled_image::set_zoom(): zoom must be positive");
+	}
+	this->zoom = zoom;
+	this->invalidate_layout();
+}
+
+void tiled_image::zoom_at(const vector2& pos, real factor){
+	auto p = this->offset + pos / this->zoom;
+	this->set_zoom(this->zoom * factor);
+	this->offset = p - pos / this->zoom;
+}
+
+unsigned tiled_image::get_level()const noexcept{
+	if(!this->img){
+		return 0;
+	}
+
+	// coarsest level which still has at least one image pixel per screen pixel
+	using std::log2;
+	using std::floor;
+	real l = floor(-log2(this->zoom));
+	if(l <= 0){
+		return 0;
+	}
+
+	using std::min;
+	return min(unsigned(l), this->img->num_levels() - 1);
+}
+
+morda::vector2 tiled_image::measure(const morda::vector2& quotum)const{
+	vector2 ret(0);
+	if(this->img){
+		ret = this->img->dims().to<real>() * this->zoom;
+	}
+
+	for(unsigned i = 0; i != ret.size(); ++i){
+		if(quotum[i] >= 0){
+			ret[i] = quotum[i];
+		}
+	}
+
+	return ret;
+}
+
+void tiled_image::render(const morda::matrix4& matrix)const{
+	if(!this->img){
+		return;
+	}
+
+	auto& img = *this->img;
+
+	auto& r = *this->context->renderer;
+
+	unsigned level = this->get_level();
+
+	// visible part of the image, in full resolution pixels
+	vector2 visible_begin;
+	vector2 visible_end;
+	{
+		auto end = this->offset + this->rect().d / this->zoom;
+		auto dims = img.dims().to<real>();
+
+		using std::max;
+		using std::min;
+		for(unsigned i = 0; i != visible_begin.size(); ++i){
+			visible_begin[i] = max(this->offset[i], real(0));
+			visible_end[i] = min(end[i], dims[i]);
+			if(visible_begin[i] >= visible_end[i]){
+				this->fallbacks.clear();
+				return;
+			}
+		}
+	}
+
+	this->set_blending_to_renderer();
+
+	// range of visible tiles
+	r4::vector2<unsigned> first;
+	r4::vector2<unsigned> end;
+	{
+		auto num_tiles = img.get_num_tiles(level);
+		real tile_span = real(std::uint64_t(img.tile_size()) << level);
+
+		using std::floor;
+		using std::ceil;
+		using std::min;
+		for(unsigned i = 0; i != first.size(); ++i){
+			first[i] = min(unsigned(floor(visible_begin[i] / tile_span)), num_tiles[i] - 1);
+			end[i] = min(unsigned(ceil(visible_end[i] / tile_span)), num_tiles[i]);
+		}
+	}
+
+	unsigned top_level = img.num_levels() - 1;
+
+	decltype(this->fallbacks) fallbacks;
+
+	for(unsigned y = first.y(); y != end.y(); ++y){
+		for(unsigned x = first.x(); x != end.x(); ++x){
+			r4::vector2<unsigned> index(x, y);
+
+			auto rect = img.get_tile_rect(level, index, true).to<real>();
+
+			morda::matrix4 matr(matrix);
+			matr.translate((rect.p - this->offset) * this->zoom);
+			matr.scale(rect.d * this->zoom);
+
+			if(auto tex = img.get_tile(level, index)){
+				r.shader->pos_tex->render(matr, *r.pos_tex_quad_01_vao, *tex);
+				continue;
+			}
+
+			img.request_tile(level, index);
+
+			// show part of the closest coarser tile which is loaded
+			bool fallback_found = false;
+			for(unsigned a = level + 1; a <= top_level; ++a){
+				r4::vector2<unsigned> ancestor_index(x >> (a - level), y >> (a - level));
+
+				auto tex = img.get_tile(a, ancestor_index);
+				if(!tex){
+					continue;
+				}
+
+				auto key = res::tiled_image::get_tile_key(level, index);
+
+				auto& fb = fallbacks[key];
+
+				auto i = this->fallbacks.find(key);
+				if(i != this->fallbacks.end() && i->second.level == a){
+					fb = std::move(i->second);
+				}else{
+					auto ancestor_rect = img.get_tile_rect(a, ancestor_index, true).to<real>();
+
+					auto tc_begin = (rect.p - ancestor_rect.p).comp_div(ancestor_rect.d);
+					auto tc_end = (rect.x2_y2() - ancestor_rect.p).comp_div(ancestor_rect.d);
+
+					std::array<r4::vector2<float>, 4> tex_coords = {{
+						r4::vector2<float>(tc_begin.x(), tc_begin.y()),
+						r4::vector2<float>(tc_end.x(), tc_begin.y()),
+						r4::vector2<float>(tc_end.x(), tc_end.y()),
+						r4::vector2<float>(tc_begin.x(), tc_end.y())
+					}};
+
+					fb.level = a;
+					fb.vao = r.factory->create_vertex_array(
+							{
+								r.quad_01_vbo,
+								r.factory->create_vertex_buffer(utki::make_span(tex_coords))
+							},
+							r.quad_indices,
+							vertex_array::mode::triangle_fan
+						);
+				}
+
+				r.shader->pos_tex->render(matr, *fb.vao, *tex);
+				fallback_found = true;
+				break;
+			}
+
+			if(!fallback_found && level != top_level){
+				// request the coarsest tile after the tile itself, so that it is loaded first
+				// and the whole area is quickly covered by a low resolution preview
+				img.request_tile(top_level, r4::vector2<unsigned>(x >> (top_level - level), y >> (top_level - level)));
+			}
+		}
+	}
+
+	this->fallbacks = std::move(fallbacks);
+}
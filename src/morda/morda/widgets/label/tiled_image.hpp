@@ -0,0 +1,101 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "../widget.hpp"
+
+#include "../base/blending_widget.hpp"
+
+#include "../../res/tiled_image.hpp"
+
+namespace morda{
+
+/**
+ * @brief Tiled image widget.
+ * This widget displays a part of tiled image resource, which can be panned and zoomed.
+ * Only the tiles visible in the widget are requested for loading, the tiles are taken from the pyramid level
+ * which is closest to the current zoom, but not coarser. While the tile is being loaded,
+ * the corresponding part of a loaded tile from a coarser level is shown in its place.
+ * Widget contents are clipped by the widget boundaries.
+ * From GUI script it can be instantiated as "tiled_image".
+ *
+ * @param image - tiled image resource.
+ * @param zoom - optional, zoom factor, i.e. number of screen pixels per image pixel. Default value is 1.
+ */
+class tiled_image :
+		public virtual widget,
+		public blending_widget
+{
+	std::shared_ptr<res::tiled_image> img;
+
+	real zoom = 1;
+
+	vector2 offset = vector2(0);
+
+	struct fallback{
+		unsigned level;
+		std::shared_ptr<vertex_array> vao;
+	};
+
+	// vertex arrays with texture coordinates of coarser tile parts shown in place of loading tiles,
+	// only the ones used during the last render are kept
+	mutable std::unordered_map<std::uint64_t, fallback> fallbacks;
+
+public:
+	tiled_image(std::shared_ptr<morda::context> c, const treeml::forest& desc);
+
+	tiled_image(const tiled_image&) = delete;
+	tiled_image& operator=(const tiled_image&) = delete;
+
+	void render(const morda::matrix4& matrix)const override;
+
+	/**
+	 * @brief Measure the widget.
+	 * Natural size of the widget is the size of the whole image at the current zoom.
+	 */
+	morda::vector2 measure(const morda::vector2& quotum)const override;
+
+	void set_image(std::shared_ptr<res::tiled_image> image);
+
+	const std::shared_ptr<res::tiled_image>& get_image()const noexcept{
+		return this->img;
+	}
+
+	/**
+	 * @brief Set zoom.
+	 * @param zoom - number of screen pixels per image pixel, must be positive.
+	 */
+	void set_zoom(real zoom);
+
+	real get_zoom()const noexcept{
+		return this->zoom;
+	}
+
+	/**
+	 * @brief Set offset.
+	 * @param offset - point of the full resolution image, in pixels, which is shown at the top left corner of the widget.
+	 */
+	void set_offset(const vector2& offset)noexcept{
+		this->offset = offset;
+	}
+
+	const vector2& get_offset()const noexcept{
+		return this->offset;
+	}
+
+	/**
+	 * @brief Change zoom keeping the image point under given position.
+	 * Useful for zooming with mouse wheel.
+	 * @param pos - position within the widget.
+	 * @param factor - zoom multiplier.
+	 */
+	void zoom_at(const vector2& pos, real factor);
+
+	/**
+	 * @brief Get pyramid level shown at the current zoom.
+	 * @return pyramid level.
+	 */
+	unsigned get_level()const noexcept;
+};
+
+}
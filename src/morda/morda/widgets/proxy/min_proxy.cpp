@@ -12,18 +12,32 @@ min_proxy::min_proxy(std::shared_ptr<morda::context> c, const treeml::forest& de
 		}
 
 		try{
-			if(p.value == "root"){
-				this->root_id = get_property_value(p).to_string();
-			}else if(p.value == "target"){
-				for(const auto& id : p.children){
-					this->target_id.push_back(id.value.to_string());
-				}
+			switch(property_hash(p.value.to_string())){
+				case property_hash("root"):
+					if(p.value != "root"){
+						break;
+					}
+					this->root_id = get_property_value(p).to_string();
+					break;
+				case property_hash("target"):
+					if(p.value != "target"){
+						break;
+					}
+					for(const auto& id : p.children){
+						this->target_id.push_back(id.value.to_string());
+					}
+					break;
+				default:
+					break;
 			}
 		}catch(std::invalid_argument&){
 			TRACE(<< "could not parse value of " << treeml::to_string(p) << std::endl)
 			throw;
 		}
 	}
+
+	// the target is looked up in the whole widget hierarchy
+	this->set_depends_on_outer_layout();
 }
 
 morda::vector2 min_proxy::measure(const vector2& quotum)const{
@@ -48,6 +62,9 @@ morda::vector2 min_proxy::measure(const vector2& quotum)const{
 		ASSERT(root)
 		this->target = utki::make_weak_from(*root);
 		t = this->target.lock();
+
+		// the target is usually not a descendant, so its layout invalidation would not clear the measure caches
+		this->add_layout_dependency(*t);
 	}
 
 	ASSERT(t)
@@ -65,12 +65,23 @@ scroll_bar::scroll_bar(std::shared_ptr<morda::context> c, const treeml::forest&
 			continue;
 		}
 
-		if(p.value == "background"){
-			np->set_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(p).to_string()));
-			background_set = true;
-		}else if(p.value == "nine_patch_of_handle"){
-			hi->set_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(p).to_string()));
-			handle_set = true;
+		switch(property_hash(p.value.to_string())){
+			case property_hash("background"):
+				if(p.value != "background"){
+					break;
+				}
+				np->set_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(p).to_string()));
+				background_set = true;
+				break;
+			case property_hash("nine_patch_of_handle"):
+				if(p.value != "nine_patch_of_handle"){
+					break;
+				}
+				hi->set_nine_patch(this->context->loader.load<res::nine_patch>(get_property_value(p).to_string()));
+				handle_set = true;
+				break;
+			default:
+				break;
 		}
 	}
 
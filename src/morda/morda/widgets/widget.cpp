@@ -6,8 +6,13 @@
 
 #include "container.hpp"
 
+#include <algorithm>
+
 using namespace morda;
 
+thread_local widget::layout_batch* widget::current_layout_batch = nullptr;
+thread_local widget::layout_barrier* widget::current_layout_barrier = nullptr;
+
 widget::widget(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 		context(std::move(c))
 {
@@ -17,27 +22,72 @@ widget::widget(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
 		}
 
 		try{
-			if(p.value == "layout"){
-				this->layout_desc = p.children;
-			}else if(p.value == "x"){
-				this->rectangle.p.x() = parse_dimension_value(get_property_value(p), this->context->units);
-			}else if(p.value == "y"){
-				this->rectangle.p.y() = parse_dimension_value(get_property_value(p), this->context->units);
-			}else if(p.value == "dx"){
-				this->rectangle.d.x() = parse_dimension_value(get_property_value(p), this->context->units);
-			}else if(p.value == "dy"){
-				this->rectangle.d.y() = parse_dimension_value(get_property_value(p), this->context->units);
-			}else if(p.value == "id"){
-				this->id = get_property_value(p).to_string();
-				// TRACE(<< "inflating '" << this->id << "'" << std::endl)
-			}else if(p.value == "clip"){
-				this->clip_enabled = get_property_value(p).to_bool();
-			}else if(p.value == "cache"){
-				this->cache = get_property_value(p).to_bool();
-			}else if(p.value == "visible"){
-				this->visible = get_property_value(p).to_bool();
-			}else if(p.value == "enabled"){
-				this->enabled = get_property_value(p).to_bool();
+			switch(property_hash(p.value.to_string())){
+				case property_hash("layout"):
+					if(p.value != "layout"){
+						break;
+					}
+					if(!p.children.empty()){
+						this->get_rare().layout_desc = p.children;
+					}
+					break;
+				case property_hash("x"):
+					if(p.value != "x"){
+						break;
+					}
+					this->rectangle.p.x() = parse_dimension_value(get_property_value(p), this->context->units);
+					break;
+				case property_hash("y"):
+					if(p.value != "y"){
+						break;
+					}
+					this->rectangle.p.y() = parse_dimension_value(get_property_value(p), this->context->units);
+					break;
+				case property_hash("dx"):
+					if(p.value != "dx"){
+						break;
+					}
+					this->rectangle.d.x() = parse_dimension_value(get_property_value(p), this->context->units);
+					break;
+				case property_hash("dy"):
+					if(p.value != "dy"){
+						break;
+					}
+					this->rectangle.d.y() = parse_dimension_value(get_property_value(p), this->context->units);
+					break;
+				case property_hash("id"):
+					if(p.value != "id"){
+						break;
+					}
+					this->id = get_property_value(p).to_string();
+					// TRACE(<< "inflating '" << this->id << "'" << std::endl)
+					break;
+				case property_hash("clip"):
+					if(p.value != "clip"){
+						break;
+					}
+					this->clip_enabled = get_property_value(p).to_bool();
+					break;
+				case property_hash("cache"):
+					if(p.value != "cache"){
+						break;
+					}
+					this->cache = get_property_value(p).to_bool();
+					break;
+				case property_hash("visible"):
+					if(p.value != "visible"){
+						break;
+					}
+					this->visible = get_property_value(p).to_bool();
+					break;
+				case property_hash("enabled"):
+					if(p.value != "enabled"){
+						break;
+					}
+					this->enabled = get_property_value(p).to_bool();
+					break;
+				default:
+					break;
 			}
 		}catch(std::invalid_argument&){
 			TRACE(<< "could not parse value of " << treeml::to_string(p) << std::endl)
@@ -53,10 +103,21 @@ widget::layout_params::layout_params(const treeml::forest& desc, const morda::un
 		}
 
 		try{
-			if(p.value == "dx"){
-				this->dims.x() = parse_layout_dimension_value(get_property_value(p), units);
-			}else if(p.value == "dy"){
-				this->dims.y() = parse_layout_dimension_value(get_property_value(p), units);
+			switch(property_hash(p.value.to_string())){
+				case property_hash("dx"):
+					if(p.value != "dx"){
+						break;
+					}
+					this->dims.x() = parse_layout_dimension_value(get_property_value(p), units);
+					break;
+				case property_hash("dy"):
+					if(p.value != "dy"){
+						break;
+					}
+					this->dims.y() = parse_layout_dimension_value(get_property_value(p), units);
+					break;
+				default:
+					break;
 			}
 		}catch(std::invalid_argument&){
 			TRACE(<< "could not parse value of " << treeml::to_string(p) << std::endl)
@@ -65,7 +126,7 @@ widget::layout_params::layout_params(const treeml::forest& desc, const morda::un
 	}
 }
 
-std::shared_ptr<widget> widget::try_get_widget(const std::string& id, bool allow_itself)noexcept{
+std::shared_ptr<widget> widget::try_get_widget(const std::string& id, bool allow_itself){
 	if(allow_itself && this->id == id){
 		return utki::make_shared_from(*this);
 	}
@@ -110,7 +171,9 @@ void widget::resize(const morda::vector2& newDims){
 		if(this->relayoutNeeded){
 			this->clear_cache();
 			this->relayoutNeeded = false;
-			this->lay_out();
+			if(!this->defer_lay_out(false)){
+				this->lay_out();
+			}
 		}
 		return;
 	}
@@ -120,7 +183,26 @@ void widget::resize(const morda::vector2& newDims){
 	this->clear_cache();
 	this->rectangle.d = max(newDims, real(0)); // clamp bottom
 	this->relayoutNeeded = false;
-	this->on_resize(); // call virtual method
+	if(!this->defer_lay_out(true)){
+		this->on_resize(); // call virtual method
+	}
+}
+
+bool widget::defer_lay_out(bool resized){
+	auto batch = current_layout_batch;
+	if(!batch || batch->owner != this->parent()){
+		return false;
+	}
+
+	// the child can be resized several times by the container, lay it out only once
+	if(!this->lay_out_deferred){
+		this->lay_out_deferred = true;
+		this->resize_deferred = resized;
+		batch->deferred.push_back(this);
+	}else{
+		this->resize_deferred = this->resize_deferred || resized;
+	}
+	return true;
 }
 
 std::shared_ptr<widget> widget::remove_from_parent(){
@@ -139,14 +221,41 @@ std::shared_ptr<widget> widget::replace_by(std::shared_ptr<widget> w) {
 
 	this->parent()->insert(w, this->parent()->find(*this));
 
-	if(w && w->layout_desc.empty()){
-		w->layout_desc = std::move(this->layout_desc);
+	if(w && !w->layoutParams && (!w->rare || w->rare->layout_desc.empty())){
+		w->layoutParams = std::move(this->layoutParams);
+
+		// the raw layout description is retained along with the parsed layout parameters in case it has
+		// container specific properties, so it is moved as well
+		if(this->rare && !this->rare->layout_desc.empty()){
+			w->get_rare().layout_desc = std::move(this->rare->layout_desc);
+			this->rare->layout_desc = treeml::forest();
+			this->shrink_rare();
+		}
 	}
 
 	return this->remove_from_parent();
 }
 
 void widget::invalidate_layout()noexcept{
+	auto barrier = current_layout_barrier;
+
+	// measure results of all ancestors can depend on this widget, so clear their caches,
+	// even if they are already marked for re-layout, as those could be measured since then
+	for(widget* w = this; w; w = w->parent()){
+		if(barrier && barrier->owner == w){
+			barrier->layout_invalidated = true;
+			break;
+		}
+		w->clear_measure_cache();
+		if(w->rare && !w->rare->layout_dependents.empty()){
+			w->invalidate_layout_dependents(barrier);
+		}
+	}
+
+	if(barrier && barrier->owner == this){
+		return;
+	}
+
 	if(this->relayoutNeeded){
 		return;
 	}
@@ -154,7 +263,77 @@ void widget::invalidate_layout()noexcept{
 	if(this->parent()){
 		this->parent()->invalidate_layout();
 	}
-	this->cache_texture.reset();
+
+	// in case of parallel layout the texture must not be released from the layout thread,
+	// it will be re-created anyway on next render because the cache is marked dirty
+	if(this->rare && !barrier){
+		this->rare->cache_texture.reset();
+		this->shrink_rare();
+	}
+}
+
+namespace{
+// widgets whose layout dependents are being invalidated by the current thread, used to break dependency cycles
+struct invalidating_dependents_entry{
+	const widget* w;
+	const invalidating_dependents_entry* prev;
+};
+thread_local const invalidating_dependents_entry* invalidating_dependents = nullptr;
+}
+
+void widget::invalidate_layout_dependents(layout_barrier* barrier)noexcept{
+	ASSERT(this->rare)
+	auto& deps = this->rare->layout_dependents;
+
+	if(barrier){
+		std::lock_guard<decltype(barrier->mutex)> lock_guard(barrier->mutex);
+		barrier->dependents.insert(barrier->dependents.end(), deps.begin(), deps.end());
+		return;
+	}
+
+	for(auto e = invalidating_dependents; e; e = e->prev){
+		if(e->w == this){
+			return;
+		}
+	}
+
+	invalidating_dependents_entry entry{this, invalidating_dependents};
+	invalidating_dependents = &entry;
+	utki::scope_exit scope_exit([&entry](){
+		invalidating_dependents = entry.prev;
+	});
+
+	// invalidating a dependent does not add or remove dependents, so the list stays the same
+	for(auto& d : deps){
+		if(auto w = d.lock()){
+			w->invalidate_layout();
+		}
+	}
+
+	deps.erase(
+			std::remove_if(
+					deps.begin(),
+					deps.end(),
+					[](const std::weak_ptr<widget>& d){
+						return d.expired();
+					}
+				),
+			deps.end()
+		);
+}
+
+void widget::add_layout_dependency(const widget& w)const{
+	auto self = utki::make_shared_from(*this);
+
+	auto& deps = w.get_rare().layout_dependents;
+	for(auto& d : deps){
+		if(d.lock() == self){
+			return;
+		}
+	}
+
+	// invalidating layout of a dependent widget modifies it, so the dependents are stored as non-const
+	deps.push_back(std::const_pointer_cast<widget>(self));
 }
 
 void widget::renderInternal(const morda::matrix4& matrix)const{
@@ -169,12 +348,14 @@ void widget::renderInternal(const morda::matrix4& matrix)const{
 			bool scissorTestWasEnabled = r.is_scissor_enabled();
 			r.set_scissor_enabled(false);
 
+			auto& cache_texture = this->get_rare().cache_texture;
+
 			// check if can re-use old texture
-			if(!this->cache_texture || this->cache_texture->dims() != this->rect().d){
-				this->cache_texture = this->render_to_texture();
+			if(!cache_texture || cache_texture->dims() != this->rect().d){
+				cache_texture = this->render_to_texture();
 			}else{
-				ASSERT(this->cache_texture->dims() == this->rect().d)
-				this->cache_texture = this->render_to_texture(std::move(this->cache_texture));
+				ASSERT(cache_texture->dims() == this->rect().d)
+				cache_texture = this->render_to_texture(std::move(cache_texture));
 			}
 
 			r.set_scissor_enabled(scissorTestWasEnabled);
@@ -278,11 +459,17 @@ void widget::renderFromCache(const r4::matrix4<float>& matrix) const {
 	matr.scale(this->rect().d);
 
 	auto& r = *this->context->renderer;
-	ASSERT(this->cache_texture)
-	r.shader->pos_tex->render(matr, *r.pos_tex_quad_01_vao, *this->cache_texture);
+	ASSERT(this->rare && this->rare->cache_texture)
+	r.shader->pos_tex->render(matr, *r.pos_tex_quad_01_vao, *this->rare->cache_texture);
 }
 
 void widget::clear_cache(){
+	if(auto barrier = current_layout_barrier){
+		if(barrier->owner == this){
+			barrier->cache_cleared = true;
+			return;
+		}
+	}
 	this->cacheDirty = true;
 	if(this->parent()){
 		this->parent()->clear_cache();
@@ -360,6 +547,27 @@ vector2 widget::measure(const morda::vector2& quotum)const{
 	return ret;
 }
 
+vector2 widget::measure_cached(const vector2& quotum)const{
+	auto& mc = this->measure_cache;
+
+	if(mc[0].quotum == quotum){
+		return mc[0].dims;
+	}
+
+	if(mc[1].quotum == quotum){
+		std::swap(mc[0], mc[1]);
+		return mc[0].dims;
+	}
+
+	auto dims = this->measure(quotum);
+
+	mc[1] = mc[0];
+	mc[0].quotum = quotum;
+	mc[0].dims = dims;
+
+	return dims;
+}
+
 vector2 widget::pos_in_ancestor(vector2 pos, const widget* ancestor){
 	if(ancestor == this || !this->parent()){
 		return pos;
@@ -386,6 +594,34 @@ const widget::layout_params& widget::get_layout_params_const()const{
 	return this->parent()->get_layout_params_const(*this);
 }
 
+widget::rare_data& widget::get_rare()const{
+	if(!this->rare){
+		// while the widget is being inflated its arena is not set yet, but it is the current one
+		arena::scope arena_scope(this->owner_arena ? this->owner_arena : arena::get_current());
+		this->rare = std::make_unique<rare_data>();
+	}
+	return *this->rare;
+}
+
+void widget::shrink_rare()const noexcept{
+	if(this->rare && this->rare->is_empty()){
+		this->rare.reset();
+	}
+}
+
+size_t widget::get_heap_size()const noexcept{
+	size_t ret = this->hovered.heap_size();
+	if(this->rare){
+		ret += sizeof(rare_data);
+		ret += this->rare->layout_desc.capacity() * sizeof(treeml::forest::value_type);
+		ret += this->rare->layout_dependents.capacity() * sizeof(std::weak_ptr<widget>);
+	}
+	if(this->layoutParams){
+		ret += sizeof(layout_params);
+	}
+	return ret;
+}
+
 widget& widget::get_widget(const std::string& id, bool allow_itself){
 	auto w = this->try_get_widget(id, allow_itself);
 	if(!w){
@@ -424,7 +660,7 @@ void widget::set_visible(bool visible){
 
 void widget::set_unhovered(){
 	auto hoverSet = std::move(this->hovered);
-	ASSERT(this->hovered.size() == 0)
+	ASSERT(this->hovered.empty())
 	for(auto h : hoverSet){
 		this->on_hover_change(h);
 	}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <string>
-#include <set>
 #include <memory>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <limits>
 
 #include <utki/shared.hpp>
 #include <utki/types.hpp>
@@ -20,6 +24,9 @@
 #include "../util/key.hpp"
 #include "../util/events.hpp"
 #include "../util/units.hpp"
+#include "../util/arena.hpp"
+#include "../util/small_set.hpp"
+#include "../util/interned_string.hpp"
 
 namespace morda{
 
@@ -45,13 +52,15 @@ class widget : virtual public utki::shared{
 	friend class container;
 	friend class context;
 	friend class gui;
+	friend class inflater;
 public:
 	const std::shared_ptr<morda::context> context;
 
 	/**
 	 * @brief Basic layout parameters.
+	 * Layout parameters of a widget inflated in arena are allocated from the same arena, see inflater::inflate().
 	 */
-	class layout_params{
+	class layout_params : public arena_object{
 	public:
 		/**
 		 * @brief Requests minimal dimensions of the widget.
@@ -93,16 +102,109 @@ public:
 private:
 	container* parent_container = nullptr;
 
-	std::set<unsigned> hovered;
+	// IDs of pointers which hover the widget, normally there is only one pointer
+	small_set<unsigned, 1> hovered;
 
+	morda::rectangle rectangle = {0, 0};
+
+	struct measure_cache_entry{
+		// NaN quotum means the entry is invalid, comparison with NaN always gives false
+		vector2 quotum = vector2(std::numeric_limits<real>::quiet_NaN());
+		vector2 dims;
+	};
+
+	// cache of measure() results for two most recently used quotums
+	mutable std::array<measure_cache_entry, 2> measure_cache;
+
+	void clear_measure_cache()const noexcept{
+		this->measure_cache = decltype(this->measure_cache)();
+	}
+
+	// flags are grouped together to avoid padding between them
 	bool visible = true;
 
 	bool enabled = true;
 
-	morda::rectangle rectangle = {0, 0};
-
 	// clip widgets contents by widget's border if set to true
 	bool clip_enabled = false;
+
+	bool cache = false;
+	mutable bool cacheDirty = true;
+
+	bool relayoutNeeded = true;
+
+	bool isFocused_v = false;
+
+	// set in case the widget or any of its descendants measures widgets from outside of its sub-hierarchy,
+	// see set_depends_on_outer_layout()
+	bool depends_on_outer_layout = false;
+
+	// deferred laying out state, see defer_lay_out()
+	bool lay_out_deferred = false;
+	bool resize_deferred = false;
+
+	// rarely used data is stored out of line to save memory,
+	// the object is allocated only when one of the fields is needed
+	struct rare_data : public arena_object{
+		// raw layout parameters description, it is dropped as soon as layout parameters are parsed,
+		// unless it has container specific properties, see container::get_layout_params_const()
+		treeml::forest layout_desc;
+
+		std::shared_ptr<texture_2d> cache_texture;
+
+		// widgets whose measure() result depends on this widget, see add_layout_dependency()
+		std::vector<std::weak_ptr<widget>> layout_dependents;
+
+		bool is_empty()const noexcept{
+			return this->layout_desc.empty() && !this->cache_texture && this->layout_dependents.empty();
+		}
+	};
+
+	mutable std::unique_ptr<rare_data> rare;
+
+	rare_data& get_rare()const;
+
+	// free the out of line data in case it does not hold anything
+	void shrink_rare()const noexcept;
+
+	// layout parameters are parsed from layout description by parent container on first request
+	mutable std::unique_ptr<layout_params> layoutParams;
+
+	// arena the widget is allocated from, see inflater::inflate(), the out of line data of the widget
+	// is allocated from the same arena. The widget holds the arena alive via its shared_ptr control block.
+	morda::arena* owner_arena = nullptr;
+
+	// Parallel layout support, see container::lay_out_children().
+
+	// children of the container whose laying out is deferred until the container has resized all of its children
+	struct layout_batch{
+		const container* owner;
+
+		// the widgets are added once, the widget's resize_deferred flag tells whether
+		// on_resize() (true) or lay_out() (false) is to be called
+		std::vector<widget*> deferred;
+	};
+	static thread_local layout_batch* current_layout_batch;
+
+	// in case the widget is a child of the container which is currently resizing its children in parallel mode,
+	// then remember the widget in the batch and return true, otherwise return false
+	bool defer_lay_out(bool resized);
+
+	// container whose children are being laid out concurrently, propagation of clear_cache() and
+	// invalidate_layout() calls from its descendants stops at it and is replayed after all the children are laid out
+	struct layout_barrier{
+		const widget* owner;
+		std::atomic<bool> cache_cleared{false};
+		std::atomic<bool> layout_invalidated{false};
+
+		// layout dependents can be in other sub-hierarchies, so those are invalidated after the parallel layout
+		std::mutex mutex;
+		std::vector<std::weak_ptr<widget>> dependents;
+	};
+	static thread_local layout_barrier* current_layout_barrier;
+
+	void invalidate_layout_dependents(layout_barrier* barrier)noexcept;
+
 public:
 	/**
 	 * @brief Check if scissor test is enabled for this widget.
@@ -122,10 +224,6 @@ public:
 	}
 
 private:
-	bool cache = false;
-	mutable bool cacheDirty = true;
-	mutable std::shared_ptr<texture_2d> cache_texture;
-
 	void renderFromCache(const r4::matrix4<float>& matrix)const;
 
 protected:
@@ -141,6 +239,10 @@ public:
 	 */
 	void set_cache(bool enabled)noexcept{
 		this->cache = enabled;
+		if(!enabled && this->rare){
+			this->rare->cache_texture.reset();
+			this->shrink_rare();
+		}
 	}
 
 	/**
@@ -152,14 +254,20 @@ public:
 	 */
 	std::shared_ptr<texture_2d> render_to_texture(std::shared_ptr<texture_2d> reuse = nullptr)const;
 
-private:
-	bool relayoutNeeded = true;
-
-	treeml::forest layout_desc;
-
-	mutable std::unique_ptr<layout_params> layoutParams;
 public:
-	std::string id;
+	/**
+	 * @brief Widget ID.
+	 * IDs are interned, so all widgets with the same ID share the same string object.
+	 */
+	interned_string id;
+
+	/**
+	 * @brief Get amount of heap memory owned by this widget.
+	 * This only accounts memory allocated by the base widget class, i.e. layout parameters,
+	 * hover state and out of line data. Memory allocated by subclasses is not accounted.
+	 * @return number of bytes allocated on heap.
+	 */
+	virtual size_t get_heap_size()const noexcept;
 
 	/**
 	 * @brief Get layout parameters of the widget.
@@ -236,7 +344,7 @@ public:
 	 * @return false otherwise.
 	 */
 	bool is_hovered()const noexcept{
-		return this->hovered.size() != 0;
+		return !this->hovered.empty();
 	}
 
 	/**
@@ -246,7 +354,7 @@ public:
 	 * @return false otherwise.
 	 */
 	bool is_hovered(unsigned pointer_id)const noexcept{
-		return this->hovered.find(pointer_id) != this->hovered.end();
+		return this->hovered.contains(pointer_id);
 	}
 
 private:
@@ -321,7 +429,7 @@ public:
 	 * @return pointer to the widget if found.
 	 * @return nullptr if there is no widget with given id found.
 	 */
-	virtual std::shared_ptr<widget> try_get_widget(const std::string& id, bool allow_itself = true)noexcept;
+	virtual std::shared_ptr<widget> try_get_widget(const std::string& id, bool allow_itself = true);
 
 	/**
 	 * @brief Try get widget by id.
@@ -332,7 +440,7 @@ public:
 	 * @return nullptr if there is no widget with given id found or if the widget could not be cast to specified class.
 	 */
 	template <typename T>
-	std::shared_ptr<T> try_get_widget_as(const std::string& id, bool allow_itself = true)noexcept{
+	std::shared_ptr<T> try_get_widget_as(const std::string& id, bool allow_itself = true){
 		return std::dynamic_pointer_cast<T>(this->try_get_widget(id, allow_itself));
 	}
 
@@ -428,8 +536,6 @@ private:
 private:
 	void onKeyInternal(bool isDown, key keyCode);
 
-private:
-	bool isFocused_v = false;
 public:
 
 	/**
@@ -524,6 +630,40 @@ public:
 	 */
 	virtual vector2 measure(const vector2& quotum)const;
 
+	/**
+	 * @brief Measure how big a widget wants to be, using cached result if possible.
+	 * Same as measure(), but the results are memoized by the quotum value. The cache is cleared when
+	 * invalidate_layout() is called on this widget or any of its descendants, so widgets must call
+	 * invalidate_layout() whenever their state which affects the measure() result changes.
+	 * Containers should use this method for measuring their children.
+	 * @param quotum - space available to widget. If value is negative then a minimum size needed for proper widget drawing is assumed.
+	 * @return Measured desired widget dimensions.
+	 */
+	vector2 measure_cached(const vector2& quotum)const;
+
+protected:
+	/**
+	 * @brief Make layout of this widget depend on the layout of another widget.
+	 * Normally, measure() result of a widget depends only on the widget itself and its descendants.
+	 * In case it also depends on some other widget, this method has to be called, so that invalidating layout
+	 * of the other widget, or any of its descendants, also invalidates layout of this widget, see invalidate_layout().
+	 * Calling it several times for the same widget has no effect.
+	 * @param w - widget which this widget depends on.
+	 */
+	void add_layout_dependency(const widget& w)const;
+
+	/**
+	 * @brief Mark the widget as not safe for concurrent layout.
+	 * Must be called by widgets which measure widgets from outside of their sub-hierarchy,
+	 * or which inflate or add children from lay_out() or on_resize(), like list widgets do.
+	 * Sub-hierarchies containing such widgets are never laid out concurrently with other widgets,
+	 * see container::lay_out_children().
+	 * Must be called before the widget is added to a container, normally from the constructor.
+	 */
+	void set_depends_on_outer_layout()noexcept{
+		this->depends_on_outer_layout = true;
+	}
+
 public:
 	/**
 	 * @brief Show/hide widget.
@@ -0,0 +1,200 @@
+#include "../../../src/morda/morda/animator.hpp"
+
+#include <utki/debug.hpp>
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+namespace{
+bool is_near(morda::real a, morda::real b){
+	return std::abs(a - b) < morda::real(1e-4);
+}
+}
+
+int main(int argc, char** argv){
+	// linear animation ends and calls end handler
+	{
+		morda::animator a;
+
+		morda::real value = -1;
+		morda::animation anim;
+		unsigned num_ended = 0;
+
+		a.start(anim, value, 10, 20, 100, morda::animator::easing::linear, false, [&num_ended](){++num_ended;});
+		ASSERT_ALWAYS(anim.is_active())
+		ASSERT_ALWAYS(a.size() == 1)
+		ASSERT_ALWAYS(value == 10)
+
+		auto t0 = a.get_frame_time();
+
+		a.advance(t0 + 25);
+		ASSERT_INFO_ALWAYS(is_near(value, 12.5), "value = " << value)
+		ASSERT_ALWAYS(a.get_frame_time() == t0 + 25)
+
+		a.advance(t0 + 50);
+		ASSERT_INFO_ALWAYS(is_near(value, 15), "value = " << value)
+		ASSERT_ALWAYS(num_ended == 0)
+
+		a.advance(t0 + 150);
+		ASSERT_ALWAYS(value == 20)
+		ASSERT_ALWAYS(num_ended == 1)
+		ASSERT_ALWAYS(!anim.is_active())
+		ASSERT_ALWAYS(!a.is_active())
+
+		a.advance(t0 + 200);
+		ASSERT_ALWAYS(num_ended == 1)
+	}
+
+	// looped animation wraps around
+	{
+		morda::animator a;
+
+		morda::real value = 0;
+		morda::animation anim;
+
+		a.start(anim, value, 0, 1, 100, morda::animator::easing::linear, true);
+
+		auto t0 = a.get_frame_time();
+
+		a.advance(t0 + 250);
+		ASSERT_INFO_ALWAYS(is_near(value, 0.5), "value = " << value)
+		ASSERT_ALWAYS(anim.is_active())
+
+		a.advance(t0 + 1030);
+		ASSERT_INFO_ALWAYS(is_near(value, 0.3), "value = " << value)
+
+		anim.stop();
+		ASSERT_ALWAYS(!a.is_active())
+	}
+
+	// easing
+	{
+		morda::animator a;
+
+		morda::real in = 0, out = 0, in_out = 0;
+		morda::animation anim_in, anim_out, anim_in_out;
+
+		a.start(anim_in, in, 0, 1, 100, morda::animator::easing::ease_in);
+		a.start(anim_out, out, 0, 1, 100, morda::animator::easing::ease_out);
+		a.start(anim_in_out, in_out, 0, 1, 100, morda::animator::easing::ease_in_out);
+
+		auto t0 = a.get_frame_time();
+
+		a.advance(t0 + 25);
+		ASSERT_INFO_ALWAYS(is_near(in, 0.0625), "in = " << in)
+		ASSERT_INFO_ALWAYS(is_near(out, 0.4375), "out = " << out)
+		ASSERT_INFO_ALWAYS(is_near(in_out, 0.125), "in_out = " << in_out)
+
+		a.advance(t0 + 75);
+		ASSERT_INFO_ALWAYS(is_near(in_out, 0.875), "in_out = " << in_out)
+	}
+
+	// removing animations from the middle, destroying handles, restarting
+	{
+		morda::animator a;
+
+		morda::real v1 = 0, v2 = 0, v3 = 0;
+		morda::animation anim1, anim3;
+		auto anim2 = std::make_unique<morda::animation>();
+
+		a.start(anim1, v1, 0, 100, 100);
+		a.start(*anim2, v2, 0, 200, 100);
+		a.start(anim3, v3, 0, 300, 100);
+		ASSERT_ALWAYS(a.size() == 3)
+
+		auto t0 = a.get_frame_time();
+
+		anim2.reset();
+		ASSERT_ALWAYS(a.size() == 2)
+
+		a.advance(t0 + 50);
+		ASSERT_ALWAYS(is_near(v1, 50))
+		ASSERT_ALWAYS(v2 == 0)
+		ASSERT_ALWAYS(is_near(v3, 150))
+
+		// restarting replaces the running animation
+		a.start(anim1, v1, 100, 0, 100);
+		ASSERT_ALWAYS(a.size() == 2)
+		ASSERT_ALWAYS(v1 == 100)
+
+		a.advance(t0 + 100);
+		ASSERT_ALWAYS(is_near(v1, 50))
+		ASSERT_ALWAYS(v3 == 300)
+		ASSERT_ALWAYS(!anim3.is_active())
+		ASSERT_ALWAYS(a.size() == 1)
+	}
+
+	// end handler starts new animation
+	{
+		morda::animator a;
+
+		morda::real value = 0;
+		morda::animation anim;
+		std::string log;
+
+		a.start(anim, value, 0, 1, 10, morda::animator::easing::linear, false, [&](){
+			log += "1";
+			a.start(anim, value, 1, 0, 10, morda::animator::easing::linear, false, [&](){
+				log += "2";
+			});
+		});
+
+		auto t0 = a.get_frame_time();
+
+		a.advance(t0 + 10);
+		ASSERT_ALWAYS(log == "1")
+		ASSERT_ALWAYS(anim.is_active())
+		ASSERT_ALWAYS(value == 1)
+
+		a.advance(t0 + 20);
+		ASSERT_INFO_ALWAYS(log == "12", "log = " << log)
+		ASSERT_ALWAYS(value == 0)
+		ASSERT_ALWAYS(!a.is_active())
+	}
+
+	// step easing changes the value at half of the duration, updates are only needed at the steps
+	{
+		morda::animator a;
+
+		morda::real value = 0;
+		morda::animation anim;
+
+		a.start(anim, value, 0, 1, 1000, morda::animator::easing::step, true);
+
+		auto t0 = a.get_frame_time();
+		ASSERT_ALWAYS(a.get_next_update_delay() == 500)
+
+		a.advance(t0 + 499);
+		ASSERT_ALWAYS(value == 0)
+		ASSERT_ALWAYS(a.get_next_update_delay() == 1)
+
+		a.advance(t0 + 500);
+		ASSERT_ALWAYS(value == 1)
+		ASSERT_ALWAYS(a.get_next_update_delay() == 500)
+
+		a.advance(t0 + 1200);
+		ASSERT_ALWAYS(value == 0)
+		ASSERT_INFO_ALWAYS(a.get_next_update_delay() == 300, "delay = " << a.get_next_update_delay())
+
+		// continuous animation needs updates every frame
+		morda::real other = 0;
+		morda::animation other_anim;
+		a.start(other_anim, other, 0, 1, 1000);
+		ASSERT_ALWAYS(a.get_next_update_delay() == a.get_frame_period())
+	}
+
+	// destroying animator stops animations
+	{
+		morda::animation anim;
+		morda::real value = 0;
+		{
+			morda::animator a;
+			a.start(anim, value, 0, 1, 100);
+			ASSERT_ALWAYS(anim.is_active())
+		}
+		ASSERT_ALWAYS(!anim.is_active())
+	}
+
+	return 0;
+}
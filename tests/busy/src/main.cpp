@@ -49,7 +49,7 @@ public:
 			auto& button = c->get_widget_as<morda::push_button>("refresh_toggle_button");
 			button.click_handler = [spinner](morda::push_button& b){
 				if(auto s = spinner.lock()){
-					s->set_active(!s->is_updating());
+					s->set_active(!s->is_active());
 				}
 			};
 		}
@@ -0,0 +1,227 @@
+#include "../../../src/morda/morda/gui.hpp"
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+namespace{
+class counting_container : public morda::container{
+public:
+	unsigned num_children_changes = 0;
+
+	counting_container(std::shared_ptr<morda::context> c) :
+			morda::widget(c, treeml::forest()),
+			morda::container(std::move(c), treeml::forest())
+	{}
+
+	void on_children_change()override{
+		++this->num_children_changes;
+		this->container::on_children_change();
+	}
+};
+
+class counting_widget : public morda::widget{
+public:
+	unsigned num_parent_changes = 0;
+
+	// parent at the moment of the last parent change notification
+	const morda::container* notified_parent = nullptr;
+
+	// number of parent's children at the moment of the last parent change notification
+	size_t notified_num_siblings = 0;
+
+	counting_widget(std::shared_ptr<morda::context> c, const std::string& id) :
+			morda::widget(std::move(c), treeml::read(("id{" + id + "}").c_str()))
+	{}
+
+	void on_parent_change()override{
+		++this->num_parent_changes;
+		this->notified_parent = this->parent();
+		if(this->notified_parent){
+			this->notified_num_siblings = this->notified_parent->children().size();
+		}
+	}
+};
+}
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	auto c = std::make_shared<counting_container>(m.context);
+	c->set_id_index_enabled(true);
+
+	// populate in one edit
+	const unsigned num_widgets = 1000;
+	std::vector<std::shared_ptr<counting_widget>> widgets;
+	{
+		morda::container::edit e(*c);
+
+		// children list is locked during the edit
+		{
+			bool thrown = false;
+			try{
+				c->push_back(std::make_shared<morda::widget>(m.context, treeml::forest()));
+			}catch(std::logic_error&){
+				thrown = true;
+			}
+			ASSERT_ALWAYS(thrown)
+		}
+
+		// insert at front
+		for(unsigned i = 0; i != num_widgets; ++i){
+			widgets.push_back(std::make_shared<counting_widget>(m.context, std::to_string(i)));
+			e.insert(widgets.back(), e.begin());
+		}
+
+		// inserting the same widget twice is not allowed
+		{
+			bool thrown = false;
+			try{
+				e.push_back(widgets.front());
+			}catch(std::invalid_argument&){
+				thrown = true;
+			}
+			ASSERT_ALWAYS(thrown)
+		}
+
+		// nothing is applied before commit
+		ASSERT_ALWAYS(c->children().empty())
+		ASSERT_ALWAYS(widgets.front()->num_parent_changes == 0)
+		ASSERT_ALWAYS(c->num_children_changes == 0)
+
+		e.commit();
+	}
+
+	ASSERT_ALWAYS(c->num_children_changes == 1)
+	ASSERT_ALWAYS(c->children().size() == num_widgets)
+	ASSERT_ALWAYS(c->children().front() == widgets.back())
+	ASSERT_ALWAYS(c->children().back() == widgets.front())
+	for(auto& w : widgets){
+		ASSERT_ALWAYS(w->parent() == c.get())
+		ASSERT_ALWAYS(w->num_parent_changes == 1)
+		ASSERT_ALWAYS(w->notified_parent == c.get())
+		ASSERT_ALWAYS(w->notified_num_siblings == num_widgets)
+	}
+	ASSERT_ALWAYS(c->try_get_widget("500") == widgets[500])
+
+	// remove, reorder and insert in one edit
+	{
+		morda::container::edit e(*c);
+		ASSERT_ALWAYS(e.size() == num_widgets)
+
+		// remove even widgets
+		for(auto i = e.begin(); i != e.end();){
+			auto id = std::stoul((*i)->id.to_string());
+			if(id % 2 == 0){
+				i = e.erase(i);
+			}else{
+				++i;
+			}
+		}
+
+		// move last widget to front
+		auto last = std::prev(e.end());
+		auto moved = *last;
+		ASSERT_ALWAYS(e.change_child_z_position(last, e.begin()) == e.begin())
+
+		auto added = std::make_shared<counting_widget>(m.context, "added");
+		e.push_back(added);
+
+		// inserted and then erased widget is not added
+		auto discarded = std::make_shared<counting_widget>(m.context, "discarded");
+		e.erase(e.push_back(discarded));
+
+		e.commit();
+
+		ASSERT_ALWAYS(c->num_children_changes == 2)
+		ASSERT_ALWAYS(c->children().size() == num_widgets / 2 + 1)
+		ASSERT_ALWAYS(c->children().front() == moved)
+		ASSERT_ALWAYS(c->children().back() == added)
+		ASSERT_ALWAYS(added->parent() == c.get())
+		ASSERT_ALWAYS(added->num_parent_changes == 1)
+		ASSERT_ALWAYS(!discarded->parent())
+		ASSERT_ALWAYS(discarded->num_parent_changes == 0)
+
+		// committed edit cannot be used
+		bool thrown = false;
+		try{
+			e.commit();
+		}catch(std::logic_error&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	for(unsigned i = 0; i != num_widgets; ++i){
+		auto& w = widgets[i];
+		if(i % 2 == 0){
+			ASSERT_ALWAYS(!w->parent())
+			ASSERT_ALWAYS(w->num_parent_changes == 2)
+			ASSERT_ALWAYS(!w->notified_parent)
+			ASSERT_ALWAYS(!c->try_get_widget(std::to_string(i)))
+		}else{
+			ASSERT_ALWAYS(w->parent() == c.get())
+			ASSERT_ALWAYS(w->num_parent_changes == 1)
+			ASSERT_ALWAYS(c->try_get_widget(std::to_string(i)) == w)
+		}
+	}
+	ASSERT_ALWAYS(c->try_get_widget("added"))
+
+	// edit which is not committed is discarded and unlocks the children list
+	{
+		morda::container::edit e(*c);
+		e.clear();
+	}
+	ASSERT_ALWAYS(c->children().size() == num_widgets / 2 + 1)
+	ASSERT_ALWAYS(c->num_children_changes == 2)
+	c->push_back(std::make_shared<morda::widget>(m.context, treeml::forest()));
+	ASSERT_ALWAYS(c->num_children_changes == 3)
+
+	// iterators of other edits are not accepted
+	{
+		auto other = std::make_shared<counting_container>(m.context);
+		other->push_back(std::make_shared<morda::widget>(m.context, treeml::forest()));
+
+		morda::container::edit e(*c);
+		morda::container::edit other_e(*other);
+
+		auto w = std::make_shared<morda::widget>(m.context, treeml::forest());
+
+		bool thrown = false;
+		try{
+			e.insert(w, other_e.begin());
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		// the widget can be inserted after the failed attempt
+		e.insert(w, e.begin());
+
+		thrown = false;
+		try{
+			e.change_child_z_position(e.begin(), other_e.end());
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		// erased widget's iterator is invalid
+		auto erased = e.begin();
+		e.erase(erased);
+		thrown = false;
+		try{
+			e.erase(erased);
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/fonts/glyph_cache_file.hpp"
+#include "../../../src/morda/morda/fonts/texture_font.hxx"
+
+#include <utki/debug.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+int main(int argc, char** argv){
+	const std::string cache_path = "out/test.glyphs";
+
+	const std::uint64_t font_hash = morda::glyph_cache_file::hash(utki::make_span(std::vector<std::uint8_t>{1, 2, 3}));
+	const unsigned pixel_size = 13;
+
+	std::vector<std::uint8_t> bitmap_a = {1, 2, 3, 4, 5, 6};
+	std::vector<std::uint8_t> bitmap_b = {7, 8, 9, 10};
+	std::vector<std::uint8_t> bitmap_dup = {0xff};
+
+	// write glyphs in unsorted order, with duplicate character, space glyph and missing glyph
+	{
+		std::vector<morda::glyph_cache_file::glyph> glyphs;
+
+		morda::glyph_cache_file::glyph g;
+		g.c = U'b';
+		g.is_missing = false;
+		g.top_left = morda::vector2(1, -2);
+		g.bottom_right = morda::vector2(3, 0);
+		g.advance = 4.5f;
+		g.dims = r4::vector2<unsigned>(2, 2);
+		g.alpha = utki::make_span(bitmap_b);
+		glyphs.push_back(g);
+
+		g.c = U'a';
+		g.dims = r4::vector2<unsigned>(3, 2);
+		g.alpha = utki::make_span(bitmap_a);
+		glyphs.push_back(g);
+
+		g.c = U'b';
+		g.dims = r4::vector2<unsigned>(1, 1);
+		g.alpha = utki::make_span(bitmap_dup);
+		glyphs.push_back(g);
+
+		g.c = U' ';
+		g.top_left = morda::vector2(0);
+		g.bottom_right = morda::vector2(0);
+		g.advance = 3;
+		g.dims = r4::vector2<unsigned>(0);
+		g.alpha = nullptr;
+		glyphs.push_back(g);
+
+		g.c = 0x4e00;
+		g.is_missing = true;
+		glyphs.push_back(g);
+
+		papki::fs_file dst(cache_path);
+		morda::glyph_cache_file::write(dst, font_hash, pixel_size, utki::make_span(glyphs));
+	}
+
+	// read back
+	{
+		morda::glyph_cache_file cache(cache_path, font_hash, pixel_size);
+
+		ASSERT_INFO_ALWAYS(cache.get_glyphs().size() == 4, "size = " << cache.get_glyphs().size())
+
+		auto a = cache.find(U'a');
+		ASSERT_ALWAYS(a)
+		ASSERT_ALWAYS(!a->is_missing)
+		ASSERT_ALWAYS(a->top_left == morda::vector2(1, -2))
+		ASSERT_ALWAYS(a->bottom_right == morda::vector2(3, 0))
+		ASSERT_ALWAYS(a->advance == 4.5f)
+		ASSERT_ALWAYS(a->dims == r4::vector2<unsigned>(3, 2))
+		ASSERT_ALWAYS(std::vector<std::uint8_t>(a->alpha.begin(), a->alpha.end()) == bitmap_a)
+
+		// first one of the duplicates is written
+		auto b = cache.find(U'b');
+		ASSERT_ALWAYS(b)
+		ASSERT_ALWAYS(std::vector<std::uint8_t>(b->alpha.begin(), b->alpha.end()) == bitmap_b)
+
+		auto space = cache.find(U' ');
+		ASSERT_ALWAYS(space)
+		ASSERT_ALWAYS(space->alpha.empty())
+		ASSERT_ALWAYS(space->advance == 3)
+
+		auto missing = cache.find(0x4e00);
+		ASSERT_ALWAYS(missing)
+		ASSERT_ALWAYS(missing->is_missing)
+
+		ASSERT_ALWAYS(!cache.find(U'c'))
+	}
+
+	// cache made for different font or size is rejected
+	for(auto p : {std::make_pair(font_hash + 1, pixel_size), std::make_pair(font_hash, pixel_size + 1)}){
+		bool thrown = false;
+		try{
+			morda::glyph_cache_file cache(cache_path, p.first, p.second);
+		}catch(std::runtime_error&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	// truncated cache is rejected
+	{
+		papki::fs_file fi(cache_path);
+		auto data = fi.load();
+		data.resize(data.size() - 1);
+
+		bool thrown = false;
+		try{
+			morda::glyph_cache_file cache(std::move(data), font_hash, pixel_size);
+		}catch(std::runtime_error&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	// number of rasterized glyph bitmaps kept by the font is limited
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		const unsigned max_cached = 10;
+		const unsigned font_size = 16;
+
+		papki::fs_file font_file("../../res/morda_res/fonts/Vera.ttf");
+		morda::texture_font f(m.context, font_file, font_size, max_cached);
+
+		morda::matrix4 matr;
+		matr.set_identity();
+
+		for(char32_t c = U'A'; c <= U'Z'; ++c){
+			f.render(matr, r4::vector4<float>(1), std::u32string(1, c));
+		}
+
+		size_t cpu = 0;
+		size_t gpu = 0;
+		f.get_memory_usage(cpu, gpu);
+
+		size_t bitmaps_size = cpu - font_file.load().size();
+		ASSERT_INFO_ALWAYS(bitmaps_size <= max_cached * 2 * font_size * 2 * font_size, "bitmaps_size = " << bitmaps_size)
+
+		// only the cached bitmaps are saved
+		const std::string font_cache_path = "out/font.glyphs";
+		{
+			papki::fs_file dst(font_cache_path);
+			f.save_glyph_cache(dst);
+		}
+
+		morda::glyph_cache_file cache(font_cache_path, morda::glyph_cache_file::hash(utki::make_span(font_file.load())), font_size);
+		ASSERT_INFO_ALWAYS(cache.get_glyphs().size() == max_cached, "size = " << cache.get_glyphs().size())
+		ASSERT_ALWAYS(cache.find(U'Z'))
+		ASSERT_ALWAYS(!cache.find(U'A'))
+	}
+
+	return 0;
+}
@@ -9,18 +9,57 @@ public:
 	fake_texture_2d() : morda::texture_2d(morda::vector2(13, 666)){}
 };
 
+class fake_vertex_buffer : public morda::vertex_buffer{
+public:
+	fake_vertex_buffer(size_t size) : morda::vertex_buffer(size){}
+};
+
+class fake_index_buffer : public morda::index_buffer{};
+
+class fake_frame_buffer : public morda::frame_buffer{
+public:
+	fake_frame_buffer(std::shared_ptr<morda::texture_2d> color) : morda::frame_buffer(std::move(color)){}
+};
+
+class fake_shader : public morda::shader{
+public:
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va)const override{}
+};
+
+class fake_texturing_shader : public morda::texturing_shader{
+public:
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, const morda::texture_2d& tex)const override{}
+};
+
+class fake_coloring_shader : public morda::coloring_shader{
+public:
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color)const override{}
+};
+
+class fake_coloring_texturing_shader : public morda::coloring_texturing_shader{
+public:
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color, const morda::texture_2d& tex)const override{}
+};
+
 class FakeFactory : public morda::render_factory{
 public:
 	std::shared_ptr<morda::frame_buffer> create_framebuffer(std::shared_ptr<morda::texture_2d> color)override{
-		return nullptr;
+		return std::make_shared<fake_frame_buffer>(std::move(color));
 	}
 
 	std::shared_ptr<morda::index_buffer> create_index_buffer(utki::span<const std::uint16_t> indices)override{
-		return nullptr;
+		return std::make_shared<fake_index_buffer>();
 	}
 
 	std::unique_ptr<morda::render_factory::shaders> create_shaders() override{
-		return nullptr;
+		auto ret = std::make_unique<morda::render_factory::shaders>();
+		ret->pos_tex = std::make_unique<fake_texturing_shader>();
+		ret->color_pos = std::make_unique<fake_coloring_shader>();
+		ret->color_pos_lum = std::make_unique<fake_coloring_shader>();
+		ret->pos_clr = std::make_unique<fake_shader>();
+		ret->color_pos_tex = std::make_unique<fake_coloring_texturing_shader>();
+		ret->color_pos_sdf = std::make_unique<fake_coloring_texturing_shader>();
+		return ret;
 	}
 
 	std::shared_ptr<morda::texture_2d> create_texture_2d(morda::texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data)override{
@@ -33,46 +72,46 @@ public:
 			morda::vertex_array::mode rendering_mode
 		)override
 	{
-		return nullptr;
+		return std::make_shared<morda::vertex_array>(std::move(buffers), std::move(indices), rendering_mode);
 	}
 
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const float> vertices)override{
-		return nullptr;
+		return std::make_shared<fake_vertex_buffer>(vertices.size());
 	}
 
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector2<float>> vertices)override{
-		return nullptr;
+		return std::make_shared<fake_vertex_buffer>(vertices.size());
 	}
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector3<float>> vertices)override{
-		return nullptr;
+		return std::make_shared<fake_vertex_buffer>(vertices.size());
 	}
 
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices)override{
-		return nullptr;
+		return std::make_shared<fake_vertex_buffer>(vertices.size());
 	}
 
 };
 
 class FakeRenderer : public morda::renderer{
 public:
-	FakeRenderer() :
-			morda::renderer(std::make_unique<FakeFactory>(), params())
+	FakeRenderer(std::unique_ptr<morda::render_factory> factory = std::make_unique<FakeFactory>()) :
+			morda::renderer(std::move(factory), params())
 	{}
 
 	void clear_framebuffer()override{}
-	r4::rectangle<int> get_scissor()const override{
+	r4::rectangle<int> get_scissor_internal()const override{
 		return r4::rectangle<int>(0, 0);
 	}
-	r4::rectangle<int> get_viewport()const override{
+	r4::rectangle<int> get_viewport_internal()const override{
 		return r4::rectangle<int>(0, 0);
 	}
-	bool is_scissor_enabled()const override{
+	bool is_scissor_enabled_internal()const override{
 		return false;
 	}
-	void set_blend_enabled(bool enable)override{}
-	void set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override{}
+	void set_blend_enabled_internal(bool enable)override{}
+	void set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override{}
 	void set_framebuffer_internal(morda::frame_buffer* fb)override{}
-	void set_scissor_enabled(bool enabled)override{}
-	void set_scissor(r4::rectangle<int> r)override{}
-	void set_viewport(r4::rectangle<int> r)override{}
+	void set_scissor_enabled_internal(bool enabled)override{}
+	void set_scissor_internal(r4::rectangle<int> r)override{}
+	void set_viewport_internal(r4::rectangle<int> r)override{}
 };
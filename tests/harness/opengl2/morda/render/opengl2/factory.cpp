@@ -11,25 +11,134 @@
 #include "shader_color.hpp"
 #include "shader_pos_clr.hpp"
 #include "shader_color_pos_tex.hpp"
+#include "shader_color_pos_sdf.hpp"
 #include "shader_color_pos_lum.hpp"
+#include "shader_instanced_quad.hpp"
 #include "frame_buffer.hpp"
 
 #include <GL/glew.h>
 
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
 using namespace morda::render_opengl2;
 
 render_factory::render_factory(){}
 
 render_factory::~render_factory()noexcept{}
 
+namespace{
+GLint to_gl_filter(morda::texture_2d::filter f, morda::texture_2d::mipmap m){
+	bool nearest = f == morda::texture_2d::filter::nearest;
+	switch(m){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::mipmap::none:
+			return nearest ? GL_NEAREST : GL_LINEAR;
+		case morda::texture_2d::mipmap::nearest:
+			return nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_NEAREST;
+		case morda::texture_2d::mipmap::linear:
+			return nearest ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+	}
+}
+
+GLint to_gl_wrap(morda::texture_2d::wrap w){
+	switch(w){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::wrap::repeat:
+			return GL_REPEAT;
+		case morda::texture_2d::wrap::mirrored_repeat:
+			return GL_MIRRORED_REPEAT;
+		case morda::texture_2d::wrap::clamp:
+			return GL_CLAMP_TO_EDGE;
+	}
+}
+
+// texture has to be bound
+void set_sampling(const morda::texture_2d::sampling& params, unsigned num_mips){
+	auto mipmaps = num_mips > 1 ? params.mipmaps : morda::texture_2d::mipmap::none;
+
+	if(num_mips > 1){
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(num_mips - 1));
+		assertOpenGLNoError();
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, to_gl_filter(params.min_filter, mipmaps));
+	assertOpenGLNoError();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, to_gl_filter(params.mag_filter, morda::texture_2d::mipmap::none));
+	assertOpenGLNoError();
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, to_gl_wrap(params.wrap_s));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, to_gl_wrap(params.wrap_t));
+}
+
+r4::vector2<unsigned> mip_dims(r4::vector2<unsigned> dims, unsigned level){
+	return r4::vector2<unsigned>(
+			std::max(dims.x() >> level, 1u),
+			std::max(dims.y() >> level, 1u)
+		);
+}
+
+GLenum to_gl_format(morda::texture_2d::compression c){
+	switch(c){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::compression::etc1_rgb:
+			// ETC2 is backwards compatible with ETC1
+		case morda::texture_2d::compression::etc2_rgb:
+			return GL_COMPRESSED_RGB8_ETC2;
+		case morda::texture_2d::compression::etc2_rgba:
+			return GL_COMPRESSED_RGBA8_ETC2_EAC;
+		case morda::texture_2d::compression::bc1_rgb:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case morda::texture_2d::compression::bc1_rgba:
+			return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		case morda::texture_2d::compression::bc3_rgba:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case morda::texture_2d::compression::bc7_rgba:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+}
+
 std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(morda::texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data){
-	//TODO: turn these asserts to real checks with exceptions throwing
-	ASSERT(data.size() % morda::texture_2d::bytes_per_pixel(type) == 0)
-	ASSERT(data.size() % dims.x() == 0)
+	std::array<utki::span<const uint8_t>, 1> mips = {{data}};
+	return this->create_texture_2d(type, dims, utki::make_span(mips), morda::texture_2d::sampling());
+}
 
-	ASSERT(data.size() == 0 || data.size() / morda::texture_2d::bytes_per_pixel(type) / dims.x() == dims.y())
-	
-	auto ret = std::make_shared<texture_2d>(dims.to<float>());
+std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(
+		morda::texture_2d::type type,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const morda::texture_2d::sampling& params
+	)
+{
+	auto bpp = morda::texture_2d::bytes_per_pixel(type);
+
+	for(unsigned i = 0; i != mips.size(); ++i){
+		auto d = mip_dims(dims, i);
+		if(mips[i].size() != 0 && mips[i].size() != size_t(d.x()) * d.y() * bpp){
+			throw std::invalid_argument("render_factory::create_texture_2d(): mipmap level data size does not match dimensions");
+		}
+	}
+
+	unsigned num_levels = params.mipmaps == morda::texture_2d::mipmap::none ? 1 : std::max(unsigned(mips.size()), 1u);
+
+	bool generate_mipmaps = num_levels == 1 && params.mipmaps != morda::texture_2d::mipmap::none
+			&& !mips.empty() && mips[0].size() != 0
+			&& (GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object);
+
+	auto ret = std::make_shared<texture_2d>(
+			dims.to<float>(),
+			morda::texture_2d::calc_memory_size(
+					type,
+					dims,
+					generate_mipmaps ? 1 + unsigned(std::log2(std::max(dims.x(), dims.y()))) : num_levels
+				)
+		);
 	
 	//TODO: save previous bind and restore it after?
 	ret->bind(0);
@@ -56,32 +165,99 @@ std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(morda::text
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	assertOpenGLNoError();
 
-	glTexImage2D(
-			GL_TEXTURE_2D,
-			0, // 0th level, no mipmaps
-			internalFormat, // internal format
-			dims.x(),
-			dims.y(),
-			0, // border, should be 0!
-			internalFormat, // format of the texel data
-			GL_UNSIGNED_BYTE,
-			data.size() == 0 ? nullptr : &*data.begin()
-		);
-	assertOpenGLNoError();
+	for(unsigned i = 0; i != num_levels; ++i){
+		auto d = mip_dims(dims, i);
+		auto data = i < mips.size() ? mips[i] : utki::span<const uint8_t>();
+		glTexImage2D(
+				GL_TEXTURE_2D,
+				i, // mipmap level
+				internalFormat, // internal format
+				d.x(),
+				d.y(),
+				0, // border, should be 0!
+				internalFormat, // format of the texel data
+				GL_UNSIGNED_BYTE,
+				data.size() == 0 ? nullptr : &*data.begin()
+			);
+		assertOpenGLNoError();
+	}
+
+	if(generate_mipmaps){
+		glGenerateMipmap(GL_TEXTURE_2D);
+		assertOpenGLNoError();
+		num_levels = 1 + unsigned(std::log2(std::max(dims.x(), dims.y())));
+	}
 
 	// NOTE: on OpenGL ES 2 it is necessary to set the filter parameters
 	//       for every texture!!! Otherwise it may not work!
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	assertOpenGLNoError();
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	assertOpenGLNoError();
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	set_sampling(params, num_levels);
 	
 	return ret;
 }
 
+bool render_factory::is_supported(morda::texture_2d::compression c)const{
+	switch(c){
+		case morda::texture_2d::compression::etc1_rgb:
+		case morda::texture_2d::compression::etc2_rgb:
+		case morda::texture_2d::compression::etc2_rgba:
+			return GLEW_ARB_ES3_compatibility;
+		case morda::texture_2d::compression::bc1_rgb:
+		case morda::texture_2d::compression::bc1_rgba:
+		case morda::texture_2d::compression::bc3_rgba:
+			return GLEW_EXT_texture_compression_s3tc;
+		case morda::texture_2d::compression::bc7_rgba:
+			return GLEW_ARB_texture_compression_bptc;
+	}
+	return false;
+}
+
+std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(
+		morda::texture_2d::compression c,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const morda::texture_2d::sampling& params
+	)
+{
+	if(!this->is_supported(c)){
+		throw std::runtime_error("render_factory::create_texture_2d(): compressed texture format is not supported");
+	}
+
+	if(mips.empty()){
+		throw std::invalid_argument("render_factory::create_texture_2d(): no compressed data given");
+	}
+
+	for(unsigned i = 0; i != mips.size(); ++i){
+		if(mips[i].size() != morda::texture_2d::compressed_size(c, mip_dims(dims, i))){
+			throw std::invalid_argument("render_factory::create_texture_2d(): mipmap level data size does not match dimensions");
+		}
+	}
+
+	unsigned num_levels = params.mipmaps == morda::texture_2d::mipmap::none ? 1 : unsigned(mips.size());
+
+	auto ret = std::make_shared<texture_2d>(dims.to<float>(), morda::texture_2d::calc_memory_size(c, dims, num_levels));
+
+	ret->bind(0);
+
+	for(unsigned i = 0; i != num_levels; ++i){
+		auto d = mip_dims(dims, i);
+		glCompressedTexImage2D(
+				GL_TEXTURE_2D,
+				i, // mipmap level
+				to_gl_format(c),
+				d.x(),
+				d.y(),
+				0, // border, should be 0!
+				GLsizei(mips[i].size()),
+				&*mips[i].begin()
+			);
+		assertOpenGLNoError();
+	}
+
+	set_sampling(params, num_levels);
+
+	return ret;
+}
+
 std::shared_ptr<morda::vertex_buffer> render_factory::create_vertex_buffer(utki::span<const r4::vector4<float>> vertices){
 	return std::make_shared<vertex_buffer>(vertices);
 }
@@ -118,6 +294,10 @@ std::unique_ptr<morda::render_factory::shaders> render_factory::create_shaders()
 	ret->pos_clr = std::make_unique<shader_pos_clr>();
 	ret->color_pos_tex = std::make_unique<shader_color_pos_tex>();
 	ret->color_pos_lum = std::make_unique<shader_color_pos_lum>();
+	ret->color_pos_sdf = std::make_unique<shader_color_pos_sdf>();
+	if(GLEW_ARB_instanced_arrays){
+		ret->instanced_quad = std::make_unique<shader_instanced_quad>();
+	}
 	return ret;
 }
 
@@ -15,6 +15,22 @@ public:
 
 	std::shared_ptr<morda::texture_2d> create_texture_2d(morda::texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data)override;
 
+	std::shared_ptr<morda::texture_2d> create_texture_2d(
+			morda::texture_2d::type type,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const morda::texture_2d::sampling& params
+		)override;
+
+	bool is_supported(morda::texture_2d::compression c)const override;
+
+	std::shared_ptr<morda::texture_2d> create_texture_2d(
+			morda::texture_2d::compression c,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const morda::texture_2d::sampling& params
+		)override;
+
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices)override;
 	
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector3<float>> vertices)override;
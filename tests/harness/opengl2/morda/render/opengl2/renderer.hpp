@@ -22,21 +22,21 @@ public:
 
 	void clear_framebuffer()override;
 	
-	bool is_scissor_enabled()const override;
+	bool is_scissor_enabled_internal()const override;
 	
-	void set_scissor_enabled(bool enabled)override;
+	void set_scissor_enabled_internal(bool enabled)override;
 	
-	r4::rectangle<int> get_scissor()const override;
+	r4::rectangle<int> get_scissor_internal()const override;
 	
-	void set_scissor(r4::rectangle<int> r)override;
+	void set_scissor_internal(r4::rectangle<int> r)override;
 
-	r4::rectangle<int> get_viewport()const override;
+	r4::rectangle<int> get_viewport_internal()const override;
 	
-	void set_viewport(r4::rectangle<int> r)override;
+	void set_viewport_internal(r4::rectangle<int> r)override;
 	
-	void set_blend_enabled(bool enable)override;
+	void set_blend_enabled_internal(bool enable)override;
 
-	void set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override;
+	void set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override;
 
 };
 
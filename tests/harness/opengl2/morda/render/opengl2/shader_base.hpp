@@ -46,12 +46,19 @@ public:
 	OpenGL2ShaderBase(const OpenGL2ShaderBase&) = delete;
 	OpenGL2ShaderBase& operator=(const OpenGL2ShaderBase&) = delete;
 	
-	virtual ~OpenGL2ShaderBase()noexcept{}
+	virtual ~OpenGL2ShaderBase()noexcept{
+		if(this->isBound()){
+			boundShader = nullptr;
+		}
+	}
 
 protected:
 	GLint getUniform(const char* n);
 	
 	void bind()const{
+		if(this->isBound()){
+			return;
+		}
 		glUseProgram(program.p);
 		assertOpenGLNoError();
 		boundShader = this;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <morda/render/instanced_quad_shader.hpp>
+
+#include "shader_base.hpp"
+#include "opengl_buffer.hpp"
+
+namespace morda{ namespace render_opengl2{
+
+/**
+ * @brief Instanced quad shader.
+ * Requires ARB_instanced_arrays extension.
+ * Vertex attribute 0 is the unit quad corner, attributes 1 to 6 are per-instance:
+ * rows of the transformation matrix, color and texture coordinates rectangle.
+ */
+class shader_instanced_quad : public morda::instanced_quad_shader{
+	opengl_buffer quad_vbo;
+	opengl_buffer quad_ibo;
+
+	// per-instance data is streamed to this buffer on each draw call
+	opengl_buffer instance_vbo;
+
+	class program : public OpenGL2ShaderBase{
+	public:
+		program(const char* fragmentShaderCode);
+
+		void render(const shader_instanced_quad& s, utki::span<const morda::quad_instance> instances)const;
+	};
+
+	program solid;
+	program textured;
+public:
+	shader_instanced_quad();
+
+	shader_instanced_quad(const shader_instanced_quad&) = delete;
+	shader_instanced_quad& operator=(const shader_instanced_quad&) = delete;
+
+	void render(utki::span<const morda::quad_instance> instances)const override;
+
+	void render(utki::span<const morda::quad_instance> instances, const morda::texture_2d& tex)const override;
+};
+
+}}
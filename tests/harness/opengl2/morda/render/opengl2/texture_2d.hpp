@@ -9,7 +9,7 @@ namespace morda{ namespace render_opengl2{
 struct texture_2d : public morda::texture_2d{
 	GLuint tex;
 	
-	texture_2d(r4::vector2<float> dims);
+	texture_2d(r4::vector2<float> dims, size_t memory_size);
 	
 	~texture_2d()noexcept;
 	
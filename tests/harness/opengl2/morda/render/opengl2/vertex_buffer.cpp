@@ -44,3 +44,34 @@ vertex_buffer::vertex_buffer(utki::span<const float> vertices) :
 {
 	this->init(vertices.size_bytes(), vertices.data());
 }
+
+bool vertex_buffer::update(GLint num_components, size_t num_vertices, GLsizeiptr size, const GLvoid* data){
+	ASSERT(num_components == this->numComponents)
+	ASSERT(num_vertices == this->size)
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+	assertOpenGLNoError();
+
+	// re-specifying the whole data store lets the driver allocate new storage instead of
+	// waiting for the draw calls which still use the previous data
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+	assertOpenGLNoError();
+
+	return true;
+}
+
+bool vertex_buffer::update(utki::span<const r4::vector4<float>> vertices){
+	return this->update(4, vertices.size(), vertices.size_bytes(), vertices.data());
+}
+
+bool vertex_buffer::update(utki::span<const r4::vector3<float>> vertices){
+	return this->update(3, vertices.size(), vertices.size_bytes(), vertices.data());
+}
+
+bool vertex_buffer::update(utki::span<const r4::vector2<float>> vertices){
+	return this->update(2, vertices.size(), vertices.size_bytes(), vertices.data());
+}
+
+bool vertex_buffer::update(utki::span<const float> vertices){
+	return this->update(1, vertices.size(), vertices.size_bytes(), vertices.data());
+}
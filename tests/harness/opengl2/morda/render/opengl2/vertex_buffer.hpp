@@ -26,8 +26,18 @@ public:
 	vertex_buffer(const vertex_buffer&) = delete;
 	vertex_buffer& operator=(const vertex_buffer&) = delete;
 
+	bool update(utki::span<const r4::vector4<float>> vertices)override;
+
+	bool update(utki::span<const r4::vector3<float>> vertices)override;
+
+	bool update(utki::span<const r4::vector2<float>> vertices)override;
+
+	bool update(utki::span<const float> vertices)override;
+
 private:
 	void init(GLsizeiptr size, const GLvoid* data);
+
+	bool update(GLint num_components, size_t num_vertices, GLsizeiptr size, const GLvoid* data);
 };
 
 }}
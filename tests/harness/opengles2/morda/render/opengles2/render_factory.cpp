@@ -13,33 +13,233 @@
 #include "shader_color.hpp"
 #include "shader_pos_clr.hpp"
 #include "shader_color_pos_tex.hpp"
+#include "shader_color_pos_sdf.hpp"
 #include "shader_color_pos_lum.hpp"
+#include "shader_instanced_quad.hpp"
 #include "frame_buffer.hpp"
 
 #if M_OS_NAME == M_OS_NAME_IOS
 #	include <OpenGlES/ES2/glext.h>
 #else
 #	include <GLES2/gl2.h>
+#	include <EGL/egl.h>
+#endif
+
+#include <array>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef GL_ETC1_RGB8_OES
+#	define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#	define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#	define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#	define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM_EXT
+#	define GL_COMPRESSED_RGBA_BPTC_UNORM_EXT 0x8E8C
 #endif
 
 using namespace morda::render_opengles2;
 
-render_factory::render_factory(){}
+namespace{
+bool has_extension(const char* extensions, const char* name){
+	if(!extensions){
+		return false;
+	}
+	auto len = std::strlen(name);
+	for(auto p = std::strstr(extensions, name); p; p = std::strstr(p + len, name)){
+		bool starts_word = p == extensions || p[-1] == ' ';
+		bool ends_word = p[len] == ' ' || p[len] == '\0';
+		if(starts_word && ends_word){
+			return true;
+		}
+	}
+	return false;
+}
+
+instancing_functions get_instancing_functions(const char* extensions, bool is_es3){
+	instancing_functions ret;
+
+#if M_OS_NAME == M_OS_NAME_IOS
+	if(is_es3 || has_extension(extensions, "GL_EXT_instanced_arrays")){
+		ret.vertex_attrib_divisor = &glVertexAttribDivisorEXT;
+		ret.draw_elements_instanced = &glDrawElementsInstancedEXT;
+	}
+#else
+	// the entry points have the same signatures, only the name suffixes differ
+	const char* suffix;
+	if(is_es3){
+		suffix = "";
+	}else if(has_extension(extensions, "GL_EXT_instanced_arrays")){
+		suffix = "EXT";
+	}else if(has_extension(extensions, "GL_ANGLE_instanced_arrays")){
+		suffix = "ANGLE";
+	}else if(has_extension(extensions, "GL_NV_instanced_arrays") && has_extension(extensions, "GL_NV_draw_instanced")){
+		suffix = "NV";
+	}else{
+		return ret;
+	}
+
+	ret.vertex_attrib_divisor = reinterpret_cast<instancing_functions::vertex_attrib_divisor_type>(
+			eglGetProcAddress((std::string("glVertexAttribDivisor") + suffix).c_str())
+		);
+	ret.draw_elements_instanced = reinterpret_cast<instancing_functions::draw_elements_instanced_type>(
+			eglGetProcAddress((std::string("glDrawElementsInstanced") + suffix).c_str())
+		);
+#endif
+
+	return ret;
+}
+
+GLint to_gl_filter(morda::texture_2d::filter f, morda::texture_2d::mipmap m){
+	bool nearest = f == morda::texture_2d::filter::nearest;
+	switch(m){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::mipmap::none:
+			return nearest ? GL_NEAREST : GL_LINEAR;
+		case morda::texture_2d::mipmap::nearest:
+			return nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_NEAREST;
+		case morda::texture_2d::mipmap::linear:
+			return nearest ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+	}
+}
+
+GLint to_gl_wrap(morda::texture_2d::wrap w){
+	switch(w){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::wrap::repeat:
+			return GL_REPEAT;
+		case morda::texture_2d::wrap::mirrored_repeat:
+			return GL_MIRRORED_REPEAT;
+		case morda::texture_2d::wrap::clamp:
+			return GL_CLAMP_TO_EDGE;
+	}
+}
+
+// texture has to be bound
+void set_sampling(const morda::texture_2d::sampling& params, bool has_mipmaps){
+	auto mipmaps = has_mipmaps ? params.mipmaps : morda::texture_2d::mipmap::none;
+
+	// NOTE: on OpenGL ES 2 it is necessary to set the filter parameters
+	//       for every texture!!! Otherwise it may not work!
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, to_gl_filter(params.min_filter, mipmaps));
+	assertOpenGLNoError();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, to_gl_filter(params.mag_filter, morda::texture_2d::mipmap::none));
+	assertOpenGLNoError();
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, to_gl_wrap(params.wrap_s));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, to_gl_wrap(params.wrap_t));
+}
+
+r4::vector2<unsigned> mip_dims(r4::vector2<unsigned> dims, unsigned level){
+	return r4::vector2<unsigned>(
+			std::max(dims.x() >> level, 1u),
+			std::max(dims.y() >> level, 1u)
+		);
+}
+
+unsigned full_mip_chain_size(r4::vector2<unsigned> dims){
+	unsigned ret = 1;
+	for(auto d = std::max(dims.x(), dims.y()); d > 1; d /= 2){
+		++ret;
+	}
+	return ret;
+}
+
+bool is_power_of_two(unsigned n){
+	return n != 0 && (n & (n - 1)) == 0;
+}
+
+GLenum to_gl_format(morda::texture_2d::compression c, bool is_es3){
+	switch(c){
+		default:
+			ASSERT(false)
+		case morda::texture_2d::compression::etc1_rgb:
+			// ETC2 is backwards compatible with ETC1
+			return is_es3 ? GL_COMPRESSED_RGB8_ETC2 : GL_ETC1_RGB8_OES;
+		case morda::texture_2d::compression::etc2_rgb:
+			return GL_COMPRESSED_RGB8_ETC2;
+		case morda::texture_2d::compression::etc2_rgba:
+			return GL_COMPRESSED_RGBA8_ETC2_EAC;
+		case morda::texture_2d::compression::bc1_rgb:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case morda::texture_2d::compression::bc1_rgba:
+			return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		case morda::texture_2d::compression::bc3_rgba:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case morda::texture_2d::compression::bc7_rgba:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM_EXT;
+	}
+}
+}
+
+render_factory::render_factory(){
+	auto version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	this->is_es3 = version && std::strncmp(version, "OpenGL ES 3", 11) == 0;
+
+	auto extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	this->has_etc1 = this->is_es3 || has_extension(extensions, "GL_OES_compressed_ETC1_RGB8_texture");
+	this->has_s3tc = has_extension(extensions, "GL_EXT_texture_compression_s3tc");
+	this->has_bptc = has_extension(extensions, "GL_EXT_texture_compression_bptc");
+	this->has_standard_derivatives = has_extension(extensions, "GL_OES_standard_derivatives");
+	this->instancing = get_instancing_functions(extensions, this->is_es3);
+}
 
 render_factory::~render_factory()noexcept{}
 
 std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(morda::texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data){
-	//TODO: turn these asserts to real checks with exceptions throwing
-	ASSERT(data.size() % morda::texture_2d::bytes_per_pixel(type) == 0)
-	ASSERT(data.size() % dims.x() == 0)
-
-	ASSERT(data.size() == 0 || data.size() / morda::texture_2d::bytes_per_pixel(type) / dims.x() == dims.y())
-	
-	auto ret = std::make_shared<texture_2d>(dims.to<float>());
-	
+	std::array<utki::span<const uint8_t>, 1> mips = {{data}};
+	return this->create_texture_2d(type, dims, utki::make_span(mips), morda::texture_2d::sampling());
+}
+
+std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(
+		morda::texture_2d::type type,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const morda::texture_2d::sampling& params
+	)
+{
+	auto bpp = morda::texture_2d::bytes_per_pixel(type);
+
+	for(unsigned i = 0; i != mips.size(); ++i){
+		auto d = mip_dims(dims, i);
+		if(mips[i].size() != 0 && mips[i].size() != size_t(d.x()) * d.y() * bpp){
+			throw std::invalid_argument("render_factory::create_texture_2d(): mipmap level data size does not match dimensions");
+		}
+	}
+
+	// OpenGL ES 2 supports mipmaps only for power of two textures and only with complete mipmap chain
+	bool can_have_mipmaps = params.mipmaps != morda::texture_2d::mipmap::none
+			&& (this->is_es3 || (is_power_of_two(dims.x()) && is_power_of_two(dims.y())));
+
+	unsigned num_levels = can_have_mipmaps && mips.size() == full_mip_chain_size(dims) ? unsigned(mips.size()) : 1;
+
+	bool generate_mipmaps = num_levels == 1 && can_have_mipmaps && !mips.empty() && mips[0].size() != 0;
+
+	auto ret = std::make_shared<texture_2d>(
+			dims.to<float>(),
+			morda::texture_2d::calc_memory_size(type, dims, generate_mipmaps ? full_mip_chain_size(dims) : num_levels)
+		);
+
 	//TODO: save previous bind and restore it after?
 	ret->bind(0);
-	
+
 	GLint internalFormat;
 	switch(type){
 		default:
@@ -62,29 +262,97 @@ std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(morda::text
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	assertOpenGLNoError();
 
-	glTexImage2D(
-			GL_TEXTURE_2D,
-			0, // 0th level, no mipmaps
-			internalFormat, // internal format
-			dims.x(),
-			dims.y(),
-			0, // border, should be 0!
-			internalFormat, // format of the texel data
-			GL_UNSIGNED_BYTE,
-			data.size() == 0 ? nullptr : &*data.begin()
-		);
-	assertOpenGLNoError();
+	for(unsigned i = 0; i != num_levels; ++i){
+		auto d = mip_dims(dims, i);
+		auto data = i < mips.size() ? mips[i] : utki::span<const uint8_t>();
+		glTexImage2D(
+				GL_TEXTURE_2D,
+				i, // mipmap level
+				internalFormat, // internal format
+				d.x(),
+				d.y(),
+				0, // border, should be 0!
+				internalFormat, // format of the texel data
+				GL_UNSIGNED_BYTE,
+				data.size() == 0 ? nullptr : &*data.begin()
+			);
+		assertOpenGLNoError();
+	}
+
+	if(generate_mipmaps){
+		glGenerateMipmap(GL_TEXTURE_2D);
+		assertOpenGLNoError();
+	}
+
+	set_sampling(params, num_levels > 1 || generate_mipmaps);
+
+	return ret;
+}
+
+bool render_factory::is_supported(morda::texture_2d::compression c)const{
+	switch(c){
+		case morda::texture_2d::compression::etc1_rgb:
+			return this->has_etc1;
+		case morda::texture_2d::compression::etc2_rgb:
+		case morda::texture_2d::compression::etc2_rgba:
+			return this->is_es3;
+		case morda::texture_2d::compression::bc1_rgb:
+		case morda::texture_2d::compression::bc1_rgba:
+		case morda::texture_2d::compression::bc3_rgba:
+			return this->has_s3tc;
+		case morda::texture_2d::compression::bc7_rgba:
+			return this->has_bptc;
+	}
+	return false;
+}
+
+std::shared_ptr<morda::texture_2d> render_factory::create_texture_2d(
+		morda::texture_2d::compression c,
+		r4::vector2<unsigned> dims,
+		utki::span<const utki::span<const uint8_t>> mips,
+		const morda::texture_2d::sampling& params
+	)
+{
+	if(!this->is_supported(c)){
+		throw std::runtime_error("render_factory::create_texture_2d(): compressed texture format is not supported");
+	}
+
+	if(mips.empty()){
+		throw std::invalid_argument("render_factory::create_texture_2d(): no compressed data given");
+	}
+
+	for(unsigned i = 0; i != mips.size(); ++i){
+		if(mips[i].size() != morda::texture_2d::compressed_size(c, mip_dims(dims, i))){
+			throw std::invalid_argument("render_factory::create_texture_2d(): mipmap level data size does not match dimensions");
+		}
+	}
+
+	bool can_have_mipmaps = params.mipmaps != morda::texture_2d::mipmap::none
+			&& (this->is_es3 || (is_power_of_two(dims.x()) && is_power_of_two(dims.y())));
+
+	unsigned num_levels = can_have_mipmaps && mips.size() == full_mip_chain_size(dims) ? unsigned(mips.size()) : 1;
+
+	auto ret = std::make_shared<texture_2d>(dims.to<float>(), morda::texture_2d::calc_memory_size(c, dims, num_levels));
+
+	ret->bind(0);
+
+	for(unsigned i = 0; i != num_levels; ++i){
+		auto d = mip_dims(dims, i);
+		glCompressedTexImage2D(
+				GL_TEXTURE_2D,
+				i, // mipmap level
+				to_gl_format(c, this->is_es3),
+				d.x(),
+				d.y(),
+				0, // border, should be 0!
+				GLsizei(mips[i].size()),
+				&*mips[i].begin()
+			);
+		assertOpenGLNoError();
+	}
+
+	set_sampling(params, num_levels > 1);
 
-	// NOTE: on OpenGL ES 2 it is necessary to set the filter parameters
-	//       for every texture!!! Otherwise it may not work!
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	assertOpenGLNoError();
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	assertOpenGLNoError();
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	
 	return ret;
 }
 
@@ -124,6 +392,12 @@ std::unique_ptr<morda::render_factory::shaders> render_factory::create_shaders()
 	ret->pos_clr = std::make_unique<shader_pos_clr>();
 	ret->color_pos_tex = std::make_unique<shader_color_pos_tex>();
 	ret->color_pos_lum = std::make_unique<shader_color_pos_lum>();
+	if(this->has_standard_derivatives){
+		ret->color_pos_sdf = std::make_unique<shader_color_pos_sdf>();
+	}
+	if(this->instancing.is_valid()){
+		ret->instanced_quad = std::make_unique<shader_instanced_quad>(this->instancing);
+	}
 	return ret;
 }
 
@@ -2,9 +2,17 @@
 
 #include <morda/render/render_factory.hpp>
 
+#include "shader_instanced_quad.hpp"
+
 namespace morda{ namespace render_opengles2{
 
 class render_factory : public morda::render_factory{
+	bool is_es3;
+	bool has_etc1;
+	bool has_s3tc;
+	bool has_bptc;
+	bool has_standard_derivatives;
+	instancing_functions instancing;
 public:
 	render_factory();
 	
@@ -15,6 +23,22 @@ public:
 
 	std::shared_ptr<morda::texture_2d> create_texture_2d(morda::texture_2d::type type, r4::vector2<unsigned> dims, utki::span<const uint8_t> data)override;
 
+	std::shared_ptr<morda::texture_2d> create_texture_2d(
+			morda::texture_2d::type type,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const morda::texture_2d::sampling& params
+		)override;
+
+	bool is_supported(morda::texture_2d::compression c)const override;
+
+	std::shared_ptr<morda::texture_2d> create_texture_2d(
+			morda::texture_2d::compression c,
+			r4::vector2<unsigned> dims,
+			utki::span<const utki::span<const uint8_t>> mips,
+			const morda::texture_2d::sampling& params
+		)override;
+
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices)override;
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector3<float>> vertices)override;
 	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector2<float>> vertices)override;
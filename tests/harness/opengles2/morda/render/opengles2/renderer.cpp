@@ -74,11 +74,11 @@ void renderer::clear_framebuffer(){
 	assertOpenGLNoError();
 }
 
-bool renderer::is_scissor_enabled()const{
+bool renderer::is_scissor_enabled_internal()const{
 	return glIsEnabled(GL_SCISSOR_TEST) ? true : false; // "? true : false" is to avoid warning under MSVC
 }
 
-void renderer::set_scissor_enabled(bool enabled){
+void renderer::set_scissor_enabled_internal(bool enabled){
 	if(enabled){
 		glEnable(GL_SCISSOR_TEST);
 	}else{
@@ -86,18 +86,18 @@ void renderer::set_scissor_enabled(bool enabled){
 	}
 }
 
-r4::rectangle<int> renderer::get_scissor()const{
+r4::rectangle<int> renderer::get_scissor_internal()const{
 	GLint osb[4];
 	glGetIntegerv(GL_SCISSOR_BOX, osb);
 	return r4::rectangle<int>(osb[0], osb[1], osb[2], osb[3]);
 }
 
-void renderer::set_scissor(r4::rectangle<int> r){
+void renderer::set_scissor_internal(r4::rectangle<int> r){
 	glScissor(r.p.x(), r.p.y(), r.d.x(), r.d.y());
 	assertOpenGLNoError();
 }
 
-r4::rectangle<int> renderer::get_viewport()const{
+r4::rectangle<int> renderer::get_viewport_internal()const{
 	GLint vp[4];
 
 	glGetIntegerv(GL_VIEWPORT, vp);
@@ -105,12 +105,12 @@ r4::rectangle<int> renderer::get_viewport()const{
 	return r4::rectangle<int>(vp[0], vp[1], vp[2], vp[3]);
 }
 
-void renderer::set_viewport(r4::rectangle<int> r){
+void renderer::set_viewport_internal(r4::rectangle<int> r){
 	glViewport(r.p.x(), r.p.y(), r.d.x(), r.d.y());
 	assertOpenGLNoError();
 }
 
-void renderer::set_blend_enabled(bool enable){
+void renderer::set_blend_enabled_internal(bool enable){
 	if(enable){
 		glEnable(GL_BLEND);
 	}else{
@@ -140,7 +140,7 @@ GLenum blendFunc[] = {
 
 }
 
-void renderer::set_blend_func(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha){
+void renderer::set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha){
 	glBlendFuncSeparate(
 			blendFunc[unsigned(src_color)],
 			blendFunc[unsigned(dst_color)],
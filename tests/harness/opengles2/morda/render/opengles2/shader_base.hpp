@@ -51,12 +51,19 @@ public:
 	shader_base(const shader_base&) = delete;
 	shader_base& operator=(const shader_base&) = delete;
 	
-	virtual ~shader_base()noexcept{}
+	virtual ~shader_base()noexcept{
+		if(this->isBound()){
+			boundShader = nullptr;
+		}
+	}
 
 protected:
 	GLint getUniform(const char* n);
 	
 	void bind()const{
+		if(this->isBound()){
+			return;
+		}
 		glUseProgram(program.p);
 		assertOpenGLNoError();
 		boundShader = this;
@@ -0,0 +1,65 @@
+#include "shader_color_pos_sdf.hpp"
+
+#include "texture_2d.hpp"
+
+using namespace morda::render_opengles2;
+
+shader_color_pos_sdf::shader_color_pos_sdf() :
+		shader_base(
+				R"qwertyuiop(
+						#ifndef GL_ES
+						#	define highp
+						#	define mediump
+						#	define lowp
+						#endif
+
+						attribute highp vec4 a0;
+
+						attribute highp vec2 a1;
+
+						uniform highp mat4 matrix;
+
+						varying highp vec2 tc0;
+
+						void main(void){
+							gl_Position = matrix * a0;
+							tc0 = a1;
+						}
+					)qwertyuiop",
+				R"qwertyuiop(
+						#ifdef GL_ES
+						#	extension GL_OES_standard_derivatives : enable
+						#endif
+						#ifndef GL_ES
+						#	define highp
+						#	define mediump
+						#	define lowp
+						#endif
+		
+						uniform sampler2D texture0;
+		
+						uniform highp vec4 uniformColor;
+		
+						varying highp vec2 tc0;
+		
+						void main(void){
+							// distance is 0.5 at the glyph edge, smooth the edge over about one screen pixel
+							highp float d = texture2D(texture0, tc0).r;
+							highp float w = clamp(fwidth(d) * 0.7, 0.001, 0.5);
+							gl_FragColor = vec4(uniformColor.rgb, uniformColor.a * smoothstep(0.5 - w, 0.5 + w, d));
+						}
+					)qwertyuiop"
+			)
+{
+	this->colorUniform = this->getUniform("uniformColor");
+}
+
+void shader_color_pos_sdf::render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color, const morda::texture_2d& tex)const {
+	ASSERT(dynamic_cast<const texture_2d*>(&tex))
+	static_cast<const texture_2d&>(tex).bind(0);
+	this->bind();
+	
+	this->setUniform4f(this->colorUniform, color.x(), color.y(), color.z(), color.w());
+	
+	this->shader_base::render(m, va);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <morda/render/coloring_texturing_shader.hpp>
+
+#include "shader_base.hpp"
+
+namespace morda{ namespace render_opengles2{
+
+class shader_color_pos_sdf :
+		public morda::coloring_texturing_shader,
+		public shader_base
+{
+	GLint colorUniform;
+public:
+	shader_color_pos_sdf();
+	
+	shader_color_pos_sdf(const shader_color_pos_sdf&) = delete;
+	shader_color_pos_sdf& operator=(const shader_color_pos_sdf&) = delete;
+	
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color, const morda::texture_2d& tex)const override;
+};
+
+}}
@@ -0,0 +1,165 @@
+#include "shader_instanced_quad.hpp"
+
+#include <array>
+
+#include "texture_2d.hpp"
+
+using namespace morda::render_opengles2;
+
+namespace{
+const std::array<r4::vector2<float>, 4> quad_corners = {{
+	r4::vector2<float>(0, 0), r4::vector2<float>(1, 0), r4::vector2<float>(1, 1), r4::vector2<float>(0, 1)
+}};
+
+const std::array<GLushort, 6> quad_indices = {{0, 1, 2, 0, 2, 3}};
+
+// matrix rows, color and texture coordinates rectangle
+const GLuint num_instance_attributes = 6;
+
+static_assert(
+		sizeof(morda::quad_instance) == num_instance_attributes * sizeof(r4::vector4<float>),
+		"quad instance is expected to be tightly packed"
+	);
+
+const char* vertex_shader_code = R"qwertyuiop(
+		#ifndef GL_ES
+		#	define highp
+		#	define mediump
+		#	define lowp
+		#endif
+
+		uniform highp mat4 matrix;
+
+		attribute highp vec2 a0;
+
+		attribute highp vec4 a1;
+		attribute highp vec4 a2;
+		attribute highp vec4 a3;
+		attribute highp vec4 a4;
+		attribute highp vec4 a5;
+		attribute highp vec4 a6;
+
+		varying highp vec4 color_varying;
+		varying highp vec2 tc0;
+
+		void main(void){
+			highp vec4 p = vec4(a0, 0.0, 1.0);
+			gl_Position = matrix * vec4(dot(a1, p), dot(a2, p), dot(a3, p), dot(a4, p));
+			color_varying = a5;
+			tc0 = mix(a6.xy, a6.zw, a0);
+		}
+	)qwertyuiop";
+}
+
+shader_instanced_quad::program::program(const char* fragmentShaderCode) :
+		shader_base(vertex_shader_code, fragmentShaderCode)
+{}
+
+void shader_instanced_quad::program::render(const shader_instanced_quad& s, utki::span<const morda::quad_instance> instances)const{
+	this->bind();
+
+	// instance matrices transform the unit quad right to the output
+	this->setMatrix(r4::matrix4<float>().set_identity());
+
+	glBindBuffer(GL_ARRAY_BUFFER, s.quad_vbo.buffer);
+	assertOpenGLNoError();
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	assertOpenGLNoError();
+	glEnableVertexAttribArray(0);
+	assertOpenGLNoError();
+
+	glBindBuffer(GL_ARRAY_BUFFER, s.instance_vbo.buffer);
+	assertOpenGLNoError();
+
+	// re-specifying the whole data store lets the driver allocate new storage instead of
+	// waiting for the draw calls which still use the previous data
+	glBufferData(GL_ARRAY_BUFFER, instances.size_bytes(), instances.data(), GL_STREAM_DRAW);
+	assertOpenGLNoError();
+
+	for(GLuint i = 0; i != num_instance_attributes; ++i){
+		GLuint a = i + 1;
+		glVertexAttribPointer(
+				a,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				sizeof(morda::quad_instance),
+				reinterpret_cast<const GLvoid*>(i * sizeof(r4::vector4<float>))
+			);
+		assertOpenGLNoError();
+		glEnableVertexAttribArray(a);
+		assertOpenGLNoError();
+		s.instancing.vertex_attrib_divisor(a, 1);
+		assertOpenGLNoError();
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.quad_ibo.buffer);
+	assertOpenGLNoError();
+
+	s.instancing.draw_elements_instanced(GL_TRIANGLES, GLsizei(quad_indices.size()), GL_UNSIGNED_SHORT, nullptr, GLsizei(instances.size()));
+	assertOpenGLNoError();
+
+	// other shaders do not use instancing
+	for(GLuint i = 0; i != num_instance_attributes; ++i){
+		GLuint a = i + 1;
+		s.instancing.vertex_attrib_divisor(a, 0);
+		assertOpenGLNoError();
+		glDisableVertexAttribArray(a);
+		assertOpenGLNoError();
+	}
+}
+
+shader_instanced_quad::shader_instanced_quad(const instancing_functions& instancing) :
+		instancing(instancing),
+		solid(R"qwertyuiop(
+				#ifndef GL_ES
+				#	define highp
+				#	define mediump
+				#	define lowp
+				#endif
+
+				varying highp vec4 color_varying;
+
+				void main(void){
+					gl_FragColor = color_varying;
+				}
+			)qwertyuiop"),
+		textured(R"qwertyuiop(
+				#ifndef GL_ES
+				#	define highp
+				#	define mediump
+				#	define lowp
+				#endif
+
+				uniform sampler2D texture0;
+
+				varying highp vec4 color_varying;
+				varying highp vec2 tc0;
+
+				void main(void){
+					gl_FragColor = texture2D(texture0, tc0) * color_varying;
+				}
+			)qwertyuiop")
+{
+	ASSERT(this->instancing.is_valid())
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->quad_vbo.buffer);
+	assertOpenGLNoError();
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_corners), quad_corners.data(), GL_STATIC_DRAW);
+	assertOpenGLNoError();
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->quad_ibo.buffer);
+	assertOpenGLNoError();
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices.data(), GL_STATIC_DRAW);
+	assertOpenGLNoError();
+}
+
+void shader_instanced_quad::render(utki::span<const morda::quad_instance> instances)const{
+	this->solid.render(*this, instances);
+}
+
+void shader_instanced_quad::render(utki::span<const morda::quad_instance> instances, const morda::texture_2d& tex)const{
+	ASSERT(dynamic_cast<const texture_2d*>(&tex))
+	static_cast<const texture_2d&>(tex).bind(0);
+	this->textured.render(*this, instances);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <morda/render/instanced_quad_shader.hpp>
+
+#include "shader_base.hpp"
+#include "opengl_buffer.hpp"
+
+namespace morda{ namespace render_opengles2{
+
+/**
+ * @brief Instancing entry points.
+ * Instancing is in core of OpenGL ES 3, while OpenGL ES 2 has it only through EXT, ANGLE or NV extensions,
+ * so the functions are obtained at run time.
+ */
+struct instancing_functions{
+	typedef void (GL_APIENTRY *vertex_attrib_divisor_type)(GLuint index, GLuint divisor);
+	typedef void (GL_APIENTRY *draw_elements_instanced_type)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount);
+
+	vertex_attrib_divisor_type vertex_attrib_divisor = nullptr;
+	draw_elements_instanced_type draw_elements_instanced = nullptr;
+
+	bool is_valid()const noexcept{
+		return this->vertex_attrib_divisor && this->draw_elements_instanced;
+	}
+};
+
+/**
+ * @brief Instanced quad shader.
+ * Requires instancing support, see instancing_functions.
+ * Vertex attribute 0 is the unit quad corner, attributes 1 to 6 are per-instance:
+ * rows of the transformation matrix, color and texture coordinates rectangle.
+ */
+class shader_instanced_quad : public morda::instanced_quad_shader{
+	opengl_buffer quad_vbo;
+	opengl_buffer quad_ibo;
+
+	// per-instance data is streamed to this buffer on each draw call
+	opengl_buffer instance_vbo;
+
+	const instancing_functions instancing;
+
+	class program : public shader_base{
+	public:
+		program(const char* fragmentShaderCode);
+
+		void render(const shader_instanced_quad& s, utki::span<const morda::quad_instance> instances)const;
+	};
+
+	program solid;
+	program textured;
+public:
+	shader_instanced_quad(const instancing_functions& instancing);
+
+	shader_instanced_quad(const shader_instanced_quad&) = delete;
+	shader_instanced_quad& operator=(const shader_instanced_quad&) = delete;
+
+	void render(utki::span<const morda::quad_instance> instances)const override;
+
+	void render(utki::span<const morda::quad_instance> instances, const morda::texture_2d& tex)const override;
+};
+
+}}
@@ -2,10 +2,18 @@
 
 #include "util.hpp"
 
+#include <array>
+
 using namespace morda::render_opengles2;
 
-texture_2d::texture_2d(r4::vector2<float> dims) :
-		morda::texture_2d(dims)
+namespace{
+// shadow copy of the texture bindings, to avoid redundant OpenGL calls
+GLuint activeTextureUnit = 0;
+std::array<GLuint, 32> boundTextures = {{0}};
+}
+
+texture_2d::texture_2d(r4::vector2<float> dims, size_t memory_size) :
+		morda::texture_2d(dims, memory_size)
 {
 	glGenTextures(1, &this->tex);
 	assertOpenGLNoError();
@@ -14,11 +22,27 @@ texture_2d::texture_2d(r4::vector2<float> dims) :
 
 texture_2d::~texture_2d()noexcept{
 	glDeleteTextures(1, &this->tex);
+
+	// deleted texture is unbound from all texture units
+	for(auto& t : boundTextures){
+		if(t == this->tex){
+			t = 0;
+		}
+	}
 }
 
 void texture_2d::bind(unsigned unitNum) const {
-	glActiveTexture(GL_TEXTURE0 + unitNum);
-	assertOpenGLNoError();
+	ASSERT(unitNum < boundTextures.size())
+	if(boundTextures[unitNum] == this->tex){
+		return;
+	}
+
+	if(activeTextureUnit != unitNum){
+		glActiveTexture(GL_TEXTURE0 + unitNum);
+		assertOpenGLNoError();
+		activeTextureUnit = unitNum;
+	}
 	glBindTexture(GL_TEXTURE_2D, this->tex);
 	assertOpenGLNoError();
+	boundTextures[unitNum] = this->tex;
 }
@@ -0,0 +1,107 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/widgets/group/column.hpp"
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+namespace{
+const auto layout = treeml::read(R"qwertyuiop(
+	@container{
+		id{root}
+
+		@column{
+			id{1}
+		}
+
+		@column{
+			id{2}
+
+			@column{
+				id{3}
+			}
+			@row{
+				id{4}
+
+				@pile{
+					id{5}
+				}
+			}
+		}
+	}
+)qwertyuiop");
+}
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	// test lookup through ID index
+	{
+		auto w = m.context->inflater.inflate_as<morda::container>(layout);
+		ASSERT_ALWAYS(w)
+
+		w->set_id_index_enabled(true);
+		ASSERT_ALWAYS(w->is_id_index_enabled())
+
+		for(auto id : {"1", "2", "3", "4", "5"}){
+			auto f = w->try_get_widget(id);
+			ASSERT_INFO_ALWAYS(f, "id = " << id)
+			ASSERT_ALWAYS(f->id == id)
+		}
+
+		ASSERT_ALWAYS(w->try_get_widget("root") == w)
+		ASSERT_ALWAYS(!w->try_get_widget("root", false))
+		ASSERT_ALWAYS(!w->try_get_widget("this ID was never used"))
+
+		// add widget to a nested container, the index of the root should be updated
+		auto& c4 = w->get_widget_as<morda::container>("4");
+		c4.push_back(m.context->inflater.inflate(R"qwertyuiop(@pile{id{6}})qwertyuiop"));
+		ASSERT_ALWAYS(w->try_get_widget("6"))
+		ASSERT_ALWAYS(w->try_get_widget("6")->parent() == &c4)
+
+		// remove the sub-hierarchy from the index
+		auto removed = w->get_widget("4").remove_from_parent();
+		ASSERT_ALWAYS(!w->try_get_widget("4"))
+		ASSERT_ALWAYS(!w->try_get_widget("5"))
+		ASSERT_ALWAYS(!w->try_get_widget("6"))
+
+		// change ID of the indexed widget
+		w->get_widget("3").id = "33";
+		ASSERT_ALWAYS(!w->try_get_widget("3"))
+		ASSERT_ALWAYS(w->try_get_widget("33"))
+
+		// duplicate IDs, the first one in the hierarchy should be returned
+		auto d1 = m.context->inflater.inflate(R"qwertyuiop(@column{id{dup}})qwertyuiop");
+		auto d2 = m.context->inflater.inflate(R"qwertyuiop(@column{id{dup}})qwertyuiop");
+		w->get_widget_as<morda::container>("2").push_back(d2);
+		w->get_widget_as<morda::container>("1").push_back(d1);
+		ASSERT_ALWAYS(w->try_get_widget("dup") == d1)
+	}
+
+	// test lookup of several widgets at once
+	for(bool use_index : {false, true}){
+		auto w = m.context->inflater.inflate_as<morda::container>(layout);
+		ASSERT_ALWAYS(w)
+
+		w->set_id_index_enabled(use_index);
+
+		auto ws = w->try_get_widgets({"5", "root", "unknown", "1", "5"});
+		ASSERT_ALWAYS(ws.size() == 5)
+		ASSERT_ALWAYS(ws[0] && ws[0]->id == "5")
+		ASSERT_ALWAYS(ws[1] == w)
+		ASSERT_ALWAYS(!ws[2])
+		ASSERT_ALWAYS(ws[3] && ws[3]->id == "1")
+		ASSERT_ALWAYS(ws[4] == ws[0])
+
+		ws = w->try_get_widgets({"root", "2"}, false);
+		ASSERT_ALWAYS(!ws[0])
+		ASSERT_ALWAYS(ws[1] && ws[1]->id == "2")
+	}
+
+	return 0;
+}
@@ -1,5 +1,6 @@
 #include "../../../src/morda/morda/context.hpp"
 #include "../../../src/morda/morda/widgets/group/pile.hpp"
+#include "../../../src/morda/morda/widgets/group/row.hpp"
 #include "../../../src/morda/morda/widgets/proxy/ratio_proxy.hpp"
 
 #include "../../harness/fake_renderer/fake_renderer.hpp"
@@ -404,5 +405,214 @@ int main(int argc, char** argv){
 		ASSERT_INFO_ALWAYS(w->rect().p.x() == 2, "w->rect().p.x() = " << w->rect().p.x())
 	}
 
+	// test inflating from blueprint
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+		auto bp = m.context->inflater.compile(treeml::read(R"qwertyuiop(
+			defs{
+				dims{dx{max} dy{123}}
+
+				@Cont{ x
+					@container{
+						x{${x}}
+						layout{
+							dx{fill} dy{456}
+						}
+					}
+				}
+			}
+			@container{
+				defs{
+					test_x{17}
+				}
+
+				@Cont{
+					x{${test_x}}
+					layout{
+						${dims}
+					}
+				}
+
+				@pile{
+					@Cont{}
+				}
+			}
+		)qwertyuiop"));
+		ASSERT_ALWAYS(bp)
+
+		// defs from the GUI script used for compiling are not left pushed
+		auto w = m.context->inflater.inflate(treeml::read(R"qwertyuiop(
+			@widget{
+				x{${test_x}}
+			}
+		)qwertyuiop"));
+		ASSERT_ALWAYS(w)
+		ASSERT_ALWAYS(w->rect().p.x() == 0)
+
+		for(unsigned i = 0; i != 2; ++i){
+			auto c = m.context->inflater.inflate_as<morda::container>(*bp);
+			ASSERT_ALWAYS(c)
+			ASSERT_ALWAYS(c->children().size() == 2)
+
+			auto& first = *c->children().front();
+			ASSERT_ALWAYS(dynamic_cast<morda::container*>(&first))
+			ASSERT_INFO_ALWAYS(first.rect().p.x() == 17, "first.rect().p.x() = " << first.rect().p.x())
+			auto lp = first.get_layout_params();
+			ASSERT_ALWAYS(lp.dims[0] == morda::widget::layout_params::max)
+			ASSERT_ALWAYS(lp.dims[1] == 123)
+
+			auto p = std::dynamic_pointer_cast<morda::pile>(c->children().back());
+			ASSERT_ALWAYS(p)
+			ASSERT_ALWAYS(p->children().size() == 1)
+			lp = p->children().front()->get_layout_params();
+			ASSERT_ALWAYS(lp.dims[0] == morda::widget::layout_params::fill)
+			ASSERT_ALWAYS(lp.dims[1] == 456)
+		}
+	}
+
+	// test inflating in arena
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		auto a = std::make_shared<morda::arena>(1024);
+
+		auto c = std::dynamic_pointer_cast<morda::container>(m.context->inflater.inflate(treeml::read(R"qwertyuiop(
+			@container{
+				@widget{}
+				@pile{
+					@widget{}
+				}
+			}
+		)qwertyuiop"), a));
+		ASSERT_ALWAYS(c)
+		ASSERT_ALWAYS(c->children().size() == 2)
+
+		// all widgets, including the child widgets inflated by containers, are allocated in the arena
+		auto stats = a->get_statistics();
+		ASSERT_INFO_ALWAYS(stats.num_allocations == 4, "stats.num_allocations = " << stats.num_allocations)
+		ASSERT_ALWAYS(stats.num_deallocations == 0)
+		ASSERT_ALWAYS(stats.num_blocks != 0)
+		ASSERT_ALWAYS(stats.num_bytes_reserved >= stats.num_bytes_allocated)
+
+		// widgets inflated after the call are not allocated in the arena
+		ASSERT_ALWAYS(m.context->inflater.inflate(treeml::read("@widget{}")))
+		ASSERT_ALWAYS(a->get_statistics().num_allocations == 4)
+
+		std::weak_ptr<morda::arena> weak_arena = a;
+		a.reset();
+
+		// widgets keep the arena alive
+		ASSERT_ALWAYS(weak_arena.lock())
+
+		c.reset();
+
+		// all the arena memory is freed at once when the last widget is destroyed
+		ASSERT_ALWAYS(!weak_arena.lock())
+	}
+
+	// test layout parameters and out of line data are allocated in the arena
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		auto a = std::make_shared<morda::arena>(1024);
+
+		auto c = std::dynamic_pointer_cast<morda::container>(m.context->inflater.inflate(treeml::read(R"qwertyuiop(
+			@container{
+				@widget{
+					layout{
+						dx{10}
+						weight{1}
+					}
+				}
+			}
+		)qwertyuiop"), a));
+		ASSERT_ALWAYS(c)
+		ASSERT_ALWAYS(c->children().size() == 1)
+
+		// two widgets and the out of line data holding the layout description of the child
+		auto num_allocations = a->get_statistics().num_allocations;
+		ASSERT_INFO_ALWAYS(num_allocations == 3, "num_allocations = " << num_allocations)
+
+		// layout parameters parsed after inflating are allocated in the arena as well
+		c->get_layout_params_const(*c->children().front());
+		ASSERT_ALWAYS(a->get_statistics().num_allocations == num_allocations + 1)
+
+		std::weak_ptr<morda::arena> weak_arena = a;
+		a.reset();
+
+		// weak pointer to a widget keeps the whole arena allocated
+		std::weak_ptr<morda::widget> weak_widget = c->children().front();
+		c.reset();
+		ASSERT_ALWAYS(weak_arena.lock())
+
+		weak_widget.reset();
+		ASSERT_ALWAYS(!weak_arena.lock())
+	}
+
+	// test that replacing widget passes container specific layout parameters to the new widget
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		auto p = m.context->inflater.inflate_as<morda::pile>(R"qwertyuiop(
+			@pile{
+				@widget{
+					id{a}
+					layout{
+						dx{10}
+						weight{2}
+					}
+				}
+			}
+		)qwertyuiop");
+		ASSERT_ALWAYS(p)
+
+		auto& a = p->get_widget("a");
+
+		// parse layout parameters as the pile sees them
+		ASSERT_ALWAYS(p->get_layout_params_const(a).dims.x() == 10)
+
+		auto b = std::make_shared<morda::widget>(m.context, treeml::forest());
+		a.replace_by(b);
+		ASSERT_ALWAYS(p->children().size() == 1)
+		ASSERT_ALWAYS(p->children().front() == b)
+
+		b->remove_from_parent();
+
+		auto r = std::make_shared<morda::row>(m.context, treeml::forest());
+		r->push_back(b);
+
+		auto& lp = r->get_layout_params_as_const<morda::linear_container::layout_params>(*b);
+		ASSERT_INFO_ALWAYS(lp.weight == 2, "lp.weight = " << lp.weight)
+		ASSERT_ALWAYS(lp.dims.x() == 10)
+	}
+
 	return 0;
 }
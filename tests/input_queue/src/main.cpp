@@ -0,0 +1,127 @@
+#include "../../../src/morda/morda/gui.hpp"
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+#include <utki/debug.hpp>
+
+namespace{
+class recording_widget : public morda::widget{
+public:
+	std::vector<std::string> log;
+	std::vector<morda::vector2> moves;
+	std::vector<std::vector<morda::vector2>> histories;
+
+	recording_widget(std::shared_ptr<morda::context> c) :
+			widget(std::move(c), treeml::forest())
+	{}
+
+	bool on_mouse_move(const morda::mouse_move_event& e)override{
+		this->log.push_back("move" + std::to_string(e.pointer_id));
+		this->moves.push_back(e.pos);
+		this->histories.emplace_back(e.history.begin(), e.history.end());
+		return true;
+	}
+
+	bool on_mouse_button(const morda::mouse_button_event& e)override{
+		this->log.push_back(e.is_down ? "down" : "up");
+		return true;
+	}
+
+	bool on_key(bool is_down, morda::key key_code)override{
+		this->log.push_back("key");
+		return true;
+	}
+};
+
+std::shared_ptr<morda::context> make_context(){
+	return std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		);
+}
+}
+
+int main(int argc, char** argv){
+	// without queueing events are delivered right away
+	{
+		morda::gui g(make_context());
+		auto w = std::make_shared<recording_widget>(g.context);
+		g.set_root(w);
+		g.set_viewport(morda::vector2(100, 100));
+
+		g.send_mouse_move(morda::vector2(1, 1), 0);
+		g.send_mouse_move(morda::vector2(2, 2), 0);
+		ASSERT_ALWAYS(w->moves.size() == 2)
+		ASSERT_ALWAYS(w->histories[1].empty())
+		ASSERT_ALWAYS(g.get_num_queued_input_events() == 0)
+	}
+
+	// consecutive moves are coalesced per pointer, other events keep their order
+	{
+		morda::gui g(make_context());
+		auto w = std::make_shared<recording_widget>(g.context);
+		g.set_root(w);
+		g.set_viewport(morda::vector2(100, 100));
+
+		g.set_input_queueing(true);
+
+		for(unsigned i = 0; i != 10; ++i){
+			g.send_mouse_move(morda::vector2(float(i)), 0);
+			g.send_mouse_move(morda::vector2(float(i), 50), 1);
+		}
+		g.send_mouse_button(true, morda::vector2(9), morda::mouse_button::left, 0);
+		g.send_mouse_move(morda::vector2(20), 0);
+		g.send_mouse_move(morda::vector2(30), 0);
+		g.send_key(true, morda::key::a);
+		g.send_mouse_button(false, morda::vector2(30), morda::mouse_button::left, 0);
+
+		ASSERT_INFO_ALWAYS(g.get_num_queued_input_events() == 6, "num events = " << g.get_num_queued_input_events())
+		ASSERT_ALWAYS(w->log.empty())
+
+		g.update();
+
+		ASSERT_ALWAYS(g.get_num_queued_input_events() == 0)
+
+		const std::vector<std::string> expected = {"move0", "move1", "down", "move0", "key", "up"};
+		ASSERT_ALWAYS(w->log == expected)
+
+		ASSERT_ALWAYS(w->moves[0] == morda::vector2(9))
+		ASSERT_ALWAYS(w->moves[1] == morda::vector2(9, 50))
+		ASSERT_ALWAYS(w->moves[3] == morda::vector2(30))
+
+		// history holds earlier positions relative to the event position
+		ASSERT_ALWAYS(w->histories[0].size() == 9)
+		ASSERT_ALWAYS(w->histories[0][0] == morda::vector2(-9))
+		ASSERT_ALWAYS(w->histories[0][8] == morda::vector2(-1))
+		ASSERT_ALWAYS(w->histories[3].size() == 1)
+		ASSERT_ALWAYS(w->histories[3][0] == morda::vector2(-10))
+	}
+
+	// history size limit, disabling queueing flushes the queue
+	{
+		morda::gui g(make_context());
+		auto w = std::make_shared<recording_widget>(g.context);
+		g.set_root(w);
+		g.set_viewport(morda::vector2(100, 100));
+
+		g.set_input_queueing(true);
+		g.set_max_mouse_move_history(3);
+
+		for(unsigned i = 0; i != 10; ++i){
+			g.send_mouse_move(morda::vector2(float(i)), 0);
+		}
+
+		g.set_input_queueing(false);
+
+		ASSERT_ALWAYS(w->moves.size() == 1)
+		ASSERT_ALWAYS(w->histories[0].size() == 3)
+		ASSERT_ALWAYS(w->histories[0][0] == morda::vector2(-3))
+		ASSERT_ALWAYS(w->histories[0][2] == morda::vector2(-1))
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+#include "../../../src/morda/morda/util/ktx_image.hpp"
+
+#include <utki/debug.hpp>
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+namespace{
+void append_u32(std::vector<std::uint8_t>& v, std::uint32_t n, bool big_endian){
+	for(unsigned i = 0; i != 4; ++i){
+		unsigned shift = big_endian ? (3 - i) * 8 : i * 8;
+		v.push_back(std::uint8_t(n >> shift));
+	}
+}
+
+// KTX file with one ETC2 RGB mipmap level of 8x4 pixels, i.e. two 4x4 blocks
+std::vector<std::uint8_t> make_compressed_ktx(bool big_endian){
+	std::vector<std::uint8_t> ret = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+	append_u32(ret, 0x04030201, big_endian);
+	append_u32(ret, 0, big_endian); // glType
+	append_u32(ret, 1, big_endian); // glTypeSize
+	append_u32(ret, 0, big_endian); // glFormat
+	append_u32(ret, 0x9274, big_endian); // glInternalFormat
+	append_u32(ret, 0x1907, big_endian); // glBaseInternalFormat
+	append_u32(ret, 8, big_endian);
+	append_u32(ret, 4, big_endian);
+	append_u32(ret, 0, big_endian); // pixelDepth
+	append_u32(ret, 0, big_endian); // numberOfArrayElements
+	append_u32(ret, 1, big_endian); // numberOfFaces
+	append_u32(ret, 1, big_endian); // numberOfMipmapLevels
+	append_u32(ret, 4, big_endian); // bytesOfKeyValueData
+	append_u32(ret, 0, big_endian); // key-value data
+	append_u32(ret, 16, big_endian); // imageSize
+	for(unsigned i = 0; i != 16; ++i){
+		ret.push_back(std::uint8_t(i));
+	}
+	return ret;
+}
+}
+
+int main(int argc, char** argv){
+	// compressed data sizes
+	{
+		ASSERT_ALWAYS(morda::texture_2d::compressed_size(morda::texture_2d::compression::etc1_rgb, r4::vector2<unsigned>(4, 4)) == 8)
+		ASSERT_ALWAYS(morda::texture_2d::compressed_size(morda::texture_2d::compression::bc1_rgba, r4::vector2<unsigned>(5, 1)) == 16)
+		ASSERT_ALWAYS(morda::texture_2d::compressed_size(morda::texture_2d::compression::bc7_rgba, r4::vector2<unsigned>(1, 1)) == 16)
+		ASSERT_ALWAYS(morda::texture_2d::compressed_size(morda::texture_2d::compression::etc2_rgba, r4::vector2<unsigned>(16, 8)) == 8 * 16)
+
+		// mipmap levels: 16x8, 8x4, 4x2 and 2x1 take one block row each, then 1x1
+		ASSERT_ALWAYS(morda::texture_2d::calc_memory_size(morda::texture_2d::compression::etc2_rgba, r4::vector2<unsigned>(16, 8), 5) == 16 * (8 + 2 + 1 + 1 + 1))
+		ASSERT_ALWAYS(morda::texture_2d::calc_memory_size(morda::texture_2d::type::grey_alpha, r4::vector2<unsigned>(5, 3), 3) == 2 * (5 * 3 + 2 * 1 + 1 * 1))
+	}
+
+	// write and read back uncompressed image with mipmaps, odd width requires row padding
+	{
+		morda::raster_image im(r4::vector2<unsigned>(5, 3), morda::raster_image::color_depth::grey_alpha);
+		auto pixels = im.pixels();
+		for(unsigned i = 0; i != pixels.size(); ++i){
+			pixels[i] = std::uint8_t(i * 7);
+		}
+
+		auto data = morda::ktx_image::write(im, true);
+		ASSERT_ALWAYS(morda::ktx_image::is_ktx(utki::make_span(data)))
+
+		morda::ktx_image ktx(utki::make_span(data));
+		ASSERT_ALWAYS(!ktx.is_compressed())
+		ASSERT_ALWAYS(ktx.type() == morda::texture_2d::type::grey_alpha)
+		ASSERT_ALWAYS(ktx.dims() == r4::vector2<unsigned>(5, 3))
+		ASSERT_INFO_ALWAYS(ktx.mips().size() == 3, "ktx.mips().size() = " << ktx.mips().size())
+		ASSERT_ALWAYS(ktx.mips()[0].size() == pixels.size())
+		ASSERT_ALWAYS(std::memcmp(ktx.mips()[0].data(), pixels.data(), pixels.size()) == 0)
+		ASSERT_ALWAYS(ktx.mips()[1].size() == 2 * 1 * 2)
+		ASSERT_ALWAYS(ktx.mips()[2].size() == 1 * 1 * 2)
+	}
+
+	// no mipmaps
+	{
+		morda::raster_image im(r4::vector2<unsigned>(4, 4), morda::raster_image::color_depth::rgba);
+		auto data = morda::ktx_image::write(im, false);
+		morda::ktx_image ktx(utki::make_span(data));
+		ASSERT_ALWAYS(ktx.type() == morda::texture_2d::type::rgba)
+		ASSERT_ALWAYS(ktx.mips().size() == 1)
+		ASSERT_ALWAYS(ktx.mips()[0].size() == 4 * 4 * 4)
+	}
+
+	// compressed, both byte orders
+	for(bool big_endian : {false, true}){
+		auto data = make_compressed_ktx(big_endian);
+		morda::ktx_image ktx(utki::make_span(data));
+		ASSERT_ALWAYS(ktx.is_compressed())
+		ASSERT_ALWAYS(ktx.compression() == morda::texture_2d::compression::etc2_rgb)
+		ASSERT_ALWAYS(ktx.dims() == r4::vector2<unsigned>(8, 4))
+		ASSERT_ALWAYS(ktx.mips().size() == 1)
+		ASSERT_ALWAYS(ktx.mips()[0].size() == 16)
+		ASSERT_ALWAYS(ktx.mips()[0][15] == 15)
+	}
+
+	// truncated and invalid data
+	{
+		auto data = make_compressed_ktx(false);
+		data.resize(data.size() - 1);
+
+		bool thrown = false;
+		try{
+			morda::ktx_image ktx(utki::make_span(data));
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		data[0] = 0;
+		ASSERT_ALWAYS(!morda::ktx_image::is_ktx(utki::make_span(data)))
+	}
+
+	return 0;
+}
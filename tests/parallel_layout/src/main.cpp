@@ -0,0 +1,299 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/layout_scheduler.hpp"
+#include "../../../src/morda/morda/widgets/group/pile.hpp"
+#include "../../../src/morda/morda/widgets/proxy/min_proxy.hpp"
+#include "../../../src/morda/morda/widgets/group/list.hpp"
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace{
+const auto layout = treeml::read(R"qwertyuiop(
+	@pile{
+		parallel_layout{true}
+
+		@column{
+			parallel_layout{true}
+			layout{dx{max} dy{max}}
+
+			@row{
+				parallel_layout{true}
+				@widget{layout{dx{10} dy{20}}}
+				@widget{layout{dx{30} dy{10} weight{1}}}
+				@pile{
+					@widget{layout{dx{5} dy{5}}}
+				}
+			}
+			@row{
+				layout{dx{fill} weight{1}}
+				@widget{layout{dx{10} dy{fill} weight{2}}}
+				@widget{layout{dx{15} dy{max} weight{1}}}
+			}
+		}
+
+		@row{
+			parallel_layout{true}
+			layout{dx{fill} dy{fill}}
+
+			@column{
+				layout{dy{fill} weight{1}}
+				@widget{layout{dx{max} dy{7} weight{1}}}
+				@widget{layout{dx{min} dy{3}}}
+			}
+			@column{
+				parallel_layout{true}
+				layout{dy{max} weight{3}}
+				@widget{layout{dx{fill} dy{11}}}
+				@widget{layout{dx{12} dy{13}}}
+			}
+		}
+	}
+)qwertyuiop");
+
+const auto min_proxy_layout = treeml::read(R"qwertyuiop(
+	@row{
+		parallel_layout{true}
+
+		@pile{
+			@min_proxy{
+				id{proxy}
+				target{target}
+			}
+		}
+		@pile{
+			@widget{layout{dx{10} dy{10}}}
+		}
+		@pile{
+			@sized_widget{
+				id{target}
+			}
+		}
+	}
+)qwertyuiop");
+
+const auto list_layout = treeml::read(R"qwertyuiop(
+	@row{
+		parallel_layout{true}
+
+		@pile{
+			layout{dx{max} dy{max}}
+			@list{
+				id{list}
+				layout{dx{max} dy{max}}
+				@ui_thread_widget{id{item0}}
+				@ui_thread_widget{id{item1}}
+				@ui_thread_widget{id{item2}}
+			}
+		}
+		@pile{
+			@widget{layout{dx{10} dy{10}}}
+		}
+		@column{
+			@widget{layout{dx{10} dy{10}}}
+		}
+	}
+)qwertyuiop");
+
+// widget which checks that it is created on the UI thread
+class ui_thread_widget : public morda::widget{
+public:
+	static std::thread::id ui_thread_id;
+
+	ui_thread_widget(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
+			morda::widget(std::move(c), desc)
+	{
+		ASSERT_ALWAYS(std::this_thread::get_id() == ui_thread_id)
+	}
+
+	morda::vector2 measure(const morda::vector2& quotum)const override{
+		return morda::vector2(10);
+	}
+};
+
+std::thread::id ui_thread_widget::ui_thread_id = std::this_thread::get_id();
+
+class sized_widget : public morda::widget{
+	morda::vector2 dims = morda::vector2(10, 20);
+public:
+	sized_widget(std::shared_ptr<morda::context> c, const treeml::forest& desc) :
+			morda::widget(std::move(c), desc)
+	{}
+
+	morda::vector2 measure(const morda::vector2& quotum)const override{
+		return this->dims;
+	}
+
+	void set_dims(const morda::vector2& dims){
+		this->dims = dims;
+		this->invalidate_layout();
+	}
+};
+
+void collect_rects(const morda::widget& w, std::vector<morda::rectangle>& rects){
+	rects.push_back(w.rect());
+	if(auto c = dynamic_cast<const morda::container*>(&w)){
+		for(auto& ch : c->children()){
+			collect_rects(*ch, rects);
+		}
+	}
+}
+}
+
+int main(int argc, char** argv){
+	// test layout_scheduler::for_each()
+	{
+		morda::layout_scheduler s(3);
+		ASSERT_ALWAYS(s.num_threads() == 3)
+
+		std::vector<std::atomic<unsigned>> counters(1000);
+		for(auto& c : counters){
+			c = 0;
+		}
+
+		s.for_each(counters.size(), [&counters](size_t i){
+			++counters[i];
+		});
+
+		for(auto& c : counters){
+			ASSERT_ALWAYS(c == 1)
+		}
+	}
+
+	// test nested layout_scheduler::for_each()
+	{
+		morda::layout_scheduler s(2);
+
+		std::atomic<unsigned> counter{0};
+
+		s.for_each(10, [&s, &counter](size_t i){
+			s.for_each(10, [&counter](size_t j){
+				++counter;
+			});
+		});
+
+		ASSERT_ALWAYS(counter == 100)
+	}
+
+	// test exception propagation from layout_scheduler::for_each()
+	{
+		morda::layout_scheduler s(2);
+
+		std::atomic<unsigned> counter{0};
+
+		bool thrown = false;
+		try{
+			s.for_each(20, [&counter](size_t i){
+				++counter;
+				if(i == 5){
+					throw std::runtime_error("test");
+				}
+			});
+		}catch(std::runtime_error&){
+			thrown = true;
+		}
+
+		ASSERT_ALWAYS(thrown)
+		ASSERT_ALWAYS(counter == 20)
+	}
+
+	// test that parallel layout gives same result as sequential one
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		std::vector<morda::rectangle> expected;
+		{
+			auto w = m.context->inflater.inflate(layout);
+			ASSERT_ALWAYS(w)
+			w->resize(morda::vector2(300, 200));
+			collect_rects(*w, expected);
+		}
+
+		m.context->layout_scheduler = std::make_shared<morda::layout_scheduler>(3);
+
+		auto w = m.context->inflater.inflate(layout);
+		ASSERT_ALWAYS(w)
+		w->resize(morda::vector2(300, 200));
+
+		std::vector<morda::rectangle> rects;
+		collect_rects(*w, rects);
+
+		ASSERT_ALWAYS(rects.size() == expected.size())
+		for(size_t i = 0; i != rects.size(); ++i){
+			ASSERT_INFO_ALWAYS(rects[i] == expected[i], "i = " << i << ", rect = " << rects[i] << ", expected = " << expected[i])
+		}
+
+		ASSERT_ALWAYS(!w->is_layout_invalid())
+	}
+
+	// test that min_proxy is laid out after its target and follows the target size changes
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		m.context->layout_scheduler = std::make_shared<morda::layout_scheduler>(3);
+		m.context->inflater.register_widget<sized_widget>("sized_widget");
+
+		auto w = m.context->inflater.inflate(min_proxy_layout);
+		ASSERT_ALWAYS(w)
+		w->resize(morda::vector2(300, 200));
+
+		auto& proxy = w->get_widget_as<morda::min_proxy>("proxy");
+		auto& target = w->get_widget_as<sized_widget>("target");
+
+		ASSERT_INFO_ALWAYS(proxy.rect().d == morda::vector2(10, 20), "proxy.rect().d = " << proxy.rect().d)
+
+		target.set_dims(morda::vector2(30, 5));
+		ASSERT_ALWAYS(proxy.is_layout_invalid())
+		ASSERT_ALWAYS(w->is_layout_invalid())
+
+		w->resize(w->rect().d);
+		ASSERT_INFO_ALWAYS(proxy.rect().d == morda::vector2(30, 5), "proxy.rect().d = " << proxy.rect().d)
+		ASSERT_ALWAYS(proxy.parent()->rect().d == morda::vector2(30, 5))
+	}
+
+	// test that list, which inflates its items during layout, is laid out on the UI thread
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		m.context->layout_scheduler = std::make_shared<morda::layout_scheduler>(3);
+		m.context->inflater.register_widget<ui_thread_widget>("ui_thread_widget");
+
+		auto w = m.context->inflater.inflate(list_layout);
+		ASSERT_ALWAYS(w)
+
+		for(unsigned i = 0; i != 10; ++i){
+			w->resize(morda::vector2(300, 200 + i));
+		}
+
+		auto& list = w->get_widget_as<morda::list>("list");
+		ASSERT_ALWAYS(list.children().size() == 3)
+
+		// items added during layout are in the id indices
+		ASSERT_ALWAYS(w->try_get_widget("item0"))
+		ASSERT_ALWAYS(w->try_get_widget("item2"))
+	}
+
+	return 0;
+}
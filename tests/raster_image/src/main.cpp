@@ -0,0 +1,371 @@
+#include "../../../src/morda/morda/util/raster_image.hpp"
+#include "../../../src/morda/morda/util/pixel_kernels.hpp"
+
+#include <utki/debug.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <functional>
+
+namespace{
+std::vector<std::uint8_t> make_random_buffer(size_t size){
+	std::mt19937 gen(size);
+	std::uniform_int_distribution<unsigned> dist(0, 0xff);
+	std::vector<std::uint8_t> ret(size);
+	for(auto& b : ret){
+		b = std::uint8_t(dist(gen));
+	}
+	return ret;
+}
+
+std::uint8_t reference_div_255(unsigned v){
+	return std::uint8_t((v + 127) / 255);
+}
+
+// pixel counts which are not multiple of vector sizes, to test the tails
+const size_t pixel_counts[] = {0, 1, 7, 15, 16, 17, 33, 100, 1027};
+
+void test_copy_channel(){
+	for(auto n : pixel_counts){
+		for(unsigned dst_nc = 1; dst_nc <= 4; ++dst_nc){
+			for(unsigned src_nc = 1; src_nc <= 4; ++src_nc){
+				for(unsigned dst_chan = 0; dst_chan != dst_nc; ++dst_chan){
+					for(unsigned src_chan = 0; src_chan != src_nc; ++src_chan){
+						auto src = make_random_buffer(n * src_nc);
+						auto dst = make_random_buffer(n * dst_nc + 1);
+						auto expected = dst;
+						for(size_t i = 0; i != n; ++i){
+							expected[i * dst_nc + dst_chan] = src[i * src_nc + src_chan];
+						}
+						morda::pixel_kernels::copy_channel(dst.data(), dst_nc, dst_chan, src.data(), src_nc, src_chan, n);
+						ASSERT_INFO_ALWAYS(dst == expected, "n = " << n << " dst_nc = " << dst_nc << " src_nc = " << src_nc)
+					}
+				}
+			}
+		}
+	}
+}
+
+void test_fill_channel(){
+	for(auto n : pixel_counts){
+		for(unsigned nc = 1; nc <= 4; ++nc){
+			for(unsigned chan = 0; chan != nc; ++chan){
+				auto buf = make_random_buffer(n * nc + 1);
+				auto expected = buf;
+				for(size_t i = 0; i != n; ++i){
+					expected[i * nc + chan] = 0x5a;
+				}
+				morda::pixel_kernels::fill_channel(buf.data(), nc, chan, 0x5a, n);
+				ASSERT_INFO_ALWAYS(buf == expected, "n = " << n << " nc = " << nc << " chan = " << chan)
+			}
+		}
+	}
+}
+
+void test_grey_alpha_expansion(){
+	for(auto n : pixel_counts){
+		auto src = make_random_buffer(n);
+
+		std::vector<std::uint8_t> expected(n * 2);
+		for(size_t i = 0; i != n; ++i){
+			expected[i * 2] = src[i];
+			expected[i * 2 + 1] = 0xa5;
+		}
+		std::vector<std::uint8_t> dst(n * 2);
+		morda::pixel_kernels::grey_to_grey_alpha(dst.data(), src.data(), n, 0xa5);
+		ASSERT_INFO_ALWAYS(dst == expected, "n = " << n)
+
+		for(size_t i = 0; i != n; ++i){
+			expected[i * 2] = 0xff;
+			expected[i * 2 + 1] = src[i];
+		}
+		morda::pixel_kernels::alpha_to_grey_alpha(dst.data(), src.data(), n, 0xff);
+		ASSERT_INFO_ALWAYS(dst == expected, "n = " << n)
+	}
+}
+
+void test_premultiply_alpha(){
+	// all combinations of color and alpha values
+	std::vector<std::uint8_t> all(0x100 * 0x100 * 2);
+	for(unsigned i = 0; i != 0x10000; ++i){
+		all[i * 2] = std::uint8_t(i & 0xff);
+		all[i * 2 + 1] = std::uint8_t(i >> 8);
+	}
+	morda::pixel_kernels::premultiply_alpha(all.data(), 2, 0x10000);
+	for(unsigned i = 0; i != 0x10000; ++i){
+		unsigned c = i & 0xff;
+		unsigned a = i >> 8;
+		ASSERT_INFO_ALWAYS(all[i * 2] == reference_div_255(c * a), "c = " << c << " a = " << a)
+		ASSERT_ALWAYS(all[i * 2 + 1] == a)
+	}
+
+	for(auto n : pixel_counts){
+		auto buf = make_random_buffer(n * 4);
+		auto expected = buf;
+		for(size_t i = 0; i != n; ++i){
+			auto p = &expected[i * 4];
+			for(unsigned k = 0; k != 3; ++k){
+				p[k] = reference_div_255(unsigned(p[k]) * p[3]);
+			}
+		}
+		morda::pixel_kernels::premultiply_alpha(buf.data(), 4, n);
+		ASSERT_INFO_ALWAYS(buf == expected, "n = " << n)
+	}
+}
+
+void test_downscale(){
+	for(unsigned nc = 1; nc <= 4; ++nc){
+		for(r4::vector2<unsigned> dims : {r4::vector2<unsigned>(2, 2), r4::vector2<unsigned>(33, 7), r4::vector2<unsigned>(64, 64), r4::vector2<unsigned>(101, 50)}){
+			auto src = make_random_buffer(dims.x() * dims.y() * nc);
+			r4::vector2<unsigned> dst_dims(dims.x() / 2, dims.y() / 2);
+
+			std::vector<std::uint8_t> expected(dst_dims.x() * dst_dims.y() * nc);
+			auto e = expected.begin();
+			for(unsigned y = 0; y != dst_dims.y(); ++y){
+				for(unsigned x = 0; x != dst_dims.x(); ++x){
+					for(unsigned k = 0; k != nc; ++k, ++e){
+						auto pix = [&](unsigned i, unsigned j) -> unsigned{
+							return src[((y * 2 + j) * dims.x() + x * 2 + i) * nc + k];
+						};
+						*e = std::uint8_t((pix(0, 0) + pix(1, 0) + pix(0, 1) + pix(1, 1) + 2) / 4);
+					}
+				}
+			}
+
+			std::vector<std::uint8_t> dst(expected.size());
+			morda::pixel_kernels::downscale_2x(dst.data(), src.data(), dims, nc);
+			ASSERT_INFO_ALWAYS(dst == expected, "nc = " << nc << " dims = " << dims)
+
+			// box filter gives same result for exact halving
+			if(dims.x() % 2 == 0 && dims.y() % 2 == 0){
+				morda::pixel_kernels::downscale_box(dst.data(), dst_dims, src.data(), dims, nc);
+				ASSERT_INFO_ALWAYS(dst == expected, "nc = " << nc << " dims = " << dims)
+			}
+		}
+	}
+
+	// downscaling solid color keeps the color
+	{
+		std::vector<std::uint8_t> src(37 * 23 * 3, 0x77);
+		std::vector<std::uint8_t> dst(5 * 4 * 3);
+		morda::pixel_kernels::downscale_box(dst.data(), r4::vector2<unsigned>(5, 4), src.data(), r4::vector2<unsigned>(37, 23), 3);
+		for(auto b : dst){
+			ASSERT_ALWAYS(b == 0x77)
+		}
+		morda::pixel_kernels::resize_bilinear(dst.data(), r4::vector2<unsigned>(5, 4), src.data(), r4::vector2<unsigned>(37, 23), 3);
+		for(auto b : dst){
+			ASSERT_ALWAYS(b == 0x77)
+		}
+	}
+
+	// resizing to same size keeps the image
+	{
+		r4::vector2<unsigned> dims(19, 11);
+		auto src = make_random_buffer(dims.x() * dims.y() * 4);
+		std::vector<std::uint8_t> dst(src.size());
+		morda::pixel_kernels::resize_bilinear(dst.data(), dims, src.data(), dims, 4);
+		ASSERT_ALWAYS(dst == src)
+	}
+}
+
+void test_raster_image(){
+	morda::raster_image im(r4::vector2<unsigned>(10, 8), morda::raster_image::color_depth::rgba);
+	for(unsigned y = 0; y != im.dims().y(); ++y){
+		for(unsigned x = 0; x != im.dims().x(); ++x){
+			for(unsigned k = 0; k != 4; ++k){
+				im.pix_chan(x, y, k) = std::uint8_t(y * 40 + x * 4 + k);
+			}
+		}
+	}
+
+	// sub-image
+	{
+		morda::raster_image sub(r4::vector2<unsigned>(3, 2), r4::vector2<unsigned>(5, 4), im);
+		ASSERT_ALWAYS(sub.dims() == r4::vector2<unsigned>(5, 4))
+		ASSERT_ALWAYS(sub.depth() == morda::raster_image::color_depth::rgba)
+		for(unsigned y = 0; y != sub.dims().y(); ++y){
+			for(unsigned x = 0; x != sub.dims().x(); ++x){
+				for(unsigned k = 0; k != 4; ++k){
+					ASSERT_ALWAYS(sub.pix_chan(x, y, k) == im.pix_chan(x + 3, y + 2, k))
+				}
+			}
+		}
+
+		// blit it back to another place, the part out of image is clipped
+		morda::raster_image dst(im.dims(), im.depth());
+		dst.clear(std::uint8_t(0));
+		dst.blit(r4::vector2<unsigned>(7, 6), sub);
+		for(unsigned y = 0; y != dst.dims().y(); ++y){
+			for(unsigned x = 0; x != dst.dims().x(); ++x){
+				for(unsigned k = 0; k != 4; ++k){
+					if(x >= 7 && y >= 6){
+						ASSERT_ALWAYS(dst.pix_chan(x, y, k) == sub.pix_chan(x - 7, y - 6, k))
+					}else{
+						ASSERT_ALWAYS(dst.pix_chan(x, y, k) == 0)
+					}
+				}
+			}
+		}
+	}
+
+	// conversion
+	{
+		auto rgb = im.convert(morda::raster_image::color_depth::rgb);
+		ASSERT_ALWAYS(rgb.depth() == morda::raster_image::color_depth::rgb)
+		auto rgba = rgb.convert(morda::raster_image::color_depth::rgba);
+		for(unsigned y = 0; y != im.dims().y(); ++y){
+			for(unsigned x = 0; x != im.dims().x(); ++x){
+				for(unsigned k = 0; k != 3; ++k){
+					ASSERT_ALWAYS(rgba.pix_chan(x, y, k) == im.pix_chan(x, y, k))
+				}
+				ASSERT_ALWAYS(rgba.pix_chan(x, y, 3) == 0xff)
+			}
+		}
+
+		auto grey = rgb.convert(morda::raster_image::color_depth::grey);
+		auto grey_alpha = grey.convert(morda::raster_image::color_depth::grey_alpha);
+		auto grey_rgba = grey_alpha.convert(morda::raster_image::color_depth::rgba);
+		for(unsigned y = 0; y != im.dims().y(); ++y){
+			for(unsigned x = 0; x != im.dims().x(); ++x){
+				ASSERT_ALWAYS(grey_alpha.pix_chan(x, y, 0) == grey.pix_chan(x, y, 0))
+				ASSERT_ALWAYS(grey_alpha.pix_chan(x, y, 1) == 0xff)
+				for(unsigned k = 0; k != 3; ++k){
+					ASSERT_ALWAYS(grey_rgba.pix_chan(x, y, k) == grey.pix_chan(x, y, 0))
+				}
+			}
+		}
+	}
+
+	// downscaling
+	{
+		auto half = im.downscale(r4::vector2<unsigned>(5, 4));
+		ASSERT_ALWAYS(half.dims() == r4::vector2<unsigned>(5, 4))
+		auto bilinear = im.resize_bilinear(r4::vector2<unsigned>(20, 3));
+		ASSERT_ALWAYS(bilinear.dims() == r4::vector2<unsigned>(20, 3))
+
+		bool thrown = false;
+		try{
+			im.downscale(r4::vector2<unsigned>(11, 4));
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+}
+
+void test_decode_to_dims(){
+	const papki::fs_file png_file("../app/res/sample.png");
+	const papki::fs_file jpg_file("../book/res/texture.jpg");
+
+	ASSERT_ALWAYS(morda::raster_image::read_dims(png_file) == r4::vector2<unsigned>(640, 480))
+	ASSERT_ALWAYS(morda::raster_image::read_dims(jpg_file) == r4::vector2<unsigned>(512, 512))
+
+	// PNG is downscaled while decoding, same as downscaling the full size image
+	{
+		morda::raster_image full(png_file);
+		ASSERT_ALWAYS(full.dims() == r4::vector2<unsigned>(640, 480))
+
+		morda::raster_image im(png_file, r4::vector2<unsigned>(100, 0));
+		ASSERT_INFO_ALWAYS(im.dims() == r4::vector2<unsigned>(160, 120), "im.dims() = " << im.dims())
+		ASSERT_ALWAYS(im.depth() == full.depth())
+
+		auto expected = full.downscale(im.dims());
+		ASSERT_ALWAYS(im.pixels().size() == expected.pixels().size())
+		ASSERT_ALWAYS(std::equal(im.pixels().begin(), im.pixels().end(), expected.pixels().begin()))
+
+		// non-power of 2 reduction, dimensions are rounded up
+		morda::raster_image im3(png_file, r4::vector2<unsigned>(0, 59));
+		ASSERT_INFO_ALWAYS(im3.dims() == r4::vector2<unsigned>(80, 60), "im3.dims() = " << im3.dims())
+
+		// requested dimensions bigger than the image give full size image
+		morda::raster_image im2(png_file, r4::vector2<unsigned>(1000, 1000));
+		ASSERT_ALWAYS(im2.dims() == full.dims())
+	}
+
+	// JPG is decoded with DCT scaling
+	{
+		morda::raster_image im(jpg_file, r4::vector2<unsigned>(100, 100));
+		ASSERT_INFO_ALWAYS(im.dims() == r4::vector2<unsigned>(128, 128), "im.dims() = " << im.dims())
+
+		// reduction is limited to 1/8
+		morda::raster_image im2(jpg_file, r4::vector2<unsigned>(1, 1));
+		ASSERT_INFO_ALWAYS(im2.dims() == r4::vector2<unsigned>(64, 64), "im2.dims() = " << im2.dims())
+
+		morda::raster_image full(jpg_file, r4::vector2<unsigned>(0));
+		ASSERT_ALWAYS(full.dims() == r4::vector2<unsigned>(512, 512))
+	}
+}
+
+// benchmark on 1024x1024 pixels
+void benchmark(const char* name, const std::function<void()>& kernel){
+	const unsigned num_iterations = 20;
+
+	kernel(); // warm up
+
+	auto start = std::chrono::steady_clock::now();
+	for(unsigned i = 0; i != num_iterations; ++i){
+		kernel();
+	}
+	auto duration = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+	std::cout << "\t" << name << ": " << (duration.count() / num_iterations) << " us per megapixel" << std::endl;
+}
+
+void run_benchmarks(){
+	std::cout << "pixel kernels benchmark, instruction set: " << morda::pixel_kernels::instruction_set() << std::endl;
+
+	const r4::vector2<unsigned> dims(1024, 1024);
+	const size_t n = dims.x() * dims.y();
+
+	auto rgba = make_random_buffer(n * 4);
+	auto rgba2 = rgba;
+	auto grey = make_random_buffer(n);
+	std::vector<std::uint8_t> grey_alpha(n * 2);
+
+	benchmark("copy_rows (sub-rect copy, blit)", [&](){
+		morda::pixel_kernels::copy_rows(rgba2.data(), dims.x() * 4, rgba.data(), dims.x() * 4, (dims.x() - 1) * 4, dims.y());
+	});
+	benchmark("copy_channel (insert)", [&](){
+		morda::pixel_kernels::copy_channel(rgba2.data(), 4, 3, grey.data(), 1, 0, n);
+	});
+	benchmark("copy_channel (extract)", [&](){
+		morda::pixel_kernels::copy_channel(grey.data(), 1, 0, rgba.data(), 4, 1, n);
+	});
+	benchmark("fill_channel", [&](){
+		morda::pixel_kernels::fill_channel(rgba2.data(), 4, 3, 0xff, n);
+	});
+	benchmark("alpha_to_grey_alpha", [&](){
+		morda::pixel_kernels::alpha_to_grey_alpha(grey_alpha.data(), grey.data(), n, 0xff);
+	});
+	benchmark("premultiply_alpha", [&](){
+		morda::pixel_kernels::premultiply_alpha(rgba2.data(), 4, n);
+	});
+	benchmark("downscale_2x", [&](){
+		morda::pixel_kernels::downscale_2x(rgba2.data(), rgba.data(), dims, 4);
+	});
+	benchmark("downscale_box", [&](){
+		morda::pixel_kernels::downscale_box(rgba2.data(), r4::vector2<unsigned>(300, 300), rgba.data(), dims, 4);
+	});
+	benchmark("resize_bilinear", [&](){
+		morda::pixel_kernels::resize_bilinear(rgba2.data(), r4::vector2<unsigned>(700, 700), rgba.data(), dims, 4);
+	});
+}
+}
+
+int main(int argc, char** argv){
+	test_copy_channel();
+	test_fill_channel();
+	test_grey_alpha_expansion();
+	test_premultiply_alpha();
+	test_downscale();
+	test_raster_image();
+	test_decode_to_dims();
+
+	run_benchmarks();
+
+	return 0;
+}
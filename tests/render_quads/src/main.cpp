@@ -0,0 +1,371 @@
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+#include <utki/debug.hpp>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <iostream>
+
+namespace{
+template <class T> class test_vertex_buffer : public morda::vertex_buffer{
+public:
+	std::vector<T> data;
+
+	test_vertex_buffer(utki::span<const T> data) :
+			morda::vertex_buffer(data.size()),
+			data(data.begin(), data.end())
+	{}
+
+	using morda::vertex_buffer::update;
+
+	bool update(utki::span<const T> data)override{
+		ASSERT_ALWAYS(data.size() == this->size)
+		this->data.assign(data.begin(), data.end());
+		return true;
+	}
+};
+
+class test_index_buffer : public morda::index_buffer{
+public:
+	const std::vector<std::uint16_t> data;
+
+	test_index_buffer(utki::span<const std::uint16_t> data) :
+			data(data.begin(), data.end())
+	{}
+};
+
+struct draw_log{
+	unsigned num_draws = 0;
+	unsigned num_instanced_draws = 0;
+	size_t num_instances = 0;
+	unsigned num_created_buffers = 0;
+	r4::vector4<float> last_color;
+
+	// keep the buffers of the last draw call
+	std::vector<std::shared_ptr<morda::vertex_buffer>> last_buffers;
+	std::shared_ptr<morda::index_buffer> last_indices;
+	morda::vertex_array::mode last_mode;
+
+	void record(const morda::vertex_array& va){
+		++this->num_draws;
+		this->last_buffers = va.buffers;
+		this->last_indices = va.indices;
+		this->last_mode = va.rendering_mode;
+	}
+};
+
+class test_shader : public morda::shader{
+	draw_log& log;
+public:
+	test_shader(draw_log& log) : log(log){}
+
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va)const override{
+		this->log.record(va);
+	}
+};
+
+class test_coloring_shader : public morda::coloring_shader{
+	draw_log& log;
+public:
+	test_coloring_shader(draw_log& log) : log(log){}
+
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color)const override{
+		this->log.record(va);
+		this->log.last_color = color;
+	}
+};
+
+class test_coloring_texturing_shader : public morda::coloring_texturing_shader{
+	draw_log& log;
+public:
+	test_coloring_texturing_shader(draw_log& log) : log(log){}
+
+	void render(const r4::matrix4<float>& m, const morda::vertex_array& va, r4::vector4<float> color, const morda::texture_2d& tex)const override{
+		this->log.record(va);
+		this->log.last_color = color;
+	}
+};
+
+class test_instanced_quad_shader : public morda::instanced_quad_shader{
+	draw_log& log;
+public:
+	test_instanced_quad_shader(draw_log& log) : log(log){}
+
+	void render(utki::span<const morda::quad_instance> instances)const override{
+		++this->log.num_instanced_draws;
+		this->log.num_instances += instances.size();
+	}
+
+	void render(utki::span<const morda::quad_instance> instances, const morda::texture_2d& tex)const override{
+		++this->log.num_instanced_draws;
+		this->log.num_instances += instances.size();
+	}
+};
+
+class test_factory : public FakeFactory{
+	draw_log& log;
+	bool instancing;
+public:
+	test_factory(draw_log& log, bool instancing) :
+			log(log),
+			instancing(instancing)
+	{}
+
+	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector2<float>> vertices)override{
+		++this->log.num_created_buffers;
+		return std::make_shared<test_vertex_buffer<r4::vector2<float>>>(vertices);
+	}
+
+	std::shared_ptr<morda::vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices)override{
+		++this->log.num_created_buffers;
+		return std::make_shared<test_vertex_buffer<r4::vector4<float>>>(vertices);
+	}
+
+	std::shared_ptr<morda::index_buffer> create_index_buffer(utki::span<const std::uint16_t> indices)override{
+		return std::make_shared<test_index_buffer>(indices);
+	}
+
+	std::shared_ptr<morda::vertex_array> create_vertex_array(
+			std::vector<std::shared_ptr<morda::vertex_buffer>>&& buffers,
+			std::shared_ptr<morda::index_buffer> indices,
+			morda::vertex_array::mode rendering_mode
+		)override
+	{
+		return std::make_shared<morda::vertex_array>(std::move(buffers), std::move(indices), rendering_mode);
+	}
+
+	std::unique_ptr<morda::render_factory::shaders> create_shaders()override{
+		auto ret = std::make_unique<morda::render_factory::shaders>();
+		ret->pos_clr = std::make_unique<test_shader>(this->log);
+		ret->color_pos = std::make_unique<test_coloring_shader>(this->log);
+		ret->color_pos_tex = std::make_unique<test_coloring_texturing_shader>(this->log);
+		if(this->instancing){
+			ret->instanced_quad = std::make_unique<test_instanced_quad_shader>(this->log);
+		}
+		return ret;
+	}
+};
+
+template <class T> const std::vector<T>& get_data(const draw_log& log, size_t buffer_index){
+	ASSERT_ALWAYS(buffer_index < log.last_buffers.size())
+	auto b = dynamic_cast<const test_vertex_buffer<T>*>(log.last_buffers[buffer_index].get());
+	ASSERT_ALWAYS(b)
+	return b->data;
+}
+
+morda::quad_instance make_quad(r4::vector4<float> color, r4::vector4<float> tex_rect = r4::vector4<float>(0, 0, 1, 1)){
+	morda::quad_instance q;
+	q.matrix.set_identity();
+	q.color = color;
+	q.tex_rect = tex_rect;
+	return q;
+}
+}
+
+int main(int argc, char** argv){
+	const r4::vector4<float> red(1, 0, 0, 1);
+	const r4::vector4<float> green(0, 1, 0, 1);
+
+	// solid quads without instancing are expanded to one draw call
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, false));
+
+		std::vector<morda::quad_instance> quads = {make_quad(red), make_quad(green), make_quad(red)};
+
+		r.render_quads(utki::make_span(quads));
+
+		ASSERT_INFO_ALWAYS(log.num_draws == 1, "log.num_draws = " << log.num_draws)
+		ASSERT_ALWAYS(log.num_instanced_draws == 0)
+		ASSERT_ALWAYS(log.last_mode == morda::vertex_array::mode::triangles)
+
+		// the buffers are rounded up to the power of two number of quads, the tail is filled with degenerate quads
+		auto& pos = get_data<r4::vector4<float>>(log, 0);
+		auto& colors = get_data<r4::vector4<float>>(log, 1);
+		ASSERT_ALWAYS(pos.size() == 16)
+		ASSERT_ALWAYS(colors.size() == 16)
+		ASSERT_ALWAYS(pos[12] == r4::vector4<float>(0))
+		ASSERT_ALWAYS(pos[15] == r4::vector4<float>(0))
+		ASSERT_ALWAYS(pos[5] == r4::vector4<float>(0, 1, 0, 1))
+		ASSERT_ALWAYS(pos[6] == r4::vector4<float>(1, 1, 0, 1))
+		ASSERT_ALWAYS(colors[3] == red)
+		ASSERT_ALWAYS(colors[4] == green)
+		ASSERT_ALWAYS(colors[7] == green)
+		ASSERT_ALWAYS(colors[8] == red)
+
+		auto indices = dynamic_cast<const test_index_buffer*>(log.last_indices.get());
+		ASSERT_ALWAYS(indices)
+		ASSERT_ALWAYS(indices->data.size() == 24)
+		ASSERT_ALWAYS((std::vector<std::uint16_t>(indices->data.begin() + 6, indices->data.begin() + 12) == std::vector<std::uint16_t>{4, 5, 6, 4, 6, 7}))
+	}
+
+	// textured quads without instancing are drawn once per run of the same color
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, false));
+
+		fake_texture_2d tex;
+
+		std::vector<morda::quad_instance> quads = {
+			make_quad(red, r4::vector4<float>(0, 0, 0.5, 0.5)),
+			make_quad(red, r4::vector4<float>(0.5, 0.5, 1, 1)),
+			make_quad(green)
+		};
+
+		r.render_quads(utki::make_span(quads), tex);
+
+		ASSERT_INFO_ALWAYS(log.num_draws == 2, "log.num_draws = " << log.num_draws)
+		ASSERT_ALWAYS(log.last_color == green)
+
+		// single quad covering the whole texture is drawn with the unit quad vertex array
+		ASSERT_ALWAYS(log.last_buffers == r.pos_tex_quad_01_vao->buffers)
+	}
+
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, false));
+
+		fake_texture_2d tex;
+
+		std::vector<morda::quad_instance> quads = {
+			make_quad(red, r4::vector4<float>(0, 0, 0.5, 0.5)),
+			make_quad(red, r4::vector4<float>(0.5, 0.5, 1, 1))
+		};
+
+		r.render_quads(utki::make_span(quads), tex);
+
+		ASSERT_ALWAYS(log.num_draws == 1)
+		ASSERT_ALWAYS(log.last_color == red)
+
+		auto& tc = get_data<r4::vector2<float>>(log, 1);
+		ASSERT_ALWAYS(tc.size() == 8)
+		ASSERT_ALWAYS(tc[0] == r4::vector2<float>(0, 0))
+		ASSERT_ALWAYS(tc[2] == r4::vector2<float>(0.5, 0.5))
+		ASSERT_ALWAYS(tc[4] == r4::vector2<float>(0.5, 0.5))
+		ASSERT_ALWAYS(tc[5] == r4::vector2<float>(0.5, 1))
+		ASSERT_ALWAYS(tc[6] == r4::vector2<float>(1, 1))
+	}
+
+	// too many quads for 16 bit indices are split into several draw calls
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, false));
+
+		std::vector<morda::quad_instance> quads(morda::renderer::max_quads_per_draw + 1, make_quad(red));
+
+		r.render_quads(utki::make_span(quads));
+
+		ASSERT_INFO_ALWAYS(log.num_draws == 2, "log.num_draws = " << log.num_draws)
+		ASSERT_ALWAYS(log.last_buffers == r.pos_quad_01_vao->buffers)
+	}
+
+	// expanded vertices are streamed through the same buffers from call to call
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, false));
+
+		std::vector<morda::quad_instance> quads = {make_quad(red), make_quad(green), make_quad(red)};
+
+		r.render_quads(utki::make_span(quads));
+		auto buffers = log.last_buffers;
+		auto num_created_buffers = log.num_created_buffers;
+
+		quads.pop_back();
+		quads.front().color = green;
+		r.render_quads(utki::make_span(quads));
+
+		// two quads do not fit the stream of one quad, so the stream of two quads is created
+		ASSERT_ALWAYS(log.num_created_buffers == num_created_buffers + 2)
+
+		quads.push_back(make_quad(green));
+		r.render_quads(utki::make_span(quads));
+		ASSERT_ALWAYS(log.num_draws == 3)
+		ASSERT_ALWAYS(log.num_created_buffers == num_created_buffers + 2)
+		ASSERT_ALWAYS(log.last_buffers == buffers)
+
+		auto& colors = get_data<r4::vector4<float>>(log, 1);
+		ASSERT_ALWAYS(colors.size() == 16)
+		ASSERT_ALWAYS(colors[0] == green)
+		ASSERT_ALWAYS(colors[8] == green)
+
+		// single quad does not use the streams
+		r.render_quads(utki::make_span(quads.data(), 1));
+		ASSERT_ALWAYS(log.num_created_buffers == num_created_buffers + 2)
+		ASSERT_ALWAYS(log.last_buffers == r.pos_quad_01_vao->buffers)
+	}
+
+	// instanced shader draws all quads at once
+	{
+		draw_log log;
+		FakeRenderer r(std::make_unique<test_factory>(log, true));
+
+		fake_texture_2d tex;
+
+		std::vector<morda::quad_instance> quads = {make_quad(red), make_quad(green), make_quad(red)};
+
+		r.render_quads(utki::make_span(quads));
+		r.render_quads(utki::make_span(quads), tex);
+
+		ASSERT_ALWAYS(log.num_draws == 0)
+		ASSERT_ALWAYS(log.num_instanced_draws == 2)
+		ASSERT_ALWAYS(log.num_instances == 6)
+
+		r.render_quads(utki::span<const morda::quad_instance>());
+		ASSERT_ALWAYS(log.num_instanced_draws == 2)
+
+		// single quad is drawn without instancing
+		r.render_quads(utki::make_span(quads.data(), 1));
+		r.render_quads(utki::make_span(quads.data(), 1), tex);
+		ASSERT_ALWAYS(log.num_instanced_draws == 2)
+		ASSERT_ALWAYS(log.num_draws == 2)
+		ASSERT_ALWAYS(log.last_buffers == r.pos_tex_quad_01_vao->buffers)
+	}
+
+	// benchmark: screen of colored rectangles drawn one by one vs in a batch
+	{
+		const size_t num_quads = 10000;
+
+		std::vector<morda::quad_instance> quads;
+		for(size_t i = 0; i != num_quads; ++i){
+			quads.push_back(make_quad(i % 2 == 0 ? red : green));
+		}
+
+		auto measure = [](const std::function<void()>& f){
+			auto start = std::chrono::steady_clock::now();
+			f();
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		draw_log single_log;
+		FakeRenderer single_r(std::make_unique<test_factory>(single_log, false));
+		auto single_us = measure([&](){
+			for(auto& q : quads){
+				single_r.shader->color_pos->render(q.matrix, *single_r.pos_quad_01_vao, q.color);
+			}
+		});
+
+		draw_log fallback_log;
+		FakeRenderer fallback_r(std::make_unique<test_factory>(fallback_log, false));
+		auto fallback_us = measure([&](){
+			fallback_r.render_quads(utki::make_span(quads));
+		});
+
+		draw_log instanced_log;
+		FakeRenderer instanced_r(std::make_unique<test_factory>(instanced_log, true));
+		auto instanced_us = measure([&](){
+			instanced_r.render_quads(utki::make_span(quads));
+		});
+
+		ASSERT_ALWAYS(single_log.num_draws == num_quads)
+		ASSERT_ALWAYS(fallback_log.num_draws == 1)
+		ASSERT_ALWAYS(instanced_log.num_instanced_draws == 1)
+
+		std::cout << num_quads << " quads:" << std::endl;
+		std::cout << "\tone by one: " << single_log.num_draws << " draw calls, " << single_us << " us" << std::endl;
+		std::cout << "\tCPU expanded: " << fallback_log.num_draws << " draw calls, " << fallback_us << " us" << std::endl;
+		std::cout << "\tinstanced: " << instanced_log.num_instanced_draws << " draw calls, " << instanced_us << " us" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+#include <utki/debug.hpp>
+
+namespace{
+// counts calls which reach the rendering backend
+class counting_renderer : public FakeRenderer{
+public:
+	unsigned num_backend_calls = 0;
+	unsigned num_backend_queries = 0;
+
+	bool is_scissor_enabled_internal()const override{
+		++const_cast<counting_renderer*>(this)->num_backend_queries;
+		return false;
+	}
+	r4::rectangle<int> get_scissor_internal()const override{
+		++const_cast<counting_renderer*>(this)->num_backend_queries;
+		return r4::rectangle<int>(0, 0);
+	}
+	r4::rectangle<int> get_viewport_internal()const override{
+		++const_cast<counting_renderer*>(this)->num_backend_queries;
+		return r4::rectangle<int>(0, 0, 100, 200);
+	}
+	void set_blend_enabled_internal(bool enable)override{
+		++this->num_backend_calls;
+	}
+	void set_blend_func_internal(blend_factor src_color, blend_factor dst_color, blend_factor src_alpha, blend_factor dst_alpha)override{
+		++this->num_backend_calls;
+	}
+	void set_framebuffer_internal(morda::frame_buffer* fb)override{
+		++this->num_backend_calls;
+	}
+	void set_scissor_enabled_internal(bool enabled)override{
+		++this->num_backend_calls;
+	}
+	void set_scissor_internal(r4::rectangle<int> r)override{
+		++this->num_backend_calls;
+	}
+	void set_viewport_internal(r4::rectangle<int> r)override{
+		++this->num_backend_calls;
+	}
+};
+}
+
+int main(int argc, char** argv){
+	// queries are answered from the shadow copy
+	{
+		counting_renderer r;
+
+		ASSERT_ALWAYS(!r.is_scissor_enabled())
+		ASSERT_ALWAYS(!r.is_scissor_enabled())
+		ASSERT_ALWAYS(r.num_backend_queries == 1)
+
+		ASSERT_ALWAYS(r.get_viewport().d == r4::vector2<int>(100, 200))
+		ASSERT_ALWAYS(r.get_viewport().d == r4::vector2<int>(100, 200))
+		ASSERT_ALWAYS(r.num_backend_queries == 2)
+
+		r.set_viewport(r4::rectangle<int>(1, 2, 3, 4));
+		ASSERT_ALWAYS(r.get_viewport().p == r4::vector2<int>(1, 2))
+		ASSERT_ALWAYS(r.get_viewport().d == r4::vector2<int>(3, 4))
+		ASSERT_ALWAYS(r.num_backend_queries == 2)
+
+		ASSERT_ALWAYS(r.get_state_counters().num_cached_queries == 4)
+
+		// after invalidation the state is queried again
+		r.invalidate_state();
+		ASSERT_ALWAYS(r.get_viewport().d == r4::vector2<int>(100, 200))
+		ASSERT_ALWAYS(r.num_backend_queries == 3)
+	}
+
+	// redundant changes are skipped
+	{
+		counting_renderer r;
+
+		r.set_scissor_enabled(false); // state is known after query only
+		ASSERT_ALWAYS(r.num_backend_calls == 1)
+		r.set_scissor_enabled(false);
+		ASSERT_ALWAYS(r.num_backend_calls == 1)
+		r.set_scissor_enabled(true);
+		ASSERT_ALWAYS(r.num_backend_calls == 2)
+
+		r.set_scissor(r4::rectangle<int>(1, 2, 3, 4));
+		r.set_scissor(r4::rectangle<int>(1, 2, 3, 4));
+		ASSERT_ALWAYS(r.num_backend_calls == 3)
+		r.set_scissor(r4::rectangle<int>(1, 2, 3, 5));
+		ASSERT_ALWAYS(r.num_backend_calls == 4)
+
+		for(unsigned i = 0; i != 10; ++i){
+			r.set_blend_enabled(true);
+			r.set_blend_func(
+					morda::renderer::blend_factor::src_alpha,
+					morda::renderer::blend_factor::one_minus_src_alpha,
+					morda::renderer::blend_factor::one,
+					morda::renderer::blend_factor::one_minus_src_alpha
+				);
+		}
+		ASSERT_ALWAYS(r.num_backend_calls == 6)
+
+		r.set_blend_func(
+				morda::renderer::blend_factor::one,
+				morda::renderer::blend_factor::one_minus_src_alpha,
+				morda::renderer::blend_factor::one,
+				morda::renderer::blend_factor::one_minus_src_alpha
+			);
+		ASSERT_ALWAYS(r.num_backend_calls == 7)
+
+		r.set_framebuffer(nullptr);
+		r.set_framebuffer(nullptr);
+		ASSERT_ALWAYS(r.num_backend_calls == 8)
+
+		auto& c = r.get_state_counters();
+		ASSERT_INFO_ALWAYS(c.num_changes == 8, "c.num_changes = " << c.num_changes)
+		ASSERT_INFO_ALWAYS(c.num_skipped_changes == 21, "c.num_skipped_changes = " << c.num_skipped_changes)
+
+		r.reset_state_counters();
+		ASSERT_ALWAYS(r.get_state_counters().num_changes == 0)
+		ASSERT_ALWAYS(r.get_state_counters().num_skipped_changes == 0)
+		ASSERT_ALWAYS(r.get_state_counters().num_cached_queries == 0)
+	}
+
+	return 0;
+}
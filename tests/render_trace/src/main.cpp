@@ -0,0 +1,178 @@
+#include "../../../src/morda/morda/render/recording_renderer.hpp"
+#include "../../../src/morda/morda/render/trace_player.hpp"
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+#include <utki/debug.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <array>
+#include <chrono>
+#include <vector>
+#include <iostream>
+
+namespace{
+void print_report(const morda::trace_player::report& r){
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+
+	std::cout << "frames: " << r.num_frames << std::endl;
+	std::cout << "draw calls: " << r.num_draws << std::endl;
+	std::cout << "instanced quads: " << r.num_instanced_quads << std::endl;
+	std::cout << "created objects: " << r.num_created_objects << std::endl;
+	std::cout << "state changes: " << r.state_counters.num_changes
+			<< ", skipped: " << r.state_counters.num_skipped_changes << std::endl;
+	std::cout << "total time: " << duration_cast<microseconds>(r.total_time).count() << " us" << std::endl;
+	for(size_t i = 0; i != r.frame_times.size(); ++i){
+		std::cout << "\tframe " << i << ": " << duration_cast<microseconds>(r.frame_times[i]).count() << " us" << std::endl;
+	}
+}
+}
+
+int main(int argc, char** argv){
+	// replay tool mode: replay the given trace against the fake renderer
+	if(argc > 1){
+		morda::trace_player player{papki::fs_file(argv[1])};
+		FakeRenderer r;
+		print_report(player.play(r));
+		return 0;
+	}
+
+	const std::string trace_path = "out/test.trace";
+
+	morda::renderer::state_counters recorded_counters;
+	size_t recorded_trace_size;
+
+	// record
+	{
+		auto target = std::make_shared<FakeRenderer>();
+		morda::recording_renderer r(target);
+
+		ASSERT_ALWAYS(r.shader)
+		ASSERT_ALWAYS(r.shader->color_pos)
+		ASSERT_ALWAYS(!r.shader->instanced_quad)
+
+		r4::matrix4<float> m;
+		m.set_identity();
+
+		auto tex = r.factory->create_texture_2d(r4::vector2<unsigned>(2, 1), utki::make_span(std::array<std::uint32_t, 2>{{0xff0000ff, 0xff00ff00}}));
+		ASSERT_ALWAYS(tex)
+		ASSERT_ALWAYS(tex->dims() == fake_texture_2d().dims())
+
+		auto fb = r.factory->create_framebuffer(tex);
+		ASSERT_ALWAYS(fb)
+
+		// frame 0: render to texture
+		r.set_framebuffer(fb);
+		r.clear_framebuffer();
+		r.shader->color_pos->render(m, *r.pos_quad_01_vao, r4::vector4<float>(1, 0, 0, 1));
+		r.set_framebuffer(nullptr);
+		r.end_frame();
+
+		// frame 1: render the texture and some quads
+		r.set_viewport(r4::rectangle<int>(0, 0, 640, 480));
+		r.set_scissor_enabled(true);
+		r.set_scissor(r4::rectangle<int>(10, 10, 100, 100));
+		r.set_scissor(r4::rectangle<int>(10, 10, 100, 100)); // redundant, not recorded
+		r.set_blend_enabled(true);
+		r.set_blend_func(
+				morda::renderer::blend_factor::src_alpha,
+				morda::renderer::blend_factor::one_minus_src_alpha,
+				morda::renderer::blend_factor::one,
+				morda::renderer::blend_factor::one_minus_src_alpha
+			);
+		r.shader->pos_tex->render(m, *r.pos_tex_quad_01_vao, *tex);
+		r.shader->color_pos_tex->render(m, *r.pos_tex_quad_01_vao, r4::vector4<float>(1, 1, 1, 0.5f), *tex);
+
+		std::vector<morda::quad_instance> quads(3);
+		for(auto& q : quads){
+			q.matrix = m;
+			q.color = r4::vector4<float>(0, 0, 1, 1);
+		}
+		r.render_quads(utki::make_span(quads)); // CPU expanded, since fake renderer does not support instancing
+
+		r.end_frame();
+
+		// destroyed objects are recorded as well
+		fb.reset();
+		tex.reset();
+
+		recorded_counters = r.get_state_counters();
+		recorded_trace_size = r.get_trace().size();
+
+		// the target receives the state changes
+		ASSERT_ALWAYS(target->get_scissor().p == r4::vector2<int>(10, 10))
+
+		r.save_trace(papki::fs_file(trace_path));
+
+		// the trace can be replayed while the recording renderer is alive
+		morda::trace_player player(std::vector<std::uint8_t>(r.get_trace().begin(), r.get_trace().end()));
+		FakeRenderer replay_renderer;
+		auto report = player.play(replay_renderer);
+		ASSERT_ALWAYS(report.num_frames == 2)
+	}
+
+	// replay
+	{
+		morda::trace_player player{papki::fs_file(trace_path)};
+
+		FakeRenderer r;
+
+		auto report = player.play(r);
+
+		print_report(report);
+
+		ASSERT_INFO_ALWAYS(report.num_frames == 2, "report.num_frames = " << report.num_frames)
+		ASSERT_ALWAYS(report.frame_times.size() == 2)
+		ASSERT_INFO_ALWAYS(report.num_draws == 4, "report.num_draws = " << report.num_draws)
+		ASSERT_ALWAYS(report.num_instanced_quads == 0)
+
+		// renderer creates quad VBO, index buffer, two VAOs; test created texture and frame buffer;
+		// render_quads() created two vertex buffers, index buffer and VAO
+		ASSERT_INFO_ALWAYS(report.num_created_objects == 10, "report.num_created_objects = " << report.num_created_objects)
+
+		ASSERT_INFO_ALWAYS(
+				report.state_counters.num_changes == recorded_counters.num_changes,
+				"report.state_counters.num_changes = " << report.state_counters.num_changes
+						<< ", recorded_counters.num_changes = " << recorded_counters.num_changes
+			)
+		ASSERT_ALWAYS(report.state_counters.num_skipped_changes == 0)
+
+		ASSERT_ALWAYS(r.get_scissor().p == r4::vector2<int>(10, 10))
+		ASSERT_ALWAYS(r.is_scissor_enabled())
+
+		// replaying again gives the same results
+		auto report2 = player.play(r);
+		ASSERT_ALWAYS(report2.num_draws == report.num_draws)
+		ASSERT_ALWAYS(report2.num_created_objects == report.num_created_objects)
+	}
+
+	// corrupted traces
+	{
+		bool thrown = false;
+		try{
+			morda::trace_player player(std::vector<std::uint8_t>{1, 2, 3});
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		auto data = papki::fs_file(trace_path).load();
+		ASSERT_ALWAYS(data.size() == recorded_trace_size)
+		data.resize(data.size() - 3);
+
+		morda::trace_player player(std::move(data));
+		FakeRenderer r;
+
+		thrown = false;
+		try{
+			player.play(r);
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	return 0;
+}
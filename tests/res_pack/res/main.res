@@ -0,0 +1,5 @@
+include_subdirs
+
+tml_root{
+	file{root.tml}
+}
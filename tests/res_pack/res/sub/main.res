@@ -0,0 +1,3 @@
+tml_sub{
+	file{sub.tml}
+}
@@ -0,0 +1,139 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/util/res_pack.hpp"
+#include "../../../src/morda/morda/res/treeml.hpp"
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+int main(int argc, char** argv){
+	const std::string archive_path = "out/test.respack";
+
+	// create archive
+	{
+		papki::fs_file src("res/");
+		papki::fs_file dst(archive_path);
+		morda::res_pack::write(src, dst);
+	}
+
+	// test archive contents
+	{
+		auto pack = std::make_shared<morda::res_pack>(archive_path);
+
+		ASSERT_ALWAYS(pack->find("main.res"))
+		ASSERT_ALWAYS(pack->find("root.tml"))
+		ASSERT_ALWAYS(pack->find("sub/main.res"))
+		ASSERT_ALWAYS(pack->find("sub/sub.tml"))
+		ASSERT_ALWAYS(!pack->find("sub"))
+		ASSERT_ALWAYS(!pack->find("non_existing"))
+
+		ASSERT_ALWAYS(pack->has_dir("sub/"))
+		ASSERT_ALWAYS(!pack->has_dir("non_existing/"))
+
+		{
+			auto list = pack->list_dir("");
+			ASSERT_INFO_ALWAYS(list.size() == 3, "list.size() = " << list.size())
+			ASSERT_ALWAYS(list[0] == "main.res")
+			ASSERT_ALWAYS(list[1] == "root.tml")
+			ASSERT_ALWAYS(list[2] == "sub/")
+		}
+
+		// file data is aligned within the archive
+		for(auto name : {"main.res", "root.tml", "sub/main.res", "sub/sub.tml"}){
+			auto d = pack->find(name);
+			ASSERT_ALWAYS(d)
+			ASSERT_ALWAYS(reinterpret_cast<size_t>(d->data()) % 16 == 0)
+		}
+
+		// read through file interface
+		{
+			morda::res_pack::file fi(pack, "sub/", "sub.tml");
+			ASSERT_ALWAYS(fi.exists())
+
+			papki::fs_file orig("res/sub/sub.tml");
+			auto expected = orig.load();
+
+			auto data = fi.load();
+			ASSERT_ALWAYS(data == expected)
+
+			auto direct = fi.data();
+			ASSERT_ALWAYS(direct.size() == expected.size())
+			ASSERT_ALWAYS(std::equal(direct.begin(), direct.end(), expected.begin()))
+		}
+	}
+
+	// test that huge number of entries in a truncated archive is rejected
+	{
+		std::vector<std::uint8_t> data = {'M', 'O', 'R', 'D', 'A', 'R', 'P', '1', 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0};
+
+		bool thrown = false;
+		try{
+			morda::res_pack pack(std::move(data));
+		}catch(std::runtime_error&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	// test mounting the archive
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		papki::fs_file fi(archive_path);
+		m.context->loader.mount_res_pack(fi);
+
+		auto r = m.context->loader.load<morda::res::treeml>("tml_root");
+		ASSERT_ALWAYS(r)
+		ASSERT_ALWAYS(r->forest().size() == 1)
+		ASSERT_ALWAYS(r->forest()[0].value == "hello")
+
+		auto s = m.context->loader.load<morda::res::treeml>("tml_sub");
+		ASSERT_ALWAYS(s)
+		ASSERT_ALWAYS(s->forest().size() == 3)
+	}
+
+	// test pre-decoded image header validation
+	{
+		auto make_image_data = [](std::uint32_t width, std::uint32_t height, std::uint32_t num_channels, size_t num_pixel_bytes){
+			std::vector<std::uint8_t> data = {'M', 'R', 'I', '1'};
+			for(auto v : {width, height, num_channels}){
+				for(unsigned i = 0; i != 4; ++i){
+					data.push_back(std::uint8_t(v >> (i * 8)));
+				}
+			}
+			data.resize(data.size() + num_pixel_bytes);
+			return data;
+		};
+
+		morda::res_pack::pre_decoded_image im;
+
+		auto data = make_image_data(3, 2, 4, 24);
+		ASSERT_ALWAYS(morda::res_pack::parse_pre_decoded_image(utki::make_span(data), im))
+		ASSERT_ALWAYS(im.dims == r4::vector2<unsigned>(3, 2))
+		ASSERT_ALWAYS(im.num_channels == 4)
+		ASSERT_ALWAYS(im.pixels.size() == 24)
+
+		// pixels do not fit into the data
+		data = make_image_data(3, 2, 4, 23);
+		ASSERT_ALWAYS(!morda::res_pack::parse_pre_decoded_image(utki::make_span(data), im))
+
+		// pixels size overflows
+		data = make_image_data(0xffffffff, 0xffffffff, 4, 16);
+		ASSERT_ALWAYS(!morda::res_pack::parse_pre_decoded_image(utki::make_span(data), im))
+		data = make_image_data(0x10000, 0x10000, 1, 16);
+		ASSERT_ALWAYS(!morda::res_pack::parse_pre_decoded_image(utki::make_span(data), im))
+
+		// zero dimensions
+		data = make_image_data(0, 2, 4, 16);
+		ASSERT_ALWAYS(!morda::res_pack::parse_pre_decoded_image(utki::make_span(data), im))
+	}
+
+	return 0;
+}
@@ -0,0 +1,11 @@
+tml_a{
+	file{a.tml}
+}
+
+tml_b{
+	file{b.tml}
+}
+
+tml_c{
+	file{c.tml}
+}
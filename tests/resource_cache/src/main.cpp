@@ -0,0 +1,144 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/res/treeml.hpp"
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	auto& loader = m.context->loader;
+
+	loader.mount_res_pack(papki::fs_file("res/"));
+
+	// retention cache is disabled by default, unused resources are released
+	{
+		ASSERT_ALWAYS(loader.get_cache_budget() == 0)
+
+		std::weak_ptr<morda::res::treeml> w;
+		{
+			auto a = loader.load<morda::res::treeml>("tml_a");
+			ASSERT_ALWAYS(a)
+			ASSERT_ALWAYS(a->get_memory_usage().cpu != 0)
+			ASSERT_ALWAYS(a->get_memory_usage().gpu == 0)
+			w = a;
+
+			auto a2 = loader.load<morda::res::treeml>("tml_a");
+			ASSERT_ALWAYS(a2 == a)
+		}
+		ASSERT_ALWAYS(w.expired())
+		ASSERT_ALWAYS(loader.get_cache_size() == 0)
+
+		auto& c = loader.get_cache_counters();
+		ASSERT_INFO_ALWAYS(c.num_hits == 1, "c.num_hits = " << c.num_hits)
+		ASSERT_INFO_ALWAYS(c.num_misses == 1, "c.num_misses = " << c.num_misses)
+		ASSERT_ALWAYS(c.num_evictions == 0)
+
+		loader.reset_cache_counters();
+		ASSERT_ALWAYS(loader.get_cache_counters().num_hits == 0)
+		ASSERT_ALWAYS(loader.get_cache_counters().num_misses == 0)
+	}
+
+	size_t res_size = loader.load<morda::res::treeml>("tml_a")->get_memory_usage().total();
+	loader.reset_cache_counters();
+
+	// cache fits two resources
+	{
+		loader.set_cache_budget(res_size * 2);
+
+		std::weak_ptr<morda::res::treeml> wa;
+		std::weak_ptr<morda::res::treeml> wb;
+		std::weak_ptr<morda::res::treeml> wc;
+
+		wa = loader.load<morda::res::treeml>("tml_a");
+		wb = loader.load<morda::res::treeml>("tml_b");
+
+		// retained
+		ASSERT_ALWAYS(!wa.expired())
+		ASSERT_ALWAYS(!wb.expired())
+		ASSERT_INFO_ALWAYS(loader.get_cache_size() == res_size * 2, "loader.get_cache_size() = " << loader.get_cache_size())
+
+		// loading retained resource is a hit, it becomes most recently used
+		ASSERT_ALWAYS(loader.load<morda::res::treeml>("tml_a") == wa.lock())
+
+		// loading third resource evicts least recently used one
+		wc = loader.load<morda::res::treeml>("tml_c");
+		ASSERT_ALWAYS(!wa.expired())
+		ASSERT_ALWAYS(wb.expired())
+		ASSERT_ALWAYS(!wc.expired())
+		ASSERT_ALWAYS(loader.get_cache_size() == res_size * 2)
+
+		auto& c = loader.get_cache_counters();
+		ASSERT_INFO_ALWAYS(c.num_hits == 1, "c.num_hits = " << c.num_hits)
+		ASSERT_INFO_ALWAYS(c.num_misses == 3, "c.num_misses = " << c.num_misses)
+		ASSERT_INFO_ALWAYS(c.num_evictions == 1, "c.num_evictions = " << c.num_evictions)
+
+		// shrinking the budget evicts resources
+		loader.set_cache_budget(res_size);
+		ASSERT_ALWAYS(wa.expired())
+		ASSERT_ALWAYS(!wc.expired())
+		ASSERT_ALWAYS(c.num_evictions == 2)
+
+		loader.clear_cache();
+		ASSERT_ALWAYS(wc.expired())
+		ASSERT_ALWAYS(loader.get_cache_size() == 0)
+		ASSERT_ALWAYS(c.num_evictions == 2)
+	}
+
+	loader.reset_cache_counters();
+
+	// pinning
+	{
+		loader.set_cache_budget(res_size);
+
+		// pin before loading
+		loader.pin("tml_a");
+
+		std::weak_ptr<morda::res::treeml> wa = loader.load<morda::res::treeml>("tml_a");
+		std::weak_ptr<morda::res::treeml> wb = loader.load<morda::res::treeml>("tml_b");
+		std::weak_ptr<morda::res::treeml> wc = loader.load<morda::res::treeml>("tml_c");
+
+		// pinned resource is not counted against the budget and is not evicted
+		ASSERT_ALWAYS(!wa.expired())
+		ASSERT_ALWAYS(wb.expired())
+		ASSERT_ALWAYS(!wc.expired())
+		ASSERT_ALWAYS(loader.get_cache_size() == res_size)
+		ASSERT_ALWAYS(loader.get_cache_counters().num_evictions == 1)
+
+		// unpinned resource is subject to the budget
+		loader.unpin("tml_a");
+		ASSERT_ALWAYS(wa.expired())
+		ASSERT_ALWAYS(!wc.expired())
+
+		// pin already loaded resource, pinning works with disabled cache
+		loader.set_cache_budget(0);
+		ASSERT_ALWAYS(wc.expired())
+		{
+			auto b = loader.load<morda::res::treeml>("tml_b");
+			loader.pin("tml_b");
+			wb = b;
+		}
+		ASSERT_ALWAYS(!wb.expired())
+		ASSERT_ALWAYS(loader.get_cache_size() == 0)
+
+		// clearing the cache releases pinned resources, but they stay pinned
+		loader.clear_cache();
+		ASSERT_ALWAYS(wb.expired())
+
+		wb = loader.load<morda::res::treeml>("tml_b");
+		ASSERT_ALWAYS(!wb.expired())
+
+		loader.unpin("tml_b");
+		ASSERT_ALWAYS(wb.expired())
+	}
+
+	return 0;
+}
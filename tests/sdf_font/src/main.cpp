@@ -0,0 +1,90 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/res/font.hpp"
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	const std::string font_path = "../../res/morda_res/fonts/Vera.ttf";
+
+	auto make_font = [&m, &font_path](bool sdf){
+		return std::make_shared<morda::res::font>(
+				m.context,
+				papki::fs_file(font_path),
+				nullptr,
+				nullptr,
+				nullptr,
+				24,
+				unsigned(-1),
+				sdf
+			);
+	};
+
+	auto bitmap = make_font(false);
+	auto sdf = make_font(true);
+
+	ASSERT_ALWAYS(!bitmap->is_sdf())
+	ASSERT_ALWAYS(sdf->is_sdf())
+
+	// bitmap fonts cannot be resized
+	{
+		bool thrown = false;
+		try{
+			bitmap->resize(12);
+		}catch(std::logic_error&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	const std::string str = "Hello\tworld!";
+
+	// SDF font measures text close to the bitmap font of the same size
+	{
+		auto a = bitmap->get().get_advance(str);
+		auto b = sdf->get().get_advance(str);
+		using std::abs;
+		ASSERT_INFO_ALWAYS(abs(a - b) < a * 0.1f, "a = " << a << ", b = " << b)
+	}
+
+	// resized font shares glyphs and scales metrics
+	{
+		auto small = sdf->resize(12);
+		ASSERT_ALWAYS(small)
+
+		auto a = sdf->get().get_advance(str);
+		auto b = small->get_advance(str);
+		using std::abs;
+		ASSERT_INFO_ALWAYS(abs(a - 2 * b) < 0.01f, "a = " << a << ", b = " << b)
+
+		auto bb = small->get_bounding_box(str);
+		auto bb_big = sdf->get().get_bounding_box(str);
+		ASSERT_ALWAYS(abs(bb_big.d.x() - 2 * bb.d.x()) < 0.01f)
+
+		// rendering uploads glyphs to the shared glyph set
+		morda::matrix4 matr;
+		matr.set_identity();
+		auto gpu_before = sdf->get_memory_usage().gpu;
+		auto res = small->render(matr, r4::vector4<float>(1), str);
+		ASSERT_ALWAYS(res.length == str.size() - 1 + 4)
+		ASSERT_ALWAYS(abs(res.advance - b) < 0.01f)
+		ASSERT_ALWAYS(sdf->get_memory_usage().gpu > gpu_before)
+
+		// rendering the same text with the original font does not add glyphs
+		gpu_before = sdf->get_memory_usage().gpu;
+		sdf->get().render(matr, r4::vector4<float>(1), str);
+		ASSERT_ALWAYS(sdf->get_memory_usage().gpu == gpu_before)
+	}
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "../../../src/morda/morda/task_queue.hpp"
+
+#include <utki/debug.hpp>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+int main(int argc, char** argv){
+	// priorities and order of execution
+	{
+		unsigned num_wake_ups = 0;
+		morda::task_queue q([&num_wake_ups](){++num_wake_ups;});
+
+		std::string log;
+
+		q.post([&log](){log += "b1";});
+		ASSERT_ALWAYS(num_wake_ups == 1)
+		q.post([&log](){log += "l1";}, morda::task_queue::priority::layout);
+		q.post([&log](){log += "i1";}, morda::task_queue::priority::input);
+		q.post([&log](){log += "b2";});
+		q.post([&log](){log += "i2";}, morda::task_queue::priority::input);
+		ASSERT_ALWAYS(num_wake_ups == 1)
+
+		ASSERT_ALWAYS(q.run(std::chrono::hours(1)) == 0)
+		ASSERT_INFO_ALWAYS(log == "i1i2l1b1b2", "log = " << log)
+
+		// after run the next post requests wake up again
+		q.post([&log](){log += "b3";});
+		ASSERT_ALWAYS(num_wake_ups == 2)
+		ASSERT_ALWAYS(q.run() == 0)
+		ASSERT_ALWAYS(log == "i1i2l1b1b2b3")
+	}
+
+	// coalescing
+	{
+		morda::task_queue q([](){});
+
+		int a, b;
+		std::string log;
+
+		for(unsigned i = 0; i != 10; ++i){
+			q.post(&a, [&log, i](){log += "a" + std::to_string(i);});
+			q.post(&b, [&log, i](){log += "b" + std::to_string(i);});
+		}
+		q.post([&log](){log += "c";});
+
+		ASSERT_ALWAYS(q.run() == 0)
+		ASSERT_INFO_ALWAYS(log == "a9b9c", "log = " << log)
+
+		// key is free after the task has been executed
+		q.post(&a, [&log](){log += "a";});
+		ASSERT_ALWAYS(q.run() == 0)
+		ASSERT_ALWAYS(log == "a9b9ca")
+	}
+
+	// tasks posted from tasks and time budget
+	{
+		unsigned num_wake_ups = 0;
+		morda::task_queue q([&num_wake_ups](){++num_wake_ups;});
+
+		unsigned num_runs = 0;
+		q.post([&q, &num_runs](){
+			++num_runs;
+			q.post([&num_runs](){++num_runs;});
+		});
+		ASSERT_ALWAYS(q.run() == 0)
+		ASSERT_ALWAYS(num_runs == 1)
+		ASSERT_ALWAYS(num_wake_ups == 2)
+		ASSERT_ALWAYS(q.run() == 0)
+		ASSERT_ALWAYS(num_runs == 2)
+
+		for(unsigned i = 0; i != 10; ++i){
+			q.post([&num_runs](){
+				++num_runs;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			});
+		}
+		auto wake_ups = num_wake_ups;
+
+		// zero budget still runs one task
+		ASSERT_ALWAYS(q.run(std::chrono::milliseconds(0)) == 9)
+		ASSERT_ALWAYS(num_runs == 3)
+		ASSERT_ALWAYS(num_wake_ups == wake_ups + 1)
+		ASSERT_ALWAYS(q.run(std::chrono::hours(1)) == 0)
+		ASSERT_ALWAYS(num_runs == 12)
+	}
+
+	// pending tasks are destroyed along with the queue
+	{
+		auto p = std::make_shared<int>(0);
+		{
+			morda::task_queue q([](){});
+			q.post([p](){});
+			ASSERT_ALWAYS(p.use_count() == 2)
+		}
+		ASSERT_ALWAYS(p.use_count() == 1)
+	}
+
+	// multiple producers
+	{
+		std::atomic<unsigned> num_wake_ups{0};
+		morda::task_queue q([&num_wake_ups](){++num_wake_ups;});
+
+		const unsigned num_threads = 4;
+		const unsigned num_tasks = 100000;
+
+		std::vector<unsigned> last_values(num_threads, 0);
+		unsigned num_runs = 0;
+		bool is_ordered = true;
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::atomic<unsigned> num_finished{0};
+		std::vector<std::thread> threads;
+		for(unsigned t = 0; t != num_threads; ++t){
+			threads.emplace_back([&, t](){
+				for(unsigned i = 1; i <= num_tasks; ++i){
+					q.post([&, t, i](){
+						++num_runs;
+						if(last_values[t] >= i){
+							is_ordered = false;
+						}
+						last_values[t] = i;
+					});
+				}
+				++num_finished;
+			});
+		}
+
+		// consume on this thread while producers are posting
+		while(num_finished != num_threads){
+			q.run();
+		}
+		while(q.run() != 0){}
+
+		for(auto& t : threads){
+			t.join();
+		}
+
+		auto duration = std::chrono::steady_clock::now() - start;
+
+		ASSERT_INFO_ALWAYS(num_runs == num_threads * num_tasks, "num_runs = " << num_runs)
+		ASSERT_ALWAYS(is_ordered)
+
+		std::cout << "posted and ran " << num_runs << " tasks from " << num_threads << " threads in "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms, "
+				<< num_wake_ups << " wake ups" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/widgets/input/text_input_line.hpp"
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+namespace{
+bool is_near(morda::real a, morda::real b){
+	using std::abs;
+	return abs(a - b) < morda::real(0.01);
+}
+
+void click(morda::text_input_line& w, morda::real x){
+	w.on_mouse_button(morda::mouse_button_event{true, morda::vector2(x, 0), morda::mouse_button::left, 0});
+	w.on_mouse_button(morda::mouse_button_event{false, morda::vector2(x, 0), morda::mouse_button::left, 0});
+}
+}
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	{
+		papki::fs_file fi("../../res/morda_res/");
+		m.initStandardWidgets(fi);
+	}
+
+	const std::u32string text = U"Hello,\tworld";
+
+	// caret positions and hit-testing when the whole text fits into the widget
+	{
+		auto w = std::make_shared<morda::text_input_line>(m.context, treeml::forest());
+		w->set_text(std::u32string(text));
+		w->resize(morda::vector2(1000, 30));
+
+		const auto& font = w->get_font().get();
+
+		for(size_t i = 0; i <= text.size(); ++i){
+			auto expected = font.get_advance(text.substr(0, i));
+
+			w->set_cursor_index(i);
+			ASSERT_ALWAYS(w->get_cursor_index() == i)
+			ASSERT_INFO_ALWAYS(is_near(w->get_cursor_pos(), expected), "i = " << i << ", pos = " << w->get_cursor_pos() << ", expected = " << expected)
+
+			// clicking at the caret position, or slightly around it, places the caret there
+			w->set_cursor_index(0);
+			click(*w, expected);
+			ASSERT_INFO_ALWAYS(w->get_cursor_index() == i, "i = " << i << ", index = " << w->get_cursor_index())
+
+			if(i != 0){
+				w->set_cursor_index(0);
+				click(*w, expected - morda::real(0.5));
+				ASSERT_ALWAYS(w->get_cursor_index() == i)
+			}
+			if(i != text.size()){
+				w->set_cursor_index(0);
+				click(*w, expected + morda::real(0.5));
+				ASSERT_ALWAYS(w->get_cursor_index() == i)
+			}
+		}
+
+		// clicking in the middle of the tab selects the nearest tab boundary
+		auto tab_begin = font.get_advance(text.substr(0, 6));
+		auto tab_end = font.get_advance(text.substr(0, 7));
+		ASSERT_ALWAYS(tab_end - tab_begin > font.get_advance(U' '))
+
+		click(*w, tab_begin + (tab_end - tab_begin) / 4);
+		ASSERT_ALWAYS(w->get_cursor_index() == 6)
+		click(*w, tab_end - (tab_end - tab_begin) / 4);
+		ASSERT_ALWAYS(w->get_cursor_index() == 7)
+
+		// clicking beyond the text end places the caret at the end
+		click(*w, 999);
+		ASSERT_ALWAYS(w->get_cursor_index() == text.size())
+
+		// selection
+		w->set_cursor_index(2);
+		w->set_cursor_index(8, true);
+		ASSERT_ALWAYS(w->get_cursor_index() == 8)
+		ASSERT_ALWAYS(is_near(w->get_cursor_pos(), font.get_advance(text.substr(0, 8))))
+	}
+
+	// caret stays within the widget when the text is scrolled
+	{
+		auto w = std::make_shared<morda::text_input_line>(m.context, treeml::forest());
+		w->set_text(std::u32string(text));
+
+		const auto& font = w->get_font().get();
+
+		auto width = font.get_advance(text) / 2;
+		w->resize(morda::vector2(width, 30));
+
+		w->set_cursor_index(text.size());
+		ASSERT_ALWAYS(w->get_cursor_pos() <= width)
+		ASSERT_ALWAYS(w->get_cursor_pos() > width / 2)
+
+		// the text is scrolled so that the caret stays at the same place for the last characters
+		auto end_pos = w->get_cursor_pos();
+		w->set_cursor_index(text.size() - 1);
+		auto prev_pos = w->get_cursor_pos();
+		auto expected = end_pos - (font.get_advance(text) - font.get_advance(text.substr(0, text.size() - 1)));
+		ASSERT_INFO_ALWAYS(is_near(prev_pos, expected), "prev_pos = " << prev_pos << ", expected = " << expected)
+
+		// hit-testing takes the scrolling into account
+		click(*w, end_pos);
+		ASSERT_ALWAYS(w->get_cursor_index() == text.size())
+		click(*w, prev_pos);
+		ASSERT_ALWAYS(w->get_cursor_index() == text.size() - 1)
+
+		// moving the caret to the beginning scrolls the text back
+		w->set_cursor_index(0);
+		ASSERT_ALWAYS(w->get_cursor_pos() == 0)
+		click(*w, font.get_advance(text.substr(0, 2)));
+		ASSERT_ALWAYS(w->get_cursor_index() == 2)
+
+		morda::matrix4 matr;
+		matr.set_identity();
+		w->render(matr);
+	}
+
+	// caret follows the kerned glyphs
+	{
+		const std::u32string kerned_text = U"AVAVAVAV";
+
+		auto w = std::make_shared<morda::text_input_line>(m.context, treeml::forest());
+		w->set_text(std::u32string(kerned_text));
+		w->resize(morda::vector2(1000, 30));
+
+		const auto& font = w->get_font().get();
+
+		auto offsets = font.get_char_offsets(kerned_text);
+		ASSERT_ALWAYS(offsets.size() == kerned_text.size() + 1)
+
+		// 'V' is moved closer to 'A'
+		ASSERT_INFO_ALWAYS(offsets[1] < font.get_advance(U'A'), "offsets[1] = " << offsets[1])
+
+		for(size_t i = 0; i <= kerned_text.size(); ++i){
+			w->set_cursor_index(i);
+			ASSERT_INFO_ALWAYS(is_near(w->get_cursor_pos(), offsets[i]), "i = " << i << ", pos = " << w->get_cursor_pos() << ", expected = " << offsets[i])
+		}
+
+		// caret at the end does not drift away from the end of the rendered text
+		ASSERT_ALWAYS(is_near(w->get_cursor_pos(), font.get_advance(kerned_text)))
+	}
+
+	return 0;
+}
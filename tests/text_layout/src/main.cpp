@@ -0,0 +1,221 @@
+#include "../../../src/morda/morda/util/text_layout.hpp"
+
+#include <utki/debug.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace{
+// monospace font, every character advance is 10, counts measured characters
+class fake_font : public morda::font{
+public:
+	mutable size_t num_measured = 0;
+
+	fake_font() :
+			morda::font(nullptr)
+	{
+		this->height = 20;
+		this->ascender = 15;
+		this->descender = 5;
+	}
+
+	morda::real get_advance(char32_t c, size_t tab_size)const override{
+		++this->num_measured;
+		return c == U'\t' ? 10 * morda::real(tab_size) : 10;
+	}
+
+protected:
+	render_result render_internal(
+			const morda::matrix4& matrix,
+			r4::vector4<float> color,
+			const std::u32string_view str,
+			size_t tab_size,
+			size_t offset
+		)const override
+	{
+		return render_result{morda::real(str.size() * 10), str.size()};
+	}
+
+	morda::real get_advance_internal(const std::u32string& str, size_t tab_size)const override{
+		return morda::real(str.size() * 10);
+	}
+
+	morda::rectangle get_bounding_box_internal(const std::u32string& str, size_t tab_size)const override{
+		return morda::rectangle(0, morda::vector2(morda::real(str.size() * 10), 20));
+	}
+
+};
+
+// the "AV" pair is kerned by -4
+class kerning_font : public fake_font{
+public:
+	std::vector<morda::real> get_char_offsets(const std::u32string& str, size_t tab_size)const override{
+		auto ret = this->font::get_char_offsets(str, tab_size);
+		morda::real kerning = 0;
+		for(size_t i = 1; i < str.size(); ++i){
+			if(str[i - 1] == U'A' && str[i] == U'V'){
+				kerning -= 4;
+			}
+			ret[i] += kerning;
+		}
+		ret.back() += kerning;
+		return ret;
+	}
+};
+}
+
+int main(int argc, char** argv){
+	// line breaks and wrapping
+	{
+		fake_font f;
+		morda::text_layout l;
+		l.set_font(f);
+		l.set_text(U"hello world\n\nabcdefghij");
+
+		ASSERT_ALWAYS(l.num_lines() == 3)
+		ASSERT_ALWAYS(l.get_natural_width() == 110)
+		ASSERT_ALWAYS(l.get_line(1).begin == 12)
+		ASSERT_ALWAYS(l.get_line(1).end == 12)
+		ASSERT_ALWAYS(l.get_line(2).begin == 13)
+		ASSERT_ALWAYS(l.get_line(2).end == 23)
+
+		l.set_max_width(70);
+		ASSERT_ALWAYS(l.num_lines() == 5)
+		// wrapped at space, trailing space is not counted in width
+		ASSERT_ALWAYS(l.get_line(0).begin == 0)
+		ASSERT_ALWAYS(l.get_line(0).end == 6)
+		ASSERT_ALWAYS(l.get_line(0).width == 50)
+		ASSERT_ALWAYS(l.get_line(1).begin == 6)
+		ASSERT_ALWAYS(l.get_line(1).end == 11)
+		// word which does not fit is broken
+		ASSERT_ALWAYS(l.get_line(3).begin == 13)
+		ASSERT_ALWAYS(l.get_line(3).end == 20)
+		ASSERT_ALWAYS(l.get_line(4).end == 23)
+		ASSERT_ALWAYS(l.get_width() == 70)
+		ASSERT_ALWAYS(l.get_natural_width() == 110)
+
+		// re-wrapping does not measure characters again
+		auto num_measured = f.num_measured;
+		l.set_max_width(30);
+		ASSERT_ALWAYS(l.num_lines() > 5)
+		ASSERT_ALWAYS(f.num_measured == num_measured)
+
+		// counting lines for other width does not change the layout
+		auto wrapped_num_lines = l.num_lines();
+		ASSERT_ALWAYS(l.num_lines(70) == 5)
+		ASSERT_ALWAYS(l.num_lines(-1) == 3)
+		ASSERT_ALWAYS(l.num_lines(30) == wrapped_num_lines)
+		ASSERT_ALWAYS(l.get_max_width() == 30)
+		ASSERT_ALWAYS(l.num_lines() == wrapped_num_lines)
+		ASSERT_ALWAYS(l.get_line(0).end == 3)
+		ASSERT_ALWAYS(f.num_measured == num_measured)
+
+		// cached count is updated after the text change
+		ASSERT_ALWAYS(l.num_lines(70) == 5)
+		l.replace(0, 0, U"\n");
+		ASSERT_ALWAYS(l.num_lines(70) == 6)
+	}
+
+	// character positions are kerned as the rendered text
+	{
+		kerning_font f;
+		morda::text_layout l;
+		l.set_font(f);
+		l.set_text(U"AVAV AVAV");
+
+		ASSERT_INFO_ALWAYS(l.get_natural_width() == 90 - 4 * 4, "width = " << l.get_natural_width())
+		ASSERT_ALWAYS(l.get_x(2) == 16)
+		ASSERT_ALWAYS(l.get_x(5) == 42)
+		ASSERT_ALWAYS(l.get_char_index(0, 43) == 5)
+
+		// second word wraps when kerned width of the text does not fit
+		l.set_max_width(74);
+		ASSERT_ALWAYS(l.num_lines() == 1)
+		l.set_max_width(73);
+		ASSERT_ALWAYS(l.num_lines() == 2)
+		ASSERT_ALWAYS(l.get_line(1).width == 32)
+	}
+
+	// hit testing
+	{
+		fake_font f;
+		morda::text_layout l;
+		l.set_font(f);
+		l.set_text(U"abc\ndefgh");
+		l.set_max_width(30);
+
+		ASSERT_ALWAYS(l.num_lines() == 3)
+		ASSERT_ALWAYS(l.get_line_index(0) == 0)
+		ASSERT_ALWAYS(l.get_line_index(3) == 0)
+		ASSERT_ALWAYS(l.get_line_index(4) == 1)
+		ASSERT_ALWAYS(l.get_line_index(7) == 2)
+		ASSERT_ALWAYS(l.get_line_index(100) == 2)
+		ASSERT_ALWAYS(l.get_x(5) == 10)
+		ASSERT_ALWAYS(l.get_x(8) == 10)
+
+		ASSERT_ALWAYS(l.get_char_index(0, -5) == 0)
+		ASSERT_ALWAYS(l.get_char_index(0, 14) == 1)
+		ASSERT_ALWAYS(l.get_char_index(0, 16) == 2)
+		ASSERT_ALWAYS(l.get_char_index(0, 100) == 3)
+		ASSERT_ALWAYS(l.get_char_index(2, 6) == 8)
+		ASSERT_ALWAYS(l.get_char_index(2, 100) == 9)
+	}
+
+	// incremental editing
+	{
+		fake_font f;
+		morda::text_layout l;
+		l.set_font(f);
+
+		std::u32string text;
+		for(unsigned i = 0; i != 10000; ++i){
+			text += U"line of the log number " + utki::to_utf32(std::to_string(i)) + U"\n";
+		}
+		auto text_size = text.size();
+		l.set_text(std::move(text));
+		l.set_max_width(100);
+
+		auto num_lines = l.num_lines();
+		ASSERT_ALWAYS(f.num_measured == text_size - 10000)
+
+		// edit in the middle of a paragraph
+		f.num_measured = 0;
+		auto line = l.get_line(num_lines / 2);
+		l.replace(line.begin, line.begin + 4, U"LINE");
+		ASSERT_ALWAYS(l.num_lines() == num_lines)
+		ASSERT_INFO_ALWAYS(f.num_measured < 40, "f.num_measured = " << f.num_measured)
+		ASSERT_ALWAYS(l.get_text().substr(line.begin, 4) == U"LINE")
+
+		// split paragraph
+		f.num_measured = 0;
+		l.replace(line.begin + 4, line.begin + 4, U"\n");
+		ASSERT_ALWAYS(l.get_line(l.get_line_index(line.begin + 5)).begin == line.begin + 5)
+		ASSERT_ALWAYS(f.num_measured < 40)
+
+		// join paragraphs back
+		l.replace(line.begin + 4, line.begin + 5, U"");
+		ASSERT_ALWAYS(l.num_lines() == num_lines)
+
+		// append
+		f.num_measured = 0;
+		auto size = l.get_text().size();
+		auto t0 = std::chrono::steady_clock::now();
+		for(unsigned i = 0; i != 1000; ++i){
+			l.replace(l.get_text().size(), l.get_text().size(), U"appended line\n");
+			l.num_lines();
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		ASSERT_ALWAYS(l.get_text().size() == size + 1000 * 14)
+		ASSERT_ALWAYS(f.num_measured == 1000 * 13)
+
+		std::cout << "appended 1000 lines to 10k lines text with re-layout in "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us" << std::endl;
+
+		// replace across paragraphs
+		l.replace(0, l.get_text().size(), U"a\nb");
+		ASSERT_ALWAYS(l.num_lines() == 2)
+		ASSERT_ALWAYS(l.get_line(1).begin == 2)
+	}
+
+	return 0;
+}
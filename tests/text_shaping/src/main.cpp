@@ -0,0 +1,114 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/res/font.hpp"
+#include "../../../src/morda/morda/fonts/text_shaper.hxx"
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+int main(int argc, char** argv){
+	const std::string font_path = "../../res/morda_res/fonts/Vera.ttf";
+
+	// shaped run cache
+	{
+		auto data = papki::fs_file(font_path).load();
+
+		FT_Library lib;
+		ASSERT_ALWAYS(FT_Init_FreeType(&lib) == 0)
+		FT_Face face;
+		ASSERT_ALWAYS(FT_New_Memory_Face(lib, data.data(), FT_Long(data.size()), 0, &face) == 0)
+		ASSERT_ALWAYS(FT_Set_Pixel_Sizes(face, 0, 24) == 0)
+
+		{
+			morda::text_shaper shaper(face, 2);
+
+			// pair 'AV' is kerned
+			auto av = shaper.shape(U"AV");
+			ASSERT_ALWAYS(av)
+			ASSERT_ALWAYS(av->size() == 2)
+			ASSERT_ALWAYS((*av)[0] == 0)
+			ASSERT_INFO_ALWAYS((*av)[1] < 0, "(*av)[1] = " << (*av)[1])
+			ASSERT_ALWAYS(shaper.get_cache_counters().num_misses == 1)
+
+			// shaping the same string again gives the cached run
+			ASSERT_ALWAYS(shaper.shape(U"AV") == av)
+			ASSERT_ALWAYS(shaper.get_cache_counters().num_hits == 1)
+
+			// cached runs are found by substring views
+			{
+				std::u32string str = U"xAVx";
+				ASSERT_ALWAYS(shaper.shape(std::u32string_view(str).substr(1, 2)) == av)
+				ASSERT_ALWAYS(shaper.get_cache_counters().num_hits == 2)
+			}
+
+			// tabs break the kerning pairs
+			auto tab = shaper.shape(U"A\tV");
+			ASSERT_ALWAYS(!tab || ((*tab)[1] == 0 && (*tab)[2] == 0))
+
+			// single characters need no kerning and are not cached
+			ASSERT_ALWAYS(!shaper.shape(U"A"))
+			ASSERT_ALWAYS(shaper.get_num_cached_runs() == 2)
+
+			// least recently used run is evicted
+			shaper.shape(U"AV");
+			shaper.shape(U"VA");
+			ASSERT_ALWAYS(shaper.get_num_cached_runs() == 2)
+			auto hits = shaper.get_cache_counters().num_hits;
+			ASSERT_ALWAYS(shaper.shape(U"AV") == av)
+			ASSERT_ALWAYS(shaper.get_cache_counters().num_hits == hits + 1)
+			auto misses = shaper.get_cache_counters().num_misses;
+			shaper.shape(U"A\tV");
+			ASSERT_ALWAYS(shaper.get_cache_counters().num_misses == misses + 1)
+		}
+
+		FT_Done_Face(face);
+		FT_Done_FreeType(lib);
+	}
+
+	// fonts apply the kerning
+	{
+		morda::gui m(std::make_shared<morda::context>(
+				std::make_shared<FakeRenderer>(),
+				std::make_shared<morda::updater>(),
+				[](std::function<void()>&&){},
+				[](morda::mouse_cursor){},
+				0,
+				0
+			));
+
+		for(bool sdf : {false, true}){
+			morda::res::font f(
+					m.context,
+					papki::fs_file(font_path),
+					nullptr,
+					nullptr,
+					nullptr,
+					24,
+					unsigned(-1),
+					sdf
+				);
+
+			const morda::font& font = f.get();
+
+			auto kerned = font.get_advance(std::u32string(U"AVAV"));
+			auto unkerned = 2 * (font.get_advance(U'A') + font.get_advance(U'V'));
+			ASSERT_INFO_ALWAYS(kerned < unkerned, "sdf = " << sdf << ", kerned = " << kerned << ", unkerned = " << unkerned)
+
+			morda::matrix4 matr;
+			matr.set_identity();
+			auto res = font.render(matr, r4::vector4<float>(1), std::u32string(U"AVAV"));
+			ASSERT_ALWAYS(res.length == 4)
+			using std::abs;
+			ASSERT_INFO_ALWAYS(abs(res.advance - kerned) < 0.01f, "res.advance = " << res.advance << ", kerned = " << kerned)
+
+			// character positions follow the kerning
+			auto offsets = font.get_char_offsets(std::u32string(U"AVAV"));
+			ASSERT_ALWAYS(offsets.size() == 5)
+			ASSERT_ALWAYS(offsets[0] == 0)
+			ASSERT_INFO_ALWAYS(offsets[1] < font.get_advance(U'A'), "sdf = " << sdf << ", offsets[1] = " << offsets[1])
+			ASSERT_INFO_ALWAYS(abs(offsets[4] - kerned) < 0.01f, "sdf = " << sdf << ", offsets[4] = " << offsets[4] << ", kerned = " << kerned)
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+#include "../../../src/morda/morda/gui.hpp"
+#include "../../../src/morda/morda/res/tiled_image.hpp"
+#include "../../../src/morda/morda/widgets/label/tiled_image.hpp"
+
+#include <set>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include <papki/fs_file.hpp>
+
+#include "../../harness/fake_renderer/fake_renderer.hpp"
+
+namespace{
+// executes UI thread tasks until the condition is met
+template <class F> void run_until(morda::context& c, F condition){
+	for(unsigned i = 0; !condition(); ++i){
+		ASSERT_ALWAYS(i != 10000)
+		c.task_queue.run();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+// tile loader which records loaded tiles
+class recording_loader{
+	std::mutex mutex;
+	std::vector<std::uint64_t> loaded;
+public:
+	std::set<std::uint64_t> failing;
+
+	morda::res::tiled_image::tile_loader_type make(r4::vector2<unsigned> dims, unsigned tile_size){
+		return [this, dims, tile_size](unsigned level, r4::vector2<unsigned> index){
+			auto key = morda::res::tiled_image::get_tile_key(level, index);
+			{
+				std::lock_guard<std::mutex> lock_guard(this->mutex);
+				this->loaded.push_back(key);
+			}
+			if(this->failing.find(key) != this->failing.end()){
+				throw std::runtime_error("tile is broken");
+			}
+			r4::vector2<unsigned> d;
+			for(unsigned i = 0; i != d.size(); ++i){
+				unsigned level_dim = (dims[i] + (1 << level) - 1) >> level;
+				d[i] = std::min(tile_size, level_dim - index[i] * tile_size);
+			}
+			return morda::raster_image(d, morda::raster_image::color_depth::rgb);
+		};
+	}
+
+	std::vector<std::uint64_t> get_loaded(){
+		std::lock_guard<std::mutex> lock_guard(this->mutex);
+		return this->loaded;
+	}
+};
+}
+
+int main(int argc, char** argv){
+	morda::gui m(std::make_shared<morda::context>(
+			std::make_shared<FakeRenderer>(),
+			std::make_shared<morda::updater>(),
+			[](std::function<void()>&&){},
+			[](morda::mouse_cursor){},
+			0,
+			0
+		));
+
+	// pyramid geometry
+	{
+		morda::raster_image im(r4::vector2<unsigned>(1000, 700), morda::raster_image::color_depth::rgb);
+		im.clear();
+
+		auto ti = std::make_shared<morda::res::tiled_image>(m.context, std::move(im), 128);
+
+		ASSERT_ALWAYS(ti->dims() == r4::vector2<unsigned>(1000, 700))
+		ASSERT_INFO_ALWAYS(ti->num_levels() == 4, "num_levels = " << ti->num_levels())
+		ASSERT_ALWAYS(ti->get_level_dims(1) == r4::vector2<unsigned>(500, 350))
+		ASSERT_ALWAYS(ti->get_level_dims(3) == r4::vector2<unsigned>(125, 88))
+		ASSERT_ALWAYS(ti->get_num_tiles(0) == r4::vector2<unsigned>(8, 6))
+		ASSERT_ALWAYS(ti->get_num_tiles(3) == r4::vector2<unsigned>(1, 1))
+
+		auto r = ti->get_tile_rect(0, r4::vector2<unsigned>(7, 5));
+		ASSERT_ALWAYS(r.p == r4::vector2<unsigned>(896, 640))
+		ASSERT_ALWAYS(r.d == r4::vector2<unsigned>(104, 60))
+
+		r = ti->get_tile_rect(1, r4::vector2<unsigned>(3, 2), true);
+		ASSERT_ALWAYS(r.p == r4::vector2<unsigned>(768, 512))
+		ASSERT_INFO_ALWAYS(r.d == r4::vector2<unsigned>(232, 188), "r.d = " << r.d)
+
+		// tiles are cut from the generated pyramid levels
+		ASSERT_ALWAYS(!ti->get_tile(3, r4::vector2<unsigned>(0)))
+		ti->request_tile(3, r4::vector2<unsigned>(0));
+		ti->request_tile(0, r4::vector2<unsigned>(7, 5));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 2;});
+		ASSERT_ALWAYS(ti->get_tile(3, r4::vector2<unsigned>(0)))
+		ASSERT_ALWAYS(ti->get_tile(0, r4::vector2<unsigned>(7, 5)))
+	}
+
+	// pyramid levels decoded from image file
+	{
+		auto ti = std::make_shared<morda::res::tiled_image>(
+				m.context,
+				std::make_unique<papki::fs_file>("../app/res/sample.png"),
+				128
+			);
+
+		ASSERT_ALWAYS(ti->dims() == r4::vector2<unsigned>(640, 480))
+		ASSERT_ALWAYS(ti->num_levels() == 4)
+
+		ti->request_tile(3, r4::vector2<unsigned>(0));
+		ti->request_tile(2, r4::vector2<unsigned>(1, 0));
+		ti->request_tile(0, r4::vector2<unsigned>(4, 3));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 3;});
+
+		ASSERT_ALWAYS(ti->get_tile(3, r4::vector2<unsigned>(0)))
+		ASSERT_ALWAYS(ti->get_tile(2, r4::vector2<unsigned>(1, 0)))
+		ASSERT_ALWAYS(ti->get_tile(0, r4::vector2<unsigned>(4, 3)))
+	}
+
+	// decoded levels are dropped when those exceed the memory budget
+	{
+		// image which does not fit into the budget is refused
+		bool thrown = false;
+		try{
+			morda::res::tiled_image(
+					m.context,
+					std::make_unique<papki::fs_file>("../app/res/sample.png"),
+					128,
+					morda::texture_2d::sampling(),
+					640 * 480 * 4 - 1
+				);
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		// the budget fits only the full resolution level, so coarser levels are dropped and generated again
+		auto ti = std::make_shared<morda::res::tiled_image>(
+				m.context,
+				std::make_unique<papki::fs_file>("../app/res/sample.png"),
+				128,
+				morda::texture_2d::sampling(),
+				640 * 480 * 4
+			);
+
+		ti->request_tile(3, r4::vector2<unsigned>(0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 1;});
+		ti->request_tile(2, r4::vector2<unsigned>(0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 2;});
+		ti->request_tile(0, r4::vector2<unsigned>(0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 3;});
+		ti->request_tile(1, r4::vector2<unsigned>(0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 4;});
+		ti->request_tile(2, r4::vector2<unsigned>(1, 0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 5;});
+
+		ASSERT_ALWAYS(ti->get_tile(2, r4::vector2<unsigned>(1, 0)))
+	}
+
+	// loading and eviction
+	{
+		recording_loader loader;
+		auto ti = std::make_shared<morda::res::tiled_image>(
+				m.context,
+				r4::vector2<unsigned>(1024),
+				256,
+				loader.make(r4::vector2<unsigned>(1024), 256)
+			);
+		ASSERT_ALWAYS(ti->num_levels() == 3)
+
+		// requesting the same tile many times loads it once
+		for(unsigned i = 0; i != 10; ++i){
+			ti->request_tile(0, r4::vector2<unsigned>(0));
+		}
+		run_until(*m.context, [&ti](){return ti->get_tile(0, r4::vector2<unsigned>(0)) != nullptr;});
+		ti->request_tile(0, r4::vector2<unsigned>(0));
+		ASSERT_ALWAYS(loader.get_loaded().size() == 1)
+
+		auto tile_memory = ti->get_memory_usage().gpu;
+		ASSERT_ALWAYS(tile_memory != 0)
+
+		// least recently used tiles are evicted
+		ti->set_memory_budget(tile_memory * 2);
+		ti->request_tile(0, r4::vector2<unsigned>(1, 0));
+		run_until(*m.context, [&ti](){return ti->get_num_cached_tiles() == 2;});
+		ASSERT_ALWAYS(ti->get_tile(0, r4::vector2<unsigned>(0))) // mark as recently used
+		ti->request_tile(0, r4::vector2<unsigned>(2, 0));
+		run_until(*m.context, [&loader](){return loader.get_loaded().size() == 3;});
+		run_until(*m.context, [&ti](){return ti->get_tile(0, r4::vector2<unsigned>(2, 0)) != nullptr;});
+		ASSERT_ALWAYS(ti->get_num_cached_tiles() == 2)
+		ASSERT_ALWAYS(ti->get_memory_usage().gpu == tile_memory * 2)
+		ASSERT_ALWAYS(ti->get_tile(0, r4::vector2<unsigned>(0)))
+		ASSERT_ALWAYS(!ti->get_tile(0, r4::vector2<unsigned>(1, 0)))
+
+		ti->set_memory_budget(0);
+		ASSERT_ALWAYS(ti->get_num_cached_tiles() == 1)
+
+		// failed tiles are not requested again
+		auto broken = r4::vector2<unsigned>(3, 3);
+		loader.failing.insert(morda::res::tiled_image::get_tile_key(0, broken));
+		ti->request_tile(0, broken);
+		run_until(*m.context, [&loader](){return loader.get_loaded().size() == 4;});
+		ti->request_tile(1, r4::vector2<unsigned>(0));
+		run_until(*m.context, [&ti](){return ti->get_tile(1, r4::vector2<unsigned>(0)) != nullptr;});
+		ASSERT_ALWAYS(!ti->get_tile(0, broken))
+		ti->request_tile(0, broken);
+		ASSERT_ALWAYS(loader.get_loaded().size() == 5)
+	}
+
+	// widget loads visible tiles only
+	{
+		recording_loader loader;
+		auto ti = std::make_shared<morda::res::tiled_image>(
+				m.context,
+				r4::vector2<unsigned>(4000, 3000),
+				256,
+				loader.make(r4::vector2<unsigned>(4000, 3000), 256)
+			);
+		ASSERT_ALWAYS(ti->num_levels() == 5)
+
+		auto w = std::make_shared<morda::tiled_image>(m.context, treeml::forest());
+		w->set_image(ti);
+		w->resize(morda::vector2(300, 200));
+		w->set_offset(morda::vector2(500, 0));
+
+		ASSERT_ALWAYS(w->get_level() == 0)
+		w->set_zoom(0.3f);
+		ASSERT_ALWAYS(w->get_level() == 1)
+		w->set_zoom(0.001f);
+		ASSERT_ALWAYS(w->get_level() == 4)
+		w->set_zoom(1);
+
+		morda::matrix4 matr;
+		matr.set_identity();
+
+		w->render(matr);
+
+		// visible tiles of the full resolution level and the coarsest tile as preview
+		std::set<std::uint64_t> expected = {
+			morda::res::tiled_image::get_tile_key(0, r4::vector2<unsigned>(1, 0)),
+			morda::res::tiled_image::get_tile_key(0, r4::vector2<unsigned>(2, 0)),
+			morda::res::tiled_image::get_tile_key(0, r4::vector2<unsigned>(3, 0)),
+			morda::res::tiled_image::get_tile_key(4, r4::vector2<unsigned>(0))
+		};
+
+		run_until(*m.context, [&ti, &expected](){return ti->get_num_cached_tiles() == expected.size();});
+
+		auto loaded = loader.get_loaded();
+		ASSERT_ALWAYS(loaded.size() == expected.size())
+		ASSERT_ALWAYS(std::set<std::uint64_t>(loaded.begin(), loaded.end()) == expected)
+
+		// all visible tiles are loaded, nothing new is requested
+		w->render(matr);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		ASSERT_ALWAYS(loader.get_loaded().size() == expected.size())
+
+		// coarser tile is shown while tiles of the other level are loading
+		w->zoom_at(morda::vector2(0), 0.5f);
+		ASSERT_ALWAYS(w->get_level() == 1)
+		ASSERT_ALWAYS(w->get_offset() == morda::vector2(500, 0))
+		w->render(matr);
+		w->render(matr);
+		run_until(*m.context, [&ti, &expected](){return ti->get_num_cached_tiles() == expected.size() + 3;});
+		w->render(matr);
+	}
+
+	return 0;
+}